@@ -0,0 +1,118 @@
+// This program measures the throughput of BASP over a loopback connection by
+// running two actor systems in the same process. The sender transmits a batch
+// of messages from a single message handler, i.e., in a single activation of
+// the BASP broker, and waits for the receiver to confirm the batch.
+//
+// Run with default settings:
+// - basp_throughput
+//
+// Compare against flushing after each message by adding this line to the
+// caf-application.conf in the working directory:
+// - caf { middleman { flush-threshold = 0 } }
+//
+// Measure the overhead of fragmenting large messages with:
+// - caf { middleman { max-fragment-size = 16384 } }
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+#include "caf/all.hpp"
+#include "caf/io/all.hpp"
+
+using std::cerr;
+using std::cout;
+using std::endl;
+
+using namespace caf;
+
+namespace {
+
+struct config : actor_system_config {
+  config() {
+    opt_group{custom_options_, "global"}
+      .add(batches, "batches,b", "number of batches to send")
+      .add(batch_size, "batch-size,n", "number of messages per batch")
+      .add(payload_size, "payload-size,s", "size of each message in bytes");
+  }
+  size_t batches = 10;
+  size_t batch_size = 10'000;
+  size_t payload_size = 64;
+};
+
+behavior receiver(event_based_actor*) {
+  auto received = std::make_shared<size_t>(0);
+  return {
+    [=](const std::string&) { ++*received; },
+    [=](get_atom) {
+      auto result = *received;
+      *received = 0;
+      return result;
+    },
+  };
+}
+
+} // namespace
+
+void caf_main(actor_system& sys, const config& cfg) {
+  // Spin up a second actor system that publishes the receiver. Both systems
+  // share the same settings.
+  actor_system_config server_cfg;
+  server_cfg.content = cfg.content;
+  server_cfg.load<io::middleman>();
+  actor_system server_sys{server_cfg};
+  auto port = server_sys.middleman().publish(server_sys.spawn(receiver), 0);
+  if (!port) {
+    cerr << "*** publish failed: " << to_string(port.error()) << endl;
+    return;
+  }
+  auto dst = sys.middleman().remote_actor("127.0.0.1", *port);
+  if (!dst) {
+    cerr << "*** remote_actor failed: " << to_string(dst.error()) << endl;
+    return;
+  }
+  auto payload = std::string(cfg.payload_size, 'x');
+  // Sending all messages from a single handler makes sure the BASP broker
+  // sees the entire batch in its mailbox at once. BASP only preserves the order
+  // of messages from the same sender, so the sender also asks for the count.
+  auto batch_size = cfg.batch_size;
+  auto sender = sys.spawn([=](event_based_actor* self) -> behavior {
+    return {
+      [=](ok_atom) {
+        for (size_t i = 0; i < batch_size; ++i)
+          self->send(*dst, payload);
+        auto rp = self->make_response_promise<size_t>();
+        self->request(*dst, infinite, get_atom_v).then([=](size_t n) mutable {
+          rp.deliver(n);
+        });
+        return rp;
+      },
+    };
+  });
+  scoped_actor self{sys};
+  using clock = std::chrono::steady_clock;
+  auto t0 = clock::now();
+  for (size_t i = 0; i < cfg.batches; ++i) {
+    self->request(sender, infinite, ok_atom_v)
+      .receive(
+        [&](size_t n) {
+          if (n != cfg.batch_size)
+            cerr << "*** expected " << cfg.batch_size << " messages, got " << n
+                 << endl;
+        },
+        [&](const error& err) {
+          cerr << "*** request failed: " << to_string(err) << endl;
+        });
+  }
+  auto t1 = clock::now();
+  auto secs = std::chrono::duration<double>(t1 - t0).count();
+  auto msgs = static_cast<double>(cfg.batches * cfg.batch_size);
+  cout << "sent " << msgs << " messages in " << secs << "s" << endl
+       << "throughput: " << (msgs / secs) << " msg/s, "
+       << (msgs * cfg.payload_size / secs / 1'000'000) << " MB/s" << endl;
+  anon_send_exit(sender, exit_reason::user_shutdown);
+  anon_send_exit(*dst, exit_reason::user_shutdown);
+}
+
+CAF_MAIN(io::middleman)
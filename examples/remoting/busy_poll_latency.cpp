@@ -0,0 +1,160 @@
+// This program measures the round-trip time of small messages between two
+// actor systems over a loopback connection. Each mode runs two actor systems
+// in the same process and sends one ping at a time. The program runs all
+// rounds once with a multiplexer that blocks in the kernel while idle and once
+// with a multiplexer that keeps polling for the configured spin duration.
+//
+// Run with default settings:
+// - busy_poll_latency
+//
+// Run more rounds with a longer spin duration, e.g.:
+// - busy_poll_latency --rounds=100000 --spin=10ms
+//
+// Busy polling occupies one core per multiplexer. Pin the process to isolated
+// cores for stable tail latencies. On Linux, --socket-busy-poll additionally
+// sets SO_BUSY_POLL on the sockets, which requires CAP_NET_ADMIN for values
+// above the sysctl net.core.busy_read.
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include "caf/all.hpp"
+#include "caf/io/all.hpp"
+
+using std::cerr;
+using std::cout;
+using std::endl;
+
+using namespace caf;
+
+namespace {
+
+struct config : actor_system_config {
+  config() {
+    opt_group{custom_options_, "global"}
+      .add(rounds, "rounds,r", "number of round trips per mode")
+      .add(warmup, "warmup,w", "number of round trips before measuring")
+      .add(spin, "spin,s", "busy-poll duration of the multiplexers")
+      .add(socket_busy_poll, "socket-busy-poll",
+           "SO_BUSY_POLL for the busy-poll mode");
+  }
+  size_t rounds = 10'000;
+  size_t warmup = 1'000;
+  timespan spin = timespan{1'000'000}; // 1ms
+  timespan socket_busy_poll = timespan{0};
+};
+
+using clock_type = std::chrono::steady_clock;
+
+behavior ponger(event_based_actor*) {
+  return {
+    [](ping_atom) { return pong_atom_v; },
+  };
+}
+
+struct pinger_state {
+  std::vector<double> rtts;
+  size_t remaining = 0;
+  response_promise rp;
+};
+
+using pinger_state_ptr = std::shared_ptr<pinger_state>;
+
+// Sends a single ping and records the time in microseconds until the pong.
+void ping(event_based_actor* self, const actor& dst, pinger_state_ptr st) {
+  auto t0 = clock_type::now();
+  self->request(dst, infinite, ping_atom_v).then([=](pong_atom) {
+    auto t1 = clock_type::now();
+    st->rtts.emplace_back(
+      std::chrono::duration<double, std::micro>(t1 - t0).count());
+    if (--st->remaining > 0)
+      ping(self, dst, st);
+    else
+      st->rp.deliver(st->rtts.size());
+  });
+}
+
+behavior pinger(event_based_actor* self, actor dst, pinger_state_ptr st) {
+  return {
+    [=](ok_atom, size_t rounds) {
+      st->rtts.clear();
+      st->rtts.reserve(rounds);
+      st->remaining = rounds;
+      st->rp = self->make_response_promise();
+      ping(self, dst, st);
+      return st->rp;
+    },
+  };
+}
+
+void run(const char* name, bool busy_poll, const config& cfg) {
+  // Both systems share the same settings.
+  auto make_cfg = [&](actor_system_config& x) {
+    x.content = cfg.content;
+    if (busy_poll) {
+      put(x.content, "caf.middleman.busy-poll-duration", cfg.spin);
+      put(x.content, "caf.middleman.socket-busy-poll", cfg.socket_busy_poll);
+    }
+    x.load<io::middleman>();
+  };
+  actor_system_config server_cfg;
+  make_cfg(server_cfg);
+  actor_system server_sys{server_cfg};
+  actor_system_config client_cfg;
+  make_cfg(client_cfg);
+  actor_system client_sys{client_cfg};
+  auto hdl = server_sys.spawn(ponger);
+  auto port = server_sys.middleman().publish(hdl, 0, "127.0.0.1");
+  if (!port) {
+    cerr << "*** " << name << ": publish failed: " << to_string(port.error())
+         << endl;
+    return;
+  }
+  auto dst = client_sys.middleman().remote_actor("127.0.0.1", *port);
+  if (!dst) {
+    cerr << "*** " << name << ": connect failed: " << to_string(dst.error())
+         << endl;
+    return;
+  }
+  auto st = std::make_shared<pinger_state>();
+  auto sender = client_sys.spawn(pinger, *dst, st);
+  scoped_actor self{client_sys};
+  auto measure = [&](size_t rounds) {
+    if (rounds == 0)
+      return true;
+    auto ok = false;
+    self->request(sender, infinite, ok_atom_v, rounds)
+      .receive([&](size_t n) { ok = n == rounds; },
+               [&](const error& err) {
+                 cerr << "*** " << name << ": ping failed: " << to_string(err)
+                      << endl;
+               });
+    return ok;
+  };
+  if (measure(cfg.warmup) && measure(cfg.rounds)) {
+    auto& xs = st->rtts;
+    std::sort(xs.begin(), xs.end());
+    auto percentile = [&](double p) {
+      auto index = static_cast<size_t>(p * static_cast<double>(xs.size() - 1));
+      return xs[index];
+    };
+    cout << name << ":" << endl
+         << "  round trip: p50 = " << percentile(0.5)
+         << "us, p99 = " << percentile(0.99)
+         << "us, p999 = " << percentile(0.999) << "us" << endl;
+  }
+  anon_send_exit(sender, exit_reason::user_shutdown);
+  anon_send_exit(hdl, exit_reason::user_shutdown);
+}
+
+} // namespace
+
+void caf_main(actor_system&, const config& cfg) {
+  run("blocking", false, cfg);
+  run("busy-poll", true, cfg);
+}
+
+CAF_MAIN(io::middleman)
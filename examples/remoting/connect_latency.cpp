@@ -0,0 +1,115 @@
+// This program measures the latency from connecting to a remote node until
+// receiving the first reply, e.g., for short-lived batch jobs that talk to a
+// long-running server. Each job starts a fresh actor system, connects to the
+// server, sends a single request and shuts down again. The program runs all
+// jobs once with regular handshakes and once with pipelined handshakes. The
+// latter share a handshake cache file to remember the server across jobs.
+//
+// Run with default settings:
+// - connect_latency
+//
+// Run more jobs for more stable percentiles, e.g.:
+// - connect_latency --jobs=1000
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "caf/all.hpp"
+#include "caf/io/all.hpp"
+
+using std::cerr;
+using std::cout;
+using std::endl;
+
+using namespace caf;
+
+namespace {
+
+struct config : actor_system_config {
+  config() {
+    opt_group{custom_options_, "global"}
+      .add(jobs, "jobs,j", "number of connections per mode")
+      .add(cache_file, "cache-file,f", "path for the handshake cache");
+  }
+  size_t jobs = 100;
+  std::string cache_file = "connect_latency.cache";
+};
+
+using clock_type = std::chrono::steady_clock;
+
+behavior server(event_based_actor*) {
+  return {
+    [](ping_atom) { return pong_atom_v; },
+  };
+}
+
+// Returns the time in microseconds from connecting until the first reply or a
+// negative value on error.
+double run_job(const config& cfg, uint16_t port, bool pipelined) {
+  actor_system_config job_cfg;
+  job_cfg.content = cfg.content;
+  put(job_cfg.content, "caf.middleman.pipelined-handshake", pipelined);
+  if (pipelined)
+    put(job_cfg.content, "caf.middleman.handshake-cache-file", cfg.cache_file);
+  job_cfg.load<io::middleman>();
+  actor_system sys{job_cfg};
+  scoped_actor self{sys};
+  auto t0 = clock_type::now();
+  auto dst = sys.middleman().remote_actor("localhost", port);
+  if (!dst) {
+    cerr << "*** remote_actor failed: " << to_string(dst.error()) << endl;
+    return -1;
+  }
+  auto result = -1.0;
+  self->request(*dst, infinite, ping_atom_v)
+    .receive(
+      [&](pong_atom) {
+        auto t1 = clock_type::now();
+        result = std::chrono::duration<double, std::micro>(t1 - t0).count();
+      },
+      [&](const error& err) {
+        cerr << "*** ping failed: " << to_string(err) << endl;
+      });
+  return result;
+}
+
+void run(const char* name, bool pipelined, uint16_t port, const config& cfg) {
+  std::vector<double> xs;
+  xs.reserve(cfg.jobs);
+  for (size_t i = 0; i < cfg.jobs; ++i)
+    if (auto x = run_job(cfg, port, pipelined); x >= 0)
+      xs.emplace_back(x);
+  if (xs.empty())
+    return;
+  // The first pipelined job fills the cache and only later jobs benefit.
+  auto first = xs.front();
+  std::sort(xs.begin(), xs.end());
+  auto percentile = [&](double p) {
+    auto index = static_cast<size_t>(p * static_cast<double>(xs.size() - 1));
+    return xs[index];
+  };
+  cout << name << ":" << endl
+       << "  connect to first reply: first = " << first
+       << "us, p50 = " << percentile(0.5) << "us, p99 = " << percentile(0.99)
+       << "us" << endl;
+}
+
+} // namespace
+
+void caf_main(actor_system& sys, const config& cfg) {
+  auto port = sys.middleman().publish(sys.spawn(server), 0);
+  if (!port) {
+    cerr << "*** publish failed: " << to_string(port.error()) << endl;
+    return;
+  }
+  std::remove(cfg.cache_file.c_str());
+  run("regular handshake", false, *port, cfg);
+  run("pipelined handshake", true, *port, cfg);
+  std::remove(cfg.cache_file.c_str());
+}
+
+CAF_MAIN(io::middleman)
@@ -0,0 +1,127 @@
+// This program measures how well the proxy registry scales when multiple
+// threads resolve handles to remote actors concurrently, as BASP workers do
+// when deserializing messages that contain actor handles. Each thread calls
+// `get_or_put` for random actors on a set of remote nodes.
+//
+// Run with default settings:
+// - proxy_registry_contention
+//
+// Compare different numbers of threads, e.g.:
+// - proxy_registry_contention --threads=1
+// - proxy_registry_contention --threads=8
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "caf/actor_proxy.hpp"
+#include "caf/all.hpp"
+#include "caf/make_actor.hpp"
+#include "caf/proxy_registry.hpp"
+
+using std::cerr;
+using std::cout;
+using std::endl;
+
+using namespace caf;
+
+namespace {
+
+struct config : actor_system_config {
+  config() {
+    opt_group{custom_options_, "global"}
+      .add(threads, "threads,t", "number of threads resolving handles")
+      .add(lookups, "lookups,n", "number of lookups per thread")
+      .add(nodes, "nodes", "number of remote nodes")
+      .add(actors, "actors,a", "number of remote actors per node");
+  }
+  size_t threads = 4;
+  size_t lookups = 1'000'000;
+  size_t nodes = 4;
+  size_t actors = 10'000;
+};
+
+class dummy_proxy : public actor_proxy {
+public:
+  explicit dummy_proxy(actor_config& cfg) : actor_proxy(cfg) {
+    // nop
+  }
+
+  void enqueue(mailbox_element_ptr, execution_unit*) override {
+    // nop
+  }
+
+  void kill_proxy(execution_unit*, error) override {
+    // nop
+  }
+};
+
+class dummy_backend : public proxy_registry::backend {
+public:
+  explicit dummy_backend(actor_system& sys) : sys_(sys) {
+    // nop
+  }
+
+  strong_actor_ptr make_proxy(node_id nid, actor_id aid) override {
+    actor_config cfg;
+    return make_actor<dummy_proxy, strong_actor_ptr>(aid, nid, &sys_, cfg);
+  }
+
+  void set_last_hop(node_id*) override {
+    // nop
+  }
+
+private:
+  actor_system& sys_;
+};
+
+} // namespace
+
+void caf_main(actor_system& sys, const config& cfg) {
+  if (cfg.threads == 0 || cfg.nodes == 0 || cfg.actors == 0) {
+    cerr << "*** threads, nodes and actors must be positive" << endl;
+    return;
+  }
+  dummy_backend backend{sys};
+  proxy_registry proxies{sys, backend};
+  hashed_node_id::host_id_type host;
+  host.fill(0xAB);
+  std::vector<node_id> nodes;
+  for (size_t i = 0; i < cfg.nodes; ++i)
+    nodes.emplace_back(make_node_id(static_cast<uint32_t>(i + 1), host));
+  // Start from a warm registry, i.e., measure lookups instead of creation.
+  for (auto& nid : nodes)
+    for (actor_id aid = 1; aid <= cfg.actors; ++aid)
+      proxies.get_or_put(nid, aid);
+  std::atomic<bool> go{false};
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < cfg.threads; ++i)
+    threads.emplace_back([&, i] {
+      std::minstd_rand rng{static_cast<uint32_t>(i)};
+      std::uniform_int_distribution<size_t> node_dist{0, cfg.nodes - 1};
+      std::uniform_int_distribution<actor_id> actor_dist{1, cfg.actors};
+      while (!go)
+        std::this_thread::yield();
+      for (size_t j = 0; j < cfg.lookups; ++j)
+        proxies.get_or_put(nodes[node_dist(rng)], actor_dist(rng));
+    });
+  using clock = std::chrono::steady_clock;
+  auto t0 = clock::now();
+  go = true;
+  for (auto& t : threads)
+    t.join();
+  auto t1 = clock::now();
+  auto secs = std::chrono::duration<double>(t1 - t0).count();
+  auto total = static_cast<double>(cfg.threads * cfg.lookups);
+  cout << cfg.threads << " threads resolved " << total << " handles in "
+       << secs << "s" << endl
+       << "throughput: " << (total / secs) << " lookups/s, "
+       << (total / secs / cfg.threads) << " lookups/s per thread" << endl;
+}
+
+CAF_MAIN()
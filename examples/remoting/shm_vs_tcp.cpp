@@ -0,0 +1,136 @@
+// This program compares the shared memory transport for nodes on the same
+// host against loopback TCP. For each transport, it starts two actor systems
+// in the same process, measures the round-trip time of a ping-pong exchange
+// between them and the throughput of a one-way stream of messages.
+//
+// Run with default settings:
+// - shm_vs_tcp
+//
+// Use larger messages to measure raw bandwidth, e.g.:
+// - shm_vs_tcp --payload-size=65536 --messages=10000
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "caf/all.hpp"
+#include "caf/io/all.hpp"
+
+using std::cerr;
+using std::cout;
+using std::endl;
+
+using namespace caf;
+
+namespace {
+
+struct config : actor_system_config {
+  config() {
+    opt_group{custom_options_, "global"}
+      .add(round_trips, "round-trips,r", "number of ping-pong round trips")
+      .add(messages, "messages,n", "number of messages for the throughput")
+      .add(payload_size, "payload-size,s", "size of each message in bytes");
+  }
+  size_t round_trips = 10'000;
+  size_t messages = 100'000;
+  size_t payload_size = 64;
+};
+
+using clock_type = std::chrono::steady_clock;
+
+behavior server(event_based_actor*) {
+  auto received = std::make_shared<size_t>(0);
+  return {
+    [](ping_atom) { return pong_atom_v; },
+    [=](const std::string&) { ++*received; },
+    [=](get_atom) {
+      auto result = *received;
+      *received = 0;
+      return result;
+    },
+  };
+}
+
+void run(const char* name, bool shm, const config& cfg) {
+  auto make_cfg = [&](actor_system_config& x) {
+    x.content = cfg.content;
+    put(x.content, "caf.middleman.shared-memory", shm);
+    x.load<io::middleman>();
+  };
+  actor_system_config server_cfg;
+  make_cfg(server_cfg);
+  actor_system server_sys{server_cfg};
+  actor_system_config client_cfg;
+  make_cfg(client_cfg);
+  actor_system client_sys{client_cfg};
+  auto port = server_sys.middleman().publish(server_sys.spawn(server), 0);
+  if (!port) {
+    cerr << "*** publish failed: " << to_string(port.error()) << endl;
+    return;
+  }
+  auto dst = client_sys.middleman().remote_actor("localhost", *port);
+  if (!dst) {
+    cerr << "*** remote_actor failed: " << to_string(dst.error()) << endl;
+    return;
+  }
+  scoped_actor self{client_sys};
+  // Latency: one message in flight at any time.
+  std::vector<double> rtts;
+  rtts.reserve(cfg.round_trips);
+  for (size_t i = 0; i < cfg.round_trips; ++i) {
+    auto t0 = clock_type::now();
+    self->request(*dst, infinite, ping_atom_v)
+      .receive([](pong_atom) {},
+               [&](const error& err) {
+                 cerr << "*** ping failed: " << to_string(err) << endl;
+               });
+    auto t1 = clock_type::now();
+    rtts.emplace_back(std::chrono::duration<double, std::micro>(t1 - t0)
+                        .count());
+  }
+  std::sort(rtts.begin(), rtts.end());
+  auto percentile = [&](double p) {
+    if (rtts.empty())
+      return 0.0;
+    auto index = static_cast<size_t>(p * static_cast<double>(rtts.size() - 1));
+    return rtts[index];
+  };
+  // Throughput: send all messages, then wait for the confirmation. BASP only
+  // preserves the order of messages from the same sender, so the same actor
+  // sends the messages and asks for the count.
+  auto payload = std::string(cfg.payload_size, 'x');
+  auto t0 = clock_type::now();
+  for (size_t i = 0; i < cfg.messages; ++i)
+    self->send(*dst, payload);
+  self->request(*dst, infinite, get_atom_v)
+    .receive(
+      [&](size_t n) {
+        if (n != cfg.messages)
+          cerr << "*** expected " << cfg.messages << " messages, got " << n
+               << endl;
+      },
+      [&](const error& err) {
+        cerr << "*** request failed: " << to_string(err) << endl;
+      });
+  auto t1 = clock_type::now();
+  auto secs = std::chrono::duration<double>(t1 - t0).count();
+  auto msgs = static_cast<double>(cfg.messages);
+  cout << name << ":" << endl
+       << "  round trip: p50 = " << percentile(0.5)
+       << "us, p99 = " << percentile(0.99) << "us" << endl
+       << "  throughput: " << (msgs / secs) << " msg/s, "
+       << (msgs * cfg.payload_size / secs / 1'000'000) << " MB/s" << endl;
+  anon_send_exit(*dst, exit_reason::user_shutdown);
+}
+
+} // namespace
+
+void caf_main(actor_system&, const config& cfg) {
+  run("loopback TCP", false, cfg);
+  run("shared memory", true, cfg);
+}
+
+CAF_MAIN(io::middleman)
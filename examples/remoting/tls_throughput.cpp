@@ -0,0 +1,140 @@
+// This program measures the throughput of BASP over a loopback connection with
+// plain TCP, with TLS and with TLS in the kernel (kTLS). Each mode runs two
+// actor systems in the same process. The sender transmits a batch of messages
+// from a single message handler and waits for the receiver to confirm the
+// batch.
+//
+// Run with default settings:
+// - tls_throughput
+//
+// kTLS requires Linux, OpenSSL 3 and the kernel module 'tls' (modprobe tls).
+// Without kernel support, the kTLS mode falls back to regular TLS. The file
+// /proc/net/tls_stat shows whether the kernel encrypts any connections.
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+#include "caf/all.hpp"
+#include "caf/io/all.hpp"
+#include "caf/openssl/all.hpp"
+
+using std::cerr;
+using std::cout;
+using std::endl;
+
+using namespace caf;
+
+namespace {
+
+struct config : actor_system_config {
+  config() {
+    opt_group{custom_options_, "global"}
+      .add(batches, "batches,b", "number of batches to send")
+      .add(batch_size, "batch-size,n", "number of messages per batch")
+      .add(payload_size, "payload-size,s", "size of each message in bytes");
+  }
+  size_t batches = 10;
+  size_t batch_size = 1'000;
+  size_t payload_size = 16'384;
+};
+
+behavior receiver(event_based_actor*) {
+  auto received = std::make_shared<size_t>(0);
+  return {
+    [=](const std::string&) { ++*received; },
+    [=](get_atom) {
+      auto result = *received;
+      *received = 0;
+      return result;
+    },
+  };
+}
+
+enum class mode { tcp, tls, ktls };
+
+expected<actor>
+connect(actor_system& server_sys, actor_system& client_sys, mode m) {
+  auto hdl = server_sys.spawn(receiver);
+  if (m == mode::tcp) {
+    auto port = server_sys.middleman().publish(hdl, 0, "127.0.0.1");
+    if (!port)
+      return std::move(port.error());
+    return client_sys.middleman().remote_actor("127.0.0.1", *port);
+  }
+  auto port = openssl::publish(hdl, 0, "127.0.0.1");
+  if (!port)
+    return std::move(port.error());
+  return openssl::remote_actor(client_sys, "127.0.0.1", *port);
+}
+
+void run(const char* name, mode m, const config& cfg) {
+  // Both systems share the same settings.
+  auto make_cfg = [&](actor_system_config& x) {
+    x.content = cfg.content;
+    put(x.content, "caf.openssl.ktls", m == mode::ktls);
+    x.load<io::middleman>();
+    if (m != mode::tcp)
+      x.load<openssl::manager>();
+  };
+  actor_system_config server_cfg;
+  make_cfg(server_cfg);
+  actor_system server_sys{server_cfg};
+  actor_system_config client_cfg;
+  make_cfg(client_cfg);
+  actor_system client_sys{client_cfg};
+  auto dst = connect(server_sys, client_sys, m);
+  if (!dst) {
+    cerr << "*** " << name << ": connect failed: " << to_string(dst.error())
+         << endl;
+    return;
+  }
+  auto payload = std::string(cfg.payload_size, 'x');
+  auto batch_size = cfg.batch_size;
+  auto sender = client_sys.spawn([=](event_based_actor* self) -> behavior {
+    return {
+      [=](ok_atom) {
+        for (size_t i = 0; i < batch_size; ++i)
+          self->send(*dst, payload);
+        auto rp = self->make_response_promise<size_t>();
+        self->request(*dst, infinite, get_atom_v).then([=](size_t n) mutable {
+          rp.deliver(n);
+        });
+        return rp;
+      },
+    };
+  });
+  scoped_actor self{client_sys};
+  using clock = std::chrono::steady_clock;
+  auto t0 = clock::now();
+  for (size_t i = 0; i < cfg.batches; ++i) {
+    self->request(sender, infinite, ok_atom_v)
+      .receive(
+        [&](size_t n) {
+          if (n != cfg.batch_size)
+            cerr << "*** expected " << cfg.batch_size << " messages, got " << n
+                 << endl;
+        },
+        [&](const error& err) {
+          cerr << "*** request failed: " << to_string(err) << endl;
+        });
+  }
+  auto t1 = clock::now();
+  auto secs = std::chrono::duration<double>(t1 - t0).count();
+  auto msgs = static_cast<double>(cfg.batches * cfg.batch_size);
+  cout << name << ": " << (msgs * cfg.payload_size / secs / 1'000'000)
+       << " MB/s (" << (msgs / secs) << " msg/s)" << endl;
+  anon_send_exit(sender, exit_reason::user_shutdown);
+  anon_send_exit(*dst, exit_reason::user_shutdown);
+}
+
+} // namespace
+
+void caf_main(actor_system&, const config& cfg) {
+  run("tcp", mode::tcp, cfg);
+  run("tls", mode::tls, cfg);
+  run("ktls", mode::ktls, cfg);
+}
+
+CAF_MAIN(io::middleman)
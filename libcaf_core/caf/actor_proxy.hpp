@@ -6,6 +6,7 @@
 
 #include <atomic>
 #include <cstdint>
+#include <vector>
 
 #include "caf/abstract_actor.hpp"
 #include "caf/detail/core_export.hpp"
@@ -25,6 +26,11 @@ public:
   /// Invokes cleanup code.
   virtual void kill_proxy(execution_unit* ctx, error reason) = 0;
 
+  /// Removes all monitors from this proxy and returns their observers. Allows
+  /// the runtime to notify each observer once for many proxies instead of
+  /// sending one `down_msg` per proxy.
+  std::vector<actor_addr> take_monitors();
+
   void setup_metrics() {
     // nop
   }
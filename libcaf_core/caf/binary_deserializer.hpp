@@ -44,6 +44,11 @@ public:
     reset(as_bytes(make_span(input)));
   }
 
+  /// Reads from `input`. Loading a `shared_bytes` from this deserializer
+  /// produces a view into `input` instead of copying the bytes.
+  /// @warning `input` must outlive the deserializer.
+  binary_deserializer(execution_unit* ctx, const shared_bytes& input) noexcept;
+
   binary_deserializer(execution_unit* ctx, const void* buf,
                       size_t size) noexcept
     : binary_deserializer(ctx,
@@ -91,6 +96,12 @@ public:
     return end_;
   }
 
+  /// Returns the `shared_bytes` that holds the input or `nullptr` if the input
+  /// is a plain memory block.
+  const shared_bytes* shared_input() const noexcept {
+    return shared_input_;
+  }
+
   static constexpr bool has_human_readable_format() noexcept {
     return false;
   }
@@ -216,6 +227,9 @@ private:
 
   /// Provides access to the ::proxy_registry and to the ::actor_system.
   execution_unit* context_;
+
+  /// Holds the input if constructed from a `shared_bytes`.
+  const shared_bytes* shared_input_ = nullptr;
 };
 
 } // namespace caf
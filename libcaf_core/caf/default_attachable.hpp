@@ -24,6 +24,14 @@ public:
 
   bool matches(const token& what) override;
 
+  const actor_addr& observer() const noexcept {
+    return observer_;
+  }
+
+  observe_type type() const noexcept {
+    return type_;
+  }
+
   static attachable_ptr
   make_monitor(actor_addr observed, actor_addr observer,
                message_priority prio = message_priority::normal) {
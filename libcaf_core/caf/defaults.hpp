@@ -117,4 +117,108 @@ constexpr auto heartbeat_interval = size_t{0};
 constexpr auto cached_udp_buffers = size_t{10};
 constexpr auto max_pending_msgs = size_t{10};
 
+/// Number of Bytes in the write buffer of a BASP connection that causes the
+/// broker to flush the buffer immediately instead of at the end of its current
+/// activation. A value of 0 disables write coalescing.
+constexpr auto flush_threshold = size_t{64 * 1024}; // 64 KB
+
+/// Maximum time the BASP broker delays flushing a write buffer while it keeps
+/// processing messages. A value of 0 only flushes once per activation.
+constexpr auto max_flush_delay = timespan{1'000'000}; // 1ms
+
+/// Maximum number of Bytes per fragment when splitting large BASP messages.
+/// Fragmentation only takes place if both nodes enable it. A value of 0
+/// disables fragmentation.
+constexpr auto max_fragment_size = size_t{0};
+
+/// Configures whether BASP writes urgent messages ahead of other messages once
+/// the write buffer of a connection holds `flush_threshold` Bytes.
+constexpr auto priority_lanes = false;
+
+/// Number of pending Bytes on a BASP connection that causes proxies for actors
+/// on the remote node to apply the `write_buffer_overflow_policy`. A value of 0
+/// disables the limit.
+constexpr auto write_buffer_high_watermark = size_t{0};
+
+/// Number of pending Bytes on a BASP connection that ends the overflow state.
+/// A value of 0 selects half of the high watermark.
+constexpr auto write_buffer_low_watermark = size_t{0};
+
+/// Configures how proxies treat messages to a node with too many pending
+/// Bytes: "drop" discards them, "error" discards them and answers requests
+/// with an error, and "hold" blocks the sender until the connection drains.
+constexpr auto write_buffer_overflow_policy = string_view{"error"};
+
+/// Configures whether proxies serialize messages on the sending thread instead
+/// of leaving the serialization to the BASP broker.
+constexpr auto serialize_on_send = false;
+
+/// Number of TCP connections that BASP opens to each remote node. Additional
+/// connections carry messages of different senders in parallel.
+constexpr auto connections_per_peer = size_t{1};
+
+/// Configures whether BASP connects to nodes on the same host via shared
+/// memory instead of loopback TCP. Requires Linux.
+constexpr auto shared_memory = false;
+
+/// Directory for the Unix domain sockets that nodes use for exchanging shared
+/// memory segments. An empty string selects `$XDG_RUNTIME_DIR/caf` or
+/// `/tmp/caf-<uid>`.
+constexpr auto shared_memory_dir = string_view{""};
+
+/// Number of Bytes per direction in the shared memory segment of a connection.
+constexpr auto shared_memory_ring_size = size_t{1024 * 1024}; // 1 MB
+
+/// Configures whether clients start sending messages right after their
+/// handshake when connecting to a known server instead of waiting for the
+/// server handshake.
+constexpr auto pipelined_handshake = false;
+
+/// Number of threads for resolving host names when connecting to other nodes.
+constexpr auto resolver_threads = size_t{2};
+
+/// Time the middleman keeps the addresses of a host name before resolving the
+/// name again.
+constexpr auto resolver_cache_ttl = timespan{30'000'000'000}; // 30s
+
+/// Time the middleman waits for a connection attempt to succeed before trying
+/// the next address of a host in parallel ("Happy Eyeballs", RFC 8305).
+constexpr auto connection_attempt_delay = timespan{250'000'000}; // 250ms
+
+/// Configures where brokers run: "multiplexer" runs them in the event loop of
+/// the multiplexer and "scheduler" runs them on the workers of the scheduler.
+constexpr auto broker_execution = string_view{"multiplexer"};
+
+/// Time the multiplexer keeps polling without blocking before it waits for
+/// events in the kernel. Zero disables busy polling.
+constexpr auto busy_poll_duration = timespan{0};
+
+/// Configures `SO_BUSY_POLL` for TCP sockets, i.e., the time the kernel polls
+/// the device queue on a blocking receive. Zero leaves the option unset.
+constexpr auto socket_busy_poll = timespan{0};
+
+/// Configures whether streams read as much data as available into an adaptive
+/// buffer and pass multiple frames to brokers per read.
+constexpr auto adaptive_reads = false;
+
+/// Configures whether the middleman collects metrics per connection and per
+/// message type.
+constexpr auto connection_metrics = false;
+
+/// Configures whether actors that monitored proxies for a lost node receive a
+/// single `proxies_down_msg` instead of one `down_msg` per proxy.
+constexpr auto aggregate_down_messages = false;
+
 } // namespace caf::defaults::middleman
+
+namespace caf::defaults::openssl {
+
+/// Configures whether the OpenSSL module hands record encryption to the kernel
+/// after the TLS handshake (kTLS) if the system supports it.
+constexpr auto ktls = false;
+
+/// Configures whether the OpenSSL module runs TLS handshakes on scheduler
+/// workers instead of the multiplexer thread.
+constexpr auto offload_handshakes = true;
+
+} // namespace caf::defaults::openssl
@@ -0,0 +1,49 @@
+// This file is part of CAF, the C++ Actor Framework. See the file LICENSE in
+// the main distribution directory for license terms and copyright or visit
+// https://github.com/actor-framework/actor-framework/blob/master/LICENSE.
+
+#pragma once
+
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+#include "caf/byte_buffer.hpp"
+#include "caf/detail/core_export.hpp"
+#include "caf/intrusive_ptr.hpp"
+#include "caf/ref_counted.hpp"
+
+namespace caf::detail {
+
+/// A thread-safe pool for recycling byte buffers. Threads that serialize
+/// messages take buffers from the pool and the consumer of the serialized
+/// messages puts them back, which avoids allocating a fresh buffer per message.
+class CAF_CORE_EXPORT byte_buffer_pool : public ref_counted {
+public:
+  /// @param max_buffers Maximum number of idle buffers in the pool.
+  /// @param max_capacity Maximum capacity of buffers in the pool. The pool
+  ///                     releases larger buffers to avoid hoarding memory.
+  byte_buffer_pool(size_t max_buffers, size_t max_capacity);
+
+  ~byte_buffer_pool() override;
+
+  /// Returns an empty buffer, reusing an idle buffer if possible.
+  byte_buffer take();
+
+  /// Clears `buf` and stores it for later use if the pool has room for it.
+  void put_back(byte_buffer&& buf);
+
+  /// Returns the number of idle buffers.
+  size_t size() const;
+
+private:
+  size_t max_buffers_;
+  size_t max_capacity_;
+  mutable std::mutex mtx_;
+  std::vector<byte_buffer> buffers_;
+};
+
+/// @relates byte_buffer_pool
+using byte_buffer_pool_ptr = intrusive_ptr<byte_buffer_pool>;
+
+} // namespace caf::detail
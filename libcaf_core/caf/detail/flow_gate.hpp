@@ -0,0 +1,73 @@
+// This file is part of CAF, the C++ Actor Framework. See the file LICENSE in
+// the main distribution directory for license terms and copyright or visit
+// https://github.com/actor-framework/actor-framework/blob/master/LICENSE.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "caf/detail/core_export.hpp"
+#include "caf/intrusive_ptr.hpp"
+#include "caf/ref_counted.hpp"
+
+namespace caf::detail {
+
+/// Throttles messages to the proxies of a remote node while the connection to
+/// that node cannot keep up. The broker that owns the connection closes the
+/// gate once too many bytes wait for the network and opens it again after the
+/// connection drained. All proxies of the node share the same gate.
+class CAF_CORE_EXPORT flow_gate : public ref_counted {
+public:
+  /// Configures what happens to messages while the gate is closed.
+  enum policy_type {
+    /// Proxies silently drop messages.
+    drop_messages,
+    /// Proxies drop messages and answer requests with an error.
+    reject_messages,
+    /// Proxies block the sending thread until the gate opens again.
+    hold_senders,
+  };
+
+  /// @param policy Configures how proxies respond to a closed gate.
+  /// @param io_thread Identifies the thread that drains the connection. This
+  ///                  thread never blocks on the gate.
+  flow_gate(policy_type policy, std::thread::id io_thread);
+
+  ~flow_gate() override;
+
+  /// Returns the configured policy.
+  policy_type policy() const noexcept {
+    return policy_;
+  }
+
+  /// Returns whether the gate currently lets messages through.
+  bool is_open() const noexcept {
+    return open_.load(std::memory_order_acquire);
+  }
+
+  /// Lets messages through again and wakes up all waiting senders.
+  void open();
+
+  /// Stops letting messages through.
+  void close();
+
+  /// Blocks the calling thread until the gate opens. Returns immediately when
+  /// called from the I/O thread, because only the I/O thread can drain the
+  /// connection and thus open the gate.
+  void await_open();
+
+private:
+  policy_type policy_;
+  std::thread::id io_thread_;
+  std::atomic<bool> open_;
+  std::mutex mtx_;
+  std::condition_variable cv_;
+};
+
+/// @relates flow_gate
+using flow_gate_ptr = intrusive_ptr<flow_gate>;
+
+} // namespace caf::detail
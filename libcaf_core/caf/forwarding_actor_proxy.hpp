@@ -6,7 +6,9 @@
 
 #include "caf/actor.hpp"
 #include "caf/actor_proxy.hpp"
+#include "caf/detail/byte_buffer_pool.hpp"
 #include "caf/detail/core_export.hpp"
+#include "caf/detail/flow_gate.hpp"
 #include "caf/detail/shared_spinlock.hpp"
 
 namespace caf {
@@ -18,6 +20,19 @@ public:
 
   forwarding_actor_proxy(actor_config& cfg, actor dest);
 
+  /// Creates a proxy that applies the policy of `gate` to all messages while
+  /// the gate is closed. Passing a `pool` makes the proxy serialize messages
+  /// on the sending thread into buffers from the pool. The proxy then forwards
+  /// the serialized messages as `byte_buffer` to the manager. Passing
+  /// `serialization_time` makes the proxy sample the time for serializing
+  /// each message and passing `serialization_time_by_type` additionally
+  /// samples the time per message, labeled by the types of the content.
+  forwarding_actor_proxy(
+    actor_config& cfg, actor dest, detail::flow_gate_ptr gate,
+    detail::byte_buffer_pool_ptr pool = nullptr,
+    telemetry::dbl_histogram* serialization_time = nullptr,
+    telemetry::dbl_histogram_family* serialization_time_by_type = nullptr);
+
   ~forwarding_actor_proxy() override;
 
   void enqueue(mailbox_element_ptr what, execution_unit* context) override;
@@ -32,8 +47,26 @@ private:
   void forward_msg(strong_actor_ptr sender, message_id mid, message msg,
                    const forwarding_stack* fwd = nullptr);
 
+  /// Serializes `msg` on the calling thread and forwards the bytes.
+  void forward_serialized(strong_actor_ptr sender, message_id mid,
+                          const message& msg, const forwarding_stack& fwd);
+
+  /// Applies the policy of the gate. Returns `false` if the proxy must not
+  /// forward `what`.
+  bool pass_gate(mailbox_element& what, execution_unit* context);
+
+  /// Sends an error to the sender of `mid` if it is a request.
+  void bounce(const strong_actor_ptr& sender, message_id mid);
+
+  /// Returns the histogram for serializing `msg` or `nullptr`.
+  telemetry::dbl_histogram* serialization_time_of(const message& msg);
+
   mutable detail::shared_spinlock broker_mtx_;
   actor broker_;
+  detail::flow_gate_ptr gate_;
+  detail::byte_buffer_pool_ptr pool_;
+  telemetry::dbl_histogram* serialization_time_ = nullptr;
+  telemetry::dbl_histogram_family* serialization_time_by_type_ = nullptr;
 };
 
 } // namespace caf
@@ -124,6 +124,7 @@ class resumable;
 class scheduled_actor;
 class scoped_actor;
 class serializer;
+class shared_bytes;
 class skip_t;
 class stream_manager;
 class string_view;
@@ -155,6 +156,7 @@ struct node_down_msg;
 struct none_t;
 struct open_stream_msg;
 struct prohibit_top_level_spawn_marker;
+struct proxies_down_msg;
 struct stream_slots;
 struct timeout_msg;
 struct unit_t;
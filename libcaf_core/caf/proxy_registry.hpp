@@ -4,26 +4,38 @@
 
 #pragma once
 
+#include <array>
 #include <functional>
 #include <map>
-#include <mutex>
+#include <shared_mutex>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
 #include "caf/actor_addr.hpp"
 #include "caf/actor_cast.hpp"
 #include "caf/actor_proxy.hpp"
+#include "caf/config.hpp"
 #include "caf/detail/core_export.hpp"
 #include "caf/exit_reason.hpp"
 #include "caf/fwd.hpp"
 #include "caf/node_id.hpp"
+#include "caf/timespan.hpp"
 
 namespace caf {
 
 /// Groups a (distributed) set of actors and allows actors
 /// in the same namespace to exchange messages.
+///
+/// The registry distributes its proxies over `num_shards` independently locked
+/// shards by hashing node ID and actor ID. Lookups of existing proxies only
+/// acquire a shared lock on a single shard. Hence, BASP workers deserializing
+/// actor handles rarely contend with each other.
 class CAF_CORE_EXPORT proxy_registry {
 public:
+  /// Number of independently locked partitions of the registry.
+  static constexpr size_t num_shards = 32;
+
   /// Responsible for creating proxy actors.
   class CAF_CORE_EXPORT backend {
   public:
@@ -74,6 +86,19 @@ public:
   /// Deletes all proxies for `node`.
   void erase(const node_id& nid);
 
+  /// Receives the number of killed proxies and the elapsed time after a
+  /// background teardown completed.
+  using teardown_callback = std::function<void(size_t, timespan)>;
+
+  /// Deletes all proxies for `nid` like `erase(nid)`, but kills the proxies in
+  /// a hidden actor instead of the calling thread. The actor kills proxies in
+  /// small batches to keep the scheduler responsive and calls `f` (if present)
+  /// after killing the last proxy. With `aggregate_monitors`, each observer
+  /// receives a single `proxies_down_msg` for all proxies it monitored instead
+  /// of one `down_msg` per proxy.
+  void erase_async(const node_id& nid, teardown_callback f = nullptr,
+                   bool aggregate_monitors = false);
+
   /// Deletes the proxy with id `aid` for `nid`.
   void erase(const node_id& nid, actor_id aid,
              error rsn = exit_reason::remote_link_unreachable);
@@ -100,13 +125,25 @@ public:
   }
 
 private:
-  /// @pre mtx_ is locked
-  void kill_proxy(strong_actor_ptr&, error);
+  /// Stores a partition of all proxies. Aligning shards to cache lines keeps
+  /// threads that lock different shards from interfering.
+  struct alignas(CAF_CACHE_LINE_SIZE) shard {
+    mutable std::shared_mutex mtx;
+    std::unordered_map<node_id, proxy_map> proxies;
+  };
+
+  /// Returns the shard responsible for the proxy `aid` on `nid`.
+  shard& shard_for(const node_id& nid, actor_id aid);
+
+  /// Returns the shard responsible for the proxy `aid` on `nid`.
+  const shard& shard_for(const node_id& nid, actor_id aid) const;
+
+  /// Removes all proxies for `nid` from the registry.
+  std::vector<proxy_map> take_all(const node_id& nid);
 
   actor_system& system_;
   backend& backend_;
-  mutable std::mutex mtx_;
-  std::unordered_map<node_id, proxy_map> proxies_;
+  std::array<shard, num_shards> shards_;
 };
 
 } // namespace caf
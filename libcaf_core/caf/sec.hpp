@@ -161,6 +161,9 @@ enum class sec : uint8_t {
   no_such_key = 65,
   /// An destroyed a response promise without calling deliver or delegate on it.
   broken_promise,
+  /// A proxy rejected a message because the connection to its node has too
+  /// many pending bytes.
+  outbound_buffer_full,
 };
 // --(rst-sec-end)--
 
@@ -0,0 +1,170 @@
+// This file is part of CAF, the C++ Actor Framework. See the file LICENSE in
+// the main distribution directory for license terms and copyright or visit
+// https://github.com/actor-framework/actor-framework/blob/master/LICENSE.
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <type_traits>
+
+#include "caf/binary_deserializer.hpp"
+#include "caf/byte.hpp"
+#include "caf/byte_buffer.hpp"
+#include "caf/byte_span.hpp"
+#include "caf/detail/comparable.hpp"
+#include "caf/detail/core_export.hpp"
+#include "caf/inspector_access.hpp"
+#include "caf/intrusive_ptr.hpp"
+#include "caf/ref_counted.hpp"
+
+namespace caf {
+
+/// An immutable, reference-counted sequence of bytes. Copying a `shared_bytes`
+/// only increments a reference count. Hence, sending large binary payloads as
+/// `shared_bytes` avoids copying the data whenever CAF copies the message, for
+/// example when sending it to multiple receivers. When serializing, the bytes
+/// go directly from the shared buffer into the output. A `binary_deserializer`
+/// that reads from a `shared_bytes` produces views into that buffer instead of
+/// copying. The binary format is identical to the format of a `byte_buffer`.
+class CAF_CORE_EXPORT shared_bytes : detail::comparable<shared_bytes> {
+public:
+  // -- member types -----------------------------------------------------------
+
+  using value_type = byte;
+
+  using size_type = size_t;
+
+  using const_iterator = const byte*;
+
+  // -- constructors, destructors, and assignment operators --------------------
+
+  shared_bytes() noexcept = default;
+
+  shared_bytes(shared_bytes&& other) noexcept;
+
+  shared_bytes(const shared_bytes&) noexcept = default;
+
+  shared_bytes& operator=(shared_bytes&& other) noexcept;
+
+  shared_bytes& operator=(const shared_bytes&) noexcept = default;
+
+  /// Takes ownership of `buf` without copying its content.
+  explicit shared_bytes(byte_buffer buf);
+
+  /// Copies `bytes` into a new buffer.
+  explicit shared_bytes(const_byte_span bytes);
+
+  // -- properties -------------------------------------------------------------
+
+  /// Returns a pointer to the first byte.
+  const byte* data() const noexcept {
+    return storage_ ? storage_->buf.data() + offset_ : nullptr;
+  }
+
+  /// Returns the number of bytes.
+  size_t size() const noexcept {
+    return size_;
+  }
+
+  /// Returns whether this sequence contains no bytes.
+  bool empty() const noexcept {
+    return size() == 0;
+  }
+
+  /// Returns whether this object is the only owner of the shared buffer.
+  bool unique() const noexcept {
+    return storage_ == nullptr || storage_->unique();
+  }
+
+  /// Returns a read-only view to the bytes.
+  const_byte_span bytes() const noexcept {
+    return {data(), size()};
+  }
+
+  const_iterator begin() const noexcept {
+    return data();
+  }
+
+  const_iterator end() const noexcept {
+    return data() + size();
+  }
+
+  // -- modifiers --------------------------------------------------------------
+
+  /// Returns a view to `len` bytes, starting at `offset`, that shares the
+  /// buffer with this object.
+  /// @pre `offset + len <= size()`
+  shared_bytes slice(size_t offset, size_t len) const noexcept;
+
+  /// Returns the whole underlying buffer if this object is its only owner and
+  /// an empty buffer otherwise. Leaves this object empty.
+  byte_buffer release() noexcept;
+
+  // -- comparison -------------------------------------------------------------
+
+  int compare(const shared_bytes& other) const noexcept;
+
+private:
+  struct storage : ref_counted {
+    explicit storage(byte_buffer x) : buf(std::move(x)) {
+      // nop
+    }
+
+    byte_buffer buf;
+  };
+
+  intrusive_ptr<storage> storage_;
+
+  size_t offset_ = 0;
+
+  size_t size_ = 0;
+};
+
+/// @relates shared_bytes
+CAF_CORE_EXPORT std::string to_string(const shared_bytes& x);
+
+/// @relates shared_bytes
+template <>
+struct inspector_access<shared_bytes> : inspector_access_base<shared_bytes> {
+  template <class Inspector>
+  static bool apply(Inspector& f, shared_bytes& x) {
+    if (f.has_human_readable_format()) {
+      auto get = [&x] { return byte_buffer{x.begin(), x.end()}; };
+      auto set = [&x](byte_buffer buf) {
+        x = shared_bytes{std::move(buf)};
+        return true;
+      };
+      return f.apply(get, set);
+    } else if constexpr (Inspector::is_loading) {
+      size_t size = 0;
+      if (!f.begin_sequence(size))
+        return false;
+      if constexpr (std::is_same<Inspector, binary_deserializer>::value) {
+        // Reject bogus size fields before allocating any memory.
+        if (size > f.remaining()) {
+          f.emplace_error(sec::end_of_stream);
+          return false;
+        }
+        if (auto src = f.shared_input()) {
+          auto offset = static_cast<size_t>(f.current() - src->data());
+          x = src->slice(offset, size);
+          f.skip(size);
+          return f.end_sequence();
+        }
+      }
+      byte_buffer buf;
+      buf.resize(size);
+      if (!f.value(make_span(buf)) || !f.end_sequence())
+        return false;
+      x = shared_bytes{std::move(buf)};
+      return true;
+    } else {
+      return f.begin_sequence(x.size()) //
+             && f.value(x.bytes())      //
+             && f.end_sequence();
+    }
+  }
+};
+
+} // namespace caf
@@ -106,6 +106,40 @@ bool inspect(Inspector& f, node_down_msg& x) {
                             f.field("reason", x.reason));
 }
 
+/// Sent once to each actor that monitored proxies for a node when CAF loses
+/// connection to the node, replacing one `down_msg` per proxy. Only sent if
+/// `caf.middleman.aggregate-down-messages` is enabled.
+struct proxies_down_msg {
+  /// The disconnected node.
+  node_id node;
+
+  /// IDs of all proxies for `node` that the receiver monitored.
+  std::vector<actor_id> actors;
+
+  /// The exit reason of the proxies.
+  error reason;
+};
+
+/// @relates proxies_down_msg
+inline bool operator==(const proxies_down_msg& x,
+                       const proxies_down_msg& y) noexcept {
+  return x.node == y.node && x.actors == y.actors && x.reason == y.reason;
+}
+
+/// @relates proxies_down_msg
+inline bool operator!=(const proxies_down_msg& x,
+                       const proxies_down_msg& y) noexcept {
+  return !(x == y);
+}
+
+/// @relates proxies_down_msg
+template <class Inspector>
+bool inspect(Inspector& f, proxies_down_msg& x) {
+  return f.object(x).fields(f.field("node", x.node),
+                            f.field("actors", x.actors),
+                            f.field("reason", x.reason));
+}
+
 /// Signalizes a timeout event.
 /// @note This message is handled implicitly by the runtime system.
 struct timeout_msg {
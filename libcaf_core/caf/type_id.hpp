@@ -407,6 +407,9 @@ CAF_BEGIN_TYPE_ID_BLOCK(core_module, 0)
   CAF_ADD_ATOM(core_module, caf, unsubscribe_atom)
   CAF_ADD_ATOM(core_module, caf, update_atom)
   CAF_ADD_ATOM(core_module, caf, wait_for_atom)
+  // New types go last to keep the IDs of all other core types stable.
+  CAF_ADD_TYPE_ID(core_module, (caf::shared_bytes))
+  CAF_ADD_TYPE_ID(core_module, (caf::proxies_down_msg))
 
 CAF_END_TYPE_ID_BLOCK(core_module)
 
@@ -414,7 +417,7 @@ namespace caf::detail {
 
 static constexpr type_id_t io_module_begin = id_block::core_module::end;
 
-static constexpr type_id_t io_module_end = io_module_begin + 19;
+static constexpr type_id_t io_module_end = io_module_begin + 20;
 
 static constexpr type_id_t net_module_begin = io_module_end;
 
@@ -4,6 +4,8 @@
 
 #include "caf/actor_proxy.hpp"
 
+#include "caf/default_attachable.hpp"
+
 namespace caf {
 
 actor_proxy::actor_proxy(actor_config& cfg) : monitorable_actor(cfg) {
@@ -14,4 +16,23 @@ actor_proxy::~actor_proxy() {
   // nop
 }
 
+std::vector<actor_addr> actor_proxy::take_monitors() {
+  std::vector<actor_addr> result;
+  exclusive_critical_section([&] {
+    auto i = &attachables_head_;
+    while (*i != nullptr) {
+      auto ptr = dynamic_cast<default_attachable*>(i->get());
+      if (ptr != nullptr && ptr->type() == default_attachable::monitor) {
+        result.emplace_back(ptr->observer());
+        attachable_ptr next;
+        next.swap((*i)->next);
+        (*i).swap(next);
+      } else {
+        i = &((*i)->next);
+      }
+    }
+  });
+  return result;
+}
+
 } // namespace caf
@@ -13,6 +13,7 @@
 #include "caf/detail/network_order.hpp"
 #include "caf/error.hpp"
 #include "caf/sec.hpp"
+#include "caf/shared_bytes.hpp"
 
 namespace caf {
 
@@ -56,6 +57,13 @@ binary_deserializer::binary_deserializer(actor_system& sys) noexcept
   // nop
 }
 
+binary_deserializer::binary_deserializer(execution_unit* ctx,
+                                         const shared_bytes& input) noexcept
+  : context_(ctx) {
+  reset(input.bytes());
+  shared_input_ = &input;
+}
+
 bool binary_deserializer::fetch_next_object_type(type_id_t& type) noexcept {
   type = invalid_type_id;
   emplace_error(sec::unsupported_operation,
@@ -87,6 +95,7 @@ void binary_deserializer::skip(size_t num_bytes) {
 void binary_deserializer::reset(span<const byte> bytes) noexcept {
   current_ = bytes.data();
   end_ = current_ + bytes.size();
+  shared_input_ = nullptr;
 }
 
 bool binary_deserializer::begin_field(string_view, bool& is_present) noexcept {
@@ -0,0 +1,42 @@
+// This file is part of CAF, the C++ Actor Framework. See the file LICENSE in
+// the main distribution directory for license terms and copyright or visit
+// https://github.com/actor-framework/actor-framework/blob/master/LICENSE.
+
+#include "caf/detail/byte_buffer_pool.hpp"
+
+namespace caf::detail {
+
+byte_buffer_pool::byte_buffer_pool(size_t max_buffers, size_t max_capacity)
+  : max_buffers_(max_buffers), max_capacity_(max_capacity) {
+  buffers_.reserve(max_buffers);
+}
+
+byte_buffer_pool::~byte_buffer_pool() {
+  // nop
+}
+
+byte_buffer byte_buffer_pool::take() {
+  byte_buffer result;
+  std::unique_lock<std::mutex> guard{mtx_};
+  if (!buffers_.empty()) {
+    result.swap(buffers_.back());
+    buffers_.pop_back();
+  }
+  return result;
+}
+
+void byte_buffer_pool::put_back(byte_buffer&& buf) {
+  if (buf.capacity() == 0 || buf.capacity() > max_capacity_)
+    return;
+  buf.clear();
+  std::unique_lock<std::mutex> guard{mtx_};
+  if (buffers_.size() < max_buffers_)
+    buffers_.emplace_back(std::move(buf));
+}
+
+size_t byte_buffer_pool::size() const {
+  std::unique_lock<std::mutex> guard{mtx_};
+  return buffers_.size();
+}
+
+} // namespace caf::detail
@@ -0,0 +1,36 @@
+// This file is part of CAF, the C++ Actor Framework. See the file LICENSE in
+// the main distribution directory for license terms and copyright or visit
+// https://github.com/actor-framework/actor-framework/blob/master/LICENSE.
+
+#include "caf/detail/flow_gate.hpp"
+
+namespace caf::detail {
+
+flow_gate::flow_gate(policy_type policy, std::thread::id io_thread)
+  : policy_(policy), io_thread_(io_thread), open_(true) {
+  // nop
+}
+
+flow_gate::~flow_gate() {
+  // nop
+}
+
+void flow_gate::open() {
+  std::unique_lock<std::mutex> guard{mtx_};
+  open_.store(true, std::memory_order_release);
+  cv_.notify_all();
+}
+
+void flow_gate::close() {
+  std::unique_lock<std::mutex> guard{mtx_};
+  open_.store(false, std::memory_order_release);
+}
+
+void flow_gate::await_open() {
+  if (std::this_thread::get_id() == io_thread_)
+    return;
+  std::unique_lock<std::mutex> guard{mtx_};
+  cv_.wait(guard, [this] { return open_.load(std::memory_order_acquire); });
+}
+
+} // namespace caf::detail
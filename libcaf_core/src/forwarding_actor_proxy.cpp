@@ -6,10 +6,20 @@
 
 #include "caf/forwarding_actor_proxy.hpp"
 
+#include "caf/actor_system.hpp"
+#include "caf/binary_serializer.hpp"
+#include "caf/detail/sync_request_bouncer.hpp"
+#include "caf/exit_reason.hpp"
 #include "caf/locks.hpp"
 #include "caf/logger.hpp"
 #include "caf/mailbox_element.hpp"
+#include "caf/sec.hpp"
 #include "caf/send.hpp"
+#include "caf/system_messages.hpp"
+#include "caf/telemetry/counter.hpp"
+#include "caf/telemetry/histogram.hpp"
+#include "caf/telemetry/metric_family_impl.hpp"
+#include "caf/telemetry/timer.hpp"
 
 namespace caf {
 
@@ -18,6 +28,18 @@ forwarding_actor_proxy::forwarding_actor_proxy(actor_config& cfg, actor dest)
   anon_send(broker_, monitor_atom_v, ctrl());
 }
 
+forwarding_actor_proxy::forwarding_actor_proxy(
+  actor_config& cfg, actor dest, detail::flow_gate_ptr gate,
+  detail::byte_buffer_pool_ptr pool,
+  telemetry::dbl_histogram* serialization_time,
+  telemetry::dbl_histogram_family* serialization_time_by_type)
+  : forwarding_actor_proxy(cfg, std::move(dest)) {
+  gate_ = std::move(gate);
+  pool_ = std::move(pool);
+  serialization_time_ = serialization_time;
+  serialization_time_by_type_ = serialization_time_by_type;
+}
+
 forwarding_actor_proxy::~forwarding_actor_proxy() {
   anon_send(broker_, make_message(delete_atom_v, node(), id()));
 }
@@ -38,12 +60,108 @@ void forwarding_actor_proxy::forward_msg(strong_actor_ptr sender,
                                   strong_actor_ptr{ctrl()}, mid,
                                   std::move(msg)),
                      nullptr);
+  else
+    bounce(sender, mid);
+}
+
+void forwarding_actor_proxy::bounce(const strong_actor_ptr& sender,
+                                    message_id mid) {
+  // Requests to a killed proxy would otherwise wait for their timeout.
+  if (mid.is_request()) {
+    detail::sync_request_bouncer srb{exit_reason::remote_link_unreachable};
+    srb(sender, mid);
+  }
+}
+
+bool forwarding_actor_proxy::pass_gate(mailbox_element& what,
+                                       execution_unit* context) {
+  // Never throttle system messages such as exit messages or messages with high
+  // priority.
+  if (what.mid.is_urgent_message() || what.content().match_elements<exit_msg>())
+    return true;
+  switch (gate_->policy()) {
+    case detail::flow_gate::drop_messages:
+      CAF_LOG_DEBUG("drop message to congested node:" << CAF_ARG(what.mid));
+      home_system().base_metrics().rejected_messages->inc();
+      return false;
+    case detail::flow_gate::reject_messages:
+      CAF_LOG_DEBUG("reject message to congested node:" << CAF_ARG(what.mid));
+      home_system().base_metrics().rejected_messages->inc();
+      // Only requests get an error. Sending errors for asynchronous messages
+      // would terminate event-based senders with the default error handler.
+      if (what.sender && what.mid.is_request())
+        what.sender->enqueue(ctrl(), what.mid.response_id(),
+                             make_message(
+                               make_error(sec::outbound_buffer_full)),
+                             context);
+      return false;
+    default:
+      gate_->await_open();
+      return true;
+  }
+}
+
+void forwarding_actor_proxy::forward_serialized(strong_actor_ptr sender,
+                                                message_id mid,
+                                                const message& msg,
+                                                const forwarding_stack& fwd) {
+  CAF_LOG_TRACE(CAF_ARG(id())
+                << CAF_ARG(sender) << CAF_ARG(mid) << CAF_ARG(msg));
+  // Since each sender serializes and enqueues its messages one after another,
+  // the manager still receives them in order.
+  auto buf = pool_->take();
+  binary_serializer sink{home_system(), buf};
+  auto ok = false;
+  { // Lifetime scope of total.
+    telemetry::timer total{serialization_time_};
+    ok = sink.apply(fwd);
+    if (ok) {
+      telemetry::timer t{serialization_time_of(msg)};
+      ok = sink.apply(msg);
+    }
+  }
+  if (!ok) {
+    CAF_LOG_ERROR("unable to serialize message:" << sink.get_error());
+    pool_->put_back(std::move(buf));
+    return;
+  }
+  shared_lock<detail::shared_spinlock> guard(broker_mtx_);
+  if (broker_) {
+    broker_->enqueue(nullptr, make_message_id(),
+                     make_message(forward_atom_v, std::move(sender),
+                                  strong_actor_ptr{ctrl()}, mid,
+                                  std::move(buf)),
+                     nullptr);
+    return;
+  }
+  pool_->put_back(std::move(buf));
+  bounce(sender, mid);
+}
+
+telemetry::dbl_histogram*
+forwarding_actor_proxy::serialization_time_of(const message& msg) {
+  if (serialization_time_by_type_ == nullptr)
+    return nullptr;
+  return serialization_time_by_type_->get_or_add(
+    {{"type", to_string(msg.types())}});
 }
 
 void forwarding_actor_proxy::enqueue(mailbox_element_ptr what,
-                                     execution_unit*) {
+                                     execution_unit* context) {
   CAF_PUSH_AID(0);
   CAF_ASSERT(what);
+  if (gate_ && !gate_->is_open() && !pass_gate(*what, context))
+    return;
+  // Actors may send exit and down messages while holding locks. Serializing
+  // actor handles may lock the same actors, so we leave these messages to the
+  // manager.
+  auto& content = what->payload;
+  if (pool_ != nullptr && !content.match_elements<exit_msg>()
+      && !content.match_elements<down_msg>()) {
+    forward_serialized(std::move(what->sender), what->mid, content,
+                       what->stages);
+    return;
+  }
   forward_msg(std::move(what->sender), what->mid, std::move(what->payload),
               &what->stages);
 }
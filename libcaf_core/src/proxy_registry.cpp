@@ -3,20 +3,98 @@
 // https://github.com/actor-framework/actor-framework/blob/master/LICENSE.
 
 #include <algorithm>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
 #include <utility>
 
 #include "caf/actor_addr.hpp"
 #include "caf/actor_system.hpp"
 #include "caf/deserializer.hpp"
+#include "caf/event_based_actor.hpp"
+#include "caf/hash/fnv.hpp"
 #include "caf/node_id.hpp"
 #include "caf/proxy_registry.hpp"
+#include "caf/send.hpp"
 #include "caf/serializer.hpp"
+#include "caf/system_messages.hpp"
 
 #include "caf/actor_registry.hpp"
 #include "caf/logger.hpp"
 
 namespace caf {
 
+namespace {
+
+using shared_guard = std::shared_lock<std::shared_mutex>;
+
+using exclusive_guard = std::unique_lock<std::shared_mutex>;
+
+void kill_proxy(strong_actor_ptr& ptr, error rsn) {
+  if (!ptr)
+    return;
+  auto pptr = static_cast<actor_proxy*>(actor_cast<abstract_actor*>(ptr));
+  pptr->kill_proxy(nullptr, std::move(rsn));
+}
+
+/// Maximum number of proxies that the teardown actor kills per message.
+constexpr size_t teardown_batch_size = 1000;
+
+struct teardown_state {
+  node_id nid;
+  std::vector<proxy_registry::proxy_map> pending;
+  size_t killed = 0;
+  std::chrono::steady_clock::time_point start;
+  proxy_registry::teardown_callback done;
+  bool aggregate_monitors = false;
+  std::unordered_map<actor_addr, std::vector<actor_id>> monitors;
+};
+
+behavior teardown_actor(event_based_actor* self,
+                        std::shared_ptr<teardown_state> st) {
+  self->send(self, delete_atom_v);
+  return {
+    [self, st](delete_atom) {
+      size_t n = 0;
+      while (!st->pending.empty() && n < teardown_batch_size) {
+        auto& submap = st->pending.back();
+        auto i = submap.begin();
+        if (st->aggregate_monitors && i->second) {
+          auto pptr = static_cast<actor_proxy*>(
+            actor_cast<abstract_actor*>(i->second));
+          for (auto& observer : pptr->take_monitors())
+            st->monitors[observer].emplace_back(i->first);
+        }
+        kill_proxy(i->second, exit_reason::remote_link_unreachable);
+        submap.erase(i);
+        ++n;
+        if (submap.empty())
+          st->pending.pop_back();
+      }
+      st->killed += n;
+      if (!st->pending.empty()) {
+        // Give other actors a chance to run before killing the next batch.
+        self->send(self, delete_atom_v);
+        return;
+      }
+      // Observers receive a single message instead of one down_msg per proxy.
+      for (auto& [observer, ids] : st->monitors) {
+        auto rsn = make_error(exit_reason::remote_link_unreachable);
+        if (auto hdl = actor_cast<actor>(observer))
+          anon_send(hdl, proxies_down_msg{st->nid, std::move(ids), rsn});
+      }
+      if (st->done) {
+        auto elapsed = std::chrono::steady_clock::now() - st->start;
+        st->done(st->killed, std::chrono::duration_cast<timespan>(elapsed));
+      }
+      self->quit();
+    },
+  };
+}
+
+} // namespace
+
 proxy_registry::backend::~backend() {
   // nop
 }
@@ -31,15 +109,21 @@ proxy_registry::~proxy_registry() {
 }
 
 size_t proxy_registry::count_proxies(const node_id& node) const {
-  std::unique_lock<std::mutex> guard{mtx_};
-  auto i = proxies_.find(node);
-  return i != proxies_.end() ? i->second.size() : 0;
+  size_t result = 0;
+  for (auto& x : shards_) {
+    shared_guard guard{x.mtx};
+    auto i = x.proxies.find(node);
+    if (i != x.proxies.end())
+      result += i->second.size();
+  }
+  return result;
 }
 
 strong_actor_ptr proxy_registry::get(const node_id& node, actor_id aid) const {
-  std::unique_lock<std::mutex> guard{mtx_};
-  auto i = proxies_.find(node);
-  if (i == proxies_.end())
+  auto& x = shard_for(node, aid);
+  shared_guard guard{x.mtx};
+  auto i = x.proxies.find(node);
+  if (i == x.proxies.end())
     return nullptr;
   auto j = i->second.find(aid);
   return j != i->second.end() ? j->second : nullptr;
@@ -47,8 +131,20 @@ strong_actor_ptr proxy_registry::get(const node_id& node, actor_id aid) const {
 
 strong_actor_ptr proxy_registry::get_or_put(const node_id& nid, actor_id aid) {
   CAF_LOG_TRACE(CAF_ARG(nid) << CAF_ARG(aid));
-  std::unique_lock<std::mutex> guard{mtx_};
-  auto& result = proxies_[nid][aid];
+  auto& x = shard_for(nid, aid);
+  // Fast path: the proxy already exists.
+  {
+    shared_guard guard{x.mtx};
+    auto i = x.proxies.find(nid);
+    if (i != x.proxies.end()) {
+      auto j = i->second.find(aid);
+      if (j != i->second.end())
+        return j->second;
+    }
+  }
+  // Slow path: create the proxy unless another thread beat us to it.
+  exclusive_guard guard{x.mtx};
+  auto& result = x.proxies[nid][aid];
   if (!result)
     result = backend_.make_proxy(nid, aid);
   return result;
@@ -59,35 +155,48 @@ proxy_registry::get_all(const node_id& node) const {
   // Reserve at least some memory outside of the critical section.
   std::vector<strong_actor_ptr> result;
   result.reserve(128);
-  std::unique_lock<std::mutex> guard{mtx_};
-  auto i = proxies_.find(node);
-  if (i != proxies_.end())
-    for (auto& kvp : i->second)
-      result.emplace_back(kvp.second);
+  for (auto& x : shards_) {
+    shared_guard guard{x.mtx};
+    auto i = x.proxies.find(node);
+    if (i != x.proxies.end())
+      for (auto& kvp : i->second)
+        result.emplace_back(kvp.second);
+  }
   return result;
 }
 
 bool proxy_registry::empty() const {
-  std::unique_lock<std::mutex> guard{mtx_};
-  return proxies_.empty();
+  for (auto& x : shards_) {
+    shared_guard guard{x.mtx};
+    if (!x.proxies.empty())
+      return false;
+  }
+  return true;
 }
 
 void proxy_registry::erase(const node_id& nid) {
   CAF_LOG_TRACE(CAF_ARG(nid));
-  // Move submap for `nid` to a local variable.
-  proxy_map tmp;
-  {
-    using std::swap;
-    std::unique_lock<std::mutex> guard{mtx_};
-    auto i = proxies_.find(nid);
-    if (i == proxies_.end())
-      return;
-    swap(i->second, tmp);
-    proxies_.erase(i);
-  }
   // Call kill_proxy outside the critical section.
-  for (auto& kvp : tmp)
-    kill_proxy(kvp.second, exit_reason::remote_link_unreachable);
+  for (auto& submap : take_all(nid))
+    for (auto& kvp : submap)
+      kill_proxy(kvp.second, exit_reason::remote_link_unreachable);
+}
+
+void proxy_registry::erase_async(const node_id& nid, teardown_callback f,
+                                 bool aggregate_monitors) {
+  CAF_LOG_TRACE(CAF_ARG(nid) << CAF_ARG(aggregate_monitors));
+  auto st = std::make_shared<teardown_state>();
+  st->nid = nid;
+  st->aggregate_monitors = aggregate_monitors;
+  st->start = std::chrono::steady_clock::now();
+  st->pending = take_all(nid);
+  st->done = std::move(f);
+  if (st->pending.empty()) {
+    if (st->done)
+      st->done(0, timespan{0});
+    return;
+  }
+  system_.spawn<hidden>(teardown_actor, std::move(st));
 }
 
 void proxy_registry::erase(const node_id& nid, actor_id aid, error rsn) {
@@ -96,9 +205,10 @@ void proxy_registry::erase(const node_id& nid, actor_id aid, error rsn) {
   strong_actor_ptr erased_proxy;
   {
     using std::swap;
-    std::unique_lock<std::mutex> guard{mtx_};
-    auto i = proxies_.find(nid);
-    if (i != proxies_.end()) {
+    auto& x = shard_for(nid, aid);
+    exclusive_guard guard{x.mtx};
+    auto i = x.proxies.find(nid);
+    if (i != x.proxies.end()) {
       auto& submap = i->second;
       auto j = submap.find(aid);
       if (j == submap.end())
@@ -106,7 +216,7 @@ void proxy_registry::erase(const node_id& nid, actor_id aid, error rsn) {
       swap(j->second, erased_proxy);
       submap.erase(j);
       if (submap.empty())
-        proxies_.erase(i);
+        x.proxies.erase(i);
     }
   }
   // Call kill_proxy outside the critical section.
@@ -116,25 +226,44 @@ void proxy_registry::erase(const node_id& nid, actor_id aid, error rsn) {
 
 void proxy_registry::clear() {
   CAF_LOG_TRACE("");
-  // Move the content of proxies_ to a local variable.
-  std::unordered_map<node_id, proxy_map> tmp;
-  {
-    using std::swap;
-    std::unique_lock<std::mutex> guard{mtx_};
-    swap(proxies_, tmp);
+  // Move the content of all shards to a local variable.
+  std::vector<std::unordered_map<node_id, proxy_map>> tmp;
+  for (auto& x : shards_) {
+    exclusive_guard guard{x.mtx};
+    if (!x.proxies.empty()) {
+      tmp.emplace_back(std::move(x.proxies));
+      x.proxies.clear();
+    }
   }
   // Call kill_proxy outside the critical section.
-  for (auto& kvp : tmp)
-    for (auto& sub_kvp : kvp.second)
-      kill_proxy(sub_kvp.second, exit_reason::remote_link_unreachable);
-  proxies_.clear();
+  for (auto& proxies : tmp)
+    for (auto& kvp : proxies)
+      for (auto& sub_kvp : kvp.second)
+        kill_proxy(sub_kvp.second, exit_reason::remote_link_unreachable);
 }
 
-void proxy_registry::kill_proxy(strong_actor_ptr& ptr, error rsn) {
-  if (!ptr)
-    return;
-  auto pptr = static_cast<actor_proxy*>(actor_cast<abstract_actor*>(ptr));
-  pptr->kill_proxy(nullptr, std::move(rsn));
+proxy_registry::shard& proxy_registry::shard_for(const node_id& nid,
+                                                 actor_id aid) {
+  return shards_[hash::fnv<size_t>::compute(nid, aid) % num_shards];
+}
+
+const proxy_registry::shard&
+proxy_registry::shard_for(const node_id& nid, actor_id aid) const {
+  return shards_[hash::fnv<size_t>::compute(nid, aid) % num_shards];
+}
+
+std::vector<proxy_registry::proxy_map>
+proxy_registry::take_all(const node_id& nid) {
+  std::vector<proxy_map> result;
+  for (auto& x : shards_) {
+    exclusive_guard guard{x.mtx};
+    auto i = x.proxies.find(nid);
+    if (i != x.proxies.end()) {
+      result.emplace_back(std::move(i->second));
+      x.proxies.erase(i);
+    }
+  }
+  return result;
 }
 
 } // namespace caf
@@ -150,6 +150,8 @@ std::string to_string(sec x) {
       return "caf::sec::no_such_key";
     case sec::broken_promise:
       return "caf::sec::broken_promise";
+    case sec::outbound_buffer_full:
+      return "caf::sec::outbound_buffer_full";
   };
 }
 
@@ -355,6 +357,9 @@ bool from_string(string_view in, sec& out) {
   } else if (in == "caf::sec::broken_promise") {
     out = sec::broken_promise;
     return true;
+  } else if (in == "caf::sec::outbound_buffer_full") {
+    out = sec::outbound_buffer_full;
+    return true;
   } else {
     return false;
   }
@@ -433,6 +438,7 @@ bool from_integer(std::underlying_type_t<sec> in,
     case sec::unsupported_operation:
     case sec::no_such_key:
     case sec::broken_promise:
+    case sec::outbound_buffer_full:
       out = result;
       return true;
   };
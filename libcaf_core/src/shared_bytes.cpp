@@ -0,0 +1,87 @@
+// This file is part of CAF, the C++ Actor Framework. See the file LICENSE in
+// the main distribution directory for license terms and copyright or visit
+// https://github.com/actor-framework/actor-framework/blob/master/LICENSE.
+
+#include "caf/shared_bytes.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include "caf/config.hpp"
+#include "caf/detail/append_hex.hpp"
+#include "caf/make_counted.hpp"
+
+namespace caf {
+
+// -- constructors, destructors, and assignment operators ----------------------
+
+shared_bytes::shared_bytes(shared_bytes&& other) noexcept
+  : storage_(std::move(other.storage_)),
+    offset_(other.offset_),
+    size_(other.size_) {
+  other.offset_ = 0;
+  other.size_ = 0;
+}
+
+shared_bytes& shared_bytes::operator=(shared_bytes&& other) noexcept {
+  storage_ = std::move(other.storage_);
+  offset_ = other.offset_;
+  size_ = other.size_;
+  other.offset_ = 0;
+  other.size_ = 0;
+  return *this;
+}
+
+shared_bytes::shared_bytes(byte_buffer buf)
+  : storage_(make_counted<storage>(std::move(buf))) {
+  size_ = storage_->buf.size();
+}
+
+shared_bytes::shared_bytes(const_byte_span bytes)
+  : storage_(make_counted<storage>(byte_buffer{bytes.begin(), bytes.end()})) {
+  size_ = storage_->buf.size();
+}
+
+// -- modifiers ----------------------------------------------------------------
+
+shared_bytes shared_bytes::slice(size_t offset, size_t len) const noexcept {
+  CAF_ASSERT(offset + len <= size_);
+  shared_bytes result;
+  result.storage_ = storage_;
+  result.offset_ = offset_ + offset;
+  result.size_ = len;
+  return result;
+}
+
+byte_buffer shared_bytes::release() noexcept {
+  byte_buffer result;
+  if (storage_ != nullptr && storage_->unique())
+    result.swap(storage_->buf);
+  storage_.reset();
+  offset_ = 0;
+  size_ = 0;
+  return result;
+}
+
+// -- comparison ---------------------------------------------------------------
+
+int shared_bytes::compare(const shared_bytes& other) const noexcept {
+  if (storage_ == other.storage_ && offset_ == other.offset_
+      && size_ == other.size_)
+    return 0;
+  auto n = std::min(size(), other.size());
+  if (n > 0)
+    if (auto res = memcmp(data(), other.data(), n); res != 0)
+      return res;
+  return size() == other.size() ? 0 : (size() < other.size() ? -1 : 1);
+}
+
+// -- free functions -----------------------------------------------------------
+
+std::string to_string(const shared_bytes& x) {
+  std::string result;
+  detail::append_hex(result, x.data(), x.size());
+  return result;
+}
+
+} // namespace caf
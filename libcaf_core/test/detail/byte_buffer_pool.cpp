@@ -0,0 +1,47 @@
+// This file is part of CAF, the C++ Actor Framework. See the file LICENSE in
+// the main distribution directory for license terms and copyright or visit
+// https://github.com/actor-framework/actor-framework/blob/master/LICENSE.
+
+#define CAF_SUITE detail.byte_buffer_pool
+
+#include "caf/detail/byte_buffer_pool.hpp"
+
+#include "caf/test/dsl.hpp"
+
+#include "caf/make_counted.hpp"
+
+using namespace caf;
+
+using detail::byte_buffer_pool;
+
+CAF_TEST(the pool recycles buffers) {
+  auto pool = make_counted<byte_buffer_pool>(2, 1024);
+  auto buf = pool->take();
+  CAF_CHECK(buf.empty());
+  buf.resize(100);
+  auto ptr = buf.data();
+  pool->put_back(std::move(buf));
+  CAF_CHECK_EQUAL(pool->size(), 1u);
+  auto recycled = pool->take();
+  CAF_CHECK(recycled.empty());
+  CAF_CHECK_EQUAL(recycled.data(), ptr);
+  CAF_CHECK_EQUAL(pool->size(), 0u);
+}
+
+CAF_TEST(the pool releases large buffers) {
+  auto pool = make_counted<byte_buffer_pool>(2, 1024);
+  byte_buffer buf;
+  buf.resize(2048);
+  pool->put_back(std::move(buf));
+  CAF_CHECK_EQUAL(pool->size(), 0u);
+}
+
+CAF_TEST(the pool keeps a limited number of buffers) {
+  auto pool = make_counted<byte_buffer_pool>(2, 1024);
+  for (int i = 0; i < 3; ++i) {
+    byte_buffer buf;
+    buf.resize(10);
+    pool->put_back(std::move(buf));
+  }
+  CAF_CHECK_EQUAL(pool->size(), 2u);
+}
@@ -0,0 +1,53 @@
+// This file is part of CAF, the C++ Actor Framework. See the file LICENSE in
+// the main distribution directory for license terms and copyright or visit
+// https://github.com/actor-framework/actor-framework/blob/master/LICENSE.
+
+#define CAF_SUITE detail.flow_gate
+
+#include "caf/detail/flow_gate.hpp"
+
+#include "caf/test/dsl.hpp"
+
+#include <atomic>
+#include <thread>
+
+#include "caf/make_counted.hpp"
+
+using namespace caf;
+
+using detail::flow_gate;
+
+CAF_TEST(gates start open) {
+  auto gate = make_counted<flow_gate>(flow_gate::drop_messages,
+                                      std::thread::id{});
+  CAF_CHECK(gate->is_open());
+  CAF_CHECK_EQUAL(gate->policy(), flow_gate::drop_messages);
+  gate->close();
+  CAF_CHECK(!gate->is_open());
+  gate->open();
+  CAF_CHECK(gate->is_open());
+}
+
+CAF_TEST(await_open blocks until the gate opens) {
+  auto gate = make_counted<flow_gate>(flow_gate::hold_senders,
+                                      std::thread::id{});
+  gate->close();
+  std::atomic<bool> passed{false};
+  std::thread sender{[&] {
+    gate->await_open();
+    passed = true;
+  }};
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  CAF_CHECK(!passed);
+  gate->open();
+  sender.join();
+  CAF_CHECK(passed);
+}
+
+CAF_TEST(await_open never blocks the I/O thread) {
+  auto gate = make_counted<flow_gate>(flow_gate::hold_senders,
+                                      std::this_thread::get_id());
+  gate->close();
+  gate->await_open();
+  CAF_CHECK(!gate->is_open());
+}
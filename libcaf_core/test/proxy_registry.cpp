@@ -0,0 +1,161 @@
+// This file is part of CAF, the C++ Actor Framework. See the file LICENSE in
+// the main distribution directory for license terms and copyright or visit
+// https://github.com/actor-framework/actor-framework/blob/master/LICENSE.
+
+#define CAF_SUITE proxy_registry
+
+#include "caf/proxy_registry.hpp"
+
+#include "core-test.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "caf/actor_proxy.hpp"
+#include "caf/make_actor.hpp"
+
+using namespace caf;
+
+namespace {
+
+std::atomic<size_t> killed_proxies;
+
+class mock_actor_proxy : public actor_proxy {
+public:
+  explicit mock_actor_proxy(actor_config& cfg) : actor_proxy(cfg) {
+    // nop
+  }
+
+  void enqueue(mailbox_element_ptr, execution_unit*) override {
+    // nop
+  }
+
+  void kill_proxy(execution_unit*, error) override {
+    ++killed_proxies;
+  }
+};
+
+class mock_backend : public proxy_registry::backend {
+public:
+  explicit mock_backend(actor_system& sys) : sys_(sys) {
+    // nop
+  }
+
+  strong_actor_ptr make_proxy(node_id nid, actor_id aid) override {
+    ++created_proxies;
+    actor_config cfg;
+    return make_actor<mock_actor_proxy, strong_actor_ptr>(aid, nid, &sys_, cfg);
+  }
+
+  void set_last_hop(node_id*) override {
+    // nop
+  }
+
+  std::atomic<size_t> created_proxies{0};
+
+private:
+  actor_system& sys_;
+};
+
+struct fixture : test_coordinator_fixture<> {
+  mock_backend backend;
+  proxy_registry proxies;
+  node_id alice;
+  node_id bob;
+
+  fixture() : backend(sys), proxies(sys, backend) {
+    killed_proxies = 0;
+    alice = unbox(make_node_id(1, "00112233445566778899AABBCCDDEEFF00112233"));
+    bob = unbox(make_node_id(2, "33221100FFEEDDCCBBAA99887766554433221100"));
+  }
+};
+
+} // namespace
+
+CAF_TEST_FIXTURE_SCOPE(proxy_registry_tests, fixture)
+
+CAF_TEST(get_or_put creates each proxy only once) {
+  CAF_CHECK(proxies.empty());
+  CAF_CHECK_EQUAL(proxies.get(alice, 42), nullptr);
+  auto p1 = proxies.get_or_put(alice, 42);
+  auto p2 = proxies.get_or_put(alice, 42);
+  CAF_CHECK_NOT_EQUAL(p1, nullptr);
+  CAF_CHECK_EQUAL(p1, p2);
+  CAF_CHECK_EQUAL(proxies.get(alice, 42), p1);
+  CAF_CHECK_EQUAL(backend.created_proxies.load(), 1u);
+  CAF_CHECK(!proxies.empty());
+}
+
+CAF_TEST(erasing a node removes all of its proxies) {
+  for (actor_id aid = 1; aid <= 100; ++aid) {
+    proxies.get_or_put(alice, aid);
+    proxies.get_or_put(bob, aid);
+  }
+  CAF_CHECK_EQUAL(proxies.count_proxies(alice), 100u);
+  CAF_CHECK_EQUAL(proxies.get_all(bob).size(), 100u);
+  proxies.erase(alice);
+  CAF_CHECK_EQUAL(killed_proxies.load(), 100u);
+  CAF_CHECK_EQUAL(proxies.count_proxies(alice), 0u);
+  CAF_CHECK_EQUAL(proxies.count_proxies(bob), 100u);
+  proxies.erase(bob, 1);
+  CAF_CHECK_EQUAL(killed_proxies.load(), 101u);
+  CAF_CHECK_EQUAL(proxies.get(bob, 1), nullptr);
+  CAF_CHECK_EQUAL(proxies.count_proxies(bob), 99u);
+  proxies.clear();
+  CAF_CHECK_EQUAL(killed_proxies.load(), 200u);
+  CAF_CHECK(proxies.empty());
+}
+
+CAF_TEST(erase_async kills proxies in the background) {
+  for (actor_id aid = 1; aid <= 2500; ++aid)
+    proxies.get_or_put(alice, aid);
+  proxies.get_or_put(bob, 1);
+  size_t reported = 0;
+  proxies.erase_async(alice, [&](size_t n, timespan) { reported = n; });
+  CAF_CHECK_EQUAL(proxies.count_proxies(alice), 0u);
+  CAF_CHECK_EQUAL(proxies.count_proxies(bob), 1u);
+  CAF_CHECK_EQUAL(killed_proxies.load(), 0u);
+  CAF_CHECK_EQUAL(reported, 0u);
+  sched.run();
+  CAF_CHECK_EQUAL(killed_proxies.load(), 2500u);
+  CAF_CHECK_EQUAL(reported, 2500u);
+}
+
+CAF_TEST(erase_async aggregates monitors per observer) {
+  for (actor_id aid = 1; aid <= 5; ++aid)
+    self->monitor(actor_cast<actor>(proxies.get_or_put(alice, aid)));
+  proxies.get_or_put(alice, 6);
+  proxies.erase_async(alice, nullptr, true);
+  sched.run();
+  CAF_CHECK_EQUAL(killed_proxies.load(), 6u);
+  self->receive(
+    [this](proxies_down_msg& msg) {
+      std::sort(msg.actors.begin(), msg.actors.end());
+      CAF_CHECK_EQUAL(msg.node, alice);
+      CAF_CHECK_EQUAL(msg.actors, std::vector<actor_id>({1, 2, 3, 4, 5}));
+      CAF_CHECK_EQUAL(msg.reason, exit_reason::remote_link_unreachable);
+    },
+    after(std::chrono::seconds(0)) >> [] { CAF_FAIL("no proxies_down_msg"); });
+}
+
+CAF_TEST(concurrent lookups agree on a single proxy per actor) {
+  constexpr size_t num_threads = 4;
+  constexpr actor_id num_actors = 1000;
+  std::vector<std::vector<strong_actor_ptr>> results(num_threads);
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < num_threads; ++i)
+    threads.emplace_back([&, i] {
+      for (actor_id aid = 1; aid <= num_actors; ++aid)
+        results[i].emplace_back(proxies.get_or_put(alice, aid));
+    });
+  for (auto& t : threads)
+    t.join();
+  CAF_CHECK_EQUAL(backend.created_proxies.load(), num_actors);
+  CAF_CHECK_EQUAL(proxies.count_proxies(alice), num_actors);
+  for (size_t i = 1; i < num_threads; ++i)
+    CAF_CHECK_EQUAL(results[i], results[0]);
+}
+
+CAF_TEST_FIXTURE_SCOPE_END()
@@ -0,0 +1,148 @@
+// This file is part of CAF, the C++ Actor Framework. See the file LICENSE in
+// the main distribution directory for license terms and copyright or visit
+// https://github.com/actor-framework/actor-framework/blob/master/LICENSE.
+
+#define CAF_SUITE shared_bytes
+
+#include "caf/shared_bytes.hpp"
+
+#include "core-test.hpp"
+
+#include "caf/binary_deserializer.hpp"
+#include "caf/binary_serializer.hpp"
+#include "caf/byte_buffer.hpp"
+#include "caf/message.hpp"
+
+using namespace caf;
+
+namespace {
+
+byte_buffer make_bytes(size_t n) {
+  byte_buffer result;
+  result.reserve(n);
+  for (size_t i = 0; i < n; ++i)
+    result.emplace_back(static_cast<byte>(i % 256));
+  return result;
+}
+
+struct fixture {
+  template <class T>
+  byte_buffer serialize(const T& x) {
+    byte_buffer buf;
+    binary_serializer sink(nullptr, buf);
+    if (!sink.apply(x))
+      CAF_FAIL("serialization failed: " << sink.get_error());
+    return buf;
+  }
+
+  template <class T>
+  T deserialize(const byte_buffer& buf) {
+    T result;
+    binary_deserializer source(nullptr, buf);
+    if (!source.apply(result))
+      CAF_FAIL("deserialization failed: " << source.get_error());
+    return result;
+  }
+};
+
+} // namespace
+
+CAF_TEST_FIXTURE_SCOPE(shared_bytes_tests, fixture)
+
+CAF_TEST(default constructed shared_bytes are empty) {
+  shared_bytes x;
+  CAF_CHECK(x.empty());
+  CAF_CHECK(x.unique());
+  CAF_CHECK_EQUAL(x.size(), 0u);
+  CAF_CHECK_EQUAL(x.data(), nullptr);
+  CAF_CHECK_EQUAL(x, shared_bytes{byte_buffer{}});
+}
+
+CAF_TEST(shared_bytes take ownership of byte buffers) {
+  auto buf = make_bytes(1024);
+  auto ptr = buf.data();
+  shared_bytes x{std::move(buf)};
+  CAF_CHECK_EQUAL(x.size(), 1024u);
+  CAF_CHECK_EQUAL(x.data(), ptr);
+}
+
+CAF_TEST(copying shared_bytes shares the buffer) {
+  shared_bytes x{make_bytes(1024)};
+  CAF_CHECK(x.unique());
+  auto y = x;
+  CAF_CHECK(!x.unique());
+  CAF_CHECK_EQUAL(x.data(), y.data());
+  CAF_CHECK_EQUAL(x, y);
+  auto msg = make_message(x);
+  auto z = msg.get_as<shared_bytes>(0);
+  CAF_CHECK_EQUAL(z.data(), x.data());
+}
+
+CAF_TEST(shared_bytes compare their content) {
+  auto buf = make_bytes(10);
+  shared_bytes x{buf};
+  shared_bytes y{make_span(buf)};
+  shared_bytes z{make_bytes(11)};
+  CAF_CHECK_NOT_EQUAL(x.data(), y.data());
+  CAF_CHECK_EQUAL(x, y);
+  CAF_CHECK_LESS(x, z);
+  CAF_CHECK_GREATER(z, y);
+}
+
+CAF_TEST(shared_bytes use the binary format of byte buffers) {
+  auto buf = make_bytes(300);
+  shared_bytes x{buf};
+  CAF_CHECK_EQUAL(serialize(x), serialize(buf));
+  CAF_CHECK_EQUAL(deserialize<shared_bytes>(serialize(buf)), x);
+  CAF_CHECK_EQUAL(deserialize<byte_buffer>(serialize(x)), buf);
+}
+
+CAF_TEST(deserializing shared_bytes rejects truncated input) {
+  auto buf = serialize(shared_bytes{make_bytes(100)});
+  buf.resize(50);
+  shared_bytes x;
+  binary_deserializer source(nullptr, buf);
+  CAF_CHECK(!source.apply(x));
+  CAF_CHECK_EQUAL(source.get_error(), sec::end_of_stream);
+}
+
+CAF_TEST(slices share the buffer) {
+  shared_bytes x{make_bytes(100)};
+  auto y = x.slice(10, 20);
+  CAF_CHECK_EQUAL(y.size(), 20u);
+  CAF_CHECK_EQUAL(y.data(), x.data() + 10);
+  CAF_CHECK(!x.unique());
+  CAF_CHECK_EQUAL(y, shared_bytes{make_span(x.data() + 10, 20)});
+  CAF_CHECK_NOT_EQUAL(y, x.slice(10, 21));
+}
+
+CAF_TEST(deserializing from shared_bytes aliases the input) {
+  auto buf = serialize(std::make_tuple(int32_t{42}, make_bytes(100)));
+  shared_bytes input{std::move(buf)};
+  int32_t i = 0;
+  shared_bytes x;
+  binary_deserializer source(nullptr, input);
+  if (CAF_CHECK(source.apply(i) && source.apply(x))) {
+    CAF_CHECK_EQUAL(i, 42);
+    CAF_CHECK_EQUAL(x.size(), 100u);
+    CAF_CHECK_EQUAL(x.data(), input.end() - 100);
+    CAF_CHECK_EQUAL(x, shared_bytes{make_bytes(100)});
+  }
+  CAF_MESSAGE("the input buffer stays alive while slices refer to it");
+  CAF_CHECK(input.release().empty());
+  CAF_CHECK_EQUAL(x, shared_bytes{make_bytes(100)});
+  CAF_MESSAGE("releasing the last owner returns the buffer");
+  auto ptr = x.data();
+  auto whole = x.release();
+  CAF_CHECK_EQUAL(whole.size(), 105u);
+  CAF_CHECK_EQUAL(whole.data() + whole.size() - 100, ptr);
+  CAF_CHECK(x.empty());
+}
+
+CAF_TEST(shared_bytes render as hex strings) {
+  byte_buffer buf{byte{0xCA}, byte{0xFE}};
+  CAF_CHECK_EQUAL(to_string(shared_bytes{buf}), "CAFE");
+  CAF_CHECK_EQUAL(deep_to_string(shared_bytes{buf}), "CAFE");
+}
+
+CAF_TEST_FIXTURE_SCOPE_END()
@@ -4,16 +4,21 @@
 
 #pragma once
 
+#include <deque>
+#include <mutex>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "caf/byte_buffer.hpp"
 #include "caf/detail/io_export.hpp"
+#include "caf/detail/unique_function.hpp"
 #include "caf/io/accept_handle.hpp"
 #include "caf/io/connection_handle.hpp"
 #include "caf/io/datagram_handle.hpp"
 #include "caf/io/fwd.hpp"
 #include "caf/io/network/acceptor_manager.hpp"
+#include "caf/io/network/connection_metrics.hpp"
 #include "caf/io/network/datagram_manager.hpp"
 #include "caf/io/network/ip_endpoint.hpp"
 #include "caf/io/network/native_socket.hpp"
@@ -22,6 +27,8 @@
 #include "caf/io/system_messages.hpp"
 #include "caf/prohibit_top_level_spawn_marker.hpp"
 #include "caf/scheduled_actor.hpp"
+#include "caf/string_view.hpp"
+#include "caf/timespan.hpp"
 
 namespace caf::io {
 
@@ -55,7 +62,13 @@ class middleman;
 /// Each `accept_handle` is associated with a `doorman` that will create
 /// a `new_connection_msg` whenever a new connection was established.
 ///
-/// All `scribe` and `doorman` instances are managed by the `multiplexer`
+/// All `scribe` and `doorman` instances are managed by the `multiplexer`.
+///
+/// By default, brokers run in the event loop of the `multiplexer`. With
+/// `caf.middleman.broker-execution = "scheduler"`, brokers run on the workers
+/// of the scheduler instead. In this mode, the `multiplexer` only moves bytes
+/// and enqueues system messages such as `new_data_msg` for the broker, while
+/// the broker hands all operations on its servants back to the event loop.
 
 /// A broker mediates between actor systems and other components in the network.
 /// @ingroup Broker
@@ -100,34 +113,29 @@ public:
   /// Suspends activities on `hdl` unconditionally.
   template <class Handle>
   void halt(Handle hdl) {
-    auto ref = by_id(hdl);
-    if (ref)
-      ref->halt();
+    with_servant(hdl, [](auto& ref) { ref.halt(); });
   }
 
   /// Allows activities on `hdl` unconditionally (default).
   template <class Handle>
   void trigger(Handle hdl) {
-    auto ref = by_id(hdl);
-    if (ref)
-      ref->trigger();
+    with_servant(hdl, [](auto& ref) { ref.trigger(); });
   }
 
   /// Allows `num_events` activities on `hdl`.
   template <class Handle>
   void trigger(Handle hdl, size_t num_events) {
-    auto ref = by_id(hdl);
-    if (!ref)
-      return;
-    if (num_events > 0) {
-      ref->trigger(num_events);
-    } else {
-      // if we have any number of activity tokens, ignore this call
-      // otherwise (currently in unconditional receive state) halt
-      auto x = ref->activity_tokens();
-      if (!x)
-        ref->halt();
-    }
+    with_servant(hdl, [num_events](auto& ref) {
+      if (num_events > 0) {
+        ref.trigger(num_events);
+      } else {
+        // if we have any number of activity tokens, ignore this call
+        // otherwise (currently in unconditional receive state) halt
+        auto x = ref.activity_tokens();
+        if (!x)
+          ref.halt();
+      }
+    });
   }
 
   /// Modifies the receive policy for a given connection.
@@ -138,6 +146,23 @@ public:
   /// Enables or disables write notifications for a given connection.
   void ack_writes(connection_handle hdl, bool enable);
 
+  /// Enables or disables data views for a given connection. With data views,
+  /// the broker receives a `new_data_view_msg` instead of a `new_data_msg`.
+  /// In the multiplexer, the view refers to the receive buffer of the
+  /// connection. On the scheduler, the view refers to a copy of the data.
+  void data_views(connection_handle hdl, bool enable);
+
+  /// Enables metrics for a given connection, labeled by `node`. Gauges also
+  /// carry the ID of `hdl` as label `connection`. The servant then counts
+  /// transferred Bytes, samples the time of each read and write, and tracks
+  /// its write buffers. Only the broker knows its framing, hence the broker
+  /// counts frames via the returned counters. Brokers may add bytes that wait
+  /// outside of the write buffers to the write queue gauge.
+  /// @returns the metrics for `hdl`. All pointers are null unless the
+  ///          configuration enables `caf.middleman.connection-metrics`.
+  network::connection_metrics connection_metrics(connection_handle hdl,
+                                                 string_view node);
+
   /// Returns the write buffer for a given connection.
   byte_buffer& wr_buf(connection_handle hdl);
 
@@ -280,10 +305,18 @@ public:
   /// Unwritten data will still be send.
   template <class Handle>
   bool close(Handle hdl) {
-    auto x = by_id(hdl);
+    if (!scheduled_) {
+      auto x = by_id(hdl);
+      if (!x)
+        return false;
+      x->graceful_shutdown();
+      return true;
+    }
+    flush_staged(hdl);
+    auto x = take(hdl);
     if (!x)
       return false;
-    x->graceful_shutdown();
+    shutdown_servant(std::move(x));
     return true;
   }
 
@@ -302,6 +335,14 @@ public:
       elements.erase(i);
   }
 
+  /// Checks whether `hdl` identifies the servant `ptr`.
+  template <class Handle>
+  bool has_servant(Handle hdl, const network::manager* ptr) {
+    auto& elements = get_map(hdl);
+    auto i = elements.find(hdl);
+    return i != elements.end() && i->second.get() == ptr;
+  }
+
   // meta programming utility (not implemented)
   static intrusive_ptr<doorman> ptr_of(accept_handle);
 
@@ -350,11 +391,55 @@ public:
   /// Returns all handles of all `scribe` instances attached to this broker.
   std::vector<connection_handle> connections() const;
 
-  /// Returns the `multiplexer` running this broker.
+  /// Returns the `multiplexer` running this broker or, if the broker runs on
+  /// the scheduler, the `multiplexer` running its servants.
   network::multiplexer& backend() {
     return *backend_;
   }
 
+  /// Returns the number of Bytes that wait for the connection `hdl`. Brokers
+  /// on the scheduler only count Bytes in flight if write acknowledgements are
+  /// enabled for `hdl`.
+  size_t pending_bytes(connection_handle hdl);
+
+  /// Sends a message with content `xs...` to this broker after `delay`. Unlike
+  /// `delayed_send`, the timeout fires in the event loop of the `multiplexer`
+  /// without going through the clock of the actor system. Falls back to
+  /// `delayed_send` if the backend has no timer facility.
+  template <class... Ts>
+  void delayed_io_send(timespan delay, Ts&&... xs) {
+    static_assert(sizeof...(Ts) > 0, "no message to send");
+    delayed_io_send_impl(delay, make_message(std::forward<Ts>(xs)...));
+  }
+
+  // -- execution modes --------------------------------------------------------
+
+  /// A function object that runs in the context of a broker.
+  using io_event = detail::unique_function<void(execution_unit*)>;
+
+  /// Returns whether this broker runs on the workers of the scheduler instead
+  /// of the event loop of its `multiplexer`.
+  bool scheduled() const noexcept {
+    return scheduled_;
+  }
+
+  /// Returns the histogram for the time between reading from a socket and the
+  /// broker finishing the resulting event.
+  telemetry::dbl_histogram* io_latency() noexcept {
+    return io_latency_;
+  }
+
+  /// Runs `f` in the context of this broker, immediately if the caller already
+  /// runs in this context. Otherwise, `f` runs in the event loop or, if the
+  /// broker runs on the scheduler, before the broker processes its next
+  /// message.
+  /// @threadsafe
+  void dispatch_io_event(io_event f);
+
+  /// Runs `f` in the context of this broker after the caller returns.
+  /// @threadsafe
+  void post_io_event(io_event f);
+
 protected:
   void init_broker();
 
@@ -394,7 +479,60 @@ protected:
     return *(i->second);
   }
 
+  /// Called at the end of each activation while this broker still runs.
+  virtual void after_activation();
+
 private:
+  using backend_event = detail::unique_function<void()>;
+
+  /// Calls `f` with the servant identified by `hdl` in the event loop.
+  template <class Handle, class F>
+  void with_servant(Handle hdl, F f) {
+    auto& elements = get_map(hdl);
+    auto i = elements.find(hdl);
+    if (i == elements.end())
+      return;
+    if (!scheduled_) {
+      f(*i->second);
+      return;
+    }
+    post_to_backend(backend_event{[ptr{i->second}, f{std::move(f)}]() mutable {
+      // The broker may have closed the servant in the meantime.
+      if (!ptr->detached())
+        f(*ptr);
+    }});
+  }
+
+  /// Calls `graceful_shutdown` on `ptr` in the event loop.
+  template <class T>
+  void shutdown_servant(intrusive_ptr<T> ptr) {
+    post_to_backend(
+      backend_event{[ptr{std::move(ptr)}] { ptr->graceful_shutdown(); }});
+  }
+
+  /// Runs `f` in the event loop.
+  void post_to_backend(backend_event f);
+
+  /// Delivers `msg` to this broker after `delay`.
+  void delayed_io_send_impl(timespan delay, message msg);
+
+  /// Returns whether the caller runs in the context of this broker.
+  bool in_context() const noexcept;
+
+  /// Runs all pending events of the multiplexer.
+  void run_io_events(execution_unit* ctx);
+
+  /// Sends buffered data for `hdl` to its servant.
+  void flush_staged(connection_handle hdl);
+
+  /// Sends buffered datagrams to their servants.
+  void flush_staged(datagram_handle);
+
+  /// Convenience overload for `close(accept_handle)`.
+  void flush_staged(accept_handle) {
+    // nop
+  }
+
   void launch_servant(scribe_ptr&) {
     // nop
   }
@@ -409,6 +547,14 @@ private:
     CAF_ASSERT(ptr->parent() == nullptr);
     ptr->set_parent(this);
     auto hdl = ptr->hdl();
+    if (scheduled_ && !in_context()) {
+      // Servants such as doormen add scribes from the event loop.
+      post_io_event(io_event{[this, hdl, ptr{std::move(ptr)}](
+                               execution_unit*) mutable {
+        get_map(hdl).emplace(hdl, std::move(ptr));
+      }});
+      return hdl;
+    }
     launch_servant(ptr);
     get_map(hdl).emplace(hdl, std::move(ptr));
     return hdl;
@@ -418,17 +564,56 @@ private:
   void move_servant(intrusive_ptr<T>&& ptr) {
     CAF_ASSERT(ptr != nullptr);
     CAF_ASSERT(ptr->parent() != nullptr && ptr->parent() != this);
-    ptr->set_parent(this);
-    CAF_ASSERT(ptr->parent() == this);
     auto hdl = ptr->hdl();
+    if (scheduled_) {
+      post_to_backend(backend_event{[ptr, self{strong_actor_ptr{ctrl()}}] {
+        ptr->set_parent(static_cast<abstract_broker*>(self->get()));
+      }});
+    } else {
+      ptr->set_parent(this);
+      CAF_ASSERT(ptr->parent() == this);
+    }
     get_map(hdl).emplace(hdl, std::move(ptr));
   }
 
+  /// Buffers outgoing data of a connection while running on the scheduler.
+  struct staged_writes {
+    /// Data that the broker did not flush yet.
+    byte_buffer buf;
+
+    /// Flushed Bytes that the servant did not confirm yet.
+    size_t in_flight = 0;
+
+    /// Stores whether the broker enabled write acknowledgements.
+    bool ack_writes = false;
+  };
+
   network::multiplexer* backend_ = nullptr;
   scribe_map scribes_;
   doorman_map doormen_;
   datagram_servant_map datagram_servants_;
   byte_buffer dummy_wr_buf_;
+
+  /// Stores whether this broker runs on the scheduler.
+  bool scheduled_ = false;
+
+  /// Samples the latency of I/O events in the execution mode of this broker.
+  telemetry::dbl_histogram* io_latency_ = nullptr;
+
+  /// Protects `io_events_` and `io_events_closed_`.
+  std::mutex io_events_mtx_;
+
+  /// Stores events from the multiplexer while running on the scheduler.
+  std::vector<io_event> io_events_;
+
+  /// Stores whether this broker no longer accepts events.
+  bool io_events_closed_ = false;
+
+  /// Buffers outgoing data while running on the scheduler.
+  std::unordered_map<connection_handle, staged_writes> staged_writes_;
+
+  /// Buffers outgoing datagrams while running on the scheduler.
+  std::deque<std::pair<datagram_handle, byte_buffer>> staged_datagrams_;
 };
 
 } // namespace caf::io
@@ -4,19 +4,55 @@
 
 #pragma once
 
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <string>
 #include <unordered_map>
+#include <unordered_set>
 
+#include "caf/byte_buffer.hpp"
+#include "caf/make_counted.hpp"
 #include "caf/response_promise.hpp"
 #include "caf/variant.hpp"
 
 #include "caf/io/connection_handle.hpp"
 #include "caf/io/datagram_handle.hpp"
+#include "caf/io/network/connection_metrics.hpp"
 
 #include "caf/io/basp/connection_state.hpp"
 #include "caf/io/basp/header.hpp"
+#include "caf/io/basp/message_queue.hpp"
 
 namespace caf::io::basp {
 
+// identifies a priority lane for outgoing messages of a connection
+enum class lane : uint8_t {
+  // heartbeats, monitor and down messages, and messages with high priority
+  urgent,
+  // all other messages
+  normal,
+  // messages that exceed the flush threshold or the fragment size, plus all
+  // later messages from the same senders
+  bulk,
+};
+
+// number of priority lanes per connection
+constexpr size_t num_lanes = 3;
+
+// a serialized BASP message that waits in a lane for the write buffer to drain
+struct pending_frame {
+  // the sending actor, used for preserving the order of its messages
+  actor_id source_actor;
+  // number of bytes that we have written as fragments so far (bulk lane only)
+  size_t written;
+  // BASP header plus payload
+  byte_buffer bytes;
+  // time when the message entered its lane
+  std::chrono::steady_clock::time_point enqueued;
+};
+
 // stores meta information for active endpoints
 struct endpoint_context {
   // denotes what message we expect from the remote node next
@@ -32,6 +68,45 @@ struct endpoint_context {
   uint16_t local_port;
   // pending operations to be performed after handshake completed
   optional<response_promise> callback;
+  // maximum size of outgoing fragments or 0 if the remote node does not
+  // accept fragmented messages
+  size_t max_fragment_size = 0;
+  // outgoing messages that wait for the write buffer to drain, one queue per
+  // lane
+  std::array<std::deque<pending_frame>, num_lanes> lanes;
+  // number of bytes that wait in the lanes
+  size_t queued_bytes = 0;
+  // denotes whether pending bytes exceeded the high watermark
+  bool congested = false;
+  // reports the pending bytes of this connection to the metrics registry
+  telemetry::int_gauge* pending_bytes = nullptr;
+  // optional per-connection metrics, set after learning the remote node
+  network::connection_metrics metrics;
+  // denotes whether we currently reassemble a fragmented message
+  bool reassembling = false;
+  // header of the fragmented message we currently reassemble
+  basp::header fragmented_hdr;
+  // payload we have received so far for the fragmented message
+  byte_buffer fragmented_payload;
+  // restores the order of incoming messages after BASP workers deserialized
+  // them concurrently
+  message_queue_ptr queue = make_counted<message_queue>();
+  // denotes whether this connection is an additional connection to a node
+  // that already has a direct connection, in which case `id` holds this node
+  // from the start
+  bool stripe = false;
+  // senders that use this connection although their messages would go to
+  // another stripe, because the stripe had no connection at some point; the
+  // broker removes senders once they terminate
+  std::unordered_set<actor_id> pinned_senders;
+  // denotes whether a client sends messages before receiving the server
+  // handshake, in which case `id` holds the expected node until then
+  bool pipelined = false;
+  // actor ID in the server handshake: the server stores the actor it
+  // announced, a pipelining client stores the actor it expects
+  actor_id published_actor = invalid_actor_id;
+  // host name or path that a client used for connecting to the server
+  std::string remote_host;
 };
 
 } // namespace caf::io::basp
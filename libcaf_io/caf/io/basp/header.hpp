@@ -47,6 +47,18 @@ struct header {
   /// Identifies a receiver by name rather than ID.
   static const uint8_t named_receiver_flag = 0x01;
 
+  /// Signals in a handshake that the sender accepts fragmented messages.
+  static const uint8_t fragmentation_flag = 0x02;
+
+  /// Signals in a client handshake that the connection is an additional
+  /// connection to a node that already has a direct connection.
+  static const uint8_t stripe_flag = 0x04;
+
+  /// Signals in a client handshake that messages follow without waiting for
+  /// the server handshake. The payload then also contains the node ID the
+  /// client expects.
+  static const uint8_t pipelined_flag = 0x08;
+
   /// Identifies the config server.
   static const uint64_t config_server_id = 1;
 
@@ -8,11 +8,13 @@
 
 #include "caf/actor_system_config.hpp"
 #include "caf/byte_buffer.hpp"
+#include "caf/byte_span.hpp"
 #include "caf/callback.hpp"
 #include "caf/detail/io_export.hpp"
 #include "caf/detail/worker_hub.hpp"
 #include "caf/error.hpp"
 #include "caf/io/basp/connection_state.hpp"
+#include "caf/io/basp/endpoint_context.hpp"
 #include "caf/io/basp/header.hpp"
 #include "caf/io/basp/message_queue.hpp"
 #include "caf/io/basp/message_type.hpp"
@@ -84,6 +86,9 @@ public:
     /// Flushes the underlying write buffer of `hdl`.
     virtual void flush(connection_handle hdl) = 0;
 
+    /// Returns the state for `hdl` or `nullptr` if no such connection exists.
+    virtual endpoint_context* get_context(connection_handle hdl) = 0;
+
     /// Returns a handle to the callee actor.
     virtual strong_actor_ptr this_actor() = 0;
 
@@ -109,6 +114,12 @@ public:
   /// Sends heartbeat messages to all valid nodes those are directly connected.
   void handle_heartbeat(execution_unit* ctx);
 
+  /// Moves messages that wait in the lanes of `hdl` to the write buffer, urgent
+  /// messages first, and flushes the buffer afterwards. Splits large messages
+  /// into fragments if the remote node supports fragmentation. The broker
+  /// calls this function whenever the connection made progress on sending.
+  void write_pending(execution_unit* ctx, connection_handle hdl);
+
   /// Returns a route to `target` or `none` on error.
   optional<routing_table::route> lookup(const node_id& target);
 
@@ -139,6 +150,13 @@ public:
                 const node_id& dest_node, uint64_t dest_actor, uint8_t flags,
                 message_id mid, const message& msg);
 
+  /// Sends a message that the sender already serialized, i.e., `payload`
+  /// contains the forwarding stack followed by the message content.
+  /// @returns `true` if a path to destination existed, `false` otherwise.
+  bool dispatch(execution_unit* ctx, const strong_actor_ptr& sender,
+                const node_id& dest_node, uint64_t dest_actor, uint8_t flags,
+                message_id mid, const_byte_span payload);
+
   /// Returns the actor namespace associated to this BASP protocol instance.
   proxy_registry& proxies() {
     return callee_.proxies();
@@ -162,9 +180,12 @@ public:
     return published_actors_;
   }
 
-  /// Writes a header followed by its payload to `storage`.
+  /// Writes a header followed by its payload to `storage`. Passing
+  /// `serialized = true` signals that `pw` only copies a payload that the
+  /// sender already serialized, i.e., the sender sampled the serialization
+  /// time.
   static void write(execution_unit* ctx, byte_buffer& buf, header& hdr,
-                    payload_writer* pw = nullptr);
+                    payload_writer* pw = nullptr, bool serialized = false);
 
   /// Writes the server handshake containing the information of the
   /// actor published at `port` to `buf`. If `port == none` or
@@ -173,8 +194,34 @@ public:
   void write_server_handshake(execution_unit* ctx, byte_buffer& out_buf,
                               optional<uint16_t> port);
 
-  /// Writes the client handshake to `buf`.
-  void write_client_handshake(execution_unit* ctx, byte_buffer& buf);
+  /// Writes the server handshake containing the information of `pa` to `buf`.
+  /// Writes a standard handshake if `pa == nullptr`.
+  void write_server_handshake(execution_unit* ctx, byte_buffer& out_buf,
+                              const published_actor* pa);
+
+  /// Writes the client handshake to `buf`. A client handshake for an
+  /// additional connection to a node that already has a direct connection
+  /// sets `stripe` to `true`. Clients that send messages without waiting for
+  /// the server handshake pass the node they expect as `expected_server` and
+  /// the published actor they expect as `expected_actor`.
+  void write_client_handshake(execution_unit* ctx, byte_buffer& buf,
+                              bool stripe = false,
+                              const node_id& expected_server = node_id{},
+                              actor_id expected_actor = invalid_actor_id);
+
+  /// Adds a direct route to `nid` via `hdl` before receiving the server
+  /// handshake. Allows clients to send messages right after their pipelined
+  /// client handshake.
+  /// @pre `nid != this_node() && !tbl().lookup_direct(nid)`
+  void add_pipelined_route(connection_handle hdl, const node_id& nid);
+
+  /// Upper bound for the number of connections to a single node.
+  static constexpr size_t max_connections_per_peer = 64;
+
+  /// Returns how many connections this node opens to each remote node.
+  size_t connections_per_peer() const noexcept {
+    return connections_per_peer_;
+  }
 
   /// Writes an `announce_proxy` to `buf`.
   void write_monitor_message(execution_unit* ctx, byte_buffer& buf,
@@ -185,6 +232,16 @@ public:
   write_down_message(execution_unit* ctx, byte_buffer& buf,
                      const node_id& dest_node, actor_id aid, const error& rsn);
 
+  /// Writes an `announce_proxy` to `hdl` via the urgent lane.
+  void write_monitor_message(execution_unit* ctx, connection_handle hdl,
+                             const node_id& dest_node, actor_id aid);
+
+  /// Writes a `kill_proxy` to `hdl` via the urgent lane unless messages from
+  /// `aid` still wait in the normal lane.
+  void write_down_message(execution_unit* ctx, connection_handle hdl,
+                          const node_id& dest_node, actor_id aid,
+                          const error& rsn);
+
   /// Writes a `heartbeat` to `buf`.
   void write_heartbeat(execution_unit* ctx, byte_buffer& buf);
 
@@ -196,10 +253,6 @@ public:
     return hub_;
   }
 
-  message_queue& queue() {
-    return queue_;
-  }
-
   actor_system& system() {
     return callee_.proxies().system();
   }
@@ -211,16 +264,83 @@ public:
   connection_state handle(execution_unit* ctx, connection_handle hdl,
                           header& hdr, byte_buffer* payload);
 
+  /// Returns the maximum size for outgoing fragments. A value of 0 means that
+  /// this instance neither sends fragments nor announces that it accepts them.
+  size_t max_fragment_size() const noexcept {
+    return max_fragment_size_;
+  }
+
+  /// Sets the maximum size for outgoing fragments. Affects only connections
+  /// that perform their handshake afterwards.
+  void max_fragment_size(size_t x) noexcept;
+
+  /// Returns whether this instance writes urgent messages ahead of other
+  /// messages once the write buffer of a connection fills up.
+  bool priority_lanes() const noexcept {
+    return priority_lanes_;
+  }
+
+  /// Enables or disables priority lanes.
+  void priority_lanes(bool x) noexcept {
+    priority_lanes_ = x;
+  }
+
+  /// Returns whether the broker must enable write acknowledgements on its
+  /// connections, because messages may wait in a lane.
+  bool requires_write_acks() const noexcept {
+    return max_fragment_size_ > 0 || priority_lanes_;
+  }
+
 private:
   void forward(execution_unit* ctx, const node_id& dest_node, const header& hdr,
                byte_buffer& payload);
 
+  /// Writes a direct or routed message to `dest_node`, using `body` for
+  /// writing the forwarding stack and the message content.
+  bool dispatch_impl(execution_unit* ctx, const strong_actor_ptr& sender,
+                     const node_id& dest_node, uint64_t dest_actor,
+                     uint8_t flags, message_id mid, payload_writer& body,
+                     bool serialized);
+
+  /// Writes a message to `hdl` or adds it to the lane `ln` if the write buffer
+  /// of `hdl` is full or if the message needs fragmentation.
+  void write_message(execution_unit* ctx, connection_handle hdl, lane ln,
+                     header& hdr, payload_writer* writer,
+                     bool serialized = false);
+
+  /// Returns how many bytes the write buffer of a connection may hold before
+  /// messages in the urgent and normal lanes wait.
+  size_t lane_limit() const noexcept;
+
+  /// Appends a received fragment to the message we currently reassemble and
+  /// handles the message once it is complete.
+  connection_state handle_fragment(execution_unit* ctx, connection_handle hdl,
+                                   byte_buffer& payload);
+
+  /// Returns the flags for our handshake messages.
+  uint8_t handshake_flags() const noexcept;
+
+  /// Enables fragmentation for `hdl` if the remote node supports it.
+  void negotiate_fragmentation(connection_handle hdl, const header& hdr);
+
+  /// Selects the connection for a direct message from actor `aid` to `nid`,
+  /// whereas `hdl` is the direct connection to `nid`. Pins `sender` to `hdl`
+  /// if its stripe has no connection yet. Control messages concerning `aid`
+  /// pass no `sender`.
+  connection_handle select_stripe(const node_id& nid, connection_handle hdl,
+                                  actor_id aid,
+                                  const strong_actor_ptr& sender = nullptr);
+
   routing_table tbl_;
   published_actor_map published_actors_;
   node_id this_node_;
   callee& callee_;
-  message_queue queue_;
   detail::worker_hub<worker> hub_;
+  size_t max_fragment_size_;
+  bool priority_lanes_;
+  size_t lane_limit_;
+  size_t connections_per_peer_;
+  bool connection_metrics_;
 };
 
 /// @}
@@ -4,37 +4,51 @@
 
 #pragma once
 
+#include <atomic>
+#include <cstddef>
 #include <cstdint>
-#include <mutex>
-#include <vector>
+#include <memory>
 
 #include "caf/actor_control_block.hpp"
 #include "caf/detail/io_export.hpp"
 #include "caf/fwd.hpp"
+#include "caf/intrusive_ptr.hpp"
 #include "caf/mailbox_element.hpp"
+#include "caf/ref_counted.hpp"
 
 namespace caf::io::basp {
 
 /// Enforces strict order of message delivery, i.e., deliver messages in the
-/// same order as if they were deserialized by a single thread.
-class CAF_IO_EXPORT message_queue {
+/// same order as if they were deserialized by a single thread. The queue stores
+/// out-of-order messages in a fixed-size ring that is indexed by the distance
+/// to `next_undelivered` and never acquires a lock. BASP uses one queue per
+/// connection, since ordering only matters for messages from the same peer.
+class CAF_IO_EXPORT message_queue : public ref_counted {
 public:
-  // -- member types -----------------------------------------------------------
+  // -- constants --------------------------------------------------------------
 
-  /// Request for sending a message to an actor at a later time.
-  struct actor_msg {
-    uint64_t id;
-    strong_actor_ptr receiver;
-    mailbox_element_ptr content;
-  };
+  /// Default number of slots in the reorder buffer.
+  static constexpr size_t default_capacity = 1024;
 
   // -- constructors, destructors, and assignment operators --------------------
 
-  message_queue();
+  /// @pre `capacity` is a power of two
+  explicit message_queue(size_t capacity = default_capacity);
+
+  ~message_queue() override;
+
+  // -- properties -------------------------------------------------------------
+
+  /// Returns the number of slots in the reorder buffer.
+  size_t capacity() const noexcept {
+    return mask_ + 1;
+  }
 
   // -- mutators ---------------------------------------------------------------
 
   /// Adds a new message to the queue or deliver it immediately if possible.
+  /// Blocks the caller while `id` is `capacity()` or more IDs ahead of
+  /// `next_undelivered`, until the thread owning `next_undelivered` catches up.
   void push(execution_unit* ctx, uint64_t id, strong_actor_ptr receiver,
             mailbox_element_ptr content);
 
@@ -46,19 +60,42 @@ public:
 
   // -- member variables -------------------------------------------------------
 
-  /// Protects all other properties.
-  std::mutex lock;
-
   /// The next available ascending ID. The counter is large enough to overflow
   /// after roughly 600 years if we dispatch a message every microsecond.
-  uint64_t next_id;
+  std::atomic<uint64_t> next_id;
 
   /// The next ID that we can ship.
-  uint64_t next_undelivered;
+  std::atomic<uint64_t> next_undelivered;
 
-  /// Keeps messages in sorted order in case a message other than
-  /// `next_undelivered` gets ready first.
-  std::vector<actor_msg> pending;
+private:
+  // -- member types -----------------------------------------------------------
+
+  /// Request for sending a message to an actor at a later time.
+  struct slot {
+    std::atomic<bool> ready{false};
+    strong_actor_ptr receiver;
+    mailbox_element_ptr content;
+  };
+
+  // -- utility functions ------------------------------------------------------
+
+  /// Ships all consecutive messages starting at `next_undelivered`. At most
+  /// one thread at a time delivers messages.
+  void deliver(execution_unit* ctx);
+
+  // -- member variables -------------------------------------------------------
+
+  /// Maps IDs to slots via `id & mask_`.
+  size_t mask_;
+
+  /// Stores messages that wait for their predecessors.
+  std::unique_ptr<slot[]> slots_;
+
+  /// Signals whether a thread currently ships messages.
+  std::atomic<bool> delivering_;
 };
 
+/// @relates message_queue
+using message_queue_ptr = intrusive_ptr<message_queue>;
+
 } // namespace caf::io::basp
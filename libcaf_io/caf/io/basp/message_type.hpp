@@ -60,6 +60,12 @@ enum class message_type : uint8_t {
   ///
   /// ![](heartbeat.png)
   heartbeat = 0x06,
+
+  /// Transmits a chunk of a direct or routed message that exceeds the maximum
+  /// fragment size. The receiver reassembles the original message from
+  /// consecutive fragments. Only sent to nodes that announced support for
+  /// fragmentation in their handshake.
+  fragment = 0x07,
 };
 
 CAF_IO_EXPORT std::string to_string(message_type);
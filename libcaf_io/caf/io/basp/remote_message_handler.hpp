@@ -21,7 +21,9 @@
 #include "caf/message.hpp"
 #include "caf/message_id.hpp"
 #include "caf/node_id.hpp"
+#include "caf/shared_bytes.hpp"
 #include "caf/telemetry/histogram.hpp"
+#include "caf/telemetry/metric_family_impl.hpp"
 #include "caf/telemetry/timer.hpp"
 
 namespace caf::io::basp {
@@ -34,12 +36,18 @@ public:
     // Local variables.
     auto& dref = static_cast<Subtype&>(*this);
     auto& sys = *dref.system_;
+    // Deserializing a shared_bytes aliases the payload instead of copying it.
+    // We keep the payload buffer for the next message unless the message still
+    // refers to it when we return.
+    shared_bytes payload{std::move(dref.payload_)};
+    auto reclaim
+      = detail::make_scope_guard([&] { dref.payload_ = payload.release(); });
     strong_actor_ptr src;
     strong_actor_ptr dst;
     std::vector<strong_actor_ptr> stages;
     message msg;
     auto mid = make_message_id(dref.hdr_.operation_data);
-    binary_deserializer source{ctx, dref.payload_};
+    binary_deserializer source{ctx, payload};
     // Make sure to drop the message in case we return abnormally.
     auto guard
       = detail::make_scope_guard([&] { dref.queue_->drop(ctx, dref.msg_id_); });
@@ -105,7 +113,10 @@ public:
       return;
     }
     telemetry::timer::observe(mm_metrics.deserialization_time, t0);
-    auto signed_size = static_cast<int64_t>(dref.payload_.size());
+    if (auto by_type = mm_metrics.deserialization_time_by_type)
+      telemetry::timer::observe(
+        by_type->get_or_add({{"type", to_string(msg.types())}}), t0);
+    auto signed_size = static_cast<int64_t>(payload.size());
     mm_metrics.inbound_messages_size->observe(signed_size);
     // Intercept link messages. Forwarding actor proxies signalize linking
     // by sending link_atom/unlink_atom message with src == dest.
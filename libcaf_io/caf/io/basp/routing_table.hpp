@@ -4,6 +4,9 @@
 
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <cstddef>
 #include <mutex>
 #include <unordered_map>
 #include <unordered_set>
@@ -20,6 +23,10 @@ namespace caf::io::basp {
 
 /// Stores routing information for a single broker participating as
 /// BASP peer and provides both direct and indirect paths.
+///
+/// Readers never block: the table publishes an immutable snapshot of all
+/// routes and writers replace the snapshot with an updated copy. Writers wait
+/// for all readers of a replaced snapshot to finish before destroying it.
 class CAF_IO_EXPORT routing_table {
 public:
   explicit routing_table(abstract_broker* parent);
@@ -28,12 +35,12 @@ public:
 
   /// Describes a routing path to a node.
   struct route {
-    const node_id& next_hop;
+    node_id next_hop;
     connection_handle hdl;
   };
 
   /// Returns a route to `target` or `none` on error.
-  optional<route> lookup(const node_id& target);
+  optional<route> lookup(const node_id& target) const;
 
   /// Returns the ID of the peer connected via `hdl` or
   /// `none` if `hdl` is unknown.
@@ -47,6 +54,29 @@ public:
   /// or `none` if there's no indirect route to `nid`.
   node_id lookup_indirect(const node_id& nid) const;
 
+  /// Returns the handles of all direct connections.
+  std::vector<connection_handle> direct_connections() const;
+
+  /// Returns the connection for messages from `sender` to `nid` if `nid` has
+  /// stripes, `none` otherwise. The result is `invalid_connection_handle` if
+  /// the stripe for `sender` has no connection (yet).
+  optional<connection_handle> stripe(const node_id& nid,
+                                     actor_id sender) const;
+
+  /// Returns all additional connections to `nid`.
+  std::vector<connection_handle> stripes(const node_id& nid) const;
+
+  /// Spreads messages to `nid` over at least `n` connections. The direct
+  /// connection to `nid` becomes the first stripe.
+  /// @pre `n > 1` and `nid` has a direct connection
+  void enable_stripes(const node_id& nid, size_t n);
+
+  /// Adds `hdl` as additional connection to `nid`, spreading messages to
+  /// `nid` over `n` connections unless `nid` already has stripes. Returns
+  /// `false` if `nid` has no free stripe.
+  bool add_stripe(const connection_handle& hdl, const node_id& nid,
+                  size_t n);
+
   /// Adds a new direct route to the table.
   /// @pre `hdl != invalid_connection_handle && nid != none`
   void add_direct(const connection_handle& hdl, const node_id& nid);
@@ -55,7 +85,9 @@ public:
   bool add_indirect(const node_id& hop, const node_id& dest);
 
   /// Removes a direct connection and return the node ID that became
-  /// unreachable as a result of this operation.
+  /// unreachable as a result of this operation. Removing an additional
+  /// connection only frees its stripe. Removing the direct connection also
+  /// removes all additional connections.
   node_id erase_direct(const connection_handle& hdl);
 
   /// Removes any entry for indirect connection to `dest` and returns
@@ -67,14 +99,50 @@ public:
     return parent_;
   }
 
-public:
+private:
   using node_id_set = std::unordered_set<node_id>;
 
+  /// An immutable view of all routes.
+  struct snapshot {
+    std::unordered_map<connection_handle, node_id> direct_by_hdl;
+    std::unordered_map<node_id, connection_handle> direct_by_nid;
+    std::unordered_map<node_id, node_id_set> indirect;
+    std::unordered_map<node_id, std::vector<connection_handle>> stripes;
+  };
+
+  /// Pins the current snapshot for the lifetime of the guard.
+  class read_guard {
+  public:
+    explicit read_guard(const routing_table& tbl);
+
+    ~read_guard();
+
+    const snapshot* operator->() const noexcept {
+      return ptr_;
+    }
+
+  private:
+    std::atomic<size_t>* readers_;
+    const snapshot* ptr_;
+  };
+
+  /// Replaces the current snapshot with `next`.
+  /// @pre `mtx_` is locked
+  void publish(snapshot* next);
+
   abstract_broker* parent_;
-  mutable std::mutex mtx_;
-  std::unordered_map<connection_handle, node_id> direct_by_hdl_;
-  std::unordered_map<node_id, connection_handle> direct_by_nid_;
-  std::unordered_map<node_id, node_id_set> indirect_;
+
+  /// Serializes writers.
+  std::mutex mtx_;
+
+  /// Points to the current snapshot.
+  std::atomic<snapshot*> current_;
+
+  /// Selects the reader counter for new readers.
+  std::atomic<size_t> epoch_;
+
+  /// Counts active readers per epoch.
+  mutable std::array<std::atomic<size_t>, 2> readers_;
 };
 
 /// @}
@@ -16,6 +16,7 @@
 #include "caf/fwd.hpp"
 #include "caf/io/basp/fwd.hpp"
 #include "caf/io/basp/header.hpp"
+#include "caf/io/basp/message_queue.hpp"
 #include "caf/io/basp/remote_message_handler.hpp"
 #include "caf/node_id.hpp"
 #include "caf/resumable.hpp"
@@ -41,14 +42,18 @@ public:
   // -- constructors, destructors, and assignment operators --------------------
 
   /// Only the ::worker_hub has access to the constructor.
-  worker(hub_type& hub, message_queue& queue, proxy_registry& proxies);
+  worker(hub_type& hub, proxy_registry& proxies);
 
   ~worker() override;
 
   // -- management -------------------------------------------------------------
 
-  void launch(const node_id& last_hop, const basp::header& hdr,
-              const byte_buffer& payload);
+  /// Schedules this worker for deserializing a message. Takes the content of
+  /// `payload` by swapping buffers, i.e., `payload` holds unspecified content
+  /// afterwards. The worker delivers the message through `queue`, i.e., the
+  /// ordering queue of the connection that received it.
+  void launch(message_queue_ptr queue, const node_id& last_hop,
+              const basp::header& hdr, byte_buffer& payload);
 
   // -- implementation of resumable --------------------------------------------
 
@@ -59,8 +64,7 @@ private:
 
   /// Stores how many bytes the "first half" of this object requires.
   static constexpr size_t pointer_members_size
-    = sizeof(hub_type*) + sizeof(message_queue*) + sizeof(proxy_registry*)
-      + sizeof(actor_system*);
+    = sizeof(hub_type*) + sizeof(proxy_registry*) + sizeof(actor_system*);
 
   static_assert(CAF_CACHE_LINE_SIZE > pointer_members_size,
                 "invalid cache line size");
@@ -70,9 +74,6 @@ private:
   /// Points to our home hub.
   hub_type* hub_;
 
-  /// Points to the queue for establishing strict ordering.
-  message_queue* queue_;
-
   /// Points to our proxy registry / factory.
   proxy_registry* proxies_;
 
@@ -82,6 +83,9 @@ private:
   /// Prevents false sharing when writing to `next`.
   char pad_[CAF_CACHE_LINE_SIZE - pointer_members_size];
 
+  /// Points to the queue for establishing strict ordering.
+  message_queue_ptr queue_;
+
   /// ID for local ordering.
   uint64_t msg_id_;
 
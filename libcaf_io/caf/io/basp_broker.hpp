@@ -4,11 +4,14 @@
 
 #pragma once
 
+#include <chrono>
 #include <future>
 #include <map>
+#include <mutex>
 #include <set>
 #include <stack>
 #include <string>
+#include <tuple>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
@@ -16,6 +19,9 @@
 #include "caf/binary_deserializer.hpp"
 #include "caf/binary_serializer.hpp"
 #include "caf/byte_buffer.hpp"
+#include "caf/defaults.hpp"
+#include "caf/detail/byte_buffer_pool.hpp"
+#include "caf/detail/flow_gate.hpp"
 #include "caf/detail/io_export.hpp"
 #include "caf/forwarding_actor_proxy.hpp"
 #include "caf/io/basp/all.hpp"
@@ -23,6 +29,7 @@
 #include "caf/io/typed_broker.hpp"
 #include "caf/proxy_registry.hpp"
 #include "caf/stateful_actor.hpp"
+#include "caf/timespan.hpp"
 
 namespace caf::io {
 
@@ -40,6 +47,14 @@ public:
   using monitored_actor_map
     = std::unordered_map<actor_addr, std::unordered_set<node_id>>;
 
+  /// Identifies a server by the host name (or socket path) and port that
+  /// clients use for connecting to it.
+  using server_endpoint = std::pair<std::string, uint16_t>;
+
+  /// Stores the node ID of a server as well as ID and interface of the actor
+  /// published at the endpoint.
+  using server_info = std::tuple<node_id, actor_id, std::set<std::string>>;
+
   // -- constructors, destructors, and assignment operators --------------------
 
   explicit basp_broker(actor_config& cfg);
@@ -58,6 +73,8 @@ public:
 
   resume_result resume(execution_unit*, size_t) override;
 
+  void after_activation() override;
+
   // -- implementation of proxy_registry::backend ------------------------------
 
   strong_actor_ptr make_proxy(node_id nid, actor_id aid) override;
@@ -82,6 +99,8 @@ public:
 
   void flush(connection_handle hdl) override;
 
+  basp::endpoint_context* get_context(connection_handle hdl) override;
+
   void handle_heartbeat() override;
 
   execution_unit* current_execution_unit() override;
@@ -90,8 +109,13 @@ public:
 
   // -- utility functions ------------------------------------------------------
 
-  /// Sends `node_down_msg` to all registered observers.
-  void emit_node_down_msg(const node_id& node, const error& reason);
+  /// Removes and returns all registered observers of `node`.
+  std::vector<actor_addr> take_node_observers(const node_id& node);
+
+  /// Purges the state for `nid` like `purge_state(nid)` and sends a
+  /// `node_down_msg` with `reason` to `observers` after killing all proxies.
+  void purge_state(const node_id& nid, std::vector<actor_addr> observers,
+                   error reason);
 
   /// Performs bookkeeping such as managing `spawn_servers`.
   void learned_new_node(const node_id& nid);
@@ -102,12 +126,45 @@ public:
   /// Cleans up any state for `hdl`.
   void connection_cleanup(connection_handle hdl, sec code);
 
+  /// Removes the actor published at the closed acceptor `hdl`.
+  void acceptor_cleanup(accept_handle hdl);
+
+  /// Flushes the write buffers of all connections marked by `flush`.
+  void flush_pending();
+
+  /// Compares the pending bytes of `hdl` to the configured watermarks and
+  /// throttles proxies of nodes that we reach via `hdl` while any connection
+  /// to the peer exceeds the high watermark.
+  void check_watermarks(connection_handle hdl);
+
+  /// Closes (`value == true`) or opens the flow gates of all nodes that we
+  /// reach via the direct peer `nid`.
+  void set_congested(const node_id& nid, bool value);
+
   /// Sends a basp::down_message message to a remote node.
   void send_basp_down_message(const node_id& nid, actor_id aid, error err);
 
   // Sends basp::down_message to all nodes monitoring the terminated actor.
   void handle_down_msg(down_msg&);
 
+  /// Prepares a new client connection to the server at `host` and `port`.
+  basp::endpoint_context&
+  init_client_context(scribe_ptr& ptr, std::string host, uint16_t port);
+
+  /// Tries to send the client handshake for `ectx` in pipelined mode and
+  /// returns the server information from the cache on success.
+  optional<server_info> pipeline_client_handshake(basp::endpoint_context& ectx);
+
+  /// Stores the result of a server handshake in `handshake_cache`.
+  void cache_handshake(const basp::endpoint_context& ectx, const node_id& nid,
+                       actor_id aid, const std::set<std::string>& sigs);
+
+  /// Reads `handshake_cache` from `handshake_cache_file`.
+  void load_handshake_cache();
+
+  /// Sends `handshake_cache` to `handshake_cache_writer`.
+  void save_handshake_cache();
+
   // -- disambiguation for functions found in multiple base classes ------------
 
   actor_system& system() {
@@ -140,6 +197,16 @@ public:
   /// particular node fails.
   std::unordered_map<node_id, std::vector<actor_addr>> node_observers;
 
+  /// Stores the actors published at Unix domain sockets. The BASP instance
+  /// maps ports to published actors, but these doormen have no port.
+  std::unordered_map<accept_handle, basp::instance::published_actor>
+    local_published_actors;
+
+  /// Stores the port and the number of outstanding queue round trips for each
+  /// closed acceptor.
+  std::unordered_map<accept_handle, std::pair<uint16_t, size_t>>
+    closing_acceptors;
+
   /// Configures whether BASP automatically open new connections to optimize
   /// routing paths by forming a mesh between all nodes.
   bool automatic_connections = false;
@@ -151,6 +218,67 @@ public:
 
   /// Keeps track of nodes that monitor local actors.
   monitored_actor_map monitored_actors;
+
+  /// Stores connections with buffered data that awaits flushing. The broker
+  /// flushes all pending connections at the end of each activation.
+  std::vector<connection_handle> pending_flushes;
+
+  /// Stores when the broker added the first entry to `pending_flushes`.
+  std::chrono::steady_clock::time_point first_pending_flush;
+
+  /// Configures how many bytes a write buffer may hold before the broker
+  /// flushes it immediately. A value of 0 disables write coalescing.
+  size_t flush_threshold = defaults::middleman::flush_threshold;
+
+  /// Configures how long the broker may delay flushing buffered writes.
+  timespan max_flush_delay = defaults::middleman::max_flush_delay;
+
+  /// Configures how many bytes may wait for a connection before the broker
+  /// throttles proxies. A value of 0 disables throttling.
+  size_t high_watermark = defaults::middleman::write_buffer_high_watermark;
+
+  /// Configures how many bytes may wait for a connection before the broker
+  /// stops throttling proxies.
+  size_t low_watermark = 0;
+
+  /// Configures how proxies treat messages while throttled.
+  detail::flow_gate::policy_type overflow_policy
+    = detail::flow_gate::reject_messages;
+
+  /// Stores the flow gates for all nodes with proxies when throttling is
+  /// enabled. BASP workers create proxies while deserializing messages, hence
+  /// `gates_mtx` guards this map.
+  std::unordered_map<node_id, detail::flow_gate_ptr> gates;
+
+  /// Guards `gates`.
+  std::mutex gates_mtx;
+
+  /// Provides buffers to proxies for serializing messages on the sending
+  /// thread. Proxies leave serialization to the broker if this pool is `null`.
+  detail::byte_buffer_pool_ptr buffer_pool;
+
+  /// Caches the results of server handshakes. Only servers that passed the
+  /// application ID check enter the cache.
+  std::map<server_endpoint, server_info> handshake_cache;
+
+  /// Configures whether clients send messages to servers in `handshake_cache`
+  /// right after the client handshake.
+  bool pipelined_handshake = false;
+
+  /// Keeps `handshake_cache` across restarts unless empty.
+  std::string handshake_cache_file;
+
+  /// Writes `handshake_cache` to `handshake_cache_file` in the background.
+  /// Spawned on the first change to the cache.
+  actor handshake_cache_writer;
+
+  /// Configures whether the broker enables metrics for each connection after
+  /// learning the remote node.
+  bool collect_connection_metrics = false;
+
+  /// Configures whether the broker tears down proxies for lost nodes with a
+  /// single `proxies_down_msg` per observer.
+  bool aggregate_down_messages = false;
 };
 
 } // namespace caf::io
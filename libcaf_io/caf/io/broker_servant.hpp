@@ -5,10 +5,12 @@
 #pragma once
 
 #include "caf/fwd.hpp"
+#include "caf/intrusive_ptr.hpp"
 #include "caf/io/abstract_broker.hpp"
 #include "caf/io/fwd.hpp"
 #include "caf/io/system_messages.hpp"
 #include "caf/mailbox_element.hpp"
+#include "caf/telemetry/timer.hpp"
 
 namespace caf::io {
 
@@ -33,16 +35,19 @@ public:
 
   void halt() {
     activity_tokens_ = none;
+    halted_ = true;
     this->remove_from_loop();
   }
 
   void trigger() {
     activity_tokens_ = none;
+    halted_ = false;
     this->add_to_loop();
   }
 
   void trigger(size_t num) {
     CAF_ASSERT(num > 0);
+    halted_ = false;
     if (activity_tokens_)
       *activity_tokens_ += num;
     else
@@ -59,23 +64,49 @@ protected:
     ptr->erase(hdl_);
   }
 
-  void invoke_mailbox_element_impl(execution_unit* ctx, mailbox_element& x) {
-    auto self = this->parent();
+  bool attached_to(abstract_broker* ptr) override {
+    return ptr->has_servant(hdl_, this);
+  }
+
+  // Message types for telling the broker about a servant in passive mode.
+  using passiv_t = typename std::conditional<
+    std::is_same<handle_type, connection_handle>::value,
+    connection_passivated_msg,
+    typename std::conditional<std::is_same<handle_type, accept_handle>::value,
+                              acceptor_passivated_msg,
+                              datagram_servant_passivated_msg>::type>::type;
+
+  void invoke_mailbox_element_impl(abstract_broker* self, execution_unit* ctx,
+                                   mailbox_element& x) {
     auto pfac = self->proxy_registry_ptr();
+    auto prev = ctx->proxy_registry_ptr();
     if (pfac)
       ctx->proxy_registry_ptr(pfac);
     auto guard = detail::make_scope_guard([=] {
       if (pfac)
-        ctx->proxy_registry_ptr(nullptr);
+        ctx->proxy_registry_ptr(prev);
     });
     self->activate(ctx, x);
   }
 
+  void invoke_mailbox_element_impl(execution_unit* ctx, mailbox_element& x) {
+    invoke_mailbox_element_impl(this->parent(), ctx, x);
+  }
+
   bool invoke_mailbox_element(execution_unit* ctx) {
+    return invoke_mailbox_element(ctx, value_);
+  }
+
+  bool invoke_mailbox_element(execution_unit* ctx, mailbox_element& x) {
+    if (this->parent()->scheduled())
+      return schedule_mailbox_element(hdl_, x.payload);
     // hold on to a strong reference while "messing" with the parent actor
     strong_actor_ptr ptr_guard{this->parent()->ctrl()};
     auto prev = activity_tokens_;
-    invoke_mailbox_element_impl(ctx, value_);
+    { // Lifetime scope of t.
+      telemetry::timer t{this->parent()->io_latency()};
+      invoke_mailbox_element_impl(ctx, x);
+    }
     // only consume an activity token if actor did not produce them now
     if (prev && activity_tokens_ && --(*activity_tokens_) == 0) {
       if (this->parent()->getf(abstract_actor::is_shutting_down_flag
@@ -83,13 +114,6 @@ protected:
         return false;
       // tell broker it entered passive mode, this can result in
       // producing, why we check the condition again afterwards
-      using passiv_t = typename std::conditional<
-        std::is_same<handle_type, connection_handle>::value,
-        connection_passivated_msg,
-        typename std::conditional<
-          std::is_same<handle_type, accept_handle>::value,
-          acceptor_passivated_msg,
-          datagram_servant_passivated_msg>::type>::type;
       mailbox_element tmp{strong_actor_ptr{}, make_message_id(),
                           mailbox_element::forwarding_stack{},
                           make_message(passiv_t{hdl()})};
@@ -99,6 +123,55 @@ protected:
     return true;
   }
 
+  /// Lets a broker on the scheduler process `content` and consumes an activity
+  /// token. Returns whether the servant keeps receiving.
+  bool schedule_mailbox_element(handle_type hdl, message content,
+                                abstract_broker::io_event then = {}) {
+    schedule_message(hdl, std::move(content), true, std::move(then));
+    if (!activity_tokens_ || --(*activity_tokens_) > 0)
+      return true;
+    // The broker calls trigger() from its own context to leave passive mode.
+    auto self = this->parent();
+    self->post_io_event(abstract_broker::io_event{
+      [self, ptr{intrusive_ptr<broker_servant>{this}}](execution_unit* ctx) {
+        if (!self->has_servant(ptr->hdl(), ptr.get())
+            || self->getf(abstract_actor::is_shutting_down_flag
+                          | abstract_actor::is_terminated_flag))
+          return;
+        mailbox_element tmp{strong_actor_ptr{}, make_message_id(),
+                            mailbox_element::forwarding_stack{},
+                            make_message(passiv_t{ptr->hdl()})};
+        ptr->invoke_mailbox_element_impl(self, ctx, tmp);
+      }});
+    return false;
+  }
+
+  /// Lets a broker on the scheduler process `content` unless the broker drops
+  /// `hdl` in the meantime. Calls `then` in the context of the broker after
+  /// processing `content`.
+  void schedule_message(handle_type hdl, message content, bool sample_latency,
+                        abstract_broker::io_event then = {}) {
+    using clock_type = telemetry::timer::clock_type;
+    auto self = this->parent();
+    auto latency = sample_latency ? self->io_latency() : nullptr;
+    auto t0 = latency ? clock_type::now() : clock_type::time_point{};
+    self->post_io_event(abstract_broker::io_event{
+      [self, ptr{intrusive_ptr<broker_servant>{this}}, hdl, latency, t0,
+       content{std::move(content)},
+       then{std::move(then)}](execution_unit* ctx) mutable {
+        if (!self->has_servant(hdl, ptr.get()))
+          return;
+        mailbox_element tmp{strong_actor_ptr{}, make_message_id(),
+                            mailbox_element::forwarding_stack{},
+                            std::move(content)};
+        ptr->invoke_mailbox_element_impl(self, ctx, tmp);
+        if (latency)
+          telemetry::timer::observe(latency, t0);
+        if (then)
+          then(ctx);
+      }});
+  }
+
   SysMsgType& msg() {
     return value_.payload.template get_mutable_as<SysMsgType>(0);
   }
@@ -106,6 +179,7 @@ protected:
   handle_type hdl_;
   mailbox_element value_;
   optional<size_t> activity_tokens_;
+  bool halted_ = false;
 };
 
 } // namespace caf::io
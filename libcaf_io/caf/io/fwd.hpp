@@ -54,6 +54,7 @@ struct datagram_servant_closed_msg;
 struct datagram_servant_passivated_msg;
 struct new_connection_msg;
 struct new_data_msg;
+struct new_data_view_msg;
 struct new_datagram_msg;
 
 // -- aliases ------------------------------------------------------------------
@@ -70,6 +71,8 @@ class default_multiplexer;
 class multiplexer;
 class receive_buffer;
 
+struct connection_metrics;
+
 using address_listing = std::map<protocol::network, std::vector<std::string>>;
 
 } // namespace network
@@ -96,12 +99,14 @@ CAF_BEGIN_TYPE_ID_BLOCK(io_module, detail::io_module_begin)
   CAF_ADD_TYPE_ID(io_module, (caf::io::network::receive_buffer))
   CAF_ADD_TYPE_ID(io_module, (caf::io::new_connection_msg))
   CAF_ADD_TYPE_ID(io_module, (caf::io::new_data_msg))
+  CAF_ADD_TYPE_ID(io_module, (caf::io::new_data_view_msg))
   CAF_ADD_TYPE_ID(io_module, (caf::io::new_datagram_msg))
   CAF_ADD_TYPE_ID(io_module, (caf::io::scribe_ptr))
 
 CAF_END_TYPE_ID_BLOCK(io_module)
 
 CAF_ALLOW_UNSAFE_MESSAGE_TYPE(caf::io::doorman_ptr)
+CAF_ALLOW_UNSAFE_MESSAGE_TYPE(caf::io::new_data_view_msg)
 CAF_ALLOW_UNSAFE_MESSAGE_TYPE(caf::io::scribe_ptr)
 
 static_assert(caf::id_block::io_module::end == caf::detail::io_module_end);
@@ -21,10 +21,12 @@
 #include "caf/fwd.hpp"
 #include "caf/io/broker.hpp"
 #include "caf/io/middleman_actor.hpp"
+#include "caf/io/network/connection_metrics.hpp"
 #include "caf/io/network/multiplexer.hpp"
 #include "caf/node_id.hpp"
 #include "caf/proxy_registry.hpp"
 #include "caf/send.hpp"
+#include "caf/string_view.hpp"
 #include "caf/timespan.hpp"
 
 namespace caf::io {
@@ -45,8 +47,69 @@ public:
     /// Samples the size of outbound messages after serializing them.
     telemetry::int_histogram* outbound_messages_size = nullptr;
 
-    /// Samples how long the middleman needs to serialize outbound messages.
+    /// Samples how long the middleman or the proxies (when serializing on the
+    /// sending thread) need to serialize outbound messages.
     telemetry::dbl_histogram* serialization_time = nullptr;
+
+    /// Samples how long outbound messages wait in the urgent lane.
+    telemetry::dbl_histogram* urgent_queueing_time = nullptr;
+
+    /// Samples how long outbound messages wait in the normal lane.
+    telemetry::dbl_histogram* normal_queueing_time = nullptr;
+
+    /// Samples how long outbound messages wait in the bulk lane.
+    telemetry::dbl_histogram* bulk_queueing_time = nullptr;
+
+    /// Tracks the pending Bytes on BASP connections, labeled by remote node.
+    telemetry::int_gauge_family* pending_bytes = nullptr;
+
+    /// Samples how long the middleman needs to kill all proxies of a node
+    /// after losing the connection to it.
+    telemetry::dbl_histogram* proxy_teardown_time = nullptr;
+
+    /// Samples the time between reading from a socket and a broker in the
+    /// event loop of the multiplexer finishing the resulting event.
+    telemetry::dbl_histogram* multiplexer_broker_latency = nullptr;
+
+    /// Samples the time between reading from a socket and a broker on the
+    /// scheduler finishing the resulting event.
+    telemetry::dbl_histogram* scheduler_broker_latency = nullptr;
+
+    // The following families remain null unless the configuration enables
+    // `caf.middleman.connection-metrics`.
+
+    /// Counts received Bytes, labeled by remote node.
+    telemetry::int_counter_family* received_bytes = nullptr;
+
+    /// Counts sent Bytes, labeled by remote node.
+    telemetry::int_counter_family* sent_bytes = nullptr;
+
+    /// Counts received frames, labeled by remote node.
+    telemetry::int_counter_family* received_frames = nullptr;
+
+    /// Counts sent frames, labeled by remote node.
+    telemetry::int_counter_family* sent_frames = nullptr;
+
+    /// Samples the duration of reads from a socket, labeled by remote node.
+    telemetry::dbl_histogram_family* read_time = nullptr;
+
+    /// Samples the duration of writes to a socket, labeled by remote node.
+    telemetry::dbl_histogram_family* write_time = nullptr;
+
+    /// Tracks the Bytes in the write buffers of a connection, labeled by
+    /// remote node.
+    telemetry::int_gauge_family* write_queue_size = nullptr;
+
+    /// Stores when a connection started, labeled by remote node.
+    telemetry::int_gauge_family* connection_start_time = nullptr;
+
+    /// Samples the serialization time of outbound messages, labeled by the
+    /// types of the message content.
+    telemetry::dbl_histogram_family* serialization_time_by_type = nullptr;
+
+    /// Samples the deserialization time of inbound messages, labeled by the
+    /// types of the message content.
+    telemetry::dbl_histogram_family* deserialization_time_by_type = nullptr;
   };
 
   /// Independent tasks that run in the background, usually in their own thread.
@@ -90,6 +153,19 @@ public:
                    system().message_types(tk), port, in, reuse);
   }
 
+  /// Tries to publish `whom` at the Unix domain socket given by `locator`,
+  /// e.g., `unix:///run/app.sock`. The file system permissions of the socket
+  /// file control which local processes may connect. Replaces stale socket
+  /// files from previous runs.
+  /// @param whom Actor that should be published at `locator`.
+  /// @param locator URI with scheme `unix` and an absolute path.
+  template <class Handle>
+  expected<void> publish(Handle&& whom, const uri& locator) {
+    detail::type_list<typename std::decay<Handle>::type> tk;
+    return publish(actor_cast<strong_actor_ptr>(std::forward<Handle>(whom)),
+                   system().message_types(tk), locator);
+  }
+
   /// Makes *all* local groups accessible via network
   /// on address `addr` and `port`.
   /// @returns The actual port the OS uses after `bind()`. If `port == 0`
@@ -121,6 +197,21 @@ public:
     return actor_cast<ActorHandle>(std::move(*x));
   }
 
+  /// Establish a new connection to the actor published at the Unix domain
+  /// socket given by `locator`.
+  /// @param locator URI of the form `unix:///path/to/socket`.
+  /// @returns An `actor` to the proxy instance representing
+  ///          a remote actor or an `error`.
+  template <class ActorHandle = actor>
+  expected<ActorHandle> remote_actor(const uri& locator) {
+    detail::type_list<ActorHandle> tk;
+    auto x = remote_actor(system().message_types(tk), locator);
+    if (!x)
+      return x.error();
+    CAF_ASSERT(x && *x);
+    return actor_cast<ActorHandle>(std::move(*x));
+  }
+
   /// Tries to connect to a group that runs on a different node in the network.
   /// @param group_locator Locator in the format `<group-name>@<host>:<port>`.
   expected<group> remote_group(const std::string& group_locator);
@@ -306,6 +397,15 @@ public:
     return {};
   }
 
+  /// Returns metrics for a connection to `node` and sets the start time of
+  /// the connection to now. Gauges carry the additional label `connection`,
+  /// since several connections to the same node may exist at the same time.
+  /// All pointers in the result are null unless the configuration enables
+  /// `caf.middleman.connection-metrics`.
+  /// @private
+  network::connection_metrics connection_metrics(string_view node,
+                                                 string_view connection);
+
   /// @private
   metric_singletons_t metric_singletons;
 
@@ -363,11 +463,17 @@ private:
   publish(const strong_actor_ptr& whom, std::set<std::string> sigs,
           uint16_t port, const char* cstr, bool ru);
 
+  expected<void> publish(const strong_actor_ptr& whom,
+                         std::set<std::string> sigs, const uri& locator);
+
   expected<void> unpublish(const actor_addr& whom, uint16_t port);
 
   expected<strong_actor_ptr>
   remote_actor(std::set<std::string> ifs, std::string host, uint16_t port);
 
+  expected<strong_actor_ptr>
+  remote_actor(std::set<std::string> ifs, const uri& locator);
+
   static int exec_slave_mode(actor_system&, const actor_system_config&);
 
   /// The actor environment.
@@ -38,6 +38,13 @@ namespace caf::io {
 ///   (open_atom, uint16_t port, string addr, bool reuse_addr)
 ///   -> (uint16_t)
 ///
+///   // Accepts connections to `whom` on a Unix domain socket.
+///   // locator: URI of the form `unix:///path/to/socket`.
+///   // whom: Actor that should be published at given path.
+///   // ifs: Interface of given actor.
+///   (publish_atom, uri locator, strong_actor_ptr whom, set<string> ifs)
+///   -> void
+///
 ///   // Queries a remote node and returns an ID to this node as well as
 ///   // an `strong_actor_ptr` to a remote actor if an actor was published at
 ///   this
@@ -48,6 +55,11 @@ namespace caf::io {
 ///   (connect_atom, string hostname, uint16_t port)
 ///   -> (node_id nid, strong_actor_ptr remote_actor, set<string> ifs)
 ///
+///   // Same as above, but connects to a Unix domain socket.
+///   // locator: URI of the form `unix:///path/to/socket`.
+///   (connect_atom, uri locator)
+///   -> (node_id nid, strong_actor_ptr remote_actor, set<string> ifs)
+///
 ///   // Closes `port` if it is mapped to `whom`.
 ///   // whom: A published actor.
 ///   // port: Used TCP port.
@@ -77,9 +89,14 @@ using middleman_actor = typed_actor<
 
   replies_to<open_atom, uint16_t, std::string, bool>::with<uint16_t>,
 
+  reacts_to<publish_atom, uri, strong_actor_ptr, std::set<std::string>>,
+
   replies_to<connect_atom, std::string,
              uint16_t>::with<node_id, strong_actor_ptr, std::set<std::string>>,
 
+  replies_to<connect_atom,
+             uri>::with<node_id, strong_actor_ptr, std::set<std::string>>,
+
   reacts_to<unpublish_atom, actor_addr, uint16_t>,
 
   reacts_to<close_atom, uint16_t>,
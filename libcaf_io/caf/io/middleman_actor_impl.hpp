@@ -8,6 +8,7 @@
 #include "caf/fwd.hpp"
 #include "caf/io/fwd.hpp"
 #include "caf/io/middleman_actor.hpp"
+#include "caf/io/network/multiplexer.hpp"
 #include "caf/typed_actor.hpp"
 #include "caf/typed_event_based_actor.hpp"
 
@@ -47,9 +48,12 @@ public:
   behavior_type make_behavior() override;
 
 protected:
-  /// Tries to connect to given `host` and `port`. The default implementation
-  /// calls `system().middleman().backend().new_tcp_scribe(host, port)`.
-  virtual expected<scribe_ptr> connect(const std::string& host, uint16_t port);
+  /// Returns a function object for turning connected TCP sockets into
+  /// scribes, e.g., to add encryption. The multiplexer calls the function
+  /// object from its event loop, i.e., it must not access the state of this
+  /// actor. The default implementation returns `nullptr` for creating regular
+  /// scribes.
+  virtual network::multiplexer::scribe_factory tcp_scribe_factory();
 
   /// Tries to connect to given `host` and `port`. The default implementation
   /// calls `system().middleman().backend().new_udp`.
@@ -61,6 +65,22 @@ protected:
   virtual expected<doorman_ptr>
   open(uint16_t port, const char* addr, bool reuse);
 
+  /// Tries to accept shared memory connections for the actor published at
+  /// `port` if `caf.middleman.shared-memory` is enabled. The default
+  /// implementation calls
+  /// `system().middleman().backend().new_shm_doorman(port)`.
+  virtual expected<doorman_ptr> open_shm(uint16_t port);
+
+  /// Tries to connect to the Unix domain socket at `path`. Runs on a thread
+  /// of its own rather than in this actor. The default implementation calls
+  /// `system().middleman().backend().new_local_scribe(path)`.
+  virtual expected<scribe_ptr> connect_local(const std::string& path);
+
+  /// Tries to accept connections on a Unix domain socket at `path`. The
+  /// default implementation calls
+  /// `system().middleman().backend().new_local_doorman(path)`.
+  virtual expected<doorman_ptr> open_local(const std::string& path);
+
   /// Tries to open a local port. The default implementation calls
   /// `system().middleman().backend().new_tcp_doorman(port, addr, reuse)`.
   virtual expected<datagram_servant_ptr>
@@ -73,11 +93,30 @@ private:
   put_res put_udp(uint16_t port, strong_actor_ptr& whom, mpi_set& sigs,
                   const char* in = nullptr, bool reuse_addr = false);
 
+  /// Connects to `key` or returns a cached result. Endpoints with port 0
+  /// refer to Unix domain sockets.
+  get_res get_or_connect(endpoint key);
+
+  /// Receives the result of `connect_endpoint`.
+  using connect_callback = std::function<void(expected<scribe_ptr>)>;
+
+  /// Connects to `key` via Unix domain socket, shared memory or TCP and
+  /// passes the result to `f` without blocking this actor. Connects via TCP
+  /// on the multiplexer and runs the other transports on a detached worker.
+  void connect_endpoint(const endpoint& key, connect_callback f);
+
   optional<endpoint_data&> cached_tcp(const endpoint& ep);
   optional<endpoint_data&> cached_udp(const endpoint& ep);
 
   optional<std::vector<response_promise>&> pending(const endpoint& ep);
 
+  /// Checks whether we have a cached connection to `nid`.
+  bool has_cached_node(const node_id& nid) const;
+
+  /// Opens the additional connections to `nid` at `key` if
+  /// `caf.middleman.connections-per-peer` is greater than 1.
+  void connect_stripes(const endpoint& key, const node_id& nid);
+
   actor broker_;
   std::map<endpoint, endpoint_data> cached_tcp_;
   std::map<endpoint, endpoint_data> cached_udp_;
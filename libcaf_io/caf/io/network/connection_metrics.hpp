@@ -0,0 +1,42 @@
+// This file is part of CAF, the C++ Actor Framework. See the file LICENSE in
+// the main distribution directory for license terms and copyright or visit
+// https://github.com/actor-framework/actor-framework/blob/master/LICENSE.
+
+#pragma once
+
+#include "caf/fwd.hpp"
+
+namespace caf::io::network {
+
+/// Metrics for a single connection. All pointers are null unless the
+/// middleman collects connection metrics and the broker enabled them for the
+/// connection.
+struct connection_metrics {
+  /// Counts the Bytes received on the connection.
+  telemetry::int_counter* bytes_in = nullptr;
+
+  /// Counts the Bytes sent on the connection.
+  telemetry::int_counter* bytes_out = nullptr;
+
+  /// Counts the frames received on the connection. Only the broker knows its
+  /// framing, hence the broker increments this counter.
+  telemetry::int_counter* frames_in = nullptr;
+
+  /// Counts the frames sent on the connection. Only the broker knows its
+  /// framing, hence the broker increments this counter.
+  telemetry::int_counter* frames_out = nullptr;
+
+  /// Samples how long a single read from the socket takes.
+  telemetry::dbl_histogram* read_time = nullptr;
+
+  /// Samples how long a single write to the socket takes.
+  telemetry::dbl_histogram* write_time = nullptr;
+
+  /// Tracks the Bytes that wait in the write buffers of the connection.
+  telemetry::int_gauge* write_queue = nullptr;
+
+  /// Stores when the connection started, in seconds since the UNIX epoch.
+  telemetry::int_gauge* start_time = nullptr;
+};
+
+} // namespace caf::io::network
@@ -0,0 +1,79 @@
+// This file is part of CAF, the C++ Actor Framework. See the file LICENSE in
+// the main distribution directory for license terms and copyright or visit
+// https://github.com/actor-framework/actor-framework/blob/master/LICENSE.
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "caf/detail/io_export.hpp"
+#include "caf/expected.hpp"
+#include "caf/io/fwd.hpp"
+#include "caf/io/network/native_socket.hpp"
+#include "caf/io/network/resolver.hpp"
+#include "caf/ref_counted.hpp"
+#include "caf/timespan.hpp"
+
+namespace caf::io::network {
+
+/// Connects to one of the addresses of a host without blocking the event loop.
+/// Starts a new connection attempt whenever the previous attempts failed or
+/// did not succeed within the connection attempt delay, alternating between
+/// IPv6 and IPv4 addresses ("Happy Eyeballs", RFC 8305). The first successful
+/// attempt wins and the connector closes all other sockets.
+class CAF_IO_EXPORT connector : public ref_counted {
+public:
+  // -- member types -----------------------------------------------------------
+
+  /// Receives the connected socket or an error from the event loop.
+  using callback = std::function<void(expected<native_socket>)>;
+
+  // -- constructors, destructors, and assignment operators --------------------
+
+  connector(default_multiplexer& mpx, std::string host, uint16_t port,
+            const resolver::address_list& addrs, timespan attempt_delay,
+            callback f);
+
+  ~connector() override;
+
+  // -- interface functions ----------------------------------------------------
+
+  /// Starts the first connection attempt.
+  /// @warning Do not call from outside the multiplexer's event loop.
+  void start();
+
+  /// Returns the order in which the connector tries `addrs`.
+  static resolver::address_list interleave(const resolver::address_list& addrs);
+
+private:
+  class attempt;
+
+  /// Starts connecting to the next address and schedules the attempt after
+  /// that one.
+  void next();
+
+  /// Called by an attempt once its socket has connected or failed. Takes
+  /// ownership of the socket on success.
+  void done(attempt* ptr, expected<native_socket> res);
+
+  /// Reports `res` to the callback unless another attempt already did.
+  void finish(expected<native_socket> res);
+
+  default_multiplexer& mpx_;
+  std::string host_;
+  uint16_t port_;
+  resolver::address_list addrs_;
+  size_t next_addr_;
+  size_t running_;
+  timespan attempt_delay_;
+  callback f_;
+  bool finished_;
+  uint64_t timer_id_;
+  std::vector<attempt*> attempts_;
+  error last_error_;
+};
+
+} // namespace caf::io::network
@@ -4,7 +4,11 @@
 
 #pragma once
 
+#include <chrono>
 #include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
 #include <string>
 #include <thread>
 #include <vector>
@@ -12,6 +16,8 @@
 #include "caf/config.hpp"
 #include "caf/detail/io_export.hpp"
 #include "caf/extend.hpp"
+#include "caf/intrusive/lifo_inbox.hpp"
+#include "caf/intrusive/singly_linked.hpp"
 #include "caf/io/accept_handle.hpp"
 #include "caf/io/connection_handle.hpp"
 #include "caf/io/datagram_handle.hpp"
@@ -27,11 +33,14 @@
 #include "caf/io/network/operation.hpp"
 #include "caf/io/network/pipe_reader.hpp"
 #include "caf/io/network/receive_buffer.hpp"
+#include "caf/io/network/resolver.hpp"
 #include "caf/io/network/rw_state.hpp"
+#include "caf/timespan.hpp"
 #include "caf/io/network/stream_manager.hpp"
 #include "caf/io/receive_policy.hpp"
 #include "caf/io/scribe.hpp"
 #include "caf/ref_counted.hpp"
+#include "caf/timespan.hpp"
 
 #include "caf/logger.hpp"
 
@@ -104,11 +113,22 @@ public:
   expected<scribe_ptr>
   new_tcp_scribe(const std::string& host, uint16_t port) override;
 
+  void new_tcp_scribe_async(std::string host, uint16_t port,
+                            scribe_factory make, scribe_callback f) override;
+
   doorman_ptr new_doorman(native_socket fd) override;
 
   expected<doorman_ptr>
   new_tcp_doorman(uint16_t port, const char* in, bool reuse_addr) override;
 
+  expected<scribe_ptr> new_shm_scribe(uint16_t port) override;
+
+  expected<doorman_ptr> new_shm_doorman(uint16_t port) override;
+
+  expected<scribe_ptr> new_local_scribe(const std::string& path) override;
+
+  expected<doorman_ptr> new_local_doorman(const std::string& path) override;
+
   datagram_servant_ptr new_datagram_servant(native_socket fd) override;
 
   datagram_servant_ptr
@@ -164,7 +184,37 @@ public:
   /// Run all pending events generated from calls to `add` or `del`.
   void handle_internal_events();
 
+  /// Calls `f` from the event loop once `delay` has passed.
+  /// @warning Do not call from outside the multiplexer's event loop.
+  void schedule(timespan delay, std::function<void()> f);
+
+  /// Runs all resumables that other threads have passed to `exec_later`.
+  /// @warning Do not call from outside the multiplexer's event loop.
+  void handle_dispatch_requests();
+
 private:
+  /// Wraps a resumable for the dispatch queue.
+  struct dispatch_request : intrusive::singly_linked<dispatch_request> {
+    explicit dispatch_request(resumable* ptr) : ptr(ptr) {
+      // nop
+    }
+
+    resumable* ptr;
+  };
+
+  /// Releases dispatch requests that the multiplexer never runs.
+  struct dispatch_request_deleter {
+    void operator()(dispatch_request* ptr) const noexcept;
+  };
+
+  /// Configures the dispatch queue.
+  struct dispatch_queue_policy {
+    using mapped_type = dispatch_request;
+
+    using unique_pointer
+      = std::unique_ptr<dispatch_request, dispatch_request_deleter>;
+  };
+
   /// Calls `epoll`, `kqueue`, or `poll` with or without blocking.
   bool poll_once_impl(bool block);
 
@@ -210,6 +260,19 @@ private:
     }
   }
 
+  /// Returns the timeout for `poll` or `epoll_wait` in milliseconds.
+  int poll_timeout(bool block) const;
+
+  /// Runs all functions passed to `schedule` that are due.
+  /// @returns `true` if at least one function was called, `false` otherwise.
+  bool handle_timeouts();
+
+#ifdef CAF_EPOLL_MULTIPLEXER
+  /// Arms `timer_` for the earliest function passed to `schedule`.
+  /// @returns `false` if `epoll_wait` needs to wait for the timeout instead.
+  bool arm_timer();
+#endif
+
   void handle(const event& e);
 
   void handle_socket_event(native_socket fd, int mask, event_handler* ptr);
@@ -218,6 +281,9 @@ private:
 
   void wr_dispatch_request(resumable* ptr);
 
+  /// Signals the multiplexer's thread to drain the dispatch queue.
+  void wakeup();
+
   /// Socket handle to an OS-level event loop such as `epoll`. Unused in the
   /// `poll` implementation.
   native_socket epollfd_; // unused in poll() implementation
@@ -232,16 +298,34 @@ private:
   /// event handlers from `pollfd`.
   multiplexer_poll_shadow_data shadow_;
 
-  /// Pipe for pushing events and callbacks into the multiplexer's thread.
+  /// Pipe for waking up the multiplexer's thread. Both ends refer to the same
+  /// `eventfd` on Linux.
   std::pair<native_socket, native_socket> pipe_;
 
   /// Special-purpose event handler for the pipe.
   pipe_reader pipe_reader_;
 
+#ifdef CAF_EPOLL_MULTIPLEXER
+  /// Wakes up the multiplexer once the earliest function passed to `schedule`
+  /// is due. Unlike the timeout of `epoll_wait`, a `timerfd` does not round to
+  /// milliseconds. Null if the kernel refused to create a `timerfd`.
+  std::unique_ptr<event_handler> timer_;
+
+  /// Stores the deadline of `timer_` or `time_point::max()` if disarmed.
+  std::chrono::steady_clock::time_point timer_due_;
+#endif
+
+  /// Events and callbacks from other threads for the multiplexer's thread. The
+  /// queue is in blocked state while the multiplexer waits for the pipe. Hence,
+  /// only the first writer after the multiplexer drained the queue signals the
+  /// pipe.
+  intrusive::lifo_inbox<dispatch_queue_policy> dispatch_queue_;
+
+  /// Samples how many dispatch requests the multiplexer runs per wakeup.
+  telemetry::int_histogram* dispatches_per_wakeup_;
+
   /// Events posted from the multiplexer's own thread are cached in this vector
-  /// in order to prevent the multiplexer from writing into its own pipe. This
-  /// avoids a possible deadlock where the multiplexer is blocked in
-  /// `wr_dispatch_request` when the pipe's buffer is full.
+  /// in order to prevent the multiplexer from signaling its own pipe.
   std::vector<intrusive_ptr<resumable>> internally_posted_;
 
   /// Sequential ids for handles of datagram servants
@@ -249,6 +333,19 @@ private:
 
   /// Maximum messages per resume run.
   size_t max_throughput_;
+
+  /// Time to keep polling without blocking before waiting for events.
+  timespan busy_poll_duration_;
+
+  /// Value for `SO_BUSY_POLL` on new TCP sockets in microseconds or 0.
+  int socket_busy_poll_;
+
+  /// Functions passed to `schedule`, ordered by their due time.
+  std::multimap<std::chrono::steady_clock::time_point, std::function<void()>>
+    timeouts_;
+
+  /// Resolves host names for `new_tcp_scribe_async`.
+  std::unique_ptr<resolver> resolver_;
 };
 
 inline connection_handle conn_hdl_from_socket(native_socket fd) {
@@ -266,6 +363,16 @@ new_tcp_connection(const std::string& host, uint16_t port,
 CAF_IO_EXPORT expected<native_socket>
 new_tcp_acceptor_impl(uint16_t port, const char* addr, bool reuse_addr);
 
+/// Connects to the Unix domain socket at `path`.
+CAF_IO_EXPORT expected<native_socket>
+new_local_connection(const std::string& path);
+
+/// Creates a Unix domain socket listening at `path`. Replaces a stale
+/// socket file, but fails with `sec::cannot_open_port` if `path` refers to
+/// anything else or another process still listens on it.
+CAF_IO_EXPORT expected<native_socket>
+new_local_acceptor_impl(const std::string& path);
+
 expected<std::pair<native_socket, ip_endpoint>>
 new_remote_udp_endpoint_impl(const std::string& host, uint16_t port,
                              optional<protocol::network> preferred = none);
@@ -0,0 +1,60 @@
+// This file is part of CAF, the C++ Actor Framework. See the file LICENSE in
+// the main distribution directory for license terms and copyright or visit
+// https://github.com/actor-framework/actor-framework/blob/master/LICENSE.
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "caf/detail/io_export.hpp"
+#include "caf/io/fwd.hpp"
+#include "caf/io/network/doorman_impl.hpp"
+#include "caf/io/network/native_socket.hpp"
+
+namespace caf::io::network {
+
+/// Owns the file of a listening Unix domain socket. Removes the file on
+/// destruction unless another socket has replaced it in the meantime.
+class CAF_IO_EXPORT local_socket_file {
+public:
+  /// Takes ownership of the socket file at `path`, which the caller must have
+  /// bound to before.
+  explicit local_socket_file(std::string path);
+
+  local_socket_file(const local_socket_file&) = delete;
+
+  local_socket_file& operator=(const local_socket_file&) = delete;
+
+  ~local_socket_file();
+
+  const std::string& path() const noexcept {
+    return path_;
+  }
+
+private:
+  std::string path_;
+  uint64_t dev_ = 0;
+  uint64_t ino_ = 0;
+};
+
+/// Accepts connections on a Unix domain socket. Reports the path of the
+/// socket as address and 0 as port.
+class CAF_IO_EXPORT local_doorman : public doorman_impl {
+public:
+  /// Creates a doorman for the listening Unix domain socket `sockfd` bound to
+  /// `path`. The doorman removes `path` when shutting down.
+  local_doorman(default_multiplexer& mx, native_socket sockfd,
+                std::string path);
+
+  ~local_doorman() override;
+
+  std::string addr() const override;
+
+  uint16_t port() const override;
+
+protected:
+  local_socket_file file_;
+};
+
+} // namespace caf::io::network
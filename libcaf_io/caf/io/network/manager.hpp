@@ -58,6 +58,9 @@ protected:
   /// Detaches this manager from `ptr`.
   virtual void detach_from(abstract_broker* ptr) = 0;
 
+  /// Checks whether `ptr` still lists this manager as one of its servants.
+  virtual bool attached_to(abstract_broker* ptr) = 0;
+
   strong_actor_ptr parent_;
 };
 
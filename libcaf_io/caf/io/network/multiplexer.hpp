@@ -40,6 +40,24 @@ public:
   virtual expected<scribe_ptr>
   new_tcp_scribe(const std::string& host, uint16_t port) = 0;
 
+  /// Receives the result of `new_tcp_scribe_async`.
+  using scribe_callback = std::function<void(expected<scribe_ptr>)>;
+
+  /// Turns a connected TCP socket into a scribe, e.g., to add encryption.
+  /// Passes the scribe to the callback, possibly after returning to the event
+  /// loop first.
+  using scribe_factory = std::function<void(native_socket, scribe_callback)>;
+
+  /// Tries to connect to `host` on given `port` without blocking the caller.
+  /// Calls `make` for turning the connected socket into a scribe or creates a
+  /// regular scribe if `make` is `nullptr`. Passes the result to `f`, which
+  /// may run in the multiplexer's event loop. The default implementation
+  /// ignores `make` and calls `f` with the result of `new_tcp_scribe` before
+  /// returning.
+  /// @threadsafe
+  virtual void new_tcp_scribe_async(std::string host, uint16_t port,
+                                    scribe_factory make, scribe_callback f);
+
   /// Creates a new doorman from a native socket handle.
   /// @threadsafe
   virtual doorman_ptr new_doorman(native_socket fd) = 0;
@@ -52,6 +70,29 @@ public:
                   bool reuse_addr = false)
     = 0;
 
+  /// Tries to connect via shared memory to a node on the same host that
+  /// published an actor at `port`. The default implementation returns
+  /// `sec::unsupported_operation`.
+  /// @threadsafe
+  virtual expected<scribe_ptr> new_shm_scribe(uint16_t port);
+
+  /// Tries to create a doorman that accepts shared memory connections from
+  /// nodes on the same host for the actor published at `port`. The default
+  /// implementation returns `sec::unsupported_operation`.
+  /// @warning Do not call from outside the multiplexer's event loop.
+  virtual expected<doorman_ptr> new_shm_doorman(uint16_t port);
+
+  /// Tries to connect to the Unix domain socket at `path`. The default
+  /// implementation returns `sec::unsupported_operation`.
+  /// @threadsafe
+  virtual expected<scribe_ptr> new_local_scribe(const std::string& path);
+
+  /// Tries to create a doorman that accepts connections on a Unix domain
+  /// socket at `path`. The default implementation returns
+  /// `sec::unsupported_operation`.
+  /// @warning Do not call from outside the multiplexer's event loop.
+  virtual expected<doorman_ptr> new_local_doorman(const std::string& path);
+
   /// Creates a new `datagram_servant` from a native socket handle.
   /// @threadsafe
   virtual datagram_servant_ptr new_datagram_servant(native_socket fd) = 0;
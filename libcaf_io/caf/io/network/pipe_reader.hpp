@@ -26,7 +26,8 @@ public:
 
   void init(native_socket sock_fd);
 
-  resumable* try_read_next();
+  /// Consumes a wakeup signal. Returns `false` if the pipe had none.
+  bool try_read_signal();
 };
 
 } // namespace caf::io::network
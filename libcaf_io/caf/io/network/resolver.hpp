@@ -0,0 +1,110 @@
+// This file is part of CAF, the C++ Actor Framework. See the file LICENSE in
+// the main distribution directory for license terms and copyright or visit
+// https://github.com/actor-framework/actor-framework/blob/master/LICENSE.
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "caf/detail/io_export.hpp"
+#include "caf/io/fwd.hpp"
+#include "caf/io/network/protocol.hpp"
+#include "caf/timespan.hpp"
+
+namespace caf::io::network {
+
+/// Resolves host names on a pool of threads to keep `getaddrinfo` out of the
+/// event loop of the multiplexer. Caches results for a configurable time and
+/// combines concurrent lookups for the same host. Passes IP addresses through
+/// without a lookup.
+class CAF_IO_EXPORT resolver {
+public:
+  // -- member types -----------------------------------------------------------
+
+  /// Lists the addresses of a host, IPv6 addresses first.
+  using address_list = std::vector<std::pair<std::string, protocol::network>>;
+
+  /// Receives the addresses of a host or an empty list if the lookup failed.
+  using callback = std::function<void(const address_list&)>;
+
+  // -- constructors, destructors, and assignment operators --------------------
+
+  /// Creates a resolver that runs callbacks in the event loop of `mpx`. Starts
+  /// threads lazily on the first lookups, at most `max_threads`.
+  resolver(default_multiplexer& mpx, size_t max_threads, timespan ttl);
+
+  resolver(const resolver&) = delete;
+
+  resolver& operator=(const resolver&) = delete;
+
+  ~resolver();
+
+  // -- lookups ----------------------------------------------------------------
+
+  /// Resolves `host` and calls `f` from the event loop of the multiplexer.
+  /// Calls `f` immediately if the cache contains a valid entry for `host`.
+  /// @warning Do not call from outside the multiplexer's event loop.
+  void resolve(const std::string& host, callback f);
+
+  /// Stops all threads after finishing their current lookups. Afterwards,
+  /// `resolve` calls its callback with an empty list for host names.
+  void stop();
+
+  // -- properties -------------------------------------------------------------
+
+  /// Returns the number of cached hosts, including expired entries.
+  /// @private
+  size_t cache_size() const noexcept {
+    return cache_.size();
+  }
+
+private:
+  using clock_type = std::chrono::steady_clock;
+
+  struct cache_entry {
+    clock_type::time_point expires;
+    address_list addrs;
+  };
+
+  void run();
+
+  void resolved(const std::string& host, address_list addrs);
+
+  // -- members for the multiplexer's thread -----------------------------------
+
+  default_multiplexer& mpx_;
+
+  size_t max_threads_;
+
+  timespan ttl_;
+
+  std::map<std::string, cache_entry> cache_;
+
+  std::map<std::string, std::vector<callback>> pending_;
+
+  // -- members shared with the resolver threads -------------------------------
+
+  std::mutex mtx_;
+
+  std::condition_variable cv_;
+
+  std::deque<std::string> queue_;
+
+  size_t idle_threads_;
+
+  bool stopped_;
+
+  std::vector<std::thread> threads_;
+};
+
+} // namespace caf::io::network
@@ -24,8 +24,14 @@ public:
 
   byte_buffer& wr_buf() override;
 
+  size_t pending_bytes() const override;
+
   byte_buffer& rd_buf() override;
 
+  bool slices_rd_buf() const override;
+
+  void metrics(const connection_metrics& x) override;
+
   void graceful_shutdown() override;
 
   void flush() override;
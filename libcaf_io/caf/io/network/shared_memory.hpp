@@ -0,0 +1,169 @@
+// This file is part of CAF, the C++ Actor Framework. See the file LICENSE in
+// the main distribution directory for license terms and copyright or visit
+// https://github.com/actor-framework/actor-framework/blob/master/LICENSE.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "caf/config.hpp"
+#include "caf/detail/io_export.hpp"
+#include "caf/expected.hpp"
+#include "caf/intrusive_ptr.hpp"
+#include "caf/io/network/native_socket.hpp"
+#include "caf/ref_counted.hpp"
+#include "caf/timespan.hpp"
+
+namespace caf::io::network {
+
+/// Control block of a single-producer, single-consumer byte ring in a shared
+/// memory segment. Producer and consumer position live on separate cache lines
+/// to avoid false sharing between the two processes.
+struct shm_ring_header {
+  /// Position of the consumer, i.e., the number of bytes read so far.
+  alignas(CAF_CACHE_LINE_SIZE) std::atomic<uint64_t> head;
+
+  /// Position of the producer, i.e., the number of bytes written so far.
+  alignas(CAF_CACHE_LINE_SIZE) std::atomic<uint64_t> tail;
+
+  /// Set by the consumer before it goes to sleep on an empty ring.
+  alignas(CAF_CACHE_LINE_SIZE) std::atomic<bool> reader_waiting;
+
+  /// Set by the producer before it goes to sleep on a full ring.
+  std::atomic<bool> writer_waiting;
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free,
+              "shared memory rings require lock-free 64-bit atomics");
+
+/// A view to a single-producer, single-consumer byte ring in a shared memory
+/// segment. Exactly one process writes and exactly one process reads.
+class CAF_IO_EXPORT shm_ring {
+public:
+  shm_ring() noexcept : hdr_(nullptr), data_(nullptr), capacity_(0) {
+    // nop
+  }
+
+  shm_ring(shm_ring_header* hdr, std::byte* data, size_t capacity) noexcept
+    : hdr_(hdr), data_(data), capacity_(capacity) {
+    // nop
+  }
+
+  /// Returns the maximum number of bytes the ring can store.
+  size_t capacity() const noexcept {
+    return capacity_;
+  }
+
+  /// Returns the number of bytes that are currently available for reading.
+  size_t size() const noexcept;
+
+  /// Returns the number of bytes that can be written without blocking.
+  size_t free_space() const noexcept {
+    auto n = size();
+    return n < capacity_ ? capacity_ - n : 0;
+  }
+
+  /// Returns whether the positions in the header contradict the capacity,
+  /// i.e., whether the peer violated the protocol. The ring refuses to read or
+  /// write once it is corrupted.
+  bool corrupted() const noexcept {
+    return size() > capacity_;
+  }
+
+  /// Copies up to `len` bytes from `buf` into the ring. Must only get called
+  /// by the producer.
+  /// @returns the number of written bytes.
+  size_t write(const void* buf, size_t len) noexcept;
+
+  /// Copies up to `len` bytes from the ring to `buf`. Must only get called by
+  /// the consumer.
+  /// @returns the number of read bytes.
+  size_t read(void* buf, size_t len) noexcept;
+
+  /// Announces that the consumer is about to wait for new data.
+  /// @returns `true` if the ring is still empty, i.e., the consumer may go to
+  ///          sleep, `false` otherwise.
+  bool prepare_read_wait() noexcept;
+
+  /// Announces that the producer is about to wait for free space.
+  /// @returns `true` if the ring is still full, i.e., the producer may go to
+  ///          sleep, `false` otherwise.
+  bool prepare_write_wait() noexcept;
+
+  /// Checks whether the consumer waits for new data and clears the flag.
+  /// Must only get called by the producer after writing to the ring.
+  bool take_waiting_reader() noexcept;
+
+  /// Checks whether the producer waits for free space and clears the flag.
+  /// Must only get called by the consumer after reading from the ring.
+  bool take_waiting_writer() noexcept;
+
+private:
+  shm_ring_header* hdr_;
+  std::byte* data_;
+  size_t capacity_;
+};
+
+/// A memory-mapped segment with two rings, one for each direction. The process
+/// that creates the segment writes to ring 0 and reads from ring 1.
+class CAF_IO_EXPORT shm_segment : public ref_counted {
+public:
+  /// Identifies shared memory segments created by CAF.
+  static constexpr uint64_t magic_number = 0x4341465F53484D31; // "CAF_SHM1"
+
+  ~shm_segment() override;
+
+  /// Creates a new anonymous segment with two rings of at least `ring_size`
+  /// bytes each.
+  static expected<intrusive_ptr<shm_segment>> create(size_t ring_size);
+
+  /// Maps the segment referred to by `fd` into memory. Takes ownership of
+  /// `fd`.
+  static expected<intrusive_ptr<shm_segment>> attach(int fd);
+
+  /// Returns the file descriptor for sharing this segment with another
+  /// process.
+  int fd() const noexcept {
+    return fd_;
+  }
+
+  /// Returns the ring with index `i` (0 or 1).
+  shm_ring ring(size_t i) const noexcept;
+
+private:
+  shm_segment(int fd, void* addr, size_t size) noexcept;
+
+  int fd_;
+  void* addr_;
+  size_t size_;
+};
+
+/// @relates shm_segment
+using shm_segment_ptr = intrusive_ptr<shm_segment>;
+
+/// Transfers the file descriptor `fd` over the Unix domain socket `sock`.
+CAF_IO_EXPORT expected<void> send_fd(native_socket sock, int fd);
+
+/// Receives a file descriptor over the Unix domain socket `sock`, blocking
+/// until the peer sends one or until `timeout` expires.
+CAF_IO_EXPORT expected<int> receive_fd(native_socket sock, timespan timeout);
+
+/// Checks whether the peer of the Unix domain socket `sock` runs as the same
+/// user as this process.
+CAF_IO_EXPORT expected<void> check_peer_credentials(native_socket sock);
+
+/// Returns the directory for the Unix domain sockets for exchanging shared
+/// memory segments. An empty `dir` selects `$XDG_RUNTIME_DIR/caf` or
+/// `/tmp/caf-<uid>`. Creates a missing directory with mode 0700 and rejects
+/// directories that belong to another user or that other users may access.
+CAF_IO_EXPORT expected<std::string> shm_socket_dir(const std::string& dir);
+
+/// Returns the path of the Unix domain socket for exchanging shared memory
+/// segments with a node that published an actor at `port`.
+CAF_IO_EXPORT std::string shm_socket_path(const std::string& dir,
+                                          uint16_t port);
+
+} // namespace caf::io::network
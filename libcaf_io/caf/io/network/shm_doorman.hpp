@@ -0,0 +1,33 @@
+// This file is part of CAF, the C++ Actor Framework. See the file LICENSE in
+// the main distribution directory for license terms and copyright or visit
+// https://github.com/actor-framework/actor-framework/blob/master/LICENSE.
+
+#pragma once
+
+#include <string>
+
+#include "caf/detail/io_export.hpp"
+#include "caf/io/fwd.hpp"
+#include "caf/io/network/local_doorman.hpp"
+#include "caf/io/network/native_socket.hpp"
+
+namespace caf::io::network {
+
+/// Accepts connections from nodes on the same host on a Unix domain socket and
+/// hands each peer a new shared memory segment. The doorman reports the port
+/// of the TCP doorman it complements, i.e., BASP treats both alike.
+class CAF_IO_EXPORT shm_doorman : public local_doorman {
+public:
+  shm_doorman(default_multiplexer& mx, native_socket sockfd, std::string path,
+              uint16_t port, size_t ring_size);
+
+  bool new_connection() override;
+
+  uint16_t port() const override;
+
+private:
+  uint16_t port_;
+  size_t ring_size_;
+};
+
+} // namespace caf::io::network
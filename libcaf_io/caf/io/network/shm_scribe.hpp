@@ -0,0 +1,75 @@
+// This file is part of CAF, the C++ Actor Framework. See the file LICENSE in
+// the main distribution directory for license terms and copyright or visit
+// https://github.com/actor-framework/actor-framework/blob/master/LICENSE.
+
+#pragma once
+
+#include "caf/detail/io_export.hpp"
+#include "caf/io/fwd.hpp"
+#include "caf/io/network/native_socket.hpp"
+#include "caf/io/network/shared_memory.hpp"
+#include "caf/io/network/stream.hpp"
+#include "caf/io/scribe.hpp"
+#include "caf/policy/shm.hpp"
+
+namespace caf::io::network {
+
+/// A stream that transfers data through shared memory rings and uses a Unix
+/// domain socket only for wakeups. Since the socket is always writable, the
+/// stream unsubscribes from write events while the output ring is full and
+/// resubscribes once the peer signals free space.
+class CAF_IO_EXPORT shm_stream : public stream {
+public:
+  shm_stream(default_multiplexer& mpx, native_socket sockfd,
+             shm_segment_ptr seg, bool is_creator);
+
+  void handle_event(operation op) override;
+
+  void removed_from_loop(operation op) override;
+
+private:
+  void resume_writing();
+
+  policy::shm policy_;
+  bool write_suspended_;
+};
+
+/// A scribe for connections to nodes on the same host via shared memory.
+class CAF_IO_EXPORT shm_scribe : public scribe {
+public:
+  /// Creates a scribe for the Unix domain socket `sockfd` that transfers data
+  /// through `seg`. The scribe reports `port` as its remote port.
+  shm_scribe(default_multiplexer& mpx, native_socket sockfd,
+             shm_segment_ptr seg, bool is_creator, uint16_t port);
+
+  void configure_read(receive_policy::config config) override;
+
+  void ack_writes(bool enable) override;
+
+  byte_buffer& wr_buf() override;
+
+  size_t pending_bytes() const override;
+
+  byte_buffer& rd_buf() override;
+
+  void graceful_shutdown() override;
+
+  void flush() override;
+
+  std::string addr() const override;
+
+  uint16_t port() const override;
+
+  void launch();
+
+  void add_to_loop() override;
+
+  void remove_from_loop() override;
+
+private:
+  bool launched_;
+  uint16_t port_;
+  shm_stream stream_;
+};
+
+} // namespace caf::io::network
@@ -9,12 +9,14 @@
 #include "caf/byte_buffer.hpp"
 #include "caf/detail/io_export.hpp"
 #include "caf/io/fwd.hpp"
+#include "caf/io/network/connection_metrics.hpp"
 #include "caf/io/network/event_handler.hpp"
 #include "caf/io/network/rw_state.hpp"
 #include "caf/io/network/stream_manager.hpp"
 #include "caf/io/receive_policy.hpp"
 #include "caf/logger.hpp"
 #include "caf/ref_counted.hpp"
+#include "caf/telemetry/timer.hpp"
 
 namespace caf::io::network {
 
@@ -27,6 +29,8 @@ public:
 
   stream(default_multiplexer& backend_ref, native_socket sockfd);
 
+  ~stream() override;
+
   /// Starts reading data from the socket, forwarding incoming data to `mgr`.
   void start(stream_manager* mgr);
 
@@ -49,6 +53,25 @@ public:
     return wr_offline_buf_;
   }
 
+  /// Returns the number of bytes that still wait for the socket, i.e., the
+  /// unsent part of the current write buffer plus the write buffer.
+  size_t pending_bytes() const noexcept {
+    return wr_buf_.size() - written_ + wr_offline_buf_.size();
+  }
+
+  /// Returns whether this stream reads as much data as available and slices
+  /// frames out of its read buffer according to the receive policy. In this
+  /// mode, the read buffer holds data beyond the range passed to `consume`.
+  bool adaptive_reads() const noexcept {
+    return adaptive_reads_;
+  }
+
+  /// Sets the metrics for this stream. The stream counts transferred Bytes,
+  /// samples the time of each read and write, and tracks its write buffers.
+  /// @warning Must not be called outside the IO multiplexers event loop
+  ///          once the stream has been started.
+  void metrics(const connection_metrics& x);
+
   /// Returns the read buffer of this stream.
   /// @warning Must not be modified outside the IO multiplexers event loop
   ///          once the stream has been started.
@@ -86,8 +109,12 @@ protected:
         size_t reads = 0;
         while (reads < max_consecutive_reads_
                || policy.must_read_more(fd(), threshold())) {
-          auto res = policy.read_some(rb, fd(), rd_buf_.data() + collected_,
-                                      rd_buf_.size() - collected_);
+          rw_state res;
+          { // Lifetime scope of t.
+            telemetry::timer t{metrics_.read_time};
+            res = policy.read_some(rb, fd(), rd_buf_.data() + collected_,
+                                   rd_buf_.size() - collected_);
+          }
           if (!handle_read_result(res, rb))
             return;
           ++reads;
@@ -96,8 +123,12 @@ protected:
       }
       case io::network::operation::write: {
         size_t wb; // Written bytes.
-        auto res = policy.write_some(wb, fd(), wr_buf_.data() + written_,
-                                     wr_buf_.size() - written_);
+        rw_state res;
+        { // Lifetime scope of t.
+          telemetry::timer t{metrics_.write_time};
+          res = policy.write_some(wb, fd(), wr_buf_.data() + written_,
+                                  wr_buf_.size() - written_);
+        }
         handle_write_result(res, wb);
         break;
       }
@@ -110,6 +141,21 @@ protected:
 private:
   void prepare_next_read();
 
+  /// Returns the number of bytes for the next `consume` call in adaptive mode
+  /// or 0 if the buffered data does not satisfy the receive policy yet.
+  size_t next_frame_size() const noexcept;
+
+  /// Passes all complete frames in the read buffer to the reader.
+  bool consume_buffered();
+
+  /// Schedules a call to `consume_buffered` if the read buffer contains at
+  /// least one complete frame, e.g., after resuming a paused stream.
+  void resume_buffered_reads();
+
+  /// Adjusts the capacity of the read buffer to a read of `rb` bytes into
+  /// `available` bytes of free space.
+  void adapt_rd_capacity(size_t rb, size_t available);
+
   void prepare_next_write();
 
   bool handle_read_result(rw_state read_result, size_t rb);
@@ -122,6 +168,11 @@ private:
   /// connection.
   void send_fin();
 
+  /// Adds changes in the size of the write buffers to the write queue gauge
+  /// if metrics are enabled. The broker may add bytes of its own to the same
+  /// gauge, hence the stream only reports differences.
+  void update_write_queue();
+
   size_t max_consecutive_reads_;
 
   // State for reading.
@@ -131,11 +182,25 @@ private:
   size_t max_;
   byte_buffer rd_buf_;
 
+  // State for adaptive reads.
+  bool adaptive_reads_;
+  bool rd_paused_;
+  bool draining_;
+  size_t rd_pos_;
+  size_t rd_capacity_;
+  size_t small_reads_;
+
   // State for writing.
   manager_ptr writer_;
   size_t written_;
   byte_buffer wr_buf_;
   byte_buffer wr_offline_buf_;
+
+  // Optional metrics, all pointers are null if disabled.
+  connection_metrics metrics_;
+
+  // Bytes this stream added to the write queue gauge.
+  size_t reported_write_queue_ = 0;
 };
 
 } // namespace caf::io::network
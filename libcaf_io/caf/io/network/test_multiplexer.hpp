@@ -5,6 +5,7 @@
 #pragma once
 
 #include <thread>
+#include <vector>
 
 #include "caf/byte_buffer.hpp"
 #include "caf/detail/io_export.hpp"
@@ -129,6 +130,10 @@ public:
   /// Returns whether the scribe identified by `hdl` receives write ACKs.
   bool& ack_writes(connection_handle hdl);
 
+  /// Returns the size of the output buffer at each flush of the scribe
+  /// identified by `hdl`.
+  std::vector<size_t>& flushes(connection_handle hdl);
+
   /// Returns whether the dgram servant identified by `hdl` receives write ACKs.
   bool& ack_writes(datagram_handle hdl);
 
@@ -192,8 +197,8 @@ public:
 
   pending_endpoints_map& pending_endpoints();
 
-  using pending_scribes_map = std::map<std::pair<std::string, uint16_t>,
-                                       connection_handle>;
+  using pending_scribes_map
+    = std::multimap<std::pair<std::string, uint16_t>, connection_handle>;
 
   using pending_doorman_map = std::unordered_map<uint16_t, accept_handle>;
 
@@ -252,6 +257,12 @@ public:
     inline_runnables_ += num;
   }
 
+  /// Configures how many messages a runnable may handle per execution, i.e.,
+  /// per activation of a broker. Defaults to 1.
+  void max_throughput(size_t num) {
+    max_throughput_ = num;
+  }
+
   /// Executes the next enqueued runnable immediately.
   void inline_next_runnable() {
     inline_next_runnables(1);
@@ -290,6 +301,7 @@ private:
     bool passive_mode;
     intrusive_ptr<scribe> ptr;
     bool ack_writes;
+    std::vector<size_t> flushes;
 
     // Allows creating an entangled scribes where the input of this scribe is
     // the output of another scribe and vice versa.
@@ -352,6 +364,9 @@ private:
   // Configures shortcuts for runnables.
   size_t inline_runnables_;
 
+  // Configures how many messages a runnable handles per execution.
+  size_t max_throughput_;
+
   // Configures a one-shot handler for the next inlined runnable.
   std::function<void()> inline_runnable_callback_;
 
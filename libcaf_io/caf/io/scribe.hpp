@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <memory>
 #include <vector>
 
 #include "caf/allowed_unsafe_message_type.hpp"
@@ -37,9 +38,24 @@ public:
   /// Returns the current output buffer.
   virtual byte_buffer& wr_buf() = 0;
 
+  /// Returns the number of bytes that still wait for the network.
+  virtual size_t pending_bytes() const = 0;
+
   /// Returns the current input buffer.
   virtual byte_buffer& rd_buf() = 0;
 
+  /// Returns whether the input buffer holds data beyond the range passed to
+  /// `consume`. In this case, the scribe copies received data into messages
+  /// instead of lending its input buffer to the broker.
+  virtual bool slices_rd_buf() const;
+
+  /// Enables or disables `new_data_view_msg` for received data.
+  void data_views(bool enable);
+
+  /// Sets the metrics for the connection of this scribe. The default
+  /// implementation ignores `x`.
+  virtual void metrics(const network::connection_metrics& x);
+
   /// Flushes the output buffer, i.e., sends the
   /// content of the buffer via the network.
   virtual void flush() = 0;
@@ -50,6 +66,13 @@ public:
 
 protected:
   message detach_message() override;
+
+private:
+  /// Stores whether the broker receives `new_data_view_msg`.
+  bool views_ = false;
+
+  /// Caches the message for received data once the broker enabled data views.
+  std::unique_ptr<mailbox_element> view_value_;
 };
 
 using scribe_ptr = intrusive_ptr<scribe>;
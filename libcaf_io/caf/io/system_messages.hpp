@@ -15,6 +15,7 @@
 #include "caf/io/datagram_handle.hpp"
 #include "caf/io/handle.hpp"
 #include "caf/io/network/receive_buffer.hpp"
+#include "caf/span.hpp"
 
 namespace caf::io {
 
@@ -46,6 +47,21 @@ bool inspect(Inspector& f, new_data_msg& x) {
   return f.object(x).fields(f.field("handle", x.handle), f.field("buf", x.buf));
 }
 
+/// Signalizes newly arrived data for a {@link broker} that enabled data views
+/// for the connection. The view refers to memory of the connection and remains
+/// valid only while the broker handles this message.
+struct new_data_view_msg {
+  /// Handle to the related connection.
+  connection_handle handle;
+  /// View into the received data.
+  span<const byte> buf;
+
+  /// Copies the received data for keeping it beyond the message handler.
+  byte_buffer retain() const {
+    return byte_buffer{buf.begin(), buf.end()};
+  }
+};
+
 /// Signalizes that a certain amount of bytes has been written.
 struct data_transferred_msg {
   /// Handle to the related connection.
@@ -0,0 +1,71 @@
+// This file is part of CAF, the C++ Actor Framework. See the file LICENSE in
+// the main distribution directory for license terms and copyright or visit
+// https://github.com/actor-framework/actor-framework/blob/master/LICENSE.
+
+#pragma once
+
+#include "caf/detail/io_export.hpp"
+#include "caf/io/network/native_socket.hpp"
+#include "caf/io/network/rw_state.hpp"
+#include "caf/io/network/shared_memory.hpp"
+
+namespace caf::policy {
+
+/// Transfers bytes through a pair of shared memory rings. The file descriptor
+/// passed to the member functions is a Unix domain socket to the peer that
+/// only carries wakeup notifications ("doorbells") and signals a shutdown of
+/// the peer.
+class CAF_IO_EXPORT shm {
+public:
+  /// Creates a policy for the segment `seg`. The creator of the segment writes
+  /// to ring 0 and reads from ring 1, the peer does the opposite.
+  shm(io::network::shm_segment_ptr seg, bool is_creator);
+
+  /// Reads up to `len` bytes from the input ring. Returns
+  /// `rw_state::failure` once the peer has closed the connection and the ring
+  /// contains no more data.
+  io::network::rw_state read_some(size_t& result, io::network::native_socket fd,
+                                  void* buf, size_t len);
+
+  /// Writes up to `len` bytes to the output ring. Stores 0 in `result` and
+  /// marks the policy as blocked if the ring has no free space.
+  io::network::rw_state write_some(size_t& result,
+                                   io::network::native_socket fd,
+                                   const void* buf, size_t len);
+
+  /// Returns whether the input ring still contains data. The peer only rings
+  /// the doorbell after we went to sleep on an empty ring, i.e., we must not
+  /// stop reading before draining the ring.
+  bool must_read_more(io::network::native_socket, size_t) const noexcept {
+    return in_.size() > 0;
+  }
+
+  /// Returns whether the last write stopped on a full output ring.
+  bool blocked() const noexcept {
+    return blocked_;
+  }
+
+  /// Returns whether the output ring has free space again and clears the
+  /// blocked flag in this case. Otherwise, asks the peer again for a wakeup.
+  bool unblock() noexcept;
+
+  /// Returns whether the peer has shut down the connection.
+  bool peer_closed() const noexcept {
+    return peer_closed_;
+  }
+
+private:
+  /// Reads all pending doorbells from `fd`.
+  void drain(io::network::native_socket fd);
+
+  /// Wakes up the peer.
+  static void ring_doorbell(io::network::native_socket fd);
+
+  io::network::shm_segment_ptr segment_;
+  io::network::shm_ring in_;
+  io::network::shm_ring out_;
+  bool blocked_;
+  bool peer_closed_;
+};
+
+} // namespace caf::policy
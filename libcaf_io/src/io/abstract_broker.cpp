@@ -3,20 +3,32 @@
 // https://github.com/actor-framework/actor-framework/blob/master/LICENSE.
 
 #include "caf/actor_system.hpp"
+#include "caf/actor_system_config.hpp"
 #include "caf/config.hpp"
+#include "caf/defaults.hpp"
 #include "caf/detail/scope_guard.hpp"
 #include "caf/detail/sync_request_bouncer.hpp"
 #include "caf/event_based_actor.hpp"
 #include "caf/io/broker.hpp"
+#include "caf/io/middleman.hpp"
+#include "caf/io/network/default_multiplexer.hpp"
 #include "caf/io/network/multiplexer.hpp"
 #include "caf/logger.hpp"
 #include "caf/make_counted.hpp"
 #include "caf/none.hpp"
 #include "caf/scheduler/abstract_coordinator.hpp"
 #include "caf/span.hpp"
+#include "caf/telemetry/timer.hpp"
 
 namespace caf::io {
 
+namespace {
+
+// Points to the broker that currently runs on this thread.
+thread_local abstract_broker* t_running_broker;
+
+} // namespace
+
 void abstract_broker::enqueue(strong_actor_ptr src, message_id mid, message msg,
                               execution_unit*) {
   enqueue(make_mailbox_element(std::move(src), mid, {}, std::move(msg)),
@@ -25,7 +37,8 @@ void abstract_broker::enqueue(strong_actor_ptr src, message_id mid, message msg,
 
 void abstract_broker::enqueue(mailbox_element_ptr ptr, execution_unit*) {
   CAF_PUSH_AID(id());
-  scheduled_actor::enqueue(std::move(ptr), backend_);
+  // A null pointer makes the actor schedule itself via the scheduler.
+  scheduled_actor::enqueue(std::move(ptr), scheduled_ ? nullptr : backend_);
 }
 
 void abstract_broker::launch(execution_unit* eu, bool lazy, bool hide) {
@@ -33,13 +46,16 @@ void abstract_broker::launch(execution_unit* eu, bool lazy, bool hide) {
   CAF_ASSERT(eu != nullptr);
   CAF_ASSERT(dynamic_cast<network::multiplexer*>(eu) != nullptr);
   backend_ = static_cast<network::multiplexer*>(eu);
-  CAF_LOG_TRACE(CAF_ARG(lazy) << CAF_ARG(hide));
+  CAF_LOG_TRACE(CAF_ARG(lazy) << CAF_ARG(hide) << CAF_ARG(scheduled_));
   if (!hide)
     register_at_system();
   if (lazy && mailbox().try_block())
     return;
   intrusive_ptr_add_ref(ctrl());
-  eu->exec_later(this);
+  if (scheduled_)
+    home_system().scheduler().enqueue(this);
+  else
+    eu->exec_later(this);
 }
 
 bool abstract_broker::cleanup(error&& reason, execution_unit* host) {
@@ -48,6 +64,15 @@ bool abstract_broker::cleanup(error&& reason, execution_unit* host) {
   CAF_ASSERT(doormen_.empty());
   CAF_ASSERT(scribes_.empty());
   CAF_ASSERT(datagram_servants_.empty());
+  if (scheduled_) {
+    // Pending events may keep servants and thus this broker alive.
+    std::vector<io_event> events;
+    { // Lifetime scope of guard.
+      std::unique_lock<std::mutex> guard{io_events_mtx_};
+      io_events_closed_ = true;
+      events.swap(io_events_);
+    }
+  }
   return local_actor::cleanup(std::move(reason), host);
 }
 
@@ -58,19 +83,38 @@ abstract_broker::~abstract_broker() {
 void abstract_broker::configure_read(connection_handle hdl,
                                      receive_policy::config cfg) {
   CAF_LOG_TRACE(CAF_ARG(hdl) << CAF_ARG(cfg));
-  if (auto x = by_id(hdl))
-    x->configure_read(cfg);
+  with_servant(hdl, [cfg](scribe& x) { x.configure_read(cfg); });
 }
 
 void abstract_broker::ack_writes(connection_handle hdl, bool enable) {
   CAF_LOG_TRACE(CAF_ARG(hdl) << CAF_ARG(enable));
-  if (auto x = by_id(hdl))
-    x->ack_writes(enable);
+  if (scheduled_ && valid(hdl))
+    staged_writes_[hdl].ack_writes = enable;
+  with_servant(hdl, [enable](scribe& x) { x.ack_writes(enable); });
+}
+
+void abstract_broker::data_views(connection_handle hdl, bool enable) {
+  CAF_LOG_TRACE(CAF_ARG(hdl) << CAF_ARG(enable));
+  with_servant(hdl, [enable](scribe& x) { x.data_views(enable); });
+}
+
+network::connection_metrics
+abstract_broker::connection_metrics(connection_handle hdl, string_view node) {
+  CAF_LOG_TRACE(CAF_ARG(hdl) << CAF_ARG(node));
+  if (!valid(hdl))
+    return {};
+  auto id = std::to_string(hdl.id());
+  auto result = home_system().middleman().connection_metrics(node, id);
+  if (result.bytes_in != nullptr)
+    with_servant(hdl, [result](scribe& x) { x.metrics(result); });
+  return result;
 }
 
 byte_buffer& abstract_broker::wr_buf(connection_handle hdl) {
   CAF_ASSERT(hdl != invalid_connection_handle);
   if (auto x = by_id(hdl)) {
+    if (scheduled_)
+      return staged_writes_[hdl].buf;
     return x->wr_buf();
   } else {
     CAF_LOG_ERROR("tried to access wr_buf() of an unknown connection_handle:"
@@ -91,18 +135,26 @@ void abstract_broker::write(connection_handle hdl, span<const byte> buf) {
 }
 
 void abstract_broker::flush(connection_handle hdl) {
+  if (scheduled_) {
+    flush_staged(hdl);
+    return;
+  }
   if (auto x = by_id(hdl))
     x->flush();
 }
 
 void abstract_broker::ack_writes(datagram_handle hdl, bool enable) {
   CAF_LOG_TRACE(CAF_ARG(hdl) << CAF_ARG(enable));
-  if (auto x = by_id(hdl))
-    x->ack_writes(enable);
+  with_servant(hdl, [enable](datagram_servant& x) { x.ack_writes(enable); });
 }
 
 byte_buffer& abstract_broker::wr_buf(datagram_handle hdl) {
   if (auto x = by_id(hdl)) {
+    if (scheduled_) {
+      // Each call to wr_buf starts a new datagram.
+      staged_datagrams_.emplace_back(hdl, byte_buffer{});
+      return staged_datagrams_.back().second;
+    }
     return x->wr_buf(hdl);
   } else {
     CAF_LOG_ERROR("tried to access wr_buf() of an unknown"
@@ -112,7 +164,9 @@ byte_buffer& abstract_broker::wr_buf(datagram_handle hdl) {
 }
 
 void abstract_broker::enqueue_datagram(datagram_handle hdl, byte_buffer buf) {
-  if (auto x = by_id(hdl))
+  if (scheduled_ && valid(hdl))
+    staged_datagrams_.emplace_back(hdl, std::move(buf));
+  else if (auto x = by_id(hdl))
     x->enqueue_datagram(hdl, std::move(buf));
   else
     CAF_LOG_ERROR("tried to access datagram_buffer() of an unknown"
@@ -127,6 +181,10 @@ void abstract_broker::write(datagram_handle hdl, size_t bs, const void* buf) {
 }
 
 void abstract_broker::flush(datagram_handle hdl) {
+  if (scheduled_) {
+    flush_staged(hdl);
+    return;
+  }
   if (auto x = by_id(hdl))
     x->flush();
 }
@@ -204,6 +262,14 @@ void abstract_broker::add_hdl_for_datagram_servant(datagram_servant_ptr ptr,
   CAF_LOG_TRACE(CAF_ARG(ptr) << CAF_ARG(hdl));
   CAF_ASSERT(ptr != nullptr);
   CAF_ASSERT(ptr->parent() == this);
+  if (scheduled_ && !in_context()) {
+    // Datagram servants add new endpoints from the event loop.
+    post_io_event(io_event{
+      [this, hdl, ptr{std::move(ptr)}](execution_unit*) mutable {
+        get_map(hdl).emplace(hdl, std::move(ptr));
+      }});
+    return;
+  }
   get_map(hdl).emplace(hdl, std::move(ptr));
 }
 
@@ -315,16 +381,33 @@ uint16_t abstract_broker::local_port(datagram_handle hdl) {
 }
 
 bool abstract_broker::remove_endpoint(datagram_handle hdl) {
-  if (auto x = by_id(hdl)) {
-    x->remove_endpoint(hdl);
-    return true;
-  } else {
+  if (!valid(hdl))
     return false;
-  }
+  with_servant(hdl, [hdl](datagram_servant& x) { x.remove_endpoint(hdl); });
+  return true;
 }
 
 void abstract_broker::close_all() {
   CAF_LOG_TRACE("");
+  if (scheduled_) {
+    // Servants detach in the event loop, hence we clear the containers here.
+    for (auto& kvp : scribes_)
+      flush_staged(kvp.first);
+    flush_staged(datagram_handle{});
+    for (auto& kvp : doormen_)
+      shutdown_servant(std::move(kvp.second));
+    for (auto& kvp : scribes_)
+      shutdown_servant(std::move(kvp.second));
+    // Datagram servants can appear multiple times in the container.
+    for (auto& kvp : datagram_servants_)
+      if (kvp.second != nullptr && kvp.first == kvp.second->hdl())
+        shutdown_servant(std::move(kvp.second));
+    doormen_.clear();
+    scribes_.clear();
+    datagram_servants_.clear();
+    staged_writes_.clear();
+    return;
+  }
   // Calling graceful_shutdown causes the objects to detach from the broker by
   // removing from the container.
   while (!doormen_.empty())
@@ -335,15 +418,207 @@ void abstract_broker::close_all() {
     datagram_servants_.begin()->second->graceful_shutdown();
 }
 
+size_t abstract_broker::pending_bytes(connection_handle hdl) {
+  auto x = by_id(hdl);
+  if (!x)
+    return 0;
+  if (!scheduled_)
+    return x->pending_bytes();
+  auto i = staged_writes_.find(hdl);
+  return i != staged_writes_.end() ? i->second.buf.size() + i->second.in_flight
+                                   : 0;
+}
+
+void abstract_broker::dispatch_io_event(io_event f) {
+  if (!in_context())
+    post_io_event(std::move(f));
+  else if (scheduled_)
+    f(context());
+  else
+    f(&backend());
+}
+
+void abstract_broker::post_io_event(io_event f) {
+  if (!scheduled_) {
+    backend().post(
+      [self{strong_actor_ptr{ctrl()}}, f{std::move(f)}]() mutable {
+        auto ptr = static_cast<abstract_broker*>(self->get());
+        f(&ptr->backend());
+      });
+    return;
+  }
+  { // Lifetime scope of guard.
+    std::unique_lock<std::mutex> guard{io_events_mtx_};
+    if (io_events_closed_)
+      return;
+    io_events_.emplace_back(std::move(f));
+  }
+  // Schedule the broker unless it runs or already waits for a worker. Note
+  // that resume() checks for new events after blocking the mailbox.
+  if (mailbox().try_unblock()) {
+    intrusive_ptr_add_ref(ctrl());
+    home_system().scheduler().enqueue(this);
+  }
+}
+
+bool abstract_broker::in_context() const noexcept {
+  if (scheduled_)
+    return t_running_broker == this;
+  return std::this_thread::get_id() == backend_->thread_id();
+}
+
+void abstract_broker::run_io_events(execution_unit* ctx) {
+  std::vector<io_event> events;
+  { // Lifetime scope of guard.
+    std::unique_lock<std::mutex> guard{io_events_mtx_};
+    events.swap(io_events_);
+  }
+  for (auto& f : events) {
+    if (getf(is_terminated_flag))
+      return;
+    context(ctx);
+    f(ctx);
+  }
+}
+
+void abstract_broker::post_to_backend(backend_event f) {
+  backend().post(std::move(f));
+}
+
+void abstract_broker::delayed_io_send_impl(timespan delay, message msg) {
+  auto mpx = dynamic_cast<network::default_multiplexer*>(backend_);
+  if (mpx == nullptr) {
+    auto& clk = clock();
+    clk.schedule_message(clk.now() + delay, strong_actor_ptr{ctrl()},
+                         make_mailbox_element(nullptr, make_message_id(), {},
+                                              std::move(msg)));
+    return;
+  }
+  // Runs in the event loop once the timeout expires. Brokers on the scheduler
+  // receive the message with their next I/O events.
+  auto fire = [self{weak_actor_ptr{ctrl()}}, msg{std::move(msg)}] {
+    auto strong_self = self.lock();
+    if (!strong_self)
+      return;
+    auto ptr = static_cast<abstract_broker*>(strong_self->get());
+    ptr->dispatch_io_event(io_event{[ptr, msg](execution_unit* ctx) {
+      if (ptr->getf(is_terminated_flag))
+        return;
+      auto pfac = ptr->proxy_registry_ptr();
+      auto prev = ctx->proxy_registry_ptr();
+      if (pfac)
+        ctx->proxy_registry_ptr(pfac);
+      auto guard = detail::make_scope_guard([=] {
+        if (pfac)
+          ctx->proxy_registry_ptr(prev);
+      });
+      mailbox_element tmp{strong_actor_ptr{}, make_message_id(),
+                          mailbox_element::forwarding_stack{}, msg};
+      ptr->activate(ctx, tmp);
+      // Brokers on the scheduler run this event from resume().
+      if (!ptr->scheduled_)
+        ptr->after_activation();
+    }});
+  };
+  if (!scheduled_ && in_context()) {
+    mpx->schedule(delay, std::move(fire));
+    return;
+  }
+  auto t0 = std::chrono::steady_clock::now();
+  post_to_backend(
+    backend_event{[mpx, delay, t0, fire{std::move(fire)}]() mutable {
+      auto elapsed = std::chrono::steady_clock::now() - t0;
+      mpx->schedule(delay - elapsed, std::move(fire));
+    }});
+}
+
+void abstract_broker::flush_staged(connection_handle hdl) {
+  auto i = staged_writes_.find(hdl);
+  if (i == staged_writes_.end() || i->second.buf.empty())
+    return;
+  auto j = scribes_.find(hdl);
+  if (j == scribes_.end()) {
+    staged_writes_.erase(i);
+    return;
+  }
+  auto& st = i->second;
+  if (st.ack_writes)
+    st.in_flight += st.buf.size();
+  backend().post([ptr{j->second}, buf{std::move(st.buf)}]() mutable {
+    if (ptr->detached())
+      return;
+    auto& out = ptr->wr_buf();
+    if (out.empty())
+      out.swap(buf);
+    else
+      out.insert(out.end(), buf.begin(), buf.end());
+    ptr->flush();
+  });
+  st.buf = byte_buffer{};
+}
+
+void abstract_broker::flush_staged(datagram_handle) {
+  while (!staged_datagrams_.empty()) {
+    auto& [hdl, buf] = staged_datagrams_.front();
+    if (auto i = datagram_servants_.find(hdl); i != datagram_servants_.end()) {
+      backend().post(
+        [ptr{i->second}, hdl{hdl}, buf{std::move(buf)}]() mutable {
+          if (ptr->detached())
+            return;
+          ptr->enqueue_datagram(hdl, std::move(buf));
+          ptr->flush();
+        });
+    }
+    staged_datagrams_.pop_front();
+  }
+}
+
+void abstract_broker::after_activation() {
+  if (!scheduled_)
+    return;
+  for (auto& kvp : staged_writes_)
+    flush_staged(kvp.first);
+  flush_staged(datagram_handle{});
+}
+
 resumable::subtype_t abstract_broker::subtype() const {
-  return io_actor;
+  return scheduled_ ? resumable::scheduled_actor : io_actor;
 }
 
 resumable::resume_result
 abstract_broker::resume(execution_unit* ctx, size_t mt) {
   CAF_ASSERT(ctx != nullptr);
-  CAF_ASSERT(ctx == backend_);
-  return scheduled_actor::resume(ctx, mt);
+  if (!scheduled_) {
+    CAF_ASSERT(ctx == backend_);
+    auto result = scheduled_actor::resume(ctx, mt);
+    after_activation();
+    return result;
+  }
+  auto prev = t_running_broker;
+  t_running_broker = this;
+  auto guard = detail::make_scope_guard([prev] { t_running_broker = prev; });
+  for (;;) {
+    run_io_events(ctx);
+    if (getf(is_terminated_flag))
+      return resumable::done;
+    auto result = scheduled_actor::resume(ctx, mt);
+    if (result != resumable::awaiting_message) {
+      after_activation();
+      return result;
+    }
+    // Another worker may have picked up this broker after blocking the
+    // mailbox. Otherwise, we continue if new events arrived in the meantime.
+    if (!mailbox().try_unblock())
+      return result;
+    after_activation();
+    bool idle;
+    { // Lifetime scope of guard.
+      std::unique_lock<std::mutex> guard{io_events_mtx_};
+      idle = io_events_.empty();
+    }
+    if (idle && mailbox().try_block())
+      return result;
+  }
 }
 
 const char* abstract_broker::name() const {
@@ -355,24 +630,44 @@ void abstract_broker::init_broker() {
   setf(is_initialized_flag);
   // launch backends now, because user-defined initialization
   // might call functions like add_connection
-  for (auto& kvp : doormen_)
-    kvp.second->launch();
+  for (auto& kvp : doormen_) {
+    if (scheduled_)
+      backend().post([ptr{kvp.second}] { ptr->launch(); });
+    else
+      kvp.second->launch();
+  }
 }
 
 abstract_broker::abstract_broker(actor_config& cfg) : scheduled_actor(cfg) {
-  // nop
+  auto mode = get_or(home_system().config(), "caf.middleman.broker-execution",
+                     defaults::middleman::broker_execution);
+  scheduled_ = mode == "scheduler";
+  CAF_LOG_WARNING_IF(!scheduled_ && mode != "multiplexer",
+                     "invalid broker execution mode, use 'multiplexer':"
+                       << CAF_ARG(mode));
+  auto& mm_metrics = home_system().middleman().metric_singletons;
+  io_latency_ = scheduled_ ? mm_metrics.scheduler_broker_latency
+                           : mm_metrics.multiplexer_broker_latency;
 }
 
 void abstract_broker::launch_servant(doorman_ptr& ptr) {
   // A doorman needs to be launched in addition to being initialized. This
   // allows CAF to assign doorman to uninitialized brokers.
-  if (getf(is_initialized_flag))
-    ptr->launch();
+  if (getf(is_initialized_flag)) {
+    if (scheduled_)
+      backend().post([ptr] { ptr->launch(); });
+    else
+      ptr->launch();
+  }
 }
 
 void abstract_broker::launch_servant(datagram_servant_ptr& ptr) {
-  if (getf(is_initialized_flag))
-    ptr->launch();
+  if (getf(is_initialized_flag)) {
+    if (scheduled_)
+      backend().post([ptr] { ptr->launch(); });
+    else
+      ptr->launch();
+  }
 }
 
 } // namespace caf::io
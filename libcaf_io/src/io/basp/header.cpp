@@ -10,6 +10,8 @@ namespace caf::io::basp {
 
 const uint8_t header::named_receiver_flag;
 
+const uint8_t header::fragmentation_flag;
+
 std::string to_bin(uint8_t x) {
   std::string res;
   for (auto offset = 7; offset > -1; --offset)
@@ -70,6 +72,11 @@ bool heartbeat_valid(const header& hdr) {
          && zero(hdr.operation_data);
 }
 
+bool fragment_valid(const header& hdr) {
+  return zero(hdr.source_actor) && zero(hdr.dest_actor)
+         && !zero(hdr.payload_len) && zero(hdr.operation_data);
+}
+
 } // namespace
 
 bool valid(const header& hdr) {
@@ -90,6 +97,8 @@ bool valid(const header& hdr) {
       return down_message_valid(hdr);
     case message_type::heartbeat:
       return heartbeat_valid(hdr);
+    case message_type::fragment:
+      return fragment_valid(hdr);
   }
 }
 
@@ -6,6 +6,7 @@
 
 #include <algorithm>
 
+#include "caf/actor_cast.hpp"
 #include "caf/actor_system_config.hpp"
 #include "caf/binary_deserializer.hpp"
 #include "caf/binary_serializer.hpp"
@@ -13,8 +14,11 @@
 #include "caf/io/basp/remote_message_handler.hpp"
 #include "caf/io/basp/version.hpp"
 #include "caf/io/basp/worker.hpp"
+#include "caf/send.hpp"
 #include "caf/settings.hpp"
+#include "caf/telemetry/counter.hpp"
 #include "caf/telemetry/histogram.hpp"
+#include "caf/telemetry/metric_family_impl.hpp"
 #include "caf/telemetry/timer.hpp"
 
 namespace caf::io::basp {
@@ -37,35 +41,44 @@ instance::instance(abstract_broker* parent, callee& lstnr)
   else
     workers = std::min(3u, std::thread::hardware_concurrency() / 4u) + 1;
   for (size_t i = 0; i < workers; ++i)
-    hub_.add_new_worker(queue_, proxies());
+    hub_.add_new_worker(proxies());
+  max_fragment_size(get_or(config(), "caf.middleman.max-fragment-size",
+                           defaults::middleman::max_fragment_size));
+  priority_lanes_ = get_or(config(), "caf.middleman.priority-lanes",
+                           defaults::middleman::priority_lanes);
+  // Messages start waiting in their lane once the write buffer holds as many
+  // bytes as would trigger a flush.
+  lane_limit_ = std::max(get_or(config(), "caf.middleman.flush-threshold",
+                                defaults::middleman::flush_threshold),
+                         header_size);
+  connections_per_peer_
+    = std::clamp(get_or(config(), "caf.middleman.connections-per-peer",
+                        defaults::middleman::connections_per_peer),
+                 size_t{1}, max_connections_per_peer);
+  connection_metrics_ = get_or(config(), "caf.middleman.connection-metrics",
+                               defaults::middleman::connection_metrics);
 }
 
 connection_state instance::handle(execution_unit* ctx, new_data_msg& dm,
                                   header& hdr, bool is_payload) {
   CAF_LOG_TRACE(CAF_ARG(dm) << CAF_ARG(is_payload));
-  // function object providing cleanup code on errors
-  auto err = [&](connection_state code) {
-    if (auto nid = tbl_.erase_direct(dm.handle))
-      callee_.purge_state(nid);
-    return code;
-  };
   byte_buffer* payload = nullptr;
   if (is_payload) {
     payload = &dm.buf;
     if (payload->size() != hdr.payload_len) {
       CAF_LOG_WARNING("received invalid payload, expected"
                       << hdr.payload_len << "bytes, got" << payload->size());
-      return err(malformed_basp_message);
+      return malformed_basp_message;
     }
   } else {
     binary_deserializer source{ctx, dm.buf};
     if (!source.apply(hdr)) {
       CAF_LOG_WARNING("failed to receive header:" << source.get_error());
-      return err(malformed_basp_message);
+      return malformed_basp_message;
     }
     if (!valid(hdr)) {
       CAF_LOG_WARNING("received invalid header:" << CAF_ARG(hdr));
-      return err(malformed_basp_message);
+      return malformed_basp_message;
     }
     if (hdr.payload_len > 0) {
       CAF_LOG_DEBUG("await payload before processing further");
@@ -78,11 +91,85 @@ connection_state instance::handle(execution_unit* ctx, new_data_msg& dm,
 
 void instance::handle_heartbeat(execution_unit* ctx) {
   CAF_LOG_TRACE("");
-  for (auto& kvp : tbl_.direct_by_hdl_) {
-    CAF_LOG_TRACE(CAF_ARG(kvp.first) << CAF_ARG(kvp.second));
-    write_heartbeat(ctx, callee_.get_buffer(kvp.first));
-    callee_.flush(kvp.first);
+  for (auto hdl : tbl_.direct_connections()) {
+    CAF_LOG_TRACE(CAF_ARG(hdl));
+    header hdr{message_type::heartbeat, 0, 0, 0, invalid_actor_id,
+               invalid_actor_id};
+    write_message(ctx, hdl, lane::urgent, hdr, nullptr);
+    callee_.flush(hdl);
+  }
+}
+
+void instance::write_pending(execution_unit* ctx, connection_handle hdl) {
+  CAF_LOG_TRACE(CAF_ARG(hdl));
+  auto ectx = callee_.get_context(hdl);
+  if (ectx == nullptr)
+    return;
+  auto& urgent = ectx->lanes[static_cast<size_t>(lane::urgent)];
+  auto& normal = ectx->lanes[static_cast<size_t>(lane::normal)];
+  auto& bulk = ectx->lanes[static_cast<size_t>(lane::bulk)];
+  if (urgent.empty() && normal.empty() && bulk.empty())
+    return;
+  auto& buf = callee_.get_buffer(hdl);
+  auto& mm_metrics = system().middleman().metric_singletons;
+  auto now = std::chrono::steady_clock::now();
+  auto observe = [&](telemetry::dbl_histogram* h, const pending_frame& x) {
+    using dbl_secs = std::chrono::duration<double>;
+    h->observe(std::chrono::duration_cast<dbl_secs>(now - x.enqueued).count());
+  };
+  auto pop = [&](std::deque<pending_frame>& xs) {
+    auto& x = xs.front();
+    buf.insert(buf.end(), x.bytes.begin(), x.bytes.end());
+    ectx->queued_bytes -= x.bytes.size();
+    xs.pop_front();
+  };
+  auto queued = ectx->queued_bytes;
+  auto limit = lane_limit();
+  auto max_size = ectx->max_fragment_size;
+  auto bulk_limit = max_size > 0 ? max_size : limit;
+  for (;;) {
+    if (!urgent.empty() && buf.size() < limit) {
+      observe(mm_metrics.urgent_queueing_time, urgent.front());
+      pop(urgent);
+    } else if (!normal.empty() && buf.size() < limit) {
+      observe(mm_metrics.normal_queueing_time, normal.front());
+      pop(normal);
+    } else if (!bulk.empty() && buf.size() < bulk_limit) {
+      // Keeping at most one fragment in the write buffer allows other messages
+      // to slip in between two fragments.
+      auto& frame = bulk.front();
+      if (frame.written == 0) {
+        observe(mm_metrics.bulk_queueing_time, frame);
+        if (max_size == 0 || frame.bytes.size() <= max_size) {
+          // Messages that only wait for their turn go out unfragmented.
+          pop(bulk);
+          continue;
+        }
+      }
+      auto n = std::min(max_size, frame.bytes.size() - frame.written);
+      header hdr{message_type::fragment,
+                 0,
+                 static_cast<uint32_t>(n),
+                 0,
+                 invalid_actor_id,
+                 invalid_actor_id};
+      binary_serializer sink{ctx, buf};
+      if (!sink.apply(hdr)
+          || !sink.value(make_span(frame.bytes.data() + frame.written, n)))
+        CAF_LOG_ERROR(sink.get_error());
+      frame.written += n;
+      ectx->queued_bytes -= n;
+      if (frame.written == frame.bytes.size())
+        bulk.pop_front();
+    } else {
+      break;
+    }
   }
+  // The bytes now wait in the write buffer and the stream reports them.
+  if (ectx->metrics.write_queue != nullptr)
+    ectx->metrics.write_queue->dec(
+      static_cast<int64_t>(queued - ectx->queued_bytes));
+  callee_.flush(hdl);
 }
 
 optional<routing_table::route> instance::lookup(const node_id& target) {
@@ -98,6 +185,11 @@ void instance::write(execution_unit* ctx, const routing_table::route& r,
   CAF_LOG_TRACE(CAF_ARG(hdr));
   CAF_ASSERT(hdr.payload_len == 0 || writer != nullptr);
   write(ctx, callee_.get_buffer(r.hdl), hdr, writer);
+  if (connection_metrics_) {
+    auto ectx = callee_.get_context(r.hdl);
+    if (ectx != nullptr && ectx->metrics.frames_out != nullptr)
+      ectx->metrics.frames_out->inc();
+  }
   flush(r);
 }
 
@@ -158,11 +250,44 @@ bool instance::dispatch(execution_unit* ctx, const strong_actor_ptr& sender,
                         uint8_t flags, message_id mid, const message& msg) {
   CAF_LOG_TRACE(CAF_ARG(sender)
                 << CAF_ARG(dest_node) << CAF_ARG(mid) << CAF_ARG(msg));
+  auto& mm_metrics = system().middleman().metric_singletons;
+  auto by_type = mm_metrics.serialization_time_by_type;
+  auto body = make_callback([&](binary_serializer& sink) {
+    if (by_type == nullptr)
+      return sink.apply(forwarding_stack) && sink.apply(msg);
+    if (!sink.apply(forwarding_stack))
+      return false;
+    telemetry::timer t{by_type->get_or_add({{"type", to_string(msg.types())}})};
+    return sink.apply(msg);
+  });
+  return dispatch_impl(ctx, sender, dest_node, dest_actor, flags, mid, body,
+                       false);
+}
+
+bool instance::dispatch(execution_unit* ctx, const strong_actor_ptr& sender,
+                        const node_id& dest_node, uint64_t dest_actor,
+                        uint8_t flags, message_id mid,
+                        const_byte_span payload) {
+  CAF_LOG_TRACE(CAF_ARG(sender) << CAF_ARG(dest_node) << CAF_ARG(mid)
+                                << CAF_ARG2("payload_len", payload.size()));
+  auto body = make_callback([&](binary_serializer& sink) {
+    return sink.value(payload);
+  });
+  return dispatch_impl(ctx, sender, dest_node, dest_actor, flags, mid, body,
+                       true);
+}
+
+bool instance::dispatch_impl(execution_unit* ctx,
+                             const strong_actor_ptr& sender,
+                             const node_id& dest_node, uint64_t dest_actor,
+                             uint8_t flags, message_id mid,
+                             payload_writer& body, bool serialized) {
   CAF_ASSERT(dest_node && this_node_ != dest_node);
   auto path = lookup(dest_node);
   if (!path)
     return false;
   auto& source_node = sender ? sender->node() : this_node_;
+  auto ln = mid.is_urgent_message() ? lane::urgent : lane::normal;
   if (dest_node == path->next_hop && source_node == this_node_) {
     header hdr{message_type::direct_message,
                flags,
@@ -170,10 +295,10 @@ bool instance::dispatch(execution_unit* ctx, const strong_actor_ptr& sender,
                mid.integer_value(),
                sender ? sender->id() : invalid_actor_id,
                dest_actor};
-    auto writer = make_callback([&](binary_serializer& sink) { //
-      return sink.apply(forwarding_stack) && sink.apply(msg);
-    });
-    write(ctx, callee_.get_buffer(path->hdl), hdr, &writer);
+    auto hdl = select_stripe(dest_node, path->hdl, hdr.source_actor, sender);
+    write_message(ctx, hdl, ln, hdr, &body, serialized);
+    callee_.flush(hdl);
+    return true;
   } else {
     header hdr{message_type::routed_message,
                flags,
@@ -182,22 +307,20 @@ bool instance::dispatch(execution_unit* ctx, const strong_actor_ptr& sender,
                sender ? sender->id() : invalid_actor_id,
                dest_actor};
     auto writer = make_callback([&](binary_serializer& sink) {
-      CAF_LOG_DEBUG("send routed message: "
-                    << CAF_ARG(source_node) << CAF_ARG(dest_node)
-                    << CAF_ARG(forwarding_stack) << CAF_ARG(msg));
-      return sink.apply(source_node)         //
-             && sink.apply(dest_node)        //
-             && sink.apply(forwarding_stack) //
-             && sink.apply(msg);
+      CAF_LOG_DEBUG("send routed message: " << CAF_ARG(source_node)
+                                            << CAF_ARG(dest_node));
+      return sink.apply(source_node)  //
+             && sink.apply(dest_node) //
+             && body(sink);
     });
-    write(ctx, callee_.get_buffer(path->hdl), hdr, &writer);
+    write_message(ctx, path->hdl, ln, hdr, &writer, serialized);
   }
   flush(*path);
   return true;
 }
 
 void instance::write(execution_unit* ctx, byte_buffer& buf, header& hdr,
-                     payload_writer* pw) {
+                     payload_writer* pw, bool serialized) {
   CAF_ASSERT(ctx != nullptr);
   CAF_LOG_TRACE(CAF_ARG(hdr));
   binary_serializer sink{ctx, buf};
@@ -211,7 +334,8 @@ void instance::write(execution_unit* ctx, byte_buffer& buf, header& hdr,
       CAF_LOG_ERROR(sink.get_error());
       return;
     }
-    telemetry::timer::observe(mm_metrics.serialization_time, t0);
+    if (!serialized)
+      telemetry::timer::observe(mm_metrics.serialization_time, t0);
     sink.seek(header_offset);
     auto payload_len = buf.size() - (header_offset + basp::header_size);
     auto signed_payload_len = static_cast<uint32_t>(payload_len);
@@ -225,14 +349,20 @@ void instance::write(execution_unit* ctx, byte_buffer& buf, header& hdr,
 void instance::write_server_handshake(execution_unit* ctx, byte_buffer& out_buf,
                                       optional<uint16_t> port) {
   CAF_LOG_TRACE(CAF_ARG(port));
-  using namespace detail;
-  published_actor* pa = nullptr;
+  const published_actor* pa = nullptr;
   if (port) {
     auto i = published_actors_.find(*port);
     if (i != published_actors_.end())
       pa = &i->second;
   }
   CAF_LOG_DEBUG_IF(!pa && port, "no actor published");
+  write_server_handshake(ctx, out_buf, pa);
+}
+
+void instance::write_server_handshake(execution_unit* ctx, byte_buffer& out_buf,
+                                      const published_actor* pa) {
+  CAF_LOG_TRACE("");
+  using namespace detail;
   auto writer = make_callback([&](binary_serializer& sink) {
     using string_list = std::vector<std::string>;
     string_list app_ids;
@@ -253,7 +383,7 @@ void instance::write_server_handshake(execution_unit* ctx, byte_buffer& out_buf,
            && sink.apply(iface);
   });
   header hdr{message_type::server_handshake,
-             0,
+             handshake_flags(),
              0,
              version,
              invalid_actor_id,
@@ -261,19 +391,41 @@ void instance::write_server_handshake(execution_unit* ctx, byte_buffer& out_buf,
   write(ctx, out_buf, hdr, &writer);
 }
 
-void instance::write_client_handshake(execution_unit* ctx, byte_buffer& buf) {
-  auto writer = make_callback([&](binary_serializer& sink) { //
+void instance::write_client_handshake(execution_unit* ctx, byte_buffer& buf,
+                                      bool stripe,
+                                      const node_id& expected_server,
+                                      actor_id expected_actor) {
+  auto writer = make_callback([&](binary_serializer& sink) {
+    if (expected_server)
+      return sink.apply(this_node_) && sink.apply(expected_server)
+             && sink.apply(expected_actor);
     return sink.apply(this_node_);
   });
+  // The operation data tells the server how many connections to expect.
+  auto n = connections_per_peer_ > 1 ? connections_per_peer_ : size_t{0};
   header hdr{message_type::client_handshake,
+             handshake_flags(),
              0,
-             0,
-             0,
+             n,
              invalid_actor_id,
              invalid_actor_id};
+  if (stripe)
+    hdr.flags |= header::stripe_flag;
+  if (expected_server)
+    hdr.flags |= header::pipelined_flag;
   write(ctx, buf, hdr, &writer);
 }
 
+void instance::add_pipelined_route(connection_handle hdl, const node_id& nid) {
+  CAF_LOG_TRACE(CAF_ARG(hdl) << CAF_ARG(nid));
+  CAF_ASSERT(nid != this_node_ && !tbl_.lookup_direct(nid));
+  tbl_.add_direct(hdl, nid);
+  auto was_indirect = tbl_.erase_indirect(nid);
+  if (connections_per_peer_ > 1)
+    tbl_.enable_stripes(nid, connections_per_peer_);
+  callee_.learned_new_node_directly(nid, was_indirect);
+}
+
 void instance::write_monitor_message(execution_unit* ctx, byte_buffer& buf,
                                      const node_id& dest_node, actor_id aid) {
   CAF_LOG_TRACE(CAF_ARG(dest_node) << CAF_ARG(aid));
@@ -295,6 +447,38 @@ void instance::write_down_message(execution_unit* ctx, byte_buffer& buf,
   write(ctx, buf, hdr, &writer);
 }
 
+void instance::write_monitor_message(execution_unit* ctx,
+                                     connection_handle hdl,
+                                     const node_id& dest_node, actor_id aid) {
+  CAF_LOG_TRACE(CAF_ARG(hdl) << CAF_ARG(dest_node) << CAF_ARG(aid));
+  auto writer = make_callback([&](binary_serializer& sink) { //
+    return sink.apply(this_node_) && sink.apply(dest_node);
+  });
+  header hdr{message_type::monitor_message, 0, 0, 0, invalid_actor_id, aid};
+  // Keep all messages concerning `aid` on the same stripe.
+  auto stripe = select_stripe(dest_node, hdl, aid);
+  write_message(ctx, stripe, lane::urgent, hdr, &writer);
+  if (stripe != hdl)
+    callee_.flush(stripe);
+}
+
+void instance::write_down_message(execution_unit* ctx, connection_handle hdl,
+                                  const node_id& dest_node, actor_id aid,
+                                  const error& rsn) {
+  CAF_LOG_TRACE(CAF_ARG(hdl) << CAF_ARG(dest_node) << CAF_ARG(aid)
+                             << CAF_ARG(rsn));
+  auto writer = make_callback([&](binary_serializer& sink) {
+    return sink.apply(this_node_) && sink.apply(dest_node) && sink.apply(rsn);
+  });
+  header hdr{message_type::down_message, 0, 0, 0, aid, invalid_actor_id};
+  // The down message must not overtake the last messages of the actor, which
+  // went out on its stripe.
+  auto stripe = select_stripe(dest_node, hdl, aid);
+  write_message(ctx, stripe, lane::urgent, hdr, &writer);
+  if (stripe != hdl)
+    callee_.flush(stripe);
+}
+
 void instance::write_heartbeat(execution_unit* ctx, byte_buffer& buf) {
   CAF_LOG_TRACE("");
   header hdr{message_type::heartbeat, 0, 0, 0, invalid_actor_id,
@@ -315,6 +499,12 @@ connection_state instance::handle(execution_unit* ctx, connection_handle hdl,
     CAF_LOG_WARNING("actual payload size differs from advertised size");
     return malformed_basp_message;
   }
+  // Count reassembled messages instead of their fragments.
+  if (connection_metrics_ && hdr.operation != message_type::fragment) {
+    auto ectx = callee_.get_context(hdl);
+    if (ectx != nullptr && ectx->metrics.frames_in != nullptr)
+      ectx->metrics.frames_in->inc();
+  }
   // Dispatch by message type.
   switch (hdr.operation) {
     case message_type::server_handshake: {
@@ -353,6 +543,44 @@ connection_state instance::handle(execution_unit* ctx, connection_handle hdl,
         callee_.finalize_handshake(source_node, aid, sigs);
         return redundant_connection;
       }
+      // Pipelined connections already route messages to the expected node.
+      if (auto ectx = callee_.get_context(hdl); ectx && ectx->pipelined) {
+        ectx->pipelined = false;
+        auto expected = ectx->id;
+        // Passes the actual server data to the cache of the client.
+        callee_.finalize_handshake(source_node, aid, sigs);
+        if (source_node != expected) {
+          CAF_LOG_WARNING("server changed its node ID, drop connection:"
+                          << CAF_ARG(expected) << CAF_ARG(source_node));
+          ectx->id = expected;
+          return close_connection;
+        }
+        if (aid != ectx->published_actor) {
+          CAF_LOG_WARNING("server changed its published actor, drop "
+                          "connection:"
+                          << CAF_ARG(ectx->published_actor) << CAF_ARG(aid));
+          return close_connection;
+        }
+        negotiate_fragmentation(hdl, hdr);
+        break;
+      }
+      // Additional connections only fill a stripe of the direct connection.
+      if (auto ectx = callee_.get_context(hdl); ectx && ectx->stripe) {
+        if (ectx->id && ectx->id != source_node) {
+          CAF_LOG_WARNING("additional connection reached another node:"
+                          << CAF_ARG2("expected", ectx->id)
+                          << CAF_ARG(source_node));
+          return close_connection;
+        }
+        if (!tbl_.add_stripe(hdl, source_node, connections_per_peer_)) {
+          CAF_LOG_DEBUG("close surplus connection:" << CAF_ARG(source_node));
+          return redundant_connection;
+        }
+        CAF_LOG_DEBUG("new stripe:" << CAF_ARG(source_node));
+        ectx->id = source_node;
+        negotiate_fragmentation(hdl, hdr);
+        break;
+      }
       // Close this connection if we already have a direct connection.
       if (tbl_.lookup_direct(source_node)) {
         CAF_LOG_DEBUG(
@@ -370,6 +598,9 @@ connection_state instance::handle(execution_unit* ctx, connection_handle hdl,
         CAF_LOG_ERROR("no route to host after server handshake");
         return no_route_to_receiving_node;
       }
+      if (connections_per_peer_ > 1)
+        tbl_.enable_stripes(source_node, connections_per_peer_);
+      negotiate_fragmentation(hdl, hdr);
       callee_.learned_new_node_directly(source_node, was_indirect);
       callee_.finalize_handshake(source_node, aid, sigs);
       break;
@@ -383,6 +614,45 @@ connection_state instance::handle(execution_unit* ctx, connection_handle hdl,
                         << source.get_error());
         return serializing_basp_payload_failed;
       }
+      // Messages may follow right after a pipelined handshake. Closing the
+      // connection drops them if the client expects another node, e.g., our
+      // predecessor on this host and port, or another published actor.
+      if (hdr.has(header::pipelined_flag)) {
+        node_id expected_server;
+        actor_id expected_actor = invalid_actor_id;
+        if (!source.apply(expected_server) || !source.apply(expected_actor)) {
+          CAF_LOG_WARNING("unable to deserialize payload of client handshake:"
+                          << source.get_error());
+          return serializing_basp_payload_failed;
+        }
+        if (expected_server != this_node_) {
+          CAF_LOG_INFO("refuse pipelined messages for another node:"
+                       << CAF_ARG(source_node) << CAF_ARG(expected_server));
+          return close_connection;
+        }
+        auto ectx = callee_.get_context(hdl);
+        auto published = ectx != nullptr ? ectx->published_actor
+                                         : invalid_actor_id;
+        if (expected_actor != published) {
+          CAF_LOG_INFO("refuse pipelined messages for another actor:"
+                       << CAF_ARG(source_node) << CAF_ARG(expected_actor)
+                       << CAF_ARG(published));
+          return close_connection;
+        }
+      }
+      // Accept as many connections as the client announces, up to a sane
+      // limit.
+      auto n = static_cast<size_t>(
+        std::min(hdr.operation_data, uint64_t{max_connections_per_peer}));
+      if (hdr.has(header::stripe_flag)) {
+        if (!tbl_.add_stripe(hdl, source_node, n)) {
+          CAF_LOG_DEBUG("close surplus connection:" << CAF_ARG(source_node));
+          return redundant_connection;
+        }
+        CAF_LOG_DEBUG("new stripe:" << CAF_ARG(source_node));
+        negotiate_fragmentation(hdl, hdr);
+        break;
+      }
       // Drop repeated handshakes.
       if (tbl_.lookup_direct(source_node)) {
         CAF_LOG_DEBUG(
@@ -393,6 +663,9 @@ connection_state instance::handle(execution_unit* ctx, connection_handle hdl,
       CAF_LOG_DEBUG("new direct connection:" << CAF_ARG(source_node));
       tbl_.add_direct(hdl, source_node);
       auto was_indirect = tbl_.erase_indirect(source_node);
+      if (n > 1)
+        tbl_.enable_stripes(source_node, n);
+      negotiate_fragmentation(hdl, hdr);
       callee_.learned_new_node_directly(source_node, was_indirect);
       break;
     }
@@ -419,12 +692,14 @@ connection_state instance::handle(execution_unit* ctx, connection_handle hdl,
     }
     // fall through
     case message_type::direct_message: {
+      auto ectx = callee_.get_context(hdl);
+      CAF_ASSERT(ectx != nullptr);
       auto worker = hub_.pop();
       auto last_hop = tbl_.lookup_direct(hdl);
       if (worker != nullptr) {
         CAF_LOG_DEBUG("launch BASP worker for deserializing a"
                       << hdr.operation);
-        worker->launch(last_hop, hdr, *payload);
+        worker->launch(ectx->queue, last_hop, hdr, *payload);
       } else {
         CAF_LOG_DEBUG("out of BASP workers, continue deserializing a"
                       << hdr.operation);
@@ -450,7 +725,8 @@ connection_state instance::handle(execution_unit* ctx, connection_handle hdl,
           byte_buffer& payload_;
           uint64_t msg_id_;
         };
-        handler f{&queue_, &proxies(), &system(), last_hop, hdr, *payload};
+        handler f{ectx->queue.get(), &proxies(), &system(), last_hop, hdr,
+                  *payload};
         f.handle_remote_message(callee_.current_execution_unit());
       }
       break;
@@ -486,13 +762,16 @@ connection_state instance::handle(execution_unit* ctx, connection_handle hdl,
       }
       if (dest_node == this_node_) {
         // Delay this message to make sure we don't skip in-flight messages.
-        auto msg_id = queue_.new_id();
+        auto ectx = callee_.get_context(hdl);
+        CAF_ASSERT(ectx != nullptr);
+        auto& q = *ectx->queue;
+        auto msg_id = q.new_id();
         auto ptr = make_mailbox_element(nullptr, make_message_id(), {},
                                         delete_atom_v, source_node,
                                         hdr.source_actor,
                                         std::move(fail_state));
-        queue_.push(callee_.current_execution_unit(), msg_id,
-                    callee_.this_actor(), std::move(ptr));
+        q.push(callee_.current_execution_unit(), msg_id, callee_.this_actor(),
+               std::move(ptr));
       } else {
         forward(ctx, dest_node, hdr, *payload);
       }
@@ -503,6 +782,9 @@ connection_state instance::handle(execution_unit* ctx, connection_handle hdl,
       callee_.handle_heartbeat();
       break;
     }
+    case message_type::fragment: {
+      return handle_fragment(ctx, hdl, *payload);
+    }
     default: {
       CAF_LOG_ERROR("invalid operation");
       return malformed_basp_message;
@@ -528,4 +810,163 @@ void instance::forward(execution_unit* ctx, const node_id& dest_node,
   }
 }
 
+void instance::max_fragment_size(size_t x) noexcept {
+  // The first fragment must contain the entire BASP header of the message.
+  max_fragment_size_ = x > 0 ? std::max(x, header_size) : 0;
+}
+
+void instance::write_message(execution_unit* ctx, connection_handle hdl,
+                             lane ln, header& hdr, payload_writer* writer,
+                             bool serialized) {
+  auto& buf = callee_.get_buffer(hdl);
+  auto ectx = callee_.get_context(hdl);
+  // Fragments of a message count as a single frame.
+  if (ectx != nullptr && ectx->metrics.frames_out != nullptr)
+    ectx->metrics.frames_out->inc();
+  if (ectx == nullptr || (!priority_lanes_ && ectx->max_fragment_size == 0)) {
+    write(ctx, buf, hdr, writer, serialized);
+    return;
+  }
+  auto& lanes = ectx->lanes;
+  auto from_sender = [&hdr](const pending_frame& x) {
+    return x.source_actor == hdr.source_actor;
+  };
+  // Messages must not overtake previous messages from the same sender. Hence,
+  // a message joins the lowest lane that holds messages from its sender. This
+  // also keeps control messages such as down messages behind the remaining
+  // fragments of a large message. Heartbeats carry no information about any
+  // actor.
+  if (hdr.operation != message_type::heartbeat) {
+    for (auto i = static_cast<size_t>(ln) + 1; i < lanes.size(); ++i) {
+      auto& xs = lanes[i];
+      if (std::any_of(xs.begin(), xs.end(), from_sender))
+        ln = static_cast<lane>(i);
+    }
+  }
+  // Check whether we can write to the buffer directly, i.e., whether no other
+  // message with the same or a higher priority waits.
+  auto may_skip_lanes = [&] {
+    if (ln == lane::bulk || buf.size() >= lane_limit())
+      return false;
+    auto first = lanes.begin();
+    auto last = first + static_cast<ptrdiff_t>(ln) + 1;
+    return std::all_of(first, last, [](const auto& xs) { return xs.empty(); });
+  };
+  if (ectx->max_fragment_size == 0) {
+    if (may_skip_lanes()) {
+      write(ctx, buf, hdr, writer, serialized);
+      return;
+    }
+  }
+  byte_buffer bytes;
+  write(ctx, bytes, hdr, writer, serialized);
+  // Large messages wait in the bulk lane to let urgent and normal messages
+  // pass. Messages that go to the buffer directly never wait anyway.
+  if (ln == lane::normal
+      && (bytes.size() > lane_limit()
+          || (ectx->max_fragment_size > 0
+              && bytes.size() > ectx->max_fragment_size)))
+    ln = lane::bulk;
+  if (may_skip_lanes()) {
+    buf.insert(buf.end(), bytes.begin(), bytes.end());
+    return;
+  }
+  CAF_LOG_DEBUG("enqueue message:" << CAF_ARG(hdl)
+                                   << CAF_ARG2("lane", static_cast<int>(ln))
+                                   << CAF_ARG2("size", bytes.size()));
+  ectx->queued_bytes += bytes.size();
+  if (ectx->metrics.write_queue != nullptr)
+    ectx->metrics.write_queue->inc(static_cast<int64_t>(bytes.size()));
+  lanes[static_cast<size_t>(ln)].emplace_back(
+    pending_frame{hdr.source_actor, 0, std::move(bytes),
+                  std::chrono::steady_clock::now()});
+  write_pending(ctx, hdl);
+}
+
+size_t instance::lane_limit() const noexcept {
+  return priority_lanes_ ? lane_limit_ : std::numeric_limits<size_t>::max();
+}
+
+connection_state instance::handle_fragment(execution_unit* ctx,
+                                           connection_handle hdl,
+                                           byte_buffer& payload) {
+  auto ectx = callee_.get_context(hdl);
+  if (ectx == nullptr) {
+    CAF_LOG_WARNING("received fragment for unknown connection");
+    return malformed_basp_message;
+  }
+  auto& buf = ectx->fragmented_payload;
+  auto& hdr = ectx->fragmented_hdr;
+  auto first = payload.begin();
+  if (!ectx->reassembling) {
+    // The first fragment starts with the header of the original message.
+    binary_deserializer source{ctx, payload};
+    if (!source.apply(hdr) || !valid(hdr)
+        || (hdr.operation != message_type::direct_message
+            && hdr.operation != message_type::routed_message)) {
+      CAF_LOG_WARNING("received invalid header in first fragment");
+      return malformed_basp_message;
+    }
+    ectx->reassembling = true;
+    buf.clear();
+    buf.reserve(hdr.payload_len);
+    first += header_size;
+  }
+  if (buf.size() + static_cast<size_t>(payload.end() - first)
+      > hdr.payload_len) {
+    CAF_LOG_WARNING("fragments exceed the size of the original message");
+    return malformed_basp_message;
+  }
+  buf.insert(buf.end(), first, payload.end());
+  if (buf.size() < hdr.payload_len)
+    return await_header;
+  ectx->reassembling = false;
+  return handle(ctx, hdl, hdr, &buf);
+}
+
+connection_handle instance::select_stripe(const node_id& nid,
+                                         connection_handle hdl, actor_id aid,
+                                         const strong_actor_ptr& sender) {
+  if (aid == invalid_actor_id)
+    return hdl;
+  auto stripe = tbl_.stripe(nid, aid);
+  if (!stripe || *stripe == hdl)
+    return hdl;
+  auto ectx = callee_.get_context(hdl);
+  if (ectx == nullptr)
+    return hdl;
+  // Once a sender used the direct connection because its stripe had no
+  // connection, switching over to the stripe could reorder its messages.
+  auto& pinned = ectx->pinned_senders;
+  if (*stripe == invalid_connection_handle) {
+    // Control messages only follow the sender and never pin it.
+    if (sender != nullptr && pinned.emplace(aid).second) {
+      // The pin becomes obsolete once the sender terminates.
+      auto broker = actor_cast<weak_actor_ptr>(callee_.this_actor());
+      sender->get()->attach_functor([broker, aid] {
+        if (auto hdl = actor_cast<actor>(broker))
+          anon_send(hdl, delete_atom_v, aid);
+      });
+    }
+    return hdl;
+  }
+  if (pinned.count(aid) > 0)
+    return hdl;
+  return *stripe;
+}
+
+uint8_t instance::handshake_flags() const noexcept {
+  return max_fragment_size_ > 0 ? header::fragmentation_flag : uint8_t{0};
+}
+
+void instance::negotiate_fragmentation(connection_handle hdl,
+                                       const header& hdr) {
+  if (max_fragment_size_ == 0 || !hdr.has(header::fragmentation_flag))
+    return;
+  if (auto ectx = callee_.get_context(hdl)) {
+    CAF_LOG_DEBUG("enable fragmentation:" << CAF_ARG(hdl));
+    ectx->max_fragment_size = max_fragment_size_;
+  }
+}
+
 } // namespace caf::io::basp
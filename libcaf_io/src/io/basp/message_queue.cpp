@@ -4,47 +4,40 @@
 
 #include "caf/io/basp/message_queue.hpp"
 
-#include <iterator>
+#include <thread>
+
+#include "caf/config.hpp"
 
 namespace caf::io::basp {
 
-message_queue::message_queue() : next_id(0), next_undelivered(0) {
+message_queue::message_queue(size_t capacity)
+  : next_id(0),
+    next_undelivered(0),
+    mask_(capacity - 1),
+    slots_(new slot[capacity]),
+    delivering_(false) {
+  CAF_ASSERT(capacity > 0 && (capacity & mask_) == 0);
+}
+
+message_queue::~message_queue() {
   // nop
 }
 
 void message_queue::push(execution_unit* ctx, uint64_t id,
                          strong_actor_ptr receiver,
                          mailbox_element_ptr content) {
-  std::unique_lock<std::mutex> guard{lock};
   CAF_ASSERT(id >= next_undelivered);
   CAF_ASSERT(id < next_id);
-  auto first = pending.begin();
-  auto last = pending.end();
-  if (id == next_undelivered) {
-    // Dispatch current head.
-    if (receiver != nullptr)
-      receiver->enqueue(std::move(content), ctx);
-    auto next = id + 1;
-    // Check whether we can deliver more.
-    if (first == last || first->id != next) {
-      next_undelivered = next;
-      CAF_ASSERT(next_undelivered <= next_id);
-      return;
-    }
-    // Deliver everything until reaching a non-consecutive ID or the end.
-    auto i = first;
-    for (; i != last && i->id == next; ++i, ++next)
-      if (i->receiver != nullptr)
-        i->receiver->enqueue(std::move(i->content), ctx);
-    next_undelivered = next;
-    pending.erase(first, i);
-    CAF_ASSERT(next_undelivered <= next_id);
-    return;
-  }
-  // Get the insertion point.
-  auto pred = [&](const actor_msg& x) { return x.id >= id; };
-  pending.emplace(std::find_if(first, last, pred),
-                  actor_msg{id, std::move(receiver), std::move(content)});
+  // The slot for `id` becomes available once all IDs up to `id - capacity()`
+  // got shipped. The thread owning `next_undelivered` never waits here, so
+  // this loop always terminates.
+  while (id - next_undelivered.load(std::memory_order_acquire) > mask_)
+    std::this_thread::yield();
+  auto& x = slots_[id & mask_];
+  x.receiver = std::move(receiver);
+  x.content = std::move(content);
+  x.ready.store(true);
+  deliver(ctx);
 }
 
 void message_queue::drop(execution_unit* ctx, uint64_t id) {
@@ -52,8 +45,31 @@ void message_queue::drop(execution_unit* ctx, uint64_t id) {
 }
 
 uint64_t message_queue::new_id() {
-  std::unique_lock<std::mutex> guard{lock};
-  return next_id++;
+  return next_id.fetch_add(1, std::memory_order_relaxed);
+}
+
+void message_queue::deliver(execution_unit* ctx) {
+  for (;;) {
+    if (delivering_.exchange(true))
+      return;
+    auto id = next_undelivered.load(std::memory_order_relaxed);
+    for (;;) {
+      auto& x = slots_[id & mask_];
+      if (!x.ready.load(std::memory_order_acquire))
+        break;
+      auto receiver = std::move(x.receiver);
+      auto content = std::move(x.content);
+      x.ready.store(false, std::memory_order_relaxed);
+      next_undelivered.store(++id, std::memory_order_release);
+      if (receiver != nullptr)
+        receiver->enqueue(std::move(content), ctx);
+    }
+    delivering_.store(false);
+    // Another thread may have filled the next slot after our last check but
+    // gave up because we were still delivering.
+    if (!slots_[id & mask_].ready.load())
+      return;
+  }
 }
 
 } // namespace caf::io::basp
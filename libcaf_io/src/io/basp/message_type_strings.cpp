@@ -30,6 +30,8 @@ std::string to_string(message_type x) {
       return "caf::io::basp::message_type::down_message";
     case message_type::heartbeat:
       return "caf::io::basp::message_type::heartbeat";
+    case message_type::fragment:
+      return "caf::io::basp::message_type::fragment";
   };
 }
 
@@ -55,6 +57,9 @@ bool from_string(string_view in, message_type& out) {
   } else if (in == "caf::io::basp::message_type::heartbeat") {
     out = message_type::heartbeat;
     return true;
+  } else if (in == "caf::io::basp::message_type::fragment") {
+    out = message_type::fragment;
+    return true;
   } else {
     return false;
   }
@@ -73,6 +78,7 @@ bool from_integer(std::underlying_type_t<message_type> in,
     case message_type::monitor_message:
     case message_type::down_message:
     case message_type::heartbeat:
+    case message_type::fragment:
       out = result;
       return true;
   };
@@ -4,112 +4,260 @@
 
 #include "caf/io/basp/routing_table.hpp"
 
+#include <algorithm>
+#include <memory>
+#include <thread>
+
 #include "caf/io/middleman.hpp"
 
 namespace caf::io::basp {
 
-routing_table::routing_table(abstract_broker* parent) : parent_(parent) {
+routing_table::read_guard::read_guard(const routing_table& tbl) {
+  // Writers wait on both counters after replacing the snapshot. Incrementing
+  // the counter before loading the snapshot makes sure they see us.
+  auto epoch = tbl.epoch_.load();
+  readers_ = &tbl.readers_[epoch % 2];
+  readers_->fetch_add(1);
+  ptr_ = tbl.current_.load();
+}
+
+routing_table::read_guard::~read_guard() {
+  readers_->fetch_sub(1);
+}
+
+routing_table::routing_table(abstract_broker* parent)
+  : parent_(parent), current_(new snapshot), epoch_(0), readers_{{{0}, {0}}} {
   // nop
 }
 
 routing_table::~routing_table() {
-  // nop
+  delete current_.load();
 }
 
-optional<routing_table::route> routing_table::lookup(const node_id& target) {
-  std::unique_lock<std::mutex> guard{mtx_};
+optional<routing_table::route>
+routing_table::lookup(const node_id& target) const {
+  read_guard tbl{*this};
   // Check whether we have a direct path first.
   { // Lifetime scope of first iterator.
-    auto i = direct_by_nid_.find(target);
-    if (i != direct_by_nid_.end())
+    auto i = tbl->direct_by_nid.find(target);
+    if (i != tbl->direct_by_nid.end())
       return route{target, i->second};
   }
-  // Pick first available indirect route.
-  auto i = indirect_.find(target);
-  if (i != indirect_.end()) {
-    auto& hops = i->second;
-    while (!hops.empty()) {
-      auto& hop = *hops.begin();
-      auto j = direct_by_nid_.find(hop);
-      if (j != direct_by_nid_.end())
+  // Pick first available indirect route. Writers remove hops that became
+  // invalid, but checking once more costs us nothing.
+  auto i = tbl->indirect.find(target);
+  if (i != tbl->indirect.end()) {
+    for (auto& hop : i->second) {
+      auto j = tbl->direct_by_nid.find(hop);
+      if (j != tbl->direct_by_nid.end())
         return route{hop, j->second};
-      // Erase hops that became invalid.
-      hops.erase(hops.begin());
     }
   }
   return none;
 }
 
 node_id routing_table::lookup_direct(const connection_handle& hdl) const {
-  std::unique_lock<std::mutex> guard{mtx_};
-  auto i = direct_by_hdl_.find(hdl);
-  if (i != direct_by_hdl_.end())
+  read_guard tbl{*this};
+  auto i = tbl->direct_by_hdl.find(hdl);
+  if (i != tbl->direct_by_hdl.end())
     return i->second;
   return {};
 }
 
 optional<connection_handle>
 routing_table::lookup_direct(const node_id& nid) const {
-  std::unique_lock<std::mutex> guard{mtx_};
-  auto i = direct_by_nid_.find(nid);
-  if (i != direct_by_nid_.end())
+  read_guard tbl{*this};
+  auto i = tbl->direct_by_nid.find(nid);
+  if (i != tbl->direct_by_nid.end())
     return i->second;
   return {};
 }
 
 node_id routing_table::lookup_indirect(const node_id& nid) const {
-  std::unique_lock<std::mutex> guard{mtx_};
-  auto i = indirect_.find(nid);
-  if (i == indirect_.end())
+  read_guard tbl{*this};
+  auto i = tbl->indirect.find(nid);
+  if (i == tbl->indirect.end())
     return {};
   if (!i->second.empty())
     return *i->second.begin();
   return {};
 }
 
+std::vector<connection_handle> routing_table::direct_connections() const {
+  read_guard tbl{*this};
+  std::vector<connection_handle> result;
+  result.reserve(tbl->direct_by_hdl.size());
+  for (auto& kvp : tbl->direct_by_hdl)
+    result.emplace_back(kvp.first);
+  return result;
+}
+
+optional<connection_handle>
+routing_table::stripe(const node_id& nid, actor_id sender) const {
+  read_guard tbl{*this};
+  auto i = tbl->stripes.find(nid);
+  if (i == tbl->stripes.end())
+    return none;
+  auto& slots = i->second;
+  return slots[sender % slots.size()];
+}
+
+std::vector<connection_handle>
+routing_table::stripes(const node_id& nid) const {
+  read_guard tbl{*this};
+  std::vector<connection_handle> result;
+  auto i = tbl->stripes.find(nid);
+  if (i != tbl->stripes.end())
+    for (size_t index = 1; index < i->second.size(); ++index)
+      if (i->second[index] != invalid_connection_handle)
+        result.emplace_back(i->second[index]);
+  return result;
+}
+
+void routing_table::enable_stripes(const node_id& nid, size_t n) {
+  std::unique_lock<std::mutex> guard{mtx_};
+  auto cur = current_.load();
+  auto i = cur->direct_by_nid.find(nid);
+  CAF_ASSERT(n > 1 && i != cur->direct_by_nid.end());
+  if (i == cur->direct_by_nid.end())
+    return;
+  auto next = new snapshot(*cur);
+  auto& slots = next->stripes[nid];
+  if (slots.size() < n)
+    slots.resize(n, invalid_connection_handle);
+  slots[0] = i->second;
+  publish(next);
+}
+
+bool routing_table::add_stripe(const connection_handle& hdl,
+                               const node_id& nid, size_t n) {
+  std::unique_lock<std::mutex> guard{mtx_};
+  auto cur = current_.load();
+  if (cur->direct_by_hdl.count(hdl) != 0)
+    return false;
+  // The additional connection may complete its handshake before the direct
+  // connection. In this case, we reserve the first stripe for the direct
+  // connection.
+  auto next = std::make_unique<snapshot>(*cur);
+  auto& slots = next->stripes[nid];
+  if (slots.empty()) {
+    if (n < 2)
+      return false;
+    slots.resize(n, invalid_connection_handle);
+    if (auto i = cur->direct_by_nid.find(nid); i != cur->direct_by_nid.end())
+      slots[0] = i->second;
+  }
+  auto j = std::find(slots.begin() + 1, slots.end(), invalid_connection_handle);
+  if (j == slots.end())
+    return false;
+  *j = hdl;
+  next->direct_by_hdl.emplace(hdl, nid);
+  publish(next.release());
+  return true;
+}
+
 node_id routing_table::erase_direct(const connection_handle& hdl) {
   std::unique_lock<std::mutex> guard{mtx_};
-  auto i = direct_by_hdl_.find(hdl);
-  if (i == direct_by_hdl_.end())
+  auto cur = current_.load();
+  auto i = cur->direct_by_hdl.find(hdl);
+  if (i == cur->direct_by_hdl.end())
+    return {};
+  node_id result = i->second;
+  auto next = new snapshot(*cur);
+  next->direct_by_hdl.erase(hdl);
+  // Losing an additional connection only frees its stripe.
+  if (auto j = cur->direct_by_nid.find(result);
+      j == cur->direct_by_nid.end() || j->second != hdl) {
+    auto& slots = next->stripes[result];
+    std::replace(slots.begin(), slots.end(), hdl,
+                 connection_handle{invalid_connection_handle});
+    if (std::all_of(slots.begin(), slots.end(), [](const auto& x) {
+          return x == invalid_connection_handle;
+        }))
+      next->stripes.erase(result);
+    publish(next);
     return {};
-  direct_by_nid_.erase(i->second);
-  node_id result = std::move(i->second);
-  direct_by_hdl_.erase(i->first);
+  }
+  next->direct_by_nid.erase(result);
+  if (auto j = next->stripes.find(result); j != next->stripes.end()) {
+    for (auto& x : j->second)
+      next->direct_by_hdl.erase(x);
+    next->stripes.erase(j);
+  }
+  // Erase hops that became invalid.
+  for (auto j = next->indirect.begin(); j != next->indirect.end();) {
+    j->second.erase(result);
+    if (j->second.empty())
+      j = next->indirect.erase(j);
+    else
+      ++j;
+  }
+  publish(next);
   return result;
 }
 
 bool routing_table::erase_indirect(const node_id& dest) {
   std::unique_lock<std::mutex> guard{mtx_};
-  auto i = indirect_.find(dest);
-  if (i == indirect_.end())
+  auto cur = current_.load();
+  if (cur->indirect.count(dest) == 0)
     return false;
-  indirect_.erase(i);
+  auto next = new snapshot(*cur);
+  next->indirect.erase(dest);
+  publish(next);
   return true;
 }
 
 void routing_table::add_direct(const connection_handle& hdl,
                                const node_id& nid) {
   std::unique_lock<std::mutex> guard{mtx_};
-  auto hdl_added = direct_by_hdl_.emplace(hdl, nid).second;
-  auto nid_added = direct_by_nid_.emplace(nid, hdl).second;
+  auto next = new snapshot(*current_.load());
+  auto hdl_added = next->direct_by_hdl.emplace(hdl, nid).second;
+  auto nid_added = next->direct_by_nid.emplace(nid, hdl).second;
   CAF_ASSERT(hdl_added && nid_added);
   CAF_IGNORE_UNUSED(hdl_added);
   CAF_IGNORE_UNUSED(nid_added);
+  // Take over the first stripe if additional connections came first.
+  if (auto i = next->stripes.find(nid); i != next->stripes.end())
+    i->second[0] = hdl;
+  publish(next);
 }
 
 bool routing_table::add_indirect(const node_id& hop, const node_id& dest) {
   std::unique_lock<std::mutex> guard{mtx_};
+  auto cur = current_.load();
   // Never add indirect entries if we already have direct connection.
-  if (direct_by_nid_.count(dest) != 0)
+  if (cur->direct_by_nid.count(dest) != 0)
     return false;
   // Never add indirect entries if we don't have a connection to the hop.
-  if (direct_by_nid_.count(hop) == 0)
+  if (cur->direct_by_nid.count(hop) == 0)
+    return false;
+  // Skip the copy if we already know this hop.
+  if (auto i = cur->indirect.find(dest);
+      i != cur->indirect.end() && i->second.count(hop) != 0)
     return false;
   // Add entry to our node ID set.
-  auto& hops = indirect_[dest];
+  auto next = new snapshot(*cur);
+  auto& hops = next->indirect[dest];
   auto result = hops.empty();
   hops.emplace(hop);
+  publish(next);
   return result;
 }
 
+void routing_table::publish(snapshot* next) {
+  auto prev = current_.exchange(next);
+  // Readers that still use `prev` incremented one of the two counters before
+  // loading it, i.e., before the exchange. Hence, `prev` becomes unreachable
+  // once each counter dropped to zero at least once. Flipping the epoch before
+  // waiting on a counter sends new readers to the other counter, which keeps
+  // a steady stream of readers from starving the writer.
+  for (int round = 0; round < 2; ++round) {
+    auto epoch = epoch_.fetch_add(1);
+    auto& readers = readers_[epoch % 2];
+    while (readers.load() != 0)
+      std::this_thread::yield();
+  }
+  delete prev;
+}
+
 } // namespace caf::io::basp
@@ -4,13 +4,19 @@
 
 #include "caf/io/basp_broker.hpp"
 
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
 #include <limits>
 
 #include "caf/actor_registry.hpp"
 #include "caf/actor_system_config.hpp"
 #include "caf/after.hpp"
 #include "caf/defaults.hpp"
+#include "caf/detail/get_process_id.hpp"
 #include "caf/detail/sync_request_bouncer.hpp"
 #include "caf/event_based_actor.hpp"
 #include "caf/forwarding_actor_proxy.hpp"
@@ -36,6 +42,46 @@ THREAD_LOCAL caf::node_id* t_last_hop = nullptr;
 
 #undef THREAD_LOCAL
 
+// Maximum number of idle buffers for serializing messages in proxies.
+constexpr size_t max_pooled_buffers = 128;
+
+// Maximum capacity of idle buffers for serializing messages in proxies.
+constexpr size_t max_pooled_buffer_capacity = 64 * 1024;
+
+// Distinguishes temporary files of multiple brokers in the same process.
+std::atomic<size_t> handshake_cache_writers;
+
+// Writes serialized handshake caches to `path` outside of the broker. Each
+// writer uses its own temporary file, because processes that share the cache
+// file may update it at the same time.
+caf::behavior handshake_cache_writer(caf::event_based_actor* self,
+                                     const std::string& path) {
+  auto tmp = path + "." + std::to_string(caf::detail::get_process_id()) + "."
+             + std::to_string(++handshake_cache_writers) + ".tmp";
+  return {
+    [=](caf::put_atom, const caf::byte_buffer& buf) {
+      CAF_LOG_TRACE(CAF_ARG(path));
+      { // Lifetime scope of out.
+        std::ofstream out{tmp, std::ios::binary | std::ios::trunc};
+        out.write(reinterpret_cast<const char*>(buf.data()),
+                  static_cast<std::streamsize>(buf.size()));
+        if (!out) {
+          CAF_LOG_WARNING("unable to write handshake cache:" << CAF_ARG(tmp));
+          std::remove(tmp.c_str());
+          return;
+        }
+      }
+      // Renaming the temporary file makes sure that other processes never
+      // read a partially written file.
+      if (std::rename(tmp.c_str(), path.c_str()) != 0) {
+        CAF_LOG_WARNING("unable to write handshake cache:" << CAF_ARG(path));
+        std::remove(tmp.c_str());
+      }
+    },
+    [self](caf::close_atom) { self->quit(); },
+  };
+}
+
 } // namespace
 
 namespace caf::io {
@@ -58,6 +104,15 @@ basp_broker::~basp_broker() {
 // -- implementation of local_actor/broker -------------------------------------
 
 void basp_broker::on_exit() {
+  // Ship buffered data before close_all() shuts down our connections.
+  flush_pending();
+  // Release all senders that might still wait for a connection to drain.
+  { // Lifetime scope of guard.
+    std::unique_lock<std::mutex> guard{gates_mtx};
+    for (auto& kvp : gates)
+      kvp.second->open();
+    gates.clear();
+  }
   // Wait until all pending messages of workers have been shipped.
   // TODO: this blocks the calling thread. This is only safe because we know
   //       that the middleman calls this in its stop() function. However,
@@ -70,6 +125,11 @@ void basp_broker::on_exit() {
       if (auto hdl = actor_cast<actor>(observer))
         anon_send(hdl, node_down_msg{node, error{}});
   node_observers.clear();
+  // Let the writer finish pending writes of the handshake cache.
+  if (handshake_cache_writer) {
+    anon_send(handshake_cache_writer, close_atom_v);
+    handshake_cache_writer = nullptr;
+  }
   // Release any obsolete state.
   ctx.clear();
   // Make sure all spawn servers are down before clearing the container.
@@ -106,6 +166,54 @@ behavior basp_broker::make_behavior() {
     }
     automatic_connections = true;
   }
+  flush_threshold = get_or(config(), "caf.middleman.flush-threshold",
+                           defaults::middleman::flush_threshold);
+  max_flush_delay = get_or(config(), "caf.middleman.max-flush-delay",
+                           defaults::middleman::max_flush_delay);
+  high_watermark
+    = get_or(config(), "caf.middleman.write-buffer-high-watermark",
+             defaults::middleman::write_buffer_high_watermark);
+  low_watermark = std::min(
+    get_or(config(), "caf.middleman.write-buffer-low-watermark",
+           defaults::middleman::write_buffer_low_watermark),
+    high_watermark);
+  if (low_watermark == 0)
+    low_watermark = high_watermark / 2;
+  auto policy = get_or(config(), "caf.middleman.write-buffer-overflow-policy",
+                       defaults::middleman::write_buffer_overflow_policy);
+  if (policy == "drop") {
+    overflow_policy = detail::flow_gate::drop_messages;
+  } else if (policy == "hold" && scheduled()) {
+    // Blocked senders may occupy all workers of the scheduler, including the
+    // one that would drain the connection.
+    CAF_LOG_WARNING("cannot hold senders when running brokers on the scheduler,"
+                    " use 'error'");
+    overflow_policy = detail::flow_gate::reject_messages;
+  } else if (policy == "hold") {
+    overflow_policy = detail::flow_gate::hold_senders;
+  } else {
+    CAF_LOG_WARNING_IF(policy != "error",
+                       "invalid write buffer overflow policy, use 'error':"
+                         << CAF_ARG(policy));
+    overflow_policy = detail::flow_gate::reject_messages;
+  }
+  if (get_or(config(), "caf.middleman.serialize-on-send",
+             defaults::middleman::serialize_on_send))
+    buffer_pool = make_counted<detail::byte_buffer_pool>(
+      max_pooled_buffers, max_pooled_buffer_capacity);
+  pipelined_handshake = get_or(config(), "caf.middleman.pipelined-handshake",
+                               defaults::middleman::pipelined_handshake);
+  if (auto path = get_as<std::string>(config(),
+                                      "caf.middleman.handshake-cache-file")) {
+    handshake_cache_file = std::move(*path);
+    load_handshake_cache();
+  }
+  collect_connection_metrics
+    = get_or(config(), "caf.middleman.connection-metrics",
+             defaults::middleman::connection_metrics);
+  aggregate_down_messages
+    = get_or(config(), "caf.middleman.aggregate-down-messages",
+             defaults::middleman::aggregate_down_messages);
   auto heartbeat_interval = get_or(config(), "caf.middleman.heartbeat-interval",
                                    defaults::middleman::heartbeat_interval);
   if (heartbeat_interval > 0) {
@@ -120,11 +228,25 @@ behavior basp_broker::make_behavior() {
       auto& ctx = *this_context;
       auto next = instance.handle(context(), msg, ctx.hdr,
                                   ctx.cstate == basp::await_payload);
+      // We get called from the scribe rather than from resume(), hence we
+      // must not leave any writes behind.
+      flush_pending();
       if (requires_shutdown(next)) {
         connection_cleanup(msg.handle, to_sec(next));
         close(msg.handle);
         return;
       }
+      // We can only label the metrics after the handshake.
+      if (collect_connection_metrics && ctx.metrics.bytes_in == nullptr) {
+        auto nid = ctx.id ? ctx.id : instance.tbl().lookup_direct(msg.handle);
+        if (nid) {
+          ctx.metrics = connection_metrics(msg.handle, to_string(nid));
+          // Bytes in the lanes wait for the connection as well.
+          if (ctx.metrics.write_queue != nullptr)
+            ctx.metrics.write_queue->inc(
+              static_cast<int64_t>(ctx.queued_bytes));
+        }
+      }
       if (next != ctx.cstate) {
         auto rd_size = next == basp::await_payload ? ctx.hdr.payload_len
                                                    : basp::header_size;
@@ -132,6 +254,13 @@ behavior basp_broker::make_behavior() {
         ctx.cstate = next;
       }
     },
+    // received from underlying broker implementation if messages may wait in
+    // the lanes of a connection
+    [=](const data_transferred_msg& msg) {
+      instance.write_pending(context(), msg.handle);
+      check_watermarks(msg.handle);
+      flush_pending();
+    },
     // received from proxy instances
     [=](forward_atom, strong_actor_ptr& src,
         const std::vector<strong_actor_ptr>& fwd_stack, strong_actor_ptr& dest,
@@ -153,6 +282,29 @@ behavior basp_broker::make_behavior() {
         srb(src, mid);
       }
     },
+    // received from proxy instances that serialize messages on the sending
+    // thread
+    [=](forward_atom, strong_actor_ptr& src, strong_actor_ptr& dest,
+        message_id mid, byte_buffer& payload) {
+      CAF_LOG_TRACE(CAF_ARG(src) << CAF_ARG(dest) << CAF_ARG(mid)
+                                 << CAF_ARG2("payload_len", payload.size()));
+      if (!dest || system().node() == dest->node()) {
+        CAF_LOG_WARNING("cannot forward to invalid "
+                        "or local actor:"
+                        << CAF_ARG(dest));
+        return;
+      }
+      if (src && system().node() == src->node())
+        system().registry().put(src->id(), src);
+      if (!instance.dispatch(context(), src, dest->node(), dest->id(), 0, mid,
+                             payload)
+          && mid.is_request()) {
+        detail::sync_request_bouncer srb{exit_reason::remote_link_unreachable};
+        srb(src, mid);
+      }
+      if (buffer_pool)
+        buffer_pool->put_back(std::move(payload));
+    },
     // received from some system calls like whereis
     [=](forward_atom, const node_id& dest_node, uint64_t dest_id,
         const message& msg) -> result<message> {
@@ -189,7 +341,7 @@ behavior basp_broker::make_behavior() {
       CAF_LOG_DEBUG("write monitor_message:" << CAF_ARG(proxy));
       // tell remote side we are monitoring this actor now
       auto hdl = route->hdl;
-      instance.write_monitor_message(context(), get_buffer(hdl), proxy->node(),
+      instance.write_monitor_message(context(), hdl, proxy->node(),
                                      proxy->id());
       flush(hdl);
     },
@@ -238,24 +390,45 @@ behavior basp_broker::make_behavior() {
     [=](const new_connection_msg& msg) {
       CAF_LOG_TRACE(CAF_ARG(msg.handle));
       auto& bi = instance;
-      bi.write_server_handshake(context(), get_buffer(msg.handle),
-                                local_port(msg.source));
-      flush(msg.handle);
+      // Pipelined client handshakes must expect the actor we announce.
+      set_context(msg.handle);
+      const basp::instance::published_actor* pa = nullptr;
+      if (auto i = local_published_actors.find(msg.source);
+          i != local_published_actors.end()) {
+        pa = &i->second;
+      } else {
+        auto& xs = bi.published_actors();
+        if (auto j = xs.find(local_port(msg.source)); j != xs.end())
+          pa = &j->second;
+      }
+      if (pa != nullptr && pa->first != nullptr)
+        this_context->published_actor = pa->first->id();
+      bi.write_server_handshake(context(), get_buffer(msg.handle), pa);
+      super::flush(msg.handle);
       configure_read(msg.handle, receive_policy::exactly(basp::header_size));
+      // Write acknowledgements trigger sending waiting messages and tell us
+      // when the connection drains.
+      if (bi.requires_write_acks() || high_watermark > 0)
+        ack_writes(msg.handle, true);
     },
     // received from underlying broker implementation
     [=](const connection_closed_msg& msg) {
       CAF_LOG_TRACE(CAF_ARG(msg.handle));
       // We might still have pending messages from this connection. To
       // make sure there's no BASP worker deserializing a message, we are
-      // sending us a message through the queue. This message gets
-      // delivered only after all received messages up to this point were
-      // deserialized and delivered.
-      auto& q = instance.queue();
-      auto msg_id = q.new_id();
-      q.push(context(), msg_id, ctrl(),
-             make_mailbox_element(nullptr, make_message_id(), {}, delete_atom_v,
-                                  msg.handle));
+      // sending us a message through the queue of the connection. This
+      // message gets delivered only after all received messages up to this
+      // point were deserialized and delivered.
+      auto i = ctx.find(msg.handle);
+      if (i == ctx.end()) {
+        connection_cleanup(msg.handle, sec::none);
+        return;
+      }
+      auto q = i->second.queue;
+      auto msg_id = q->new_id();
+      q->push(context(), msg_id, ctrl(),
+              make_mailbox_element(nullptr, make_message_id(), {},
+                                   delete_atom_v, msg.handle));
     },
     // received from the message handler above for connection_closed_msg
     [=](delete_atom, connection_handle hdl) {
@@ -264,17 +437,28 @@ behavior basp_broker::make_behavior() {
     // received from underlying broker implementation
     [=](const acceptor_closed_msg& msg) {
       CAF_LOG_TRACE("");
-      // Same reasoning as in connection_closed_msg.
-      auto& q = instance.queue();
-      auto msg_id = q.new_id();
-      q.push(context(), msg_id, ctrl(),
-             make_mailbox_element(nullptr, make_message_id(), {}, delete_atom_v,
-                                  msg.handle));
+      // Same reasoning as in connection_closed_msg. However, messages from
+      // any connection may still be in flight. Hence, we send us a message
+      // through the queue of each connection and clean up after receiving the
+      // last one.
+      auto& entry = closing_acceptors[msg.handle];
+      entry.first = local_port(msg.handle);
+      for (auto& kvp : ctx) {
+        auto q = kvp.second.queue;
+        auto msg_id = q->new_id();
+        q->push(context(), msg_id, ctrl(),
+                make_mailbox_element(nullptr, make_message_id(), {},
+                                     delete_atom_v, msg.handle));
+        ++entry.second;
+      }
+      if (entry.second == 0)
+        acceptor_cleanup(msg.handle);
     },
     // received from the message handler above for acceptor_closed_msg
     [=](delete_atom, accept_handle hdl) {
-      auto port = local_port(hdl);
-      instance.remove_published_actor(port);
+      auto i = closing_acceptors.find(hdl);
+      if (i != closing_acceptors.end() && --i->second.second == 0)
+        acceptor_cleanup(hdl);
     },
     // received from middleman actor
     [=](publish_atom, doorman_ptr& ptr, uint16_t port,
@@ -287,6 +471,18 @@ behavior basp_broker::make_behavior() {
         system().registry().put(whom->id(), whom);
       instance.add_published_actor(port, whom, std::move(sigs));
     },
+    // received from middleman actor for doormen on Unix domain sockets
+    [=](publish_atom, doorman_ptr& ptr, const strong_actor_ptr& whom,
+        std::set<std::string>& sigs) {
+      CAF_LOG_TRACE(CAF_ARG(ptr) << CAF_ARG(whom) << CAF_ARG(sigs));
+      CAF_ASSERT(ptr != nullptr);
+      auto hdl = ptr->hdl();
+      add_doorman(std::move(ptr));
+      if (whom)
+        system().registry().put(whom->id(), whom);
+      local_published_actors.emplace(hdl, std::make_pair(whom,
+                                                         std::move(sigs)));
+    },
     // received from test code to set up two instances without doorman
     [=](publish_atom, scribe_ptr& ptr, uint16_t port,
         const strong_actor_ptr& whom, std::set<std::string>& sigs) {
@@ -299,32 +495,67 @@ behavior basp_broker::make_behavior() {
         system().registry().put(whom->id(), whom);
       instance.add_published_actor(port, whom, std::move(sigs));
       set_context(hdl);
+      if (whom)
+        this_context->published_actor = whom->id();
       instance.write_server_handshake(context(), get_buffer(hdl), port);
       flush(hdl);
       configure_read(hdl, receive_policy::exactly(basp::header_size));
     },
-    // received from middleman actor (delegated)
+    // received from test code and from the connection helper
     [=](connect_atom, scribe_ptr& ptr, uint16_t port) {
       CAF_LOG_TRACE(CAF_ARG(ptr) << CAF_ARG(port));
-      CAF_ASSERT(ptr != nullptr);
+      auto& ctx = init_client_context(ptr, std::string{}, port);
+      ctx.callback = make_response_promise();
+      instance.write_client_handshake(context(), get_buffer(ctx.hdl));
+      flush(ctx.hdl);
+    },
+    // received from middleman actor (delegated)
+    [=](connect_atom, scribe_ptr& ptr, std::string& host, uint16_t port) {
+      CAF_LOG_TRACE(CAF_ARG(ptr) << CAF_ARG(host) << CAF_ARG(port));
       auto rp = make_response_promise();
+      auto& ctx = init_client_context(ptr, std::move(host), port);
+      auto hdl = ctx.hdl;
+      // Respond immediately if we can skip waiting for the server handshake.
+      if (auto info = pipeline_client_handshake(ctx)) {
+        auto& [nid, aid, sigs] = *info;
+        strong_actor_ptr proxy;
+        if (aid != invalid_actor_id)
+          proxy = namespace_.get_or_put(nid, aid);
+        flush(hdl);
+        rp.deliver(nid, std::move(proxy), std::move(sigs));
+        return;
+      }
+      ctx.callback = rp;
+      instance.write_client_handshake(context(), get_buffer(hdl));
+      flush(hdl);
+    },
+    // received from middleman actor for additional connections to `nid`
+    [=](connect_atom, scribe_ptr& ptr, const node_id& nid) {
+      CAF_LOG_TRACE(CAF_ARG(ptr) << CAF_ARG(nid));
+      CAF_ASSERT(ptr != nullptr);
       auto hdl = ptr->hdl();
       add_scribe(std::move(ptr));
       auto& ctx = this->ctx[hdl];
       ctx.hdl = hdl;
-      ctx.remote_port = port;
       ctx.cstate = basp::await_header;
-      ctx.callback = rp;
-      // await server handshake
+      ctx.stripe = true;
+      ctx.id = nid;
       configure_read(hdl, receive_policy::exactly(basp::header_size));
-      // send client handshake
-      instance.write_client_handshake(context(), get_buffer(hdl));
+      if (instance.requires_write_acks() || high_watermark > 0)
+        ack_writes(hdl, true);
+      instance.write_client_handshake(context(), get_buffer(hdl), true);
       flush(hdl);
     },
     [=](delete_atom, const node_id& nid, actor_id aid) {
       CAF_LOG_TRACE(CAF_ARG(nid) << ", " << CAF_ARG(aid));
       proxies().erase(nid, aid);
     },
+    // received from the BASP instance when a pinned sender terminates
+    [=](delete_atom, actor_id aid) {
+      CAF_LOG_TRACE(CAF_ARG(aid));
+      for (auto& kvp : ctx)
+        kvp.second.pinned_senders.erase(aid);
+    },
     // received from the BASP instance when receiving down_message
     [=](delete_atom, const node_id& nid, actor_id aid, error& fail_state) {
       CAF_LOG_TRACE(CAF_ARG(nid)
@@ -334,9 +565,24 @@ behavior basp_broker::make_behavior() {
     [=](unpublish_atom, const actor_addr& whom, uint16_t port) -> result<void> {
       CAF_LOG_TRACE(CAF_ARG(whom) << CAF_ARG(port));
       auto cb = make_callback([&](const strong_actor_ptr&, uint16_t x) {
-        close(hdl_by_port(x));
+        // Close the TCP doorman as well as the shared memory doorman.
+        while (close(hdl_by_port(x)))
+          ; // nop
       });
-      if (instance.remove_published_actor(whom, port, &cb) == 0)
+      auto removed = instance.remove_published_actor(whom, port, &cb);
+      if (port == 0) {
+        auto i = local_published_actors.begin();
+        while (i != local_published_actors.end()) {
+          if (i->second.first == whom) {
+            close(i->first);
+            i = local_published_actors.erase(i);
+            ++removed;
+          } else {
+            ++i;
+          }
+        }
+      }
+      if (removed == 0)
         return sec::no_actor_published_at_port;
       return unit;
     },
@@ -346,7 +592,9 @@ behavior basp_broker::make_behavior() {
       // It is well-defined behavior to not have an actor published here,
       // hence the result can be ignored safely.
       instance.remove_published_actor(port, nullptr);
-      auto res = close(hdl_by_port(port));
+      auto res = false;
+      while (close(hdl_by_port(port)))
+        res = true;
       if (res)
         return unit;
       return sec::cannot_close_invalid_port;
@@ -363,8 +611,10 @@ behavior basp_broker::make_behavior() {
     },
     [=](tick_atom, size_t interval) {
       instance.handle_heartbeat(context());
-      delayed_send(this, std::chrono::milliseconds{interval}, tick_atom_v,
-                   interval);
+      // The heartbeat stays in the event loop instead of going through the
+      // clock of the actor system.
+      delayed_io_send(std::chrono::milliseconds{interval}, tick_atom_v,
+                      interval);
     }};
 }
 
@@ -379,6 +629,13 @@ resumable::resume_result basp_broker::resume(execution_unit* ctx, size_t mt) {
   return super::resume(ctx, mt);
 }
 
+void basp_broker::after_activation() {
+  // Flushing must happen before the broker hands its staged writes to the
+  // multiplexer and before another thread may pick up the broker again.
+  flush_pending();
+  super::after_activation();
+}
+
 strong_actor_ptr basp_broker::make_proxy(node_id nid, actor_id aid) {
   CAF_LOG_TRACE(CAF_ARG(nid) << CAF_ARG(aid));
   CAF_ASSERT(nid != this_node());
@@ -390,24 +647,36 @@ strong_actor_ptr basp_broker::make_proxy(node_id nid, actor_id aid) {
   // us a handle to a third node B, then we assume that A offers a route to B
   if (t_last_hop != nullptr && nid != *t_last_hop
       && instance.tbl().add_indirect(*t_last_hop, nid))
-    mm->backend().dispatch([=] { learned_new_node_indirectly(nid); });
+    dispatch_io_event(
+      io_event{[=](execution_unit*) { learned_new_node_indirectly(nid); }});
   // we need to tell remote side we are watching this actor now;
   // use a direct route if possible, i.e., when talking to a third node
   // create proxy and add functor that will be called if we
   // receive a basp::down_message
   actor_config cfg;
+  detail::flow_gate_ptr gate;
+  if (high_watermark > 0) {
+    std::unique_lock<std::mutex> guard{gates_mtx};
+    auto& ptr = gates[nid];
+    if (ptr == nullptr)
+      ptr = make_counted<detail::flow_gate>(overflow_policy,
+                                            mm->backend().thread_id());
+    gate = ptr;
+  }
   auto res = make_actor<forwarding_actor_proxy, strong_actor_ptr>(
-    aid, nid, &(system()), cfg, this);
+    aid, nid, &(system()), cfg, this, std::move(gate), buffer_pool,
+    mm->metric_singletons.serialization_time,
+    mm->metric_singletons.serialization_time_by_type);
   strong_actor_ptr selfptr{ctrl()};
   res->get()->attach_functor([=](const error& rsn) {
-    mm->backend().post([=] {
+    auto bptr = static_cast<basp_broker*>(selfptr->get());
+    bptr->post_io_event(io_event{[=](execution_unit*) {
       // using res->id() instead of aid keeps this actor instance alive
       // until the original instance terminates, thus preventing subtle
       // bugs with attachables
-      auto bptr = static_cast<basp_broker*>(selfptr->get());
       if (!bptr->getf(abstract_actor::is_terminated_flag))
         bptr->proxies().erase(nid, res->id(), rsn);
-    });
+    }});
   });
   return res;
 }
@@ -421,6 +690,7 @@ void basp_broker::finalize_handshake(const node_id& nid, actor_id aid,
   CAF_LOG_TRACE(CAF_ARG(nid) << CAF_ARG(aid) << CAF_ARG(sigs));
   CAF_ASSERT(this_context != nullptr);
   this_context->id = nid;
+  cache_handshake(*this_context, nid, aid, sigs);
   auto& cb = this_context->callback;
   if (cb == none)
     return;
@@ -441,9 +711,37 @@ void basp_broker::finalize_handshake(const node_id& nid, actor_id aid,
 }
 
 void basp_broker::purge_state(const node_id& nid) {
-  CAF_LOG_TRACE(CAF_ARG(nid));
-  // Destroy all proxies of the lost node.
-  namespace_.erase(nid);
+  purge_state(nid, {}, error{});
+}
+
+void basp_broker::purge_state(const node_id& nid,
+                              std::vector<actor_addr> observers, error reason) {
+  CAF_LOG_TRACE(CAF_ARG(nid) << CAF_ARG(reason));
+  // Destroy all proxies of the lost node. Killing proxies sends messages to
+  // all monitors and links. Hence, we kill them in the background to avoid
+  // stalling the I/O thread for nodes with many proxies. Observers of the node
+  // receive the node_down_msg only after the down_msg of each proxy, i.e.,
+  // the same order as killing all proxies before returning from this function.
+  auto& mm_metrics = system().middleman().metric_singletons;
+  auto teardown_time = mm_metrics.proxy_teardown_time;
+  auto done = [nid, teardown_time, observers{std::move(observers)},
+               reason{std::move(reason)}](size_t, timespan elapsed) {
+    using dbl_secs = std::chrono::duration<double>;
+    teardown_time->observe(
+      std::chrono::duration_cast<dbl_secs>(elapsed).count());
+    for (const auto& observer : observers)
+      if (auto hdl = actor_cast<actor>(observer))
+        caf::anon_send(hdl, node_down_msg{nid, reason});
+  };
+  namespace_.erase_async(nid, std::move(done), aggregate_down_messages);
+  // Release all senders that wait for the connection to the lost node.
+  if (high_watermark > 0) {
+    std::unique_lock<std::mutex> guard{gates_mtx};
+    if (auto i = gates.find(nid); i != gates.end()) {
+      i->second->open();
+      gates.erase(i);
+    }
+  }
   // Cleanup all remaining references to the lost node.
   for (auto& kvp : monitored_actors)
     kvp.second.erase(nid);
@@ -458,7 +756,7 @@ void basp_broker::send_basp_down_message(const node_id& nid, actor_id aid,
       "cannot send exit message for proxy, no route to host:" << CAF_ARG(nid));
     return;
   }
-  instance.write_down_message(context(), get_buffer(path->hdl), nid, aid, rsn);
+  instance.write_down_message(context(), path->hdl, nid, aid, rsn);
   instance.flush(*path);
 }
 
@@ -492,14 +790,13 @@ void basp_broker::handle_down_msg(down_msg& dm) {
   monitored_actors.erase(i);
 }
 
-void basp_broker::emit_node_down_msg(const node_id& node, const error& reason) {
-  auto i = node_observers.find(node);
-  if (i == node_observers.end())
-    return;
-  for (const auto& observer : i->second)
-    if (auto hdl = actor_cast<actor>(observer))
-      anon_send(hdl, node_down_msg{node, reason});
-  node_observers.erase(i);
+std::vector<actor_addr> basp_broker::take_node_observers(const node_id& node) {
+  std::vector<actor_addr> result;
+  if (auto i = node_observers.find(node); i != node_observers.end()) {
+    result = std::move(i->second);
+    node_observers.erase(i);
+  }
+  return result;
 }
 
 void basp_broker::learned_new_node(const node_id& nid) {
@@ -585,6 +882,97 @@ void basp_broker::learned_new_node_indirectly(const node_id& nid) {
   }
 }
 
+basp::endpoint_context&
+basp_broker::init_client_context(scribe_ptr& ptr, std::string host,
+                                 uint16_t port) {
+  CAF_ASSERT(ptr != nullptr);
+  auto hdl = ptr->hdl();
+  add_scribe(std::move(ptr));
+  auto& ctx = this->ctx[hdl];
+  ctx.hdl = hdl;
+  ctx.remote_port = port;
+  ctx.remote_host = std::move(host);
+  ctx.cstate = basp::await_header;
+  // await server handshake
+  configure_read(hdl, receive_policy::exactly(basp::header_size));
+  if (instance.requires_write_acks() || high_watermark > 0)
+    ack_writes(hdl, true);
+  return ctx;
+}
+
+optional<basp_broker::server_info>
+basp_broker::pipeline_client_handshake(basp::endpoint_context& ectx) {
+  if (!pipelined_handshake || ectx.remote_host.empty())
+    return none;
+  auto i = handshake_cache.find(server_endpoint{ectx.remote_host,
+                                                ectx.remote_port});
+  if (i == handshake_cache.end())
+    return none;
+  auto& nid = std::get<0>(i->second);
+  // An existing connection to the node makes this one redundant. The regular
+  // handshake takes care of closing it.
+  if (nid == this_node() || instance.tbl().lookup_direct(nid))
+    return none;
+  CAF_LOG_DEBUG("pipeline client handshake:" << CAF_ARG(nid));
+  auto aid = std::get<1>(i->second);
+  ectx.id = nid;
+  ectx.pipelined = true;
+  ectx.published_actor = aid;
+  instance.write_client_handshake(context(), get_buffer(ectx.hdl), false, nid,
+                                  aid);
+  instance.add_pipelined_route(ectx.hdl, nid);
+  return i->second;
+}
+
+void basp_broker::cache_handshake(const basp::endpoint_context& ectx,
+                                  const node_id& nid, actor_id aid,
+                                  const std::set<std::string>& sigs) {
+  if (ectx.remote_host.empty() || nid == this_node())
+    return;
+  auto& entry = handshake_cache[server_endpoint{ectx.remote_host,
+                                                ectx.remote_port}];
+  if (std::get<0>(entry) == nid && std::get<1>(entry) == aid
+      && std::get<2>(entry) == sigs)
+    return;
+  entry = server_info{nid, aid, sigs};
+  save_handshake_cache();
+}
+
+void basp_broker::load_handshake_cache() {
+  CAF_LOG_TRACE(CAF_ARG(handshake_cache_file));
+  std::ifstream in{handshake_cache_file, std::ios::binary};
+  if (!in)
+    return;
+  std::string buf{std::istreambuf_iterator<char>{in},
+                  std::istreambuf_iterator<char>{}};
+  binary_deserializer source{system(), buf.data(), buf.size()};
+  // Entries from other BASP versions may no longer match the handshake.
+  auto version = uint64_t{0};
+  if (!source.apply(version) || version != basp::version
+      || !source.apply(handshake_cache)) {
+    CAF_LOG_WARNING("unable to read handshake cache:"
+                    << CAF_ARG(handshake_cache_file));
+    handshake_cache.clear();
+  }
+}
+
+void basp_broker::save_handshake_cache() {
+  if (handshake_cache_file.empty())
+    return;
+  CAF_LOG_TRACE(CAF_ARG(handshake_cache_file));
+  byte_buffer buf;
+  binary_serializer sink{system(), buf};
+  auto version = basp::version;
+  if (!sink.apply(version) || !sink.apply(handshake_cache)) {
+    CAF_LOG_ERROR("unable to serialize handshake cache:" << sink.get_error());
+    return;
+  }
+  if (!handshake_cache_writer)
+    handshake_cache_writer = system().spawn<detached + hidden>(
+      ::handshake_cache_writer, handshake_cache_file);
+  anon_send(handshake_cache_writer, put_atom_v, std::move(buf));
+}
+
 void basp_broker::set_context(connection_handle hdl) {
   CAF_LOG_TRACE(CAF_ARG(hdl));
   auto i = ctx.find(hdl);
@@ -607,11 +995,51 @@ void basp_broker::set_context(connection_handle hdl) {
 
 void basp_broker::connection_cleanup(connection_handle hdl, sec code) {
   CAF_LOG_TRACE(CAF_ARG(hdl) << CAF_ARG(code));
+  // Release throttled proxies while we can still find their route. Losing
+  // any connection drops all connections to the node.
+  if (auto i = ctx.find(hdl); i != ctx.end()) {
+    auto& ref = i->second;
+    if (ref.congested) {
+      ref.congested = false;
+      if (auto nid = instance.tbl().lookup_direct(hdl))
+        set_congested(nid, false);
+    }
+    if (ref.pending_bytes != nullptr)
+      ref.pending_bytes->value(0);
+    // The scribe removes its own bytes from the write queue once it goes
+    // away, but the lanes go away with the context.
+    if (ref.metrics.write_queue != nullptr) {
+      ref.metrics.write_queue->dec(static_cast<int64_t>(ref.queued_bytes));
+      ref.metrics.write_queue = nullptr;
+    }
+    if (ref.metrics.start_time != nullptr)
+      ref.metrics.start_time->value(0);
+  }
+  // Additional connections to a node become useless without the direct
+  // connection.
+  auto& tbl = instance.tbl();
+  std::vector<connection_handle> stripes;
+  if (auto nid = tbl.lookup_direct(hdl)) {
+    auto direct = tbl.lookup_direct(nid);
+    if (direct == hdl) {
+      stripes = tbl.stripes(nid);
+    } else if (direct) {
+      // Messages in flight on the lost stripe are gone and we cannot tell the
+      // senders which ones. Hence, we treat this like losing the node.
+      CAF_LOG_INFO("lost an additional connection, drop all connections:"
+                   << CAF_ARG(nid));
+      auto direct_hdl = *direct;
+      connection_cleanup(direct_hdl, code);
+      close(direct_hdl);
+    }
+  }
   // Remove handle from the routing table, notify all observers, and clean up
   // any node-specific state we might still have.
-  if (auto nid = instance.tbl().erase_direct(hdl)) {
-    emit_node_down_msg(nid, code);
-    purge_state(nid);
+  if (auto nid = tbl.erase_direct(hdl))
+    purge_state(nid, take_node_observers(nid), code);
+  for (auto& x : stripes) {
+    connection_cleanup(x, code);
+    close(x);
   }
   // Remove the context for `hdl`, making sure clients receive an error in case
   // this connection was closed during handshake.
@@ -628,12 +1056,121 @@ void basp_broker::connection_cleanup(connection_handle hdl, sec code) {
   }
 }
 
+void basp_broker::acceptor_cleanup(accept_handle hdl) {
+  CAF_LOG_TRACE(CAF_ARG(hdl));
+  auto i = closing_acceptors.find(hdl);
+  if (i == closing_acceptors.end())
+    return;
+  auto port = i->second.first;
+  closing_acceptors.erase(i);
+  if (local_published_actors.erase(hdl) == 0)
+    instance.remove_published_actor(port);
+}
+
 byte_buffer& basp_broker::get_buffer(connection_handle hdl) {
   return wr_buf(hdl);
 }
 
 void basp_broker::flush(connection_handle hdl) {
-  super::flush(hdl);
+  check_watermarks(hdl);
+  if (flush_threshold == 0) {
+    super::flush(hdl);
+    return;
+  }
+  if (!by_id(hdl))
+    return;
+  if (wr_buf(hdl).size() >= flush_threshold) {
+    // No need to flush the same buffer again at the end of the activation.
+    auto i = std::find(pending_flushes.begin(), pending_flushes.end(), hdl);
+    if (i != pending_flushes.end())
+      pending_flushes.erase(i);
+    super::flush(hdl);
+    return;
+  }
+  auto now = std::chrono::steady_clock::now();
+  if (pending_flushes.empty()) {
+    first_pending_flush = now;
+    pending_flushes.emplace_back(hdl);
+    return;
+  }
+  auto i = std::find(pending_flushes.begin(), pending_flushes.end(), hdl);
+  if (i == pending_flushes.end())
+    pending_flushes.emplace_back(hdl);
+  if (max_flush_delay.count() > 0
+      && now - first_pending_flush >= max_flush_delay)
+    flush_pending();
+}
+
+void basp_broker::flush_pending() {
+  for (auto hdl : pending_flushes)
+    super::flush(hdl);
+  pending_flushes.clear();
+}
+
+void basp_broker::check_watermarks(connection_handle hdl) {
+  if (high_watermark == 0)
+    return;
+  auto i = ctx.find(hdl);
+  if (!by_id(hdl) || i == ctx.end())
+    return;
+  // We can only throttle proxies and label the gauge after the handshake.
+  auto nid = instance.tbl().lookup_direct(hdl);
+  if (!nid)
+    return;
+  auto& ref = i->second;
+  if (ref.pending_bytes == nullptr) {
+    auto fptr = system().middleman().metric_singletons.pending_bytes;
+    ref.pending_bytes = fptr->get_or_add({{"node", to_string(nid)}});
+  }
+  // Any congested connection to a node throttles all proxies of the node,
+  // since proxies may send on each of its connections.
+  auto hdls = instance.tbl().stripes(nid);
+  if (auto direct = instance.tbl().lookup_direct(nid))
+    hdls.emplace_back(*direct);
+  auto node_state = [&] {
+    auto congested = false;
+    size_t total = 0;
+    for (auto x : hdls) {
+      if (auto j = ctx.find(x); j != ctx.end() && by_id(x)) {
+        congested = congested || j->second.congested;
+        total += pending_bytes(x) + j->second.queued_bytes;
+      }
+    }
+    return std::make_pair(congested, total);
+  };
+  auto was_congested = node_state().first;
+  auto pending = pending_bytes(hdl) + ref.queued_bytes;
+  if (!ref.congested && pending >= high_watermark) {
+    CAF_LOG_DEBUG("connection exceeds high watermark:" << CAF_ARG(hdl)
+                                                       << CAF_ARG(pending));
+    ref.congested = true;
+  } else if (ref.congested && pending <= low_watermark) {
+    CAF_LOG_DEBUG("connection drained below low watermark:"
+                  << CAF_ARG(hdl) << CAF_ARG(pending));
+    ref.congested = false;
+  }
+  auto [congested, total] = node_state();
+  ref.pending_bytes->value(static_cast<int64_t>(total));
+  if (congested != was_congested)
+    set_congested(nid, congested);
+}
+
+void basp_broker::set_congested(const node_id& nid, bool value) {
+  std::unique_lock<std::mutex> guard{gates_mtx};
+  for (auto& [dst, gate] : gates) {
+    auto route = instance.tbl().lookup(dst);
+    if (route && route->next_hop == nid) {
+      if (value)
+        gate->close();
+      else
+        gate->open();
+    }
+  }
+}
+
+basp::endpoint_context* basp_broker::get_context(connection_handle hdl) {
+  auto i = ctx.find(hdl);
+  return i != ctx.end() ? &i->second : nullptr;
 }
 
 void basp_broker::handle_heartbeat() {
@@ -32,6 +32,12 @@ bool datagram_servant::consume(execution_unit* ctx, datagram_handle hdl,
     // further activities for the broker
     return false;
   }
+  if (parent()->scheduled()) {
+    // Brokers on the scheduler receive a copy, because the handler reuses its
+    // buffer for the next read right away.
+    return schedule_mailbox_element(hdl, make_message(new_datagram_msg{
+                                           hdl, network::receive_buffer{buf}}));
+  }
   // keep a strong reference to our parent until we leave scope
   // to avoid UB when becoming detached during invocation
   auto guard = parent_;
@@ -51,6 +57,12 @@ void datagram_servant::datagram_sent(execution_unit* ctx, datagram_handle hdl,
   if (detached())
     return;
   using sent_t = datagram_sent_msg;
+  if (parent()->scheduled()) {
+    schedule_message(hdl,
+                     make_message(sent_t{hdl, written, std::move(buffer)}),
+                     false);
+    return;
+  }
   mailbox_element tmp{strong_actor_ptr{}, make_message_id(),
                       mailbox_element::forwarding_stack{},
                       make_message(sent_t{hdl, written, std::move(buffer)})};
@@ -43,6 +43,7 @@
 #include "caf/sec.hpp"
 #include "caf/send.hpp"
 #include "caf/typed_event_based_actor.hpp"
+#include "caf/uri.hpp"
 
 #ifdef CAF_WINDOWS
 #  include <fcntl.h>
@@ -53,7 +54,7 @@ namespace caf::io {
 
 namespace {
 
-auto make_metrics(telemetry::metric_registry& reg) {
+auto make_metrics(telemetry::metric_registry& reg, bool connection_metrics) {
   std::array<double, 9> default_time_buckets{{
     .0002, //  20us
     .0004, //  40us
@@ -76,7 +77,22 @@ auto make_metrics(telemetry::metric_registry& reg) {
     500'000,
     1'000'000,
   }};
-  return middleman::metric_singletons_t{
+  std::array<double, 6> teardown_time_buckets{{
+    .001, //   1ms
+    .01,  //  10ms
+    .1,   // 100ms
+    1.,   //   1s
+    5.,   //   5s
+    10.,  //  10s
+  }};
+  auto queueing_time = reg.histogram_family<double>(
+    "caf.middleman", "queueing-time", {"lane"}, default_time_buckets,
+    "Time outbound messages wait in a lane of their connection.", "seconds");
+  auto broker_latency = reg.histogram_family<double>(
+    "caf.middleman", "broker-latency", {"mode"}, default_time_buckets,
+    "Time between reading from a socket and a broker handling the data.",
+    "seconds");
+  auto result = middleman::metric_singletons_t{
     reg.histogram_singleton(
       "caf.middleman", "inbound-messages-size", default_size_buckets,
       "The size of inbound messages before deserializing them.", "bytes"),
@@ -88,8 +104,66 @@ auto make_metrics(telemetry::metric_registry& reg) {
       "The size of outbound messages after serializing them.", "bytes"),
     reg.histogram_singleton<double>(
       "caf.middleman", "serialization-time", default_time_buckets,
-      "Time the middleman needs to serialize outbound messages.", "seconds"),
+      "Time for serializing outbound messages.", "seconds"),
+    queueing_time->get_or_add({{"lane", "urgent"}}),
+    queueing_time->get_or_add({{"lane", "normal"}}),
+    queueing_time->get_or_add({{"lane", "bulk"}}),
+    reg.gauge_family("caf.middleman", "pending-bytes", {"node"},
+                     "Bytes that wait for the connections to a node.", "bytes"),
+    reg.histogram_singleton<double>(
+      "caf.middleman", "proxy-teardown-time", teardown_time_buckets,
+      "Time the middleman needs to kill all proxies of a lost node.",
+      "seconds"),
+    broker_latency->get_or_add({{"mode", "multiplexer"}}),
+    broker_latency->get_or_add({{"mode", "scheduler"}}),
   };
+  if (!connection_metrics)
+    return result;
+  // Single reads and writes on a socket usually take only a few microseconds.
+  std::array<double, 9> io_time_buckets{{
+    .000001, //   1us
+    .000005, //   5us
+    .00001,  //  10us
+    .00005,  //  50us
+    .0001,   // 100us
+    .0005,   // 500us
+    .001,    //   1ms
+    .005,    //   5ms
+    .01,     //  10ms
+  }};
+  result.received_bytes = reg.counter_family(
+    "caf.middleman", "received-bytes", {"node"},
+    "Bytes received from a node.", "bytes", true);
+  result.sent_bytes = reg.counter_family("caf.middleman", "sent-bytes",
+                                         {"node"}, "Bytes sent to a node.",
+                                         "bytes", true);
+  result.received_frames = reg.counter_family(
+    "caf.middleman", "received-frames", {"node"},
+    "Frames received from a node.", "1", true);
+  result.sent_frames = reg.counter_family("caf.middleman", "sent-frames",
+                                          {"node"}, "Frames sent to a node.",
+                                          "1", true);
+  result.read_time = reg.histogram_family<double>(
+    "caf.middleman", "read-time", {"node"}, io_time_buckets,
+    "Time a single read from the socket of a connection takes.", "seconds");
+  result.write_time = reg.histogram_family<double>(
+    "caf.middleman", "write-time", {"node"}, io_time_buckets,
+    "Time a single write to the socket of a connection takes.", "seconds");
+  result.write_queue_size = reg.gauge_family(
+    "caf.middleman", "write-queue-size", {"node", "connection"},
+    "Bytes that wait for the socket of a connection.", "bytes");
+  result.connection_start_time = reg.gauge_family(
+    "caf.middleman", "connection-start-time", {"node", "connection"},
+    "Start of a connection in seconds since the UNIX epoch.", "seconds");
+  result.serialization_time_by_type = reg.histogram_family<double>(
+    "caf.middleman", "message-serialization-time", {"type"},
+    default_time_buckets, "Time the middleman needs to serialize a message.",
+    "seconds");
+  result.deserialization_time_by_type = reg.histogram_family<double>(
+    "caf.middleman", "message-deserialization-time", {"type"},
+    default_time_buckets, "Time the middleman needs to deserialize a message.",
+    "seconds");
+  return result;
 }
 
 template <class T>
@@ -188,7 +262,57 @@ void middleman::add_module_options(actor_system_config& cfg) {
                "schedule utility actors instead of dedicating threads")
     .add<bool>("manual-multiplexing",
                "disables background activity of the multiplexer")
-    .add<size_t>("workers", "number of deserialization workers");
+    .add<size_t>("workers", "number of deserialization workers")
+    .add<size_t>("flush-threshold",
+                 "max. number of buffered bytes before BASP flushes a write "
+                 "buffer immediately (0 disables write coalescing)")
+    .add<timespan>("max-flush-delay",
+                   "max. time BASP delays flushing buffered writes")
+    .add<size_t>("max-fragment-size",
+                 "max. size of BASP message fragments (0 disables "
+                 "fragmentation)")
+    .add<bool>("priority-lanes",
+               "write urgent BASP messages ahead of other messages")
+    .add<size_t>("write-buffer-high-watermark",
+                 "max. pending bytes per connection before throttling "
+                 "proxies (0 disables the limit)")
+    .add<size_t>("write-buffer-low-watermark",
+                 "pending bytes per connection that end throttling (0 "
+                 "selects half of the high watermark)")
+    .add<std::string>("write-buffer-overflow-policy",
+                      "either 'drop', 'error' or 'hold'")
+    .add<bool>("serialize-on-send",
+               "serialize messages to remote actors on the sending thread")
+    .add<size_t>("connections-per-peer",
+                 "number of TCP connections to each remote node")
+    .add<bool>("shared-memory",
+               "connect to nodes on the same host via shared memory")
+    .add<std::string>("shared-memory-dir",
+                      "directory for shared memory rendezvous sockets")
+    .add<size_t>("shared-memory-ring-size",
+                 "bytes per direction in shared memory segments")
+    .add<bool>("pipelined-handshake",
+               "send messages to known servers without awaiting handshakes")
+    .add<std::string>("handshake-cache-file",
+                      "file for keeping known servers across restarts")
+    .add<size_t>("resolver-threads", "number of threads for resolving hosts")
+    .add<timespan>("resolver-cache-ttl",
+                   "time to keep resolved addresses of a host")
+    .add<timespan>("connection-attempt-delay",
+                   "delay before racing the next address of a host")
+    .add<std::string>("broker-execution",
+                      "either 'multiplexer' or 'scheduler' (runs brokers on "
+                      "the workers of the scheduler)")
+    .add<timespan>("busy-poll-duration",
+                   "time to poll without blocking before waiting for events")
+    .add<timespan>("socket-busy-poll",
+                   "sets SO_BUSY_POLL on TCP sockets (requires Linux)")
+    .add<bool>("adaptive-reads",
+               "read as much as available and slice frames out of the buffer")
+    .add<bool>("connection-metrics",
+               "collect metrics per connection and per message type")
+    .add<bool>("aggregate-down-messages",
+               "send one proxies_down_msg per observer for a lost node");
   config_option_adder{cfg.custom_options(), "caf.middleman.prometheus-http"}
     .add<uint16_t>("port", "listening port for incoming scrapes")
     .add<std::string>("address", "bind address for the HTTP server socket");
@@ -205,7 +329,34 @@ actor_system::module* middleman::make(actor_system& sys, detail::type_list<>) {
 
 middleman::middleman(actor_system& sys) : system_(sys) {
   remote_groups_ = make_counted<detail::remote_group_module>(this);
-  metric_singletons = make_metrics(sys.metrics());
+  metric_singletons = make_metrics(
+    sys.metrics(), get_or(sys.config(), "caf.middleman.connection-metrics",
+                          defaults::middleman::connection_metrics));
+}
+
+network::connection_metrics
+middleman::connection_metrics(string_view node, string_view connection) {
+  network::connection_metrics result;
+  auto& fs = metric_singletons;
+  if (fs.received_bytes == nullptr)
+    return result;
+  // Counters and histograms add up over all connections to a node, whereas
+  // gauges describe a single connection.
+  auto labels = {telemetry::label_view{"node", node}};
+  auto conn_labels = {telemetry::label_view{"node", node},
+                      telemetry::label_view{"connection", connection}};
+  result.bytes_in = fs.received_bytes->get_or_add(labels);
+  result.bytes_out = fs.sent_bytes->get_or_add(labels);
+  result.frames_in = fs.received_frames->get_or_add(labels);
+  result.frames_out = fs.sent_frames->get_or_add(labels);
+  result.read_time = fs.read_time->get_or_add(labels);
+  result.write_time = fs.write_time->get_or_add(labels);
+  result.write_queue = fs.write_queue_size->get_or_add(conn_labels);
+  result.start_time = fs.connection_start_time->get_or_add(conn_labels);
+  auto now = std::chrono::system_clock::now().time_since_epoch();
+  result.start_time->value(
+    std::chrono::duration_cast<std::chrono::seconds>(now).count());
+  return result;
 }
 
 expected<strong_actor_ptr>
@@ -250,6 +401,16 @@ expected<uint16_t> middleman::publish(const strong_actor_ptr& whom,
   return f(publish_atom_v, port, std::move(whom), std::move(sigs), in, ru);
 }
 
+expected<void> middleman::publish(const strong_actor_ptr& whom,
+                                  std::set<std::string> sigs,
+                                  const uri& locator) {
+  CAF_LOG_TRACE(CAF_ARG(whom) << CAF_ARG(sigs) << CAF_ARG(locator));
+  if (!whom)
+    return sec::cannot_publish_invalid_actor;
+  auto f = make_function_view(actor_handle());
+  return f(publish_atom_v, locator, std::move(whom), std::move(sigs));
+}
+
 expected<uint16_t> middleman::publish_local_groups(uint16_t port,
                                                    const char* in, bool reuse) {
   CAF_LOG_TRACE(CAF_ARG(port) << CAF_ARG(in));
@@ -294,6 +455,22 @@ expected<strong_actor_ptr> middleman::remote_actor(std::set<std::string> ifs,
   return ptr;
 }
 
+expected<strong_actor_ptr> middleman::remote_actor(std::set<std::string> ifs,
+                                                   const uri& locator) {
+  CAF_LOG_TRACE(CAF_ARG(ifs) << CAF_ARG(locator));
+  auto f = make_function_view(actor_handle());
+  auto res = f(connect_atom_v, locator);
+  if (!res)
+    return std::move(res.error());
+  strong_actor_ptr ptr = std::move(std::get<1>(*res));
+  if (!ptr)
+    return make_error(sec::no_actor_published_at_port, locator);
+  if (!system().assignable(std::get<2>(*res), ifs))
+    return make_error(sec::unexpected_actor_messaging_interface, std::move(ifs),
+                      std::move(std::get<2>(*res)));
+  return ptr;
+}
+
 expected<group> middleman::remote_group(const std::string& group_uri) {
   CAF_LOG_TRACE(CAF_ARG(group_uri));
   // format of group_identifier is group@host:port
@@ -459,6 +636,22 @@ void middleman::start() {
 
 void middleman::stop() {
   CAF_LOG_TRACE("");
+  { // Lifetime scope of self.
+    // Brokers on the scheduler shut down in their own context.
+    scoped_actor self{system(), true};
+    for (auto& kvp : named_brokers_) {
+      auto ptr = static_cast<broker*>(actor_cast<abstract_actor*>(kvp.second));
+      if (!ptr->scheduled())
+        continue;
+      ptr->post_io_event(abstract_broker::io_event{[ptr](execution_unit*) {
+        if (!ptr->getf(abstract_actor::is_terminated_flag)) {
+          ptr->quit();
+          ptr->finalize();
+        }
+      }});
+      self->wait_for(kvp.second);
+    }
+  }
   backend().dispatch([=] {
     CAF_LOG_TRACE("");
     // managers_ will be modified while we are stopping each manager,
@@ -466,7 +659,7 @@ void middleman::stop() {
     for (auto& kvp : named_brokers_) {
       auto& hdl = kvp.second;
       auto ptr = static_cast<broker*>(actor_cast<abstract_actor*>(hdl));
-      if (!ptr->getf(abstract_actor::is_terminated_flag)) {
+      if (!ptr->scheduled() && !ptr->getf(abstract_actor::is_terminated_flag)) {
         ptr->context(&backend());
         ptr->quit();
         ptr->finalize();
@@ -4,6 +4,8 @@
 
 #include "caf/io/middleman_actor_impl.hpp"
 
+#include <algorithm>
+#include <functional>
 #include <stdexcept>
 #include <tuple>
 #include <utility>
@@ -11,19 +13,42 @@
 #include "caf/actor.hpp"
 #include "caf/actor_proxy.hpp"
 #include "caf/actor_system_config.hpp"
+#include "caf/defaults.hpp"
+#include "caf/event_based_actor.hpp"
 #include "caf/io/basp/header.hpp"
+#include "caf/io/basp/instance.hpp"
 #include "caf/io/basp_broker.hpp"
 #include "caf/io/network/default_multiplexer.hpp"
 #include "caf/io/network/interfaces.hpp"
 #include "caf/io/system_messages.hpp"
+#include "caf/ipv6_address.hpp"
 #include "caf/logger.hpp"
 #include "caf/node_id.hpp"
 #include "caf/sec.hpp"
 #include "caf/send.hpp"
 #include "caf/typed_event_based_actor.hpp"
+#include "caf/uri.hpp"
 
 namespace caf::io {
 
+namespace {
+
+/// Extracts the file system path from URIs of the form `unix:///path`.
+expected<std::string> local_path(const uri& locator) {
+  if (locator.scheme() != "unix" || !locator.authority().empty()
+      || locator.path().empty())
+    return make_error(sec::invalid_argument,
+                      "expected a URI of the form unix:///path",
+                      to_string(locator));
+  std::string result;
+  if (locator.path().front() != '/')
+    result += '/';
+  result.insert(result.end(), locator.path().begin(), locator.path().end());
+  return result;
+}
+
+} // namespace
+
 middleman_actor_impl::middleman_actor_impl(actor_config& cfg,
                                            actor default_broker)
   : middleman_actor::base(cfg), broker_(std::move(default_broker)) {
@@ -71,58 +96,31 @@ auto middleman_actor_impl::make_behavior() -> behavior_type {
       mpi_set sigs;
       return put(port, whom, sigs, addr.c_str(), reuse);
     },
+    [=](publish_atom, const uri& locator, strong_actor_ptr& whom,
+        mpi_set& sigs) -> del_res {
+      CAF_LOG_TRACE(CAF_ARG(locator) << CAF_ARG(whom) << CAF_ARG(sigs));
+      auto path = local_path(locator);
+      if (!path)
+        return std::move(path.error());
+      auto res = open_local(*path);
+      if (!res)
+        return std::move(res.error());
+      anon_send(broker_, publish_atom_v, std::move(*res), std::move(whom),
+                std::move(sigs));
+      return unit;
+    },
     [=](connect_atom, std::string& hostname, uint16_t port) -> get_res {
       CAF_LOG_TRACE(CAF_ARG(hostname) << CAF_ARG(port));
-      auto rp = make_response_promise();
-      endpoint key{std::move(hostname), port};
-      // respond immediately if endpoint is cached
-      auto x = cached_tcp(key);
-      if (x) {
-        CAF_LOG_DEBUG("found cached entry" << CAF_ARG(*x));
-        rp.deliver(get<0>(*x), get<1>(*x), get<2>(*x));
-        return get_delegated{};
-      }
-      // attach this promise to a pending request if possible
-      auto rps = pending(key);
-      if (rps) {
-        CAF_LOG_DEBUG("attach to pending request");
-        rps->emplace_back(std::move(rp));
-        return get_delegated{};
-      }
-      // connect to endpoint and initiate handhsake etc.
-      auto r = connect(key.first, port);
-      if (!r) {
-        rp.deliver(std::move(r.error()));
-        return get_delegated{};
-      }
-      auto& ptr = *r;
-      std::vector<response_promise> tmp{std::move(rp)};
-      pending_.emplace(key, std::move(tmp));
-      request(broker_, infinite, connect_atom_v, std::move(ptr), port)
-        .then(
-          [=](node_id& nid, strong_actor_ptr& addr, mpi_set& sigs) {
-            auto i = pending_.find(key);
-            if (i == pending_.end())
-              return;
-            if (nid && addr) {
-              monitor(addr);
-              cached_tcp_.emplace(key, std::make_tuple(nid, addr, sigs));
-            }
-            auto res
-              = make_message(std::move(nid), std::move(addr), std::move(sigs));
-            for (auto& promise : i->second)
-              promise.deliver(res);
-            pending_.erase(i);
-          },
-          [=](error& err) {
-            auto i = pending_.find(key);
-            if (i == pending_.end())
-              return;
-            for (auto& promise : i->second)
-              promise.deliver(err);
-            pending_.erase(i);
-          });
-      return get_delegated{};
+      return get_or_connect(endpoint{std::move(hostname), port});
+    },
+    [=](connect_atom, const uri& locator) -> get_res {
+      CAF_LOG_TRACE(CAF_ARG(locator));
+      auto path = local_path(locator);
+      if (!path)
+        return std::move(path.error());
+      // Host names never start with a slash and TCP connections never use
+      // port 0, i.e., local endpoints cannot clash with TCP endpoints.
+      return get_or_connect(endpoint{std::move(*path), 0});
     },
     [=](unpublish_atom atm, actor_addr addr, uint16_t p) -> del_res {
       CAF_LOG_TRACE("");
@@ -192,6 +190,18 @@ middleman_actor_impl::put(uint16_t port, strong_actor_ptr& whom, mpi_set& sigs,
     return std::move(res.error());
   auto& ptr = *res;
   actual_port = ptr->port();
+  if (get_or(system().config(), "caf.middleman.shared-memory",
+             defaults::middleman::shared_memory)) {
+    // Nodes on this host may connect via shared memory as well. The TCP
+    // doorman remains the primary way to reach the actor, i.e., we only log
+    // errors here.
+    if (auto shm = open_shm(actual_port))
+      anon_send(broker_, publish_atom_v, std::move(*shm), actual_port, whom,
+                sigs);
+    else
+      CAF_LOG_WARNING("unable to accept shared memory connections:"
+                      << CAF_ARG(actual_port) << CAF_ARG(shm.error()));
+  }
   anon_send(broker_, publish_atom_v, std::move(ptr), actual_port,
             std::move(whom), std::move(sigs));
   return actual_port;
@@ -216,6 +226,63 @@ middleman_actor_impl::put_udp(uint16_t port, strong_actor_ptr& whom,
   return actual_port;
 }
 
+middleman_actor_impl::get_res
+middleman_actor_impl::get_or_connect(endpoint key) {
+  auto rp = make_response_promise();
+  // respond immediately if endpoint is cached
+  auto x = cached_tcp(key);
+  if (x) {
+    CAF_LOG_DEBUG("found cached entry" << CAF_ARG(*x));
+    rp.deliver(get<0>(*x), get<1>(*x), get<2>(*x));
+    return get_delegated{};
+  }
+  // attach this promise to a pending request if possible
+  auto rps = pending(key);
+  if (rps) {
+    CAF_LOG_DEBUG("attach to pending request");
+    rps->emplace_back(std::move(rp));
+    return get_delegated{};
+  }
+  // connect to endpoint and initiate handhsake etc.
+  std::vector<response_promise> tmp{std::move(rp)};
+  pending_.emplace(key, std::move(tmp));
+  auto fail = [=](error& err) {
+    auto i = pending_.find(key);
+    if (i == pending_.end())
+      return;
+    for (auto& promise : i->second)
+      promise.deliver(err);
+    pending_.erase(i);
+  };
+  connect_endpoint(key, [=](expected<scribe_ptr> r) {
+    if (!r) {
+      fail(r.error());
+      return;
+    }
+    request(broker_, infinite, connect_atom_v, std::move(*r), key.first,
+            key.second)
+      .then(
+        [=](node_id& nid, strong_actor_ptr& addr, mpi_set& sigs) {
+          auto i = pending_.find(key);
+          if (i == pending_.end())
+            return;
+          if (nid && addr) {
+            monitor(addr);
+            if (!has_cached_node(nid))
+              connect_stripes(key, nid);
+            cached_tcp_.emplace(key, std::make_tuple(nid, addr, sigs));
+          }
+          auto res
+            = make_message(std::move(nid), std::move(addr), std::move(sigs));
+          for (auto& promise : i->second)
+            promise.deliver(res);
+          pending_.erase(i);
+        },
+        fail);
+  });
+  return get_delegated{};
+}
+
 optional<middleman_actor_impl::endpoint_data&>
 middleman_actor_impl::cached_tcp(const endpoint& ep) {
   auto i = cached_tcp_.find(ep);
@@ -240,9 +307,146 @@ middleman_actor_impl::pending(const endpoint& ep) {
   return none;
 }
 
-expected<scribe_ptr>
-middleman_actor_impl::connect(const std::string& host, uint16_t port) {
-  return system().middleman().backend().new_tcp_scribe(host, port);
+namespace {
+
+// Only checks IP addresses and "localhost" to avoid blocking on name lookups.
+bool is_local_host(const std::string& host) {
+  using network::interfaces;
+  if (host == "localhost")
+    return true;
+  ipv6_address addr;
+  if (auto err = parse(host, addr))
+    return false;
+  auto local = interfaces::list_addresses({network::protocol::ipv4,
+                                           network::protocol::ipv6},
+                                          true);
+  return std::any_of(local.begin(), local.end(), [&](const std::string& x) {
+    ipv6_address y;
+    return !parse(x, y) && y == addr;
+  });
+}
+
+// Waits for the multiplexer to connect to a TCP endpoint and responds to the
+// first message with the result.
+behavior tcp_connector(event_based_actor* self, std::string host,
+                       uint16_t port,
+                       network::multiplexer::scribe_factory make) {
+  return {
+    [=](connect_atom) {
+      auto rp = self->make_response_promise<scribe_ptr>();
+      self->become(
+        [=](connect_atom, scribe_ptr& ptr) mutable {
+          rp.deliver(std::move(ptr));
+          self->quit();
+        },
+        [=](connect_atom, error& err) mutable {
+          rp.deliver(std::move(err));
+          self->quit();
+        });
+      auto hdl = actor_cast<actor>(self);
+      auto& mpx = self->system().middleman().backend();
+      mpx.new_tcp_scribe_async(host, port, make,
+                               [hdl](expected<scribe_ptr> res) {
+                                 if (res)
+                                   anon_send(hdl, connect_atom_v,
+                                             std::move(*res));
+                                 else
+                                   anon_send(hdl, connect_atom_v,
+                                             std::move(res.error()));
+                               });
+      return rp;
+    },
+  };
+}
+
+/// Runs a connect that may block on a thread of its own, e.g., the rendezvous
+/// for a shared memory segment.
+behavior blocking_connector(event_based_actor* self,
+                            std::function<expected<scribe_ptr>()> connect) {
+  return {
+    [=](connect_atom) -> result<scribe_ptr> {
+      self->quit();
+      auto res = connect();
+      if (!res)
+        return std::move(res.error());
+      return std::move(*res);
+    },
+  };
+}
+
+} // namespace
+
+network::multiplexer::scribe_factory
+middleman_actor_impl::tcp_scribe_factory() {
+  return nullptr;
+}
+
+void middleman_actor_impl::connect_endpoint(const endpoint& key,
+                                            connect_callback f) {
+  auto run = [this](actor worker, connect_callback g) {
+    request(worker, infinite, connect_atom_v)
+      .then([g](scribe_ptr& ptr) { g(std::move(ptr)); },
+            [g](error& err) { g(std::move(err)); });
+  };
+  // Keeps this actor alive while a blocking connector calls into it.
+  auto self = actor_cast<actor>(this);
+  auto& host = key.first;
+  auto port = key.second;
+  if (port == 0) {
+    run(spawn<detached + hidden>(blocking_connector,
+                                 [this, self, host] {
+                                   return connect_local(host);
+                                 }),
+        std::move(f));
+    return;
+  }
+  auto connect_tcp = [this, run, host, port](connect_callback g) {
+    run(spawn<hidden>(tcp_connector, host, port, tcp_scribe_factory()),
+        std::move(g));
+  };
+  if (get_or(system().config(), "caf.middleman.shared-memory",
+             defaults::middleman::shared_memory)
+      && is_local_host(host)) {
+    auto& backend = system().middleman().backend();
+    run(spawn<detached + hidden>(blocking_connector,
+                                 [&backend, port] {
+                                   return backend.new_shm_scribe(port);
+                                 }),
+        [=](expected<scribe_ptr> res) {
+          if (res) {
+            f(std::move(res));
+          } else {
+            CAF_LOG_DEBUG("fall back to TCP:" << CAF_ARG(host) << CAF_ARG(port)
+                                              << CAF_ARG(res.error()));
+            connect_tcp(f);
+          }
+        });
+    return;
+  }
+  connect_tcp(std::move(f));
+}
+
+bool middleman_actor_impl::has_cached_node(const node_id& nid) const {
+  for (auto& kvp : cached_tcp_)
+    if (get<0>(kvp.second) == nid)
+      return true;
+  return false;
+}
+
+void middleman_actor_impl::connect_stripes(const endpoint& key,
+                                           const node_id& nid) {
+  auto n = get_or(system().config(), "caf.middleman.connections-per-peer",
+                  defaults::middleman::connections_per_peer);
+  n = std::min(n, basp::instance::max_connections_per_peer);
+  for (size_t i = 1; i < n; ++i)
+    connect_endpoint(key, [=](expected<scribe_ptr> r) {
+      if (!r) {
+        CAF_LOG_WARNING("unable to open additional connection:"
+                        << CAF_ARG(nid) << CAF_ARG(r.error()));
+        return;
+      }
+      anon_send(broker_, connect_atom_v, std::move(*r), nid);
+    });
 }
 
 expected<datagram_servant_ptr>
@@ -255,6 +459,20 @@ middleman_actor_impl::open(uint16_t port, const char* addr, bool reuse) {
   return system().middleman().backend().new_tcp_doorman(port, addr, reuse);
 }
 
+expected<doorman_ptr> middleman_actor_impl::open_shm(uint16_t port) {
+  return system().middleman().backend().new_shm_doorman(port);
+}
+
+expected<scribe_ptr>
+middleman_actor_impl::connect_local(const std::string& path) {
+  return system().middleman().backend().new_local_scribe(path);
+}
+
+expected<doorman_ptr>
+middleman_actor_impl::open_local(const std::string& path) {
+  return system().middleman().backend().new_local_doorman(path);
+}
+
 expected<datagram_servant_ptr>
 middleman_actor_impl::open_udp(uint16_t port, const char* addr, bool reuse) {
   return system().middleman().backend().new_local_udp_endpoint(port, addr,
@@ -0,0 +1,281 @@
+// This file is part of CAF, the C++ Actor Framework. See the file LICENSE in
+// the main distribution directory for license terms and copyright or visit
+// https://github.com/actor-framework/actor-framework/blob/master/LICENSE.
+
+#include "caf/io/network/connector.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
+
+#include "caf/detail/socket_guard.hpp"
+#include "caf/intrusive_ptr.hpp"
+#include "caf/logger.hpp"
+#include "caf/sec.hpp"
+
+#include "caf/io/network/default_multiplexer.hpp"
+#include "caf/io/network/event_handler.hpp"
+
+#ifdef CAF_WINDOWS
+#  include <winsock2.h>
+#  include <ws2tcpip.h>
+#else
+#  include <arpa/inet.h>
+#  include <cerrno>
+#  include <netinet/in.h>
+#  include <sys/socket.h>
+#  include <sys/types.h>
+#endif
+
+namespace caf::io::network {
+
+namespace {
+
+bool connect_in_progress(int errcode) {
+#ifdef CAF_WINDOWS
+  return errcode == WSAEWOULDBLOCK;
+#else
+  return errcode == EINPROGRESS;
+#endif
+}
+
+/// Starts a non-blocking connect and returns whether the socket either
+/// connected immediately or is in progress.
+template <int Family>
+bool start_connect(native_socket fd, const std::string& addr, uint16_t port) {
+  using sockaddr_type =
+    std::conditional_t<Family == AF_INET, sockaddr_in, sockaddr_in6>;
+  sockaddr_type sa;
+  memset(&sa, 0, sizeof(sockaddr_type));
+  if constexpr (Family == AF_INET) {
+    sa.sin_family = AF_INET;
+    sa.sin_port = htons(port);
+    if (inet_pton(AF_INET, addr.c_str(), &sa.sin_addr) != 1)
+      return false;
+  } else {
+    sa.sin6_family = AF_INET6;
+    sa.sin6_port = htons(port);
+    if (inet_pton(AF_INET6, addr.c_str(), &sa.sin6_addr) != 1)
+      return false;
+  }
+  if (::connect(fd, reinterpret_cast<const sockaddr*>(&sa), sizeof(sa)) == 0)
+    return true;
+  return connect_in_progress(last_socket_error());
+}
+
+} // namespace
+
+// -- connector::attempt -------------------------------------------------------
+
+/// Waits for a single socket to connect. Reports to the connector from a
+/// separate event, because the multiplexer calls `removed_from_loop` while
+/// it iterates its pending events.
+class connector::attempt : public event_handler {
+public:
+  attempt(connector* owner, native_socket fd)
+    : event_handler(owner->mpx_, fd), owner_(owner), registered_(false) {
+    state_.reading = false;
+  }
+
+  /// Connects to `addr` and returns `false` if the connect failed right away.
+  bool launch(const std::string& addr, protocol::network proto) {
+    CAF_LOG_TRACE(CAF_ARG(addr) << CAF_ARG(proto));
+    auto ok = proto == protocol::ipv4
+                ? start_connect<AF_INET>(fd(), addr, owner_->port_)
+                : start_connect<AF_INET6>(fd(), addr, owner_->port_);
+    if (!ok)
+      return false;
+    // Even if the connect succeeded immediately, we wait for the socket to
+    // become writable to keep a single code path.
+    backend().add(operation::write, fd(), this);
+    registered_ = true;
+    return true;
+  }
+
+  /// Closes the socket if it did not connect yet.
+  void cancel() {
+    if (registered_)
+      backend().del(operation::write, fd(), this);
+  }
+
+  void handle_event(operation) override {
+    CAF_LOG_TRACE(CAF_ARG(fd()));
+    int err = 0;
+    socket_size_type len = sizeof(err);
+    if (getsockopt(fd(), SOL_SOCKET, SO_ERROR,
+                   reinterpret_cast<getsockopt_ptr>(&err), &len)
+        != 0)
+      err = last_socket_error();
+    if (err != 0) {
+      CAF_LOG_DEBUG("connection attempt failed:" << CAF_ARG(fd())
+                                                 << socket_error_as_string(err));
+      result_ = make_error(sec::cannot_connect_to_node,
+                           socket_error_as_string(err));
+    } else {
+      connected_ = true;
+    }
+    backend().del(operation::write, fd(), this);
+  }
+
+  void removed_from_loop(operation op) override {
+    if (op != operation::write || !registered_)
+      return;
+    registered_ = false;
+    backend().post([this] { report(); });
+  }
+
+  void graceful_shutdown() override {
+    cancel();
+  }
+
+  /// Reports the outcome to the owner and destroys this object.
+  void report() {
+    expected<native_socket> res = std::move(result_);
+    if (connected_) {
+      res = fd_;
+      fd_ = invalid_native_socket;
+    }
+    auto owner = std::move(owner_);
+    owner->done(this, std::move(res));
+    delete this;
+  }
+
+private:
+  intrusive_ptr<connector> owner_;
+  bool registered_;
+  bool connected_ = false;
+  error result_ = make_error(sec::cannot_connect_to_node, "connect aborted");
+};
+
+// -- constructors, destructors, and assignment operators ----------------------
+
+connector::connector(default_multiplexer& mpx, std::string host, uint16_t port,
+                     const resolver::address_list& addrs,
+                     timespan attempt_delay, callback f)
+  : mpx_(mpx),
+    host_(std::move(host)),
+    port_(port),
+    addrs_(interleave(addrs)),
+    next_addr_(0),
+    running_(0),
+    attempt_delay_(attempt_delay),
+    f_(std::move(f)),
+    finished_(false),
+    timer_id_(0),
+    last_error_(make_error(sec::cannot_connect_to_node, "no such host",
+                           host_, port_)) {
+  // nop
+}
+
+connector::~connector() {
+  // nop
+}
+
+// -- interface functions ------------------------------------------------------
+
+void connector::start() {
+  CAF_LOG_TRACE(CAF_ARG(host_) << CAF_ARG(port_) << CAF_ARG(addrs_));
+  next();
+}
+
+resolver::address_list
+connector::interleave(const resolver::address_list& addrs) {
+  resolver::address_list v6;
+  resolver::address_list v4;
+  for (auto& x : addrs)
+    (x.second == protocol::ipv6 ? v6 : v4).emplace_back(x);
+  // Try the preferred family first, i.e., the family of the first address.
+  auto first = &v6;
+  auto second = &v4;
+  if (!addrs.empty() && addrs.front().second == protocol::ipv4)
+    std::swap(first, second);
+  resolver::address_list result;
+  result.reserve(addrs.size());
+  for (size_t i = 0; i < std::max(v6.size(), v4.size()); ++i) {
+    if (i < first->size())
+      result.emplace_back((*first)[i]);
+    if (i < second->size())
+      result.emplace_back((*second)[i]);
+  }
+  return result;
+}
+
+// -- private member functions -------------------------------------------------
+
+void connector::next() {
+  // Skip addresses that fail right away.
+  while (!finished_ && next_addr_ < addrs_.size()) {
+    auto& [addr, proto] = addrs_[next_addr_++];
+    CAF_LOG_DEBUG("try to connect to:" << CAF_ARG(addr) << CAF_ARG(port_));
+    int socktype = SOCK_STREAM;
+#ifdef SOCK_CLOEXEC
+    socktype |= SOCK_CLOEXEC;
+#endif
+    auto fd = ::socket(proto == protocol::ipv4 ? AF_INET : AF_INET6, socktype,
+                       0);
+    if (fd == invalid_native_socket) {
+      last_error_ = make_error(sec::cannot_connect_to_node, "socket failed",
+                               last_socket_error_as_string());
+      continue;
+    }
+    child_process_inherit(fd, false);
+    auto ptr = new attempt(this, fd);
+    if (!ptr->launch(addr, proto)) {
+      last_error_ = make_error(sec::cannot_connect_to_node, "connect failed",
+                               last_socket_error_as_string());
+      delete ptr;
+      continue;
+    }
+    attempts_.emplace_back(ptr);
+    ++running_;
+    // Race the next address if this attempt takes too long.
+    if (next_addr_ < addrs_.size()) {
+      auto id = ++timer_id_;
+      mpx_.schedule(attempt_delay_, [ptr{intrusive_ptr<connector>{this}}, id] {
+        if (!ptr->finished_ && ptr->timer_id_ == id)
+          ptr->next();
+      });
+    }
+    return;
+  }
+  if (running_ == 0)
+    finish(last_error_);
+}
+
+void connector::done(attempt* ptr, expected<native_socket> res) {
+  CAF_LOG_TRACE(CAF_ARG(res));
+  attempts_.erase(std::remove(attempts_.begin(), attempts_.end(), ptr),
+                  attempts_.end());
+  --running_;
+  if (res) {
+    if (finished_) {
+      close_socket(*res);
+      return;
+    }
+    CAF_LOG_INFO("successfully connected to:" << CAF_ARG(host_)
+                                              << CAF_ARG(port_));
+    finish(std::move(res));
+    return;
+  }
+  if (finished_)
+    return;
+  last_error_ = std::move(res.error());
+  // Start the next attempt right away instead of waiting for the delay.
+  ++timer_id_;
+  next();
+}
+
+void connector::finish(expected<native_socket> res) {
+  if (finished_)
+    return;
+  finished_ = true;
+  for (auto ptr : attempts_)
+    ptr->cancel();
+  if (!res)
+    CAF_LOG_WARNING("could not connect to:" << CAF_ARG(host_)
+                                            << CAF_ARG(port_));
+  auto f = std::move(f_);
+  f(std::move(res));
+}
+
+} // namespace caf::io::network
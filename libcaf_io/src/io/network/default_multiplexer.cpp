@@ -4,6 +4,7 @@
 
 #include "caf/io/network/default_multiplexer.hpp"
 
+#include <array>
 #include <utility>
 
 #include "caf/actor_system_config.hpp"
@@ -14,16 +15,23 @@
 
 #include "caf/io/broker.hpp"
 #include "caf/io/middleman.hpp"
+#include "caf/io/network/connector.hpp"
 #include "caf/io/network/datagram_servant_impl.hpp"
 #include "caf/io/network/doorman_impl.hpp"
 #include "caf/io/network/interfaces.hpp"
+#include "caf/io/network/local_doorman.hpp"
 #include "caf/io/network/protocol.hpp"
 #include "caf/io/network/scribe_impl.hpp"
+#include "caf/io/network/shared_memory.hpp"
+#include "caf/io/network/shm_doorman.hpp"
+#include "caf/io/network/shm_scribe.hpp"
 
 #include "caf/detail/call_cfun.hpp"
 #include "caf/detail/socket_guard.hpp"
 
 #include "caf/scheduler/abstract_coordinator.hpp"
+#include "caf/telemetry/histogram.hpp"
+#include "caf/telemetry/metric_registry.hpp"
 
 // clang-format off
 #ifdef CAF_WINDOWS
@@ -55,11 +63,17 @@
 #  include <netinet/ip.h>
 #  include <netinet/tcp.h>
 #  include <sys/socket.h>
+#  include <sys/stat.h>
+#  include <sys/un.h>
 #  include <unistd.h>
+#  ifdef CAF_LINUX
+#    include <sys/eventfd.h>
+#  endif
 #  ifdef CAF_POLL_MULTIPLEXER
 #    include <poll.h>
 #  elif defined(CAF_EPOLL_MULTIPLEXER)
 #    include <sys/epoll.h>
+#    include <sys/timerfd.h>
 #  else
 #    error "neither CAF_POLL_MULTIPLEXER nor CAF_EPOLL_MULTIPLEXER defined"
 #  endif
@@ -75,6 +89,10 @@ namespace {
 constexpr auto ipv4 = caf::io::network::protocol::ipv4;
 constexpr auto ipv6 = caf::io::network::protocol::ipv6;
 
+// Maximum time a client waits for the memory segment after connecting to the
+// rendezvous socket of a node on the same host.
+constexpr auto shm_rendezvous_timeout = caf::timespan{1'000'000'000}; // 1s
+
 auto addr_of(sockaddr_in& what) -> decltype(what.sin_addr)& {
   return what.sin_addr;
 }
@@ -126,10 +144,62 @@ const event_mask_type error_mask = EPOLLRDHUP | EPOLLERR | EPOLLHUP;
 const event_mask_type output_mask = EPOLLOUT;
 #endif
 
+namespace {
+
+// Returns an eventfd for both ends on Linux and a regular pipe otherwise.
+std::pair<native_socket, native_socket> create_wakeup_pipe() {
+#ifdef CAF_LINUX
+  auto fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  if (fd == -1) {
+    perror("eventfd");
+    exit(EXIT_FAILURE);
+  }
+  return {fd, fd};
+#else
+  return create_pipe();
+#endif
+}
+
+} // namespace
+
 // -- Platform-dependent abstraction over epoll() or poll() --------------------
 
 #ifdef CAF_EPOLL_MULTIPLEXER
 
+namespace {
+
+// Consumes expirations of the timerfd. The multiplexer runs due functions
+// after handling all events of an iteration.
+class timer_reader : public event_handler {
+public:
+  using time_point = std::chrono::steady_clock::time_point;
+
+  timer_reader(default_multiplexer& mpx, native_socket fd, time_point& due)
+    : event_handler(mpx, invalid_native_socket), due_(due) {
+    // Skip set_fd_flags() in the base type, since fd is not a socket.
+    fd_ = fd;
+  }
+
+  void handle_event(operation) override {
+    uint64_t expirations = 0;
+    if (::read(fd(), &expirations, sizeof(expirations)) > 0)
+      due_ = time_point::max();
+  }
+
+  void removed_from_loop(operation) override {
+    // nop
+  }
+
+  void graceful_shutdown() override {
+    // nop
+  }
+
+private:
+  time_point& due_;
+};
+
+} // namespace
+
 // In this implementation, shadow_ is the number of sockets we have
 // registered to epoll.
 
@@ -148,7 +218,7 @@ default_multiplexer::default_multiplexer(actor_system* sys)
   }
   // handle at most 64 events at a time
   pollset_.resize(64);
-  pipe_ = create_pipe();
+  pipe_ = create_wakeup_pipe();
   pipe_reader_.init(pipe_.first);
   epoll_event ee;
   ee.events = input_mask;
@@ -157,6 +227,21 @@ default_multiplexer::default_multiplexer(actor_system* sys)
     CAF_LOG_ERROR("epoll_ctl: " << strerror(errno));
     exit(errno);
   }
+  // The timer does not count towards shadow_, because it must not keep the
+  // event loop alive.
+  timer_due_ = std::chrono::steady_clock::time_point::max();
+  auto tfd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+  if (tfd == -1) {
+    CAF_LOG_WARNING("timerfd_create: " << strerror(errno));
+    return;
+  }
+  timer_.reset(new timer_reader(*this, tfd, timer_due_));
+  ee.events = input_mask;
+  ee.data.ptr = timer_.get();
+  if (epoll_ctl(epollfd_, EPOLL_CTL_ADD, tfd, &ee) < 0) {
+    CAF_LOG_WARNING("epoll_ctl: " << strerror(errno));
+    timer_.reset();
+  }
 }
 
 bool default_multiplexer::poll_once_impl(bool block) {
@@ -164,8 +249,11 @@ bool default_multiplexer::poll_once_impl(bool block) {
   CAF_ASSERT(block == false || internally_posted_.empty());
   // Keep running in case of `EINTR`.
   for (;;) {
+    auto timeout = poll_timeout(block);
+    if (timeout > 0 && arm_timer())
+      timeout = -1;
     int presult = epoll_wait(epollfd_, pollset_.data(),
-                             static_cast<int>(pollset_.size()), block ? -1 : 0);
+                             static_cast<int>(pollset_.size()), timeout);
     CAF_LOG_DEBUG("epoll_wait() on" << shadow_ << "sockets reported" << presult
                                     << "event(s)");
     if (presult < 0) {
@@ -182,7 +270,7 @@ bool default_multiplexer::poll_once_impl(bool block) {
       }
     }
     if (presult == 0)
-      return false;
+      return handle_timeouts();
     auto iter = pollset_.begin();
     auto last = iter + presult;
     for (; iter != last; ++iter) {
@@ -191,8 +279,31 @@ bool default_multiplexer::poll_once_impl(bool block) {
       handle_socket_event(fd, static_cast<int>(iter->events), ptr);
     }
     handle_internal_events();
+    handle_timeouts();
+    return true;
+  }
+}
+
+bool default_multiplexer::arm_timer() {
+  if (!timer_)
+    return false;
+  auto due = timeouts_.begin()->first;
+  if (due == timer_due_)
     return true;
+  // On Linux, steady_clock uses CLOCK_MONOTONIC.
+  auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+              due.time_since_epoch())
+              .count();
+  itimerspec spec;
+  memset(&spec, 0, sizeof(spec));
+  spec.it_value.tv_sec = static_cast<time_t>(ns / 1'000'000'000);
+  spec.it_value.tv_nsec = static_cast<long>(ns % 1'000'000'000);
+  if (timerfd_settime(timer_->fd(), TFD_TIMER_ABSTIME, &spec, nullptr) != 0) {
+    CAF_LOG_WARNING("timerfd_settime: " << strerror(errno));
+    return false;
   }
+  timer_due_ = due;
+  return true;
 }
 
 void default_multiplexer::run() {
@@ -288,7 +399,7 @@ default_multiplexer::default_multiplexer(actor_system* sys)
   : multiplexer(sys), epollfd_(-1), pipe_reader_(*this), servant_ids_(0) {
   init();
   // initial setup
-  pipe_ = create_pipe();
+  pipe_ = create_wakeup_pipe();
   pipe_reader_.init(pipe_.first);
   pollfd pipefd;
   pipefd.fd = pipe_reader_.fd();
@@ -314,10 +425,10 @@ bool default_multiplexer::poll_once_impl(bool block) {
     int presult;
 #  ifdef CAF_WINDOWS
     presult = ::WSAPoll(pollset_.data(), static_cast<ULONG>(pollset_.size()),
-                        block ? -1 : 0);
+                        poll_timeout(block));
 #  else
     presult = ::poll(pollset_.data(), static_cast<nfds_t>(pollset_.size()),
-                     block ? -1 : 0);
+                     poll_timeout(block));
 #  endif
     if (presult < 0) {
       switch (last_socket_error()) {
@@ -343,7 +454,7 @@ bool default_multiplexer::poll_once_impl(bool block) {
     CAF_LOG_DEBUG("poll() on" << pollset_.size() << "sockets reported"
                               << presult << "event(s)");
     if (presult == 0)
-      return false;
+      return handle_timeouts();
     // scan pollset for events first, because we might alter pollset_
     // while running callbacks (not a good idea while traversing it)
     CAF_LOG_DEBUG("scan pollset for socket events");
@@ -366,6 +477,7 @@ bool default_multiplexer::poll_once_impl(bool block) {
     }
     poll_res.clear();
     handle_internal_events();
+    handle_timeouts();
     return true;
   }
 }
@@ -501,24 +613,63 @@ void default_multiplexer::del(operation op, native_socket fd,
 }
 
 void default_multiplexer::wr_dispatch_request(resumable* ptr) {
-  intptr_t ptrval = reinterpret_cast<intptr_t>(ptr);
+  // Only the first request after draining the queue needs to wake up the
+  // multiplexer. The queue releases the resumable if it has been closed.
+  if (dispatch_queue_.emplace_front(ptr)
+      == intrusive::inbox_result::unblocked_reader)
+    wakeup();
+}
+
+void default_multiplexer::wakeup() {
+  uint64_t signal = 1;
   // on windows, we actually have sockets, otherwise we have file handles
 #ifdef CAF_WINDOWS
-  auto res = ::send(pipe_.second, reinterpret_cast<socket_send_ptr>(&ptrval),
-                    sizeof(ptrval), no_sigpipe_io_flag);
+  auto res = ::send(pipe_.second, reinterpret_cast<socket_send_ptr>(&signal),
+                    sizeof(signal), no_sigpipe_io_flag);
 #else
-  auto res = ::write(pipe_.second, &ptrval, sizeof(ptrval));
+  auto res = ::write(pipe_.second, &signal, sizeof(signal));
 #endif
-  if (res <= 0) {
-    // pipe closed, discard resumable
-    intrusive_ptr_release(ptr);
-  } else if (static_cast<size_t>(res) < sizeof(ptrval)) {
-    // must not happen: wrote invalid pointer to pipe
+  if (res > 0 && static_cast<size_t>(res) < sizeof(signal)) {
+    // must not happen: wrote a partial signal to the pipe
     std::cerr << "[CAF] Fatal error: wrote invalid data to pipe" << std::endl;
     abort();
   }
 }
 
+void default_multiplexer::handle_dispatch_requests() {
+  CAF_LOG_TRACE("");
+  int64_t dispatches = 0;
+  // Turn the LIFO list into a FIFO list to run requests in order.
+  dispatch_request* head = nullptr;
+  auto ptr = dispatch_queue_.take_head();
+  while (ptr != nullptr) {
+    auto next = dispatch_queue_.promote(ptr->next);
+    ptr->next = head;
+    head = ptr;
+    ptr = next;
+  }
+  while (head != nullptr) {
+    auto next = dispatch_queue_.promote(head->next);
+    intrusive_ptr<resumable> job{head->ptr, false};
+    delete head;
+    resume(std::move(job));
+    head = next;
+    ++dispatches;
+  }
+  dispatches_per_wakeup_->observe(dispatches);
+  // Blocking fails if another thread has enqueued new requests meanwhile. We
+  // run these after the next poll instead of draining in a loop. Otherwise,
+  // sustained traffic from other threads would starve sockets and timers.
+  if (!dispatch_queue_.try_block())
+    wakeup();
+}
+
+void default_multiplexer::dispatch_request_deleter::operator()(
+  dispatch_request* ptr) const noexcept {
+  scheduler::abstract_coordinator::cleanup_and_release(ptr->ptr);
+  delete ptr;
+}
+
 multiplexer::supervisor_ptr default_multiplexer::make_supervisor() {
   class impl : public multiplexer::supervisor {
   public:
@@ -575,8 +726,23 @@ void default_multiplexer::init() {
   }
 #endif
   namespace sr = defaults::scheduler;
-  max_throughput_ = get_or(system().config(), "caf.scheduler.max-throughput",
+  namespace mm = defaults::middleman;
+  auto& cfg = system().config();
+  max_throughput_ = get_or(cfg, "caf.scheduler.max-throughput",
                            sr::max_throughput);
+  busy_poll_duration_ = get_or(cfg, "caf.middleman.busy-poll-duration",
+                               mm::busy_poll_duration);
+  auto socket_busy_poll = get_or(cfg, "caf.middleman.socket-busy-poll",
+                                 mm::socket_busy_poll);
+  socket_busy_poll_ = static_cast<int>(
+    std::chrono::duration_cast<std::chrono::microseconds>(socket_busy_poll)
+      .count());
+  std::array<int64_t, 8> dispatch_buckets{{1, 2, 4, 8, 16, 32, 64, 128}};
+  dispatches_per_wakeup_ = system().metrics().histogram_singleton(
+    "caf.middleman", "dispatches-per-wakeup", dispatch_buckets,
+    "Number of events from other threads per wakeup of the multiplexer.");
+  // The multiplexer waits for the pipe until another thread wakes it up.
+  dispatch_queue_.try_block();
 }
 
 bool default_multiplexer::poll_once(bool block) {
@@ -597,6 +763,15 @@ bool default_multiplexer::poll_once(bool block) {
     poll_once_impl(false);
     return true;
   }
+  if (block && busy_poll_duration_.count() > 0) {
+    // Spin on the poll set to avoid the cost of waking up a sleeping thread.
+    // The multiplexer only goes to sleep after idling for the full duration.
+    auto deadline = std::chrono::steady_clock::now() + busy_poll_duration_;
+    do {
+      if (poll_once_impl(false))
+        return true;
+    } while (std::chrono::steady_clock::now() < deadline);
+  }
   return poll_once_impl(block);
 }
 
@@ -616,17 +791,16 @@ void default_multiplexer::resume(intrusive_ptr<resumable> ptr) {
 }
 
 default_multiplexer::~default_multiplexer() {
+  // Resolver threads post their results through the pipe.
+  if (resolver_ != nullptr)
+    resolver_->stop();
   if (epollfd_ != invalid_native_socket)
     close_socket(epollfd_);
   // close write handle first
-  close_socket(pipe_.second);
-  // flush pipe before closing it
-  nonblocking(pipe_.first, true);
-  auto ptr = pipe_reader_.try_read_next();
-  while (ptr != nullptr) {
-    scheduler::abstract_coordinator::cleanup_and_release(ptr);
-    ptr = pipe_reader_.try_read_next();
-  }
+  if (pipe_.second != pipe_.first)
+    close_socket(pipe_.second);
+  // release all requests that never ran
+  dispatch_queue_.close();
   // do cleanup for pipe reader manually, since WSACleanup needs to happen last
   close_socket(pipe_reader_.fd());
   pipe_reader_.init(invalid_native_socket);
@@ -654,6 +828,14 @@ void default_multiplexer::exec_later(resumable* ptr) {
 scribe_ptr default_multiplexer::new_scribe(native_socket fd) {
   CAF_LOG_TRACE("");
   keepalive(fd, true);
+#ifdef SO_BUSY_POLL
+  if (socket_busy_poll_ > 0
+      && setsockopt(fd, SOL_SOCKET, SO_BUSY_POLL, &socket_busy_poll_,
+                    static_cast<socklen_t>(sizeof(socket_busy_poll_)))
+           != 0)
+    CAF_LOG_WARNING("unable to set SO_BUSY_POLL:"
+                    << CAF_ARG(last_socket_error_as_string()));
+#endif
   return make_counted<scribe_impl>(*this, fd);
 }
 
@@ -665,6 +847,41 @@ default_multiplexer::new_tcp_scribe(const std::string& host, uint16_t port) {
   return new_scribe(*fd);
 }
 
+void default_multiplexer::new_tcp_scribe_async(std::string host, uint16_t port,
+                                               scribe_factory make,
+                                               scribe_callback f) {
+  CAF_LOG_TRACE(CAF_ARG(host) << CAF_ARG(port));
+  // Always post, because the connector registers its sockets only after
+  // returning to the event loop.
+  post([this, host{std::move(host)}, port, make{std::move(make)},
+        f{std::move(f)}]() mutable {
+    auto& cfg = system().config();
+    if (resolver_ == nullptr)
+      resolver_.reset(new resolver(
+        *this,
+        get_or(cfg, "caf.middleman.resolver-threads",
+               defaults::middleman::resolver_threads),
+        get_or(cfg, "caf.middleman.resolver-cache-ttl",
+               defaults::middleman::resolver_cache_ttl)));
+    auto delay = get_or(cfg, "caf.middleman.connection-attempt-delay",
+                        defaults::middleman::connection_attempt_delay);
+    auto on_connect = [this, make{std::move(make)},
+                       f{std::move(f)}](expected<native_socket> fd) {
+      if (!fd)
+        f(std::move(fd.error()));
+      else if (make)
+        make(*fd, f);
+      else
+        f(new_scribe(*fd));
+    };
+    resolver_->resolve(host, [=](const resolver::address_list& addrs) {
+      auto ptr = make_counted<connector>(*this, host, port, addrs, delay,
+                                         on_connect);
+      ptr->start();
+    });
+  });
+}
+
 doorman_ptr default_multiplexer::new_doorman(native_socket fd) {
   CAF_LOG_TRACE(CAF_ARG(fd));
   CAF_ASSERT(fd != network::invalid_native_socket);
@@ -680,6 +897,71 @@ default_multiplexer::new_tcp_doorman(uint16_t port, const char* in,
   return std::move(fd.error());
 }
 
+expected<scribe_ptr> default_multiplexer::new_shm_scribe(uint16_t port) {
+  CAF_LOG_TRACE(CAF_ARG(port));
+#ifdef CAF_LINUX
+  auto dir = shm_socket_dir(
+    get_or(system().config(), "caf.middleman.shared-memory-dir",
+           defaults::middleman::shared_memory_dir));
+  if (!dir)
+    return std::move(dir.error());
+  auto fd = new_local_connection(shm_socket_path(*dir, port));
+  if (!fd)
+    return std::move(fd.error());
+  detail::socket_guard sguard{*fd};
+  // Only accept memory segments from processes of the same user.
+  if (auto res = check_peer_credentials(*fd); !res)
+    return std::move(res.error());
+  auto seg_fd = receive_fd(*fd, shm_rendezvous_timeout);
+  if (!seg_fd)
+    return std::move(seg_fd.error());
+  auto seg = shm_segment::attach(*seg_fd);
+  if (!seg)
+    return std::move(seg.error());
+  return make_counted<shm_scribe>(*this, sguard.release(), std::move(*seg),
+                                  false, port);
+#else
+  return multiplexer::new_shm_scribe(port);
+#endif
+}
+
+expected<doorman_ptr> default_multiplexer::new_shm_doorman(uint16_t port) {
+  CAF_LOG_TRACE(CAF_ARG(port));
+#ifdef CAF_LINUX
+  auto& cfg = system().config();
+  auto dir = shm_socket_dir(get_or(cfg, "caf.middleman.shared-memory-dir",
+                                   defaults::middleman::shared_memory_dir));
+  if (!dir)
+    return std::move(dir.error());
+  auto ring_size = get_or(cfg, "caf.middleman.shared-memory-ring-size",
+                          defaults::middleman::shared_memory_ring_size);
+  auto path = shm_socket_path(*dir, port);
+  auto fd = new_local_acceptor_impl(path);
+  if (!fd)
+    return std::move(fd.error());
+  return make_counted<shm_doorman>(*this, *fd, std::move(path), port,
+                                   ring_size);
+#else
+  return multiplexer::new_shm_doorman(port);
+#endif
+}
+
+expected<scribe_ptr>
+default_multiplexer::new_local_scribe(const std::string& path) {
+  auto fd = new_local_connection(path);
+  if (!fd)
+    return std::move(fd.error());
+  return new_scribe(*fd);
+}
+
+expected<doorman_ptr>
+default_multiplexer::new_local_doorman(const std::string& path) {
+  auto fd = new_local_acceptor_impl(path);
+  if (!fd)
+    return std::move(fd.error());
+  return make_counted<local_doorman>(*this, *fd, path);
+}
+
 datagram_servant_ptr
 default_multiplexer::new_datagram_servant(native_socket fd) {
   CAF_LOG_TRACE(CAF_ARG(fd));
@@ -725,6 +1007,43 @@ void default_multiplexer::handle_internal_events() {
   events_.clear();
 }
 
+void default_multiplexer::schedule(timespan delay, std::function<void()> f) {
+  CAF_LOG_TRACE(CAF_ARG(delay));
+  timeouts_.emplace(std::chrono::steady_clock::now() + delay, std::move(f));
+}
+
+int default_multiplexer::poll_timeout(bool block) const {
+  if (!block)
+    return 0;
+  if (timeouts_.empty())
+    return -1;
+  auto now = std::chrono::steady_clock::now();
+  auto due = timeouts_.begin()->first;
+  if (due <= now)
+    return 0;
+  // Round up to avoid waking up right before the timeout.
+  auto ms = std::chrono::ceil<std::chrono::milliseconds>(due - now);
+  return static_cast<int>(ms.count());
+}
+
+bool default_multiplexer::handle_timeouts() {
+  if (timeouts_.empty())
+    return false;
+  auto now = std::chrono::steady_clock::now();
+  auto last = timeouts_.upper_bound(now);
+  if (last == timeouts_.begin())
+    return false;
+  // Functions may schedule new timeouts, so we move due functions out first.
+  std::vector<std::function<void()>> fs;
+  for (auto i = timeouts_.begin(); i != last; ++i)
+    fs.emplace_back(std::move(i->second));
+  timeouts_.erase(timeouts_.begin(), last);
+  for (auto& f : fs)
+    f();
+  handle_internal_events();
+  return true;
+}
+
 // -- Related helper functions -------------------------------------------------
 
 template <int Family>
@@ -880,6 +1199,99 @@ new_tcp_acceptor_impl(uint16_t port, const char* addr, bool reuse_addr) {
   return sguard.release();
 }
 
+#ifndef CAF_WINDOWS
+
+namespace {
+
+expected<sockaddr_un> local_address(const std::string& path) {
+  sockaddr_un sa;
+  memset(&sa, 0, sizeof(sa));
+  if (path.size() >= sizeof(sa.sun_path))
+    return make_error(sec::invalid_argument, "socket path too long", path);
+  sa.sun_family = AF_UNIX;
+  memcpy(sa.sun_path, path.c_str(), path.size() + 1);
+  return sa;
+}
+
+/// Checks whether the socket file at `sa` is left over from a process that
+/// no longer listens on it.
+bool stale_local_socket(const sockaddr_un& sa) {
+  auto fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd == invalid_native_socket)
+    return false;
+  detail::socket_guard sguard{fd};
+  auto res = connect(fd, reinterpret_cast<const sockaddr*>(&sa), sizeof(sa));
+  return res != 0 && errno == ECONNREFUSED;
+}
+
+} // namespace
+
+expected<native_socket> new_local_connection(const std::string& path) {
+  CAF_LOG_TRACE(CAF_ARG(path));
+  auto sa = local_address(path);
+  if (!sa)
+    return std::move(sa.error());
+  int socktype = SOCK_STREAM;
+#  ifdef SOCK_CLOEXEC
+  socktype |= SOCK_CLOEXEC;
+#  endif
+  CALL_CFUN(fd, detail::cc_valid_socket, "socket",
+            socket(AF_UNIX, socktype, 0));
+  child_process_inherit(fd, false);
+  detail::socket_guard sguard{fd};
+  if (connect(fd, reinterpret_cast<const sockaddr*>(&*sa), sizeof(*sa)) != 0) {
+    CAF_LOG_DEBUG("could not connect to:" << CAF_ARG(path));
+    return make_error(sec::cannot_connect_to_node, "connect failed", path);
+  }
+  return sguard.release();
+}
+
+expected<native_socket> new_local_acceptor_impl(const std::string& path) {
+  CAF_LOG_TRACE(CAF_ARG(path));
+  auto sa = local_address(path);
+  if (!sa)
+    return std::move(sa.error());
+  int socktype = SOCK_STREAM;
+#  ifdef SOCK_CLOEXEC
+  socktype |= SOCK_CLOEXEC;
+#  endif
+  CALL_CFUN(fd, detail::cc_valid_socket, "socket",
+            socket(AF_UNIX, socktype, 0));
+  child_process_inherit(fd, false);
+  detail::socket_guard sguard{fd};
+  // A socket file remains after a crash and would make bind fail. Remove it
+  // only if it is a socket that nobody listens on anymore.
+  struct stat st;
+  if (lstat(path.c_str(), &st) == 0) {
+    if (!S_ISSOCK(st.st_mode))
+      return make_error(sec::cannot_open_port, "path exists and is no socket",
+                        path);
+    if (!stale_local_socket(*sa))
+      return make_error(sec::cannot_open_port, "socket path in use", path);
+    unlink(path.c_str());
+  }
+  if (bind(fd, reinterpret_cast<const sockaddr*>(&*sa), sizeof(*sa)) != 0) {
+    CAF_LOG_WARNING("could not bind to:" << CAF_ARG(path));
+    return make_error(sec::cannot_open_port, "bind failed", path);
+  }
+  CALL_CFUN(tmp, detail::cc_zero, "listen", listen(fd, SOMAXCONN));
+  return sguard.release();
+}
+
+#else // CAF_WINDOWS
+
+expected<native_socket> new_local_connection(const std::string&) {
+  return make_error(sec::unsupported_operation,
+                    "Unix domain sockets are not supported on this platform");
+}
+
+expected<native_socket> new_local_acceptor_impl(const std::string&) {
+  return make_error(sec::unsupported_operation,
+                    "Unix domain sockets are not supported on this platform");
+}
+
+#endif // CAF_WINDOWS
+
 expected<std::pair<native_socket, ip_endpoint>>
 new_remote_udp_endpoint_impl(const std::string& host, uint16_t port,
                              optional<protocol::network> preferred) {
@@ -0,0 +1,54 @@
+// This file is part of CAF, the C++ Actor Framework. See the file LICENSE in
+// the main distribution directory for license terms and copyright or visit
+// https://github.com/actor-framework/actor-framework/blob/master/LICENSE.
+
+#include "caf/io/network/local_doorman.hpp"
+
+#ifndef CAF_WINDOWS
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif
+
+namespace caf::io::network {
+
+local_socket_file::local_socket_file(std::string path)
+  : path_(std::move(path)) {
+#ifndef CAF_WINDOWS
+  struct stat st;
+  if (lstat(path_.c_str(), &st) == 0) {
+    dev_ = static_cast<uint64_t>(st.st_dev);
+    ino_ = static_cast<uint64_t>(st.st_ino);
+  }
+#endif
+}
+
+local_socket_file::~local_socket_file() {
+#ifndef CAF_WINDOWS
+  // Another process may have taken over the path after we stopped listening.
+  struct stat st;
+  if (ino_ != 0 && lstat(path_.c_str(), &st) == 0
+      && static_cast<uint64_t>(st.st_dev) == dev_
+      && static_cast<uint64_t>(st.st_ino) == ino_)
+    unlink(path_.c_str());
+#endif
+}
+
+local_doorman::local_doorman(default_multiplexer& mx, native_socket sockfd,
+                             std::string path)
+  : doorman_impl(mx, sockfd), file_(std::move(path)) {
+  // nop
+}
+
+local_doorman::~local_doorman() {
+  // nop
+}
+
+std::string local_doorman::addr() const {
+  return file_.path();
+}
+
+uint16_t local_doorman::port() const {
+  return 0;
+}
+
+} // namespace caf::io::network
@@ -39,8 +39,10 @@ void manager::detach(execution_unit*, bool invoke_disconnect_message) {
     // Keep a strong reference to our parent until we go out of scope.
     strong_actor_ptr ptr;
     ptr.swap(parent_);
-    detach_from(raw_ptr);
-    if (invoke_disconnect_message) {
+    auto disconnect = [this, raw_ptr, invoke_disconnect_message] {
+      detach_from(raw_ptr);
+      if (!invoke_disconnect_message)
+        return;
       auto mptr = make_mailbox_element(nullptr, make_message_id(), {},
                                        detach_message());
       switch (raw_ptr->consume(*mptr)) {
@@ -54,7 +56,19 @@ void manager::detach(execution_unit*, bool invoke_disconnect_message) {
           CAF_LOG_INFO("broker dropped disconnect message");
           break;
       }
+    };
+    if (!raw_ptr->scheduled()) {
+      disconnect();
+      return;
     }
+    // Brokers on the scheduler own their containers of servants. The broker
+    // may also have closed this manager and reused its handle in the meantime.
+    raw_ptr->post_io_event(abstract_broker::io_event{
+      [mgr{intrusive_ptr<manager>{this}}, raw_ptr,
+       disconnect](execution_unit*) {
+        if (mgr->attached_to(raw_ptr))
+          disconnect();
+      }});
   }
 }
 
@@ -17,6 +17,31 @@ multiplexer_ptr multiplexer::make(actor_system& sys) {
   return multiplexer_ptr{new default_multiplexer(&sys)};
 }
 
+void multiplexer::new_tcp_scribe_async(std::string host, uint16_t port,
+                                       scribe_factory, scribe_callback f) {
+  f(new_tcp_scribe(host, port));
+}
+
+expected<scribe_ptr> multiplexer::new_shm_scribe(uint16_t) {
+  return make_error(sec::unsupported_operation,
+                    "backend does not support shared memory");
+}
+
+expected<doorman_ptr> multiplexer::new_shm_doorman(uint16_t) {
+  return make_error(sec::unsupported_operation,
+                    "backend does not support shared memory");
+}
+
+expected<scribe_ptr> multiplexer::new_local_scribe(const std::string&) {
+  return make_error(sec::unsupported_operation,
+                    "backend does not support Unix domain sockets");
+}
+
+expected<doorman_ptr> multiplexer::new_local_doorman(const std::string&) {
+  return make_error(sec::unsupported_operation,
+                    "backend does not support Unix domain sockets");
+}
+
 multiplexer_backend* multiplexer::pimpl() {
   return nullptr;
 }
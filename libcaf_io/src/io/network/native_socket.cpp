@@ -39,6 +39,7 @@
 #  include <netinet/ip.h>
 #  include <netinet/tcp.h>
 #  include <sys/socket.h>
+#  include <sys/un.h>
 #  include <unistd.h>
 #endif
 // clang-format on
@@ -392,6 +393,11 @@ expected<string> local_addr_of_fd(native_socket fd) {
       return inet_ntop(AF_INET6,
                        &reinterpret_cast<sockaddr_in6*>(sa)->sin6_addr, addr,
                        sizeof(addr));
+#ifndef CAF_WINDOWS
+    case AF_UNIX:
+      // Unnamed sockets, e.g., accepted connections, have an empty path.
+      return string{reinterpret_cast<sockaddr_un*>(sa)->sun_path};
+#endif
     default:
       break;
   }
@@ -404,6 +410,9 @@ expected<uint16_t> local_port_of_fd(native_socket fd) {
   socket_size_type st_len = sizeof(st);
   CALL_CFUN(tmp, detail::cc_zero, "getsockname",
             getsockname(fd, reinterpret_cast<sockaddr*>(&st), &st_len));
+  if (st.ss_family != AF_INET && st.ss_family != AF_INET6)
+    return make_error(sec::invalid_protocol_family, "local_port_of_fd",
+                      st.ss_family);
   return ntohs(port_of(reinterpret_cast<sockaddr&>(st)));
 }
 
@@ -421,6 +430,11 @@ expected<string> remote_addr_of_fd(native_socket fd) {
       return inet_ntop(AF_INET6,
                        &reinterpret_cast<sockaddr_in6*>(sa)->sin6_addr, addr,
                        sizeof(addr));
+#ifndef CAF_WINDOWS
+    case AF_UNIX:
+      // Unnamed sockets, e.g., accepted connections, have an empty path.
+      return string{reinterpret_cast<sockaddr_un*>(sa)->sun_path};
+#endif
     default:
       break;
   }
@@ -433,6 +447,9 @@ expected<uint16_t> remote_port_of_fd(native_socket fd) {
   socket_size_type st_len = sizeof(st);
   CALL_CFUN(tmp, detail::cc_zero, "getpeername",
             getpeername(fd, reinterpret_cast<sockaddr*>(&st), &st_len));
+  if (st.ss_family != AF_INET && st.ss_family != AF_INET6)
+    return make_error(sec::invalid_protocol_family, "remote_port_of_fd",
+                      st.ss_family);
   return ntohs(port_of(reinterpret_cast<sockaddr&>(st)));
 }
 
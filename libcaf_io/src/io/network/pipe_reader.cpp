@@ -31,27 +31,22 @@ void pipe_reader::graceful_shutdown() {
   shutdown_read(fd_);
 }
 
-resumable* pipe_reader::try_read_next() {
-  std::intptr_t ptrval;
+bool pipe_reader::try_read_signal() {
+  uint64_t signal;
   // on windows, we actually have sockets, otherwise we have file handles
 #ifdef CAF_WINDOWS
   auto res
-    = recv(fd(), reinterpret_cast<socket_recv_ptr>(&ptrval), sizeof(ptrval), 0);
+    = recv(fd(), reinterpret_cast<socket_recv_ptr>(&signal), sizeof(signal), 0);
 #else
-  auto res = read(fd(), &ptrval, sizeof(ptrval));
+  auto res = read(fd(), &signal, sizeof(signal));
 #endif
-  if (res != sizeof(ptrval))
-    return nullptr;
-  return reinterpret_cast<resumable*>(ptrval);
+  return res == sizeof(signal);
 }
 
 void pipe_reader::handle_event(operation op) {
   CAF_LOG_TRACE(CAF_ARG(op));
-  if (op == operation::read) {
-    auto ptr = try_read_next();
-    if (ptr != nullptr)
-      backend().resume({ptr, false});
-  }
+  if (op == operation::read && try_read_signal())
+    backend().handle_dispatch_requests();
   // else: ignore errors
 }
 
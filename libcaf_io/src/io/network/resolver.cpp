@@ -0,0 +1,133 @@
+// This file is part of CAF, the C++ Actor Framework. See the file LICENSE in
+// the main distribution directory for license terms and copyright or visit
+// https://github.com/actor-framework/actor-framework/blob/master/LICENSE.
+
+#include "caf/io/network/resolver.hpp"
+
+#include "caf/actor_system.hpp"
+#include "caf/ipv4_address.hpp"
+#include "caf/ipv6_address.hpp"
+#include "caf/logger.hpp"
+
+#include "caf/io/network/default_multiplexer.hpp"
+#include "caf/io/network/interfaces.hpp"
+
+namespace caf::io::network {
+
+resolver::resolver(default_multiplexer& mpx, size_t max_threads, timespan ttl)
+  : mpx_(mpx),
+    max_threads_(max_threads > 0 ? max_threads : 1),
+    ttl_(ttl),
+    idle_threads_(0),
+    stopped_(false) {
+  // nop
+}
+
+resolver::~resolver() {
+  stop();
+}
+
+void resolver::resolve(const std::string& host, callback f) {
+  CAF_LOG_TRACE(CAF_ARG(host));
+  // IP addresses need no lookup.
+  if (ipv4_address v4; !parse(host, v4)) {
+    f(address_list{{host, protocol::ipv4}});
+    return;
+  }
+  if (ipv6_address v6; !parse(host, v6)) {
+    f(address_list{{host, protocol::ipv6}});
+    return;
+  }
+  if (auto i = cache_.find(host); i != cache_.end()) {
+    if (i->second.expires > clock_type::now()) {
+      CAF_LOG_DEBUG("found cached addresses:" << CAF_ARG(host));
+      f(i->second.addrs);
+      return;
+    }
+    cache_.erase(i);
+  }
+  // Lookups never finish after stopping. Hence, we report a failed lookup
+  // instead of keeping the callback around forever.
+  std::unique_lock<std::mutex> guard{mtx_};
+  if (stopped_) {
+    guard.unlock();
+    CAF_LOG_DEBUG("resolver stopped, drop lookup:" << CAF_ARG(host));
+    f(address_list{});
+    return;
+  }
+  auto& callbacks = pending_[host];
+  callbacks.emplace_back(std::move(f));
+  if (callbacks.size() > 1) {
+    CAF_LOG_DEBUG("attach to pending lookup:" << CAF_ARG(host));
+    return;
+  }
+  queue_.emplace_back(host);
+  if (idle_threads_ == 0 && threads_.size() < max_threads_)
+    threads_.emplace_back([this] { run(); });
+  else
+    cv_.notify_one();
+}
+
+void resolver::stop() {
+  std::vector<std::thread> threads;
+  {
+    std::unique_lock<std::mutex> guard{mtx_};
+    stopped_ = true;
+    threads.swap(threads_);
+  }
+  cv_.notify_all();
+  for (auto& t : threads)
+    t.join();
+}
+
+void resolver::run() {
+  mpx_.system().thread_started();
+  std::unique_lock<std::mutex> guard{mtx_};
+  for (;;) {
+    ++idle_threads_;
+    cv_.wait(guard, [this] { return stopped_ || !queue_.empty(); });
+    --idle_threads_;
+    if (stopped_)
+      break;
+    auto host = std::move(queue_.front());
+    queue_.pop_front();
+    guard.unlock();
+    CAF_LOG_DEBUG("resolve host:" << CAF_ARG(host));
+    auto addrs = interfaces::server_address(0, host.c_str());
+    // Enqueueing the result while holding the lock makes sure that `stop`
+    // cannot return while we still access the multiplexer.
+    guard.lock();
+    if (stopped_)
+      break;
+    mpx_.dispatch([this, host{std::move(host)}, addrs{std::move(addrs)}] {
+      resolved(host, addrs);
+    });
+  }
+  guard.unlock();
+  mpx_.system().thread_terminates();
+}
+
+void resolver::resolved(const std::string& host, address_list addrs) {
+  CAF_LOG_TRACE(CAF_ARG(host) << CAF_ARG(addrs));
+  // Drop expired entries for hosts we no longer look up.
+  auto now = clock_type::now();
+  for (auto i = cache_.begin(); i != cache_.end();) {
+    if (i->second.expires <= now)
+      i = cache_.erase(i);
+    else
+      ++i;
+  }
+  if (addrs.empty())
+    CAF_LOG_DEBUG("no such host:" << CAF_ARG(host));
+  else
+    cache_[host] = cache_entry{now + ttl_, addrs};
+  auto i = pending_.find(host);
+  if (i == pending_.end())
+    return;
+  auto callbacks = std::move(i->second);
+  pending_.erase(i);
+  for (auto& f : callbacks)
+    f(addrs);
+}
+
+} // namespace caf::io::network
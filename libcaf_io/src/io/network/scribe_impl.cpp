@@ -35,10 +35,22 @@ byte_buffer& scribe_impl::wr_buf() {
   return stream_.wr_buf();
 }
 
+size_t scribe_impl::pending_bytes() const {
+  return stream_.pending_bytes();
+}
+
 byte_buffer& scribe_impl::rd_buf() {
   return stream_.rd_buf();
 }
 
+bool scribe_impl::slices_rd_buf() const {
+  return stream_.adaptive_reads();
+}
+
+void scribe_impl::metrics(const connection_metrics& x) {
+  stream_.metrics(x);
+}
+
 void scribe_impl::graceful_shutdown() {
   CAF_LOG_TRACE("");
   stream_.graceful_shutdown();
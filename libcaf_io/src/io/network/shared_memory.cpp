@@ -0,0 +1,331 @@
+// This file is part of CAF, the C++ Actor Framework. See the file LICENSE in
+// the main distribution directory for license terms and copyright or visit
+// https://github.com/actor-framework/actor-framework/blob/master/LICENSE.
+
+#include "caf/io/network/shared_memory.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#include "caf/logger.hpp"
+#include "caf/sec.hpp"
+
+#ifdef CAF_LINUX
+#  include <cerrno>
+#  include <poll.h>
+#  include <sys/mman.h>
+#  include <sys/socket.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif
+
+namespace caf::io::network {
+
+namespace {
+
+/// Stores the layout of a segment at its beginning.
+struct alignas(CAF_CACHE_LINE_SIZE) segment_header {
+  uint64_t magic;
+  uint64_t ring_capacity;
+};
+
+constexpr size_t min_ring_capacity = 4096;
+
+size_t ring_stride(size_t capacity) {
+  return sizeof(shm_ring_header) + capacity;
+}
+
+size_t segment_size(size_t capacity) {
+  return sizeof(segment_header) + 2 * ring_stride(capacity);
+}
+
+} // namespace
+
+// -- shm_ring -----------------------------------------------------------------
+
+size_t shm_ring::size() const noexcept {
+  auto tail = hdr_->tail.load();
+  auto head = hdr_->head.load();
+  return static_cast<size_t>(tail - head);
+}
+
+size_t shm_ring::write(const void* buf, size_t len) noexcept {
+  auto tail = hdr_->tail.load(std::memory_order_relaxed);
+  auto head = hdr_->head.load(std::memory_order_acquire);
+  // The consumer lives in another process. Never trust its position.
+  auto used = static_cast<size_t>(tail - head);
+  if (used > capacity_)
+    return 0;
+  auto n = std::min(len, capacity_ - used);
+  if (n == 0)
+    return 0;
+  auto offset = static_cast<size_t>(tail & (capacity_ - 1));
+  auto first = std::min(n, capacity_ - offset);
+  auto src = static_cast<const std::byte*>(buf);
+  memcpy(data_ + offset, src, first);
+  memcpy(data_, src + first, n - first);
+  // Sequentially consistent to order the store before reading reader_waiting.
+  hdr_->tail.store(tail + n);
+  return n;
+}
+
+size_t shm_ring::read(void* buf, size_t len) noexcept {
+  auto head = hdr_->head.load(std::memory_order_relaxed);
+  auto tail = hdr_->tail.load(std::memory_order_acquire);
+  // The producer lives in another process. Never trust its position.
+  auto used = static_cast<size_t>(tail - head);
+  if (used > capacity_)
+    return 0;
+  auto n = std::min(len, used);
+  if (n == 0)
+    return 0;
+  auto offset = static_cast<size_t>(head & (capacity_ - 1));
+  auto first = std::min(n, capacity_ - offset);
+  auto dst = static_cast<std::byte*>(buf);
+  memcpy(dst, data_ + offset, first);
+  memcpy(dst + first, data_, n - first);
+  // Sequentially consistent to order the store before reading writer_waiting.
+  hdr_->head.store(head + n);
+  return n;
+}
+
+bool shm_ring::prepare_read_wait() noexcept {
+  hdr_->reader_waiting.store(true);
+  return size() == 0;
+}
+
+bool shm_ring::prepare_write_wait() noexcept {
+  hdr_->writer_waiting.store(true);
+  return free_space() == 0;
+}
+
+bool shm_ring::take_waiting_reader() noexcept {
+  return hdr_->reader_waiting.load() && hdr_->reader_waiting.exchange(false);
+}
+
+bool shm_ring::take_waiting_writer() noexcept {
+  return hdr_->writer_waiting.load() && hdr_->writer_waiting.exchange(false);
+}
+
+// -- shm_segment --------------------------------------------------------------
+
+shm_segment::shm_segment(int fd, void* addr, size_t size) noexcept
+  : fd_(fd), addr_(addr), size_(size) {
+  // nop
+}
+
+shm_segment::~shm_segment() {
+#ifdef CAF_LINUX
+  munmap(addr_, size_);
+  ::close(fd_);
+#endif
+}
+
+shm_ring shm_segment::ring(size_t i) const noexcept {
+  CAF_ASSERT(i < 2);
+  auto base = static_cast<std::byte*>(addr_);
+  auto capacity = reinterpret_cast<segment_header*>(base)->ring_capacity;
+  auto hdr = base + sizeof(segment_header) + i * ring_stride(capacity);
+  return {reinterpret_cast<shm_ring_header*>(hdr),
+          hdr + sizeof(shm_ring_header), capacity};
+}
+
+#ifdef CAF_LINUX
+
+expected<shm_segment_ptr> shm_segment::create(size_t ring_size) {
+  CAF_LOG_TRACE(CAF_ARG(ring_size));
+  // Round up to a power of two to map positions to offsets with a bit mask.
+  size_t capacity = min_ring_capacity;
+  while (capacity < ring_size)
+    capacity <<= 1;
+  auto fd = memfd_create("caf-shm", MFD_CLOEXEC);
+  if (fd < 0)
+    return make_error(sec::runtime_error, "memfd_create failed",
+                      strerror(errno));
+  auto size = segment_size(capacity);
+  if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+    auto err = errno;
+    ::close(fd);
+    return make_error(sec::runtime_error, "ftruncate failed", strerror(err));
+  }
+  auto addr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (addr == MAP_FAILED) {
+    auto err = errno;
+    ::close(fd);
+    return make_error(sec::runtime_error, "mmap failed", strerror(err));
+  }
+  auto base = static_cast<std::byte*>(addr);
+  new (base) segment_header{magic_number, capacity};
+  // Readers start out waiting to make sure the first write rings the doorbell.
+  for (size_t i = 0; i < 2; ++i)
+    new (base + sizeof(segment_header) + i * ring_stride(capacity))
+      shm_ring_header{{0}, {0}, {true}, {false}};
+  return shm_segment_ptr{new shm_segment(fd, addr, size), false};
+}
+
+expected<shm_segment_ptr> shm_segment::attach(int fd) {
+  CAF_LOG_TRACE(CAF_ARG(fd));
+  auto fail = [fd](const char* what) {
+    ::close(fd);
+    return make_error(sec::runtime_error, what);
+  };
+  struct stat st;
+  if (fstat(fd, &st) != 0
+      || static_cast<size_t>(st.st_size) < sizeof(segment_header))
+    return fail("invalid shared memory segment");
+  auto size = static_cast<size_t>(st.st_size);
+  auto addr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (addr == MAP_FAILED)
+    return fail("mmap failed");
+  auto hdr = static_cast<segment_header*>(addr);
+  if (hdr->magic != magic_number || hdr->ring_capacity < min_ring_capacity
+      || segment_size(hdr->ring_capacity) != size) {
+    munmap(addr, size);
+    return fail("shared memory segment has an unexpected layout");
+  }
+  return shm_segment_ptr{new shm_segment(fd, addr, size), false};
+}
+
+expected<void> send_fd(native_socket sock, int fd) {
+  char dummy = 0;
+  iovec iov;
+  iov.iov_base = &dummy;
+  iov.iov_len = 1;
+  alignas(cmsghdr) char ctrl[CMSG_SPACE(sizeof(int))];
+  memset(ctrl, 0, sizeof(ctrl));
+  msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = ctrl;
+  msg.msg_controllen = sizeof(ctrl);
+  auto cmsg = CMSG_FIRSTHDR(&msg);
+  cmsg->cmsg_level = SOL_SOCKET;
+  cmsg->cmsg_type = SCM_RIGHTS;
+  cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+  memcpy(CMSG_DATA(cmsg), &fd, sizeof(int));
+  if (sendmsg(sock, &msg, MSG_NOSIGNAL) != 1)
+    return make_error(sec::runtime_error, "sendmsg failed", strerror(errno));
+  return unit;
+}
+
+expected<int> receive_fd(native_socket sock, timespan timeout) {
+  using std::chrono::duration_cast;
+  using std::chrono::milliseconds;
+  pollfd pfd{sock, POLLIN, 0};
+  auto ms = static_cast<int>(duration_cast<milliseconds>(timeout).count());
+  int pres;
+  do {
+    pres = poll(&pfd, 1, ms);
+  } while (pres < 0 && errno == EINTR);
+  if (pres == 0)
+    return make_error(sec::runtime_error, "timeout while waiting for peer");
+  if (pres < 0)
+    return make_error(sec::runtime_error, "poll failed", strerror(errno));
+  char dummy = 0;
+  iovec iov;
+  iov.iov_base = &dummy;
+  iov.iov_len = 1;
+  alignas(cmsghdr) char ctrl[CMSG_SPACE(sizeof(int))];
+  msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = ctrl;
+  msg.msg_controllen = sizeof(ctrl);
+  ssize_t res;
+  do {
+    res = recvmsg(sock, &msg, MSG_CMSG_CLOEXEC);
+  } while (res < 0 && errno == EINTR);
+  if (res != 1)
+    return make_error(sec::runtime_error, "recvmsg failed");
+  auto cmsg = CMSG_FIRSTHDR(&msg);
+  if (cmsg == nullptr || cmsg->cmsg_level != SOL_SOCKET
+      || cmsg->cmsg_type != SCM_RIGHTS
+      || cmsg->cmsg_len != CMSG_LEN(sizeof(int)))
+    return make_error(sec::runtime_error, "peer sent no file descriptor");
+  int fd;
+  memcpy(&fd, CMSG_DATA(cmsg), sizeof(int));
+  return fd;
+}
+
+expected<void> check_peer_credentials(native_socket sock) {
+  ucred cred;
+  socklen_t len = sizeof(cred);
+  if (getsockopt(sock, SOL_SOCKET, SO_PEERCRED, &cred, &len) != 0)
+    return make_error(sec::runtime_error, "getsockopt failed",
+                      strerror(errno));
+  if (cred.uid != geteuid())
+    return make_error(sec::runtime_error, "peer runs as a different user");
+  return unit;
+}
+
+expected<std::string> shm_socket_dir(const std::string& dir) {
+  std::string result;
+  if (!dir.empty())
+    result = dir;
+  else if (auto xdg = getenv("XDG_RUNTIME_DIR"); xdg != nullptr && *xdg != 0)
+    result = std::string{xdg} + "/caf";
+  else
+    result = "/tmp/caf-" + std::to_string(geteuid());
+  if (mkdir(result.c_str(), 0700) != 0 && errno != EEXIST)
+    return make_error(sec::runtime_error, "mkdir failed", result,
+                      strerror(errno));
+  // Other users could otherwise replace our sockets with their own.
+  struct stat st;
+  if (lstat(result.c_str(), &st) != 0 || !S_ISDIR(st.st_mode))
+    return make_error(sec::runtime_error, "not a directory", result);
+  if (st.st_uid != geteuid() || (st.st_mode & 077) != 0)
+    return make_error(sec::runtime_error,
+                      "directory is accessible by other users", result);
+  return result;
+}
+
+#else // CAF_LINUX
+
+expected<shm_segment_ptr> shm_segment::create(size_t) {
+  return make_error(sec::unsupported_operation,
+                    "shared memory transport requires Linux");
+}
+
+expected<shm_segment_ptr> shm_segment::attach(int) {
+  return make_error(sec::unsupported_operation,
+                    "shared memory transport requires Linux");
+}
+
+expected<void> send_fd(native_socket, int) {
+  return make_error(sec::unsupported_operation,
+                    "shared memory transport requires Linux");
+}
+
+expected<int> receive_fd(native_socket, timespan) {
+  return make_error(sec::unsupported_operation,
+                    "shared memory transport requires Linux");
+}
+
+expected<void> check_peer_credentials(native_socket) {
+  return make_error(sec::unsupported_operation,
+                    "shared memory transport requires Linux");
+}
+
+expected<std::string> shm_socket_dir(const std::string&) {
+  return make_error(sec::unsupported_operation,
+                    "shared memory transport requires Linux");
+}
+
+#endif // CAF_LINUX
+
+std::string shm_socket_path(const std::string& dir, uint16_t port) {
+  auto result = dir;
+  if (result.empty() || result.back() != '/')
+    result += '/';
+  result += "caf-shm-";
+  result += std::to_string(port);
+  result += ".sock";
+  return result;
+}
+
+} // namespace caf::io::network
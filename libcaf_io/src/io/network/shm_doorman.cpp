@@ -0,0 +1,57 @@
+// This file is part of CAF, the C++ Actor Framework. See the file LICENSE in
+// the main distribution directory for license terms and copyright or visit
+// https://github.com/actor-framework/actor-framework/blob/master/LICENSE.
+
+#include "caf/io/network/shm_doorman.hpp"
+
+#include "caf/detail/socket_guard.hpp"
+#include "caf/logger.hpp"
+#include "caf/make_counted.hpp"
+
+#include "caf/io/network/default_multiplexer.hpp"
+#include "caf/io/network/shared_memory.hpp"
+#include "caf/io/network/shm_scribe.hpp"
+
+namespace caf::io::network {
+
+shm_doorman::shm_doorman(default_multiplexer& mx, native_socket sockfd,
+                         std::string path, uint16_t port, size_t ring_size)
+  : local_doorman(mx, sockfd, std::move(path)),
+    port_(port),
+    ring_size_(ring_size) {
+  // nop
+}
+
+bool shm_doorman::new_connection() {
+  CAF_LOG_TRACE("");
+  if (detached())
+    return false;
+  auto& dm = acceptor_.backend();
+  detail::socket_guard sguard{acceptor_.accepted_socket()};
+  // Only share memory with processes of the same user.
+  if (auto res = check_peer_credentials(acceptor_.accepted_socket()); !res) {
+    CAF_LOG_WARNING("reject shared memory peer:" << res.error());
+    return false;
+  }
+  auto seg = shm_segment::create(ring_size_);
+  if (!seg) {
+    CAF_LOG_WARNING("unable to create shared memory segment:" << seg.error());
+    return false;
+  }
+  // Closing the socket makes the peer fall back to TCP.
+  if (auto res = send_fd(acceptor_.accepted_socket(), (*seg)->fd()); !res) {
+    CAF_LOG_WARNING("unable to share memory segment:" << res.error());
+    return false;
+  }
+  auto sptr = make_counted<shm_scribe>(dm, sguard.release(), std::move(*seg),
+                                       true, uint16_t{0});
+  auto hdl = sptr->hdl();
+  parent()->add_scribe(std::move(sptr));
+  return doorman::new_connection(&dm, hdl);
+}
+
+uint16_t shm_doorman::port() const {
+  return port_;
+}
+
+} // namespace caf::io::network
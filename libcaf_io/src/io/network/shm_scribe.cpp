@@ -0,0 +1,131 @@
+// This file is part of CAF, the C++ Actor Framework. See the file LICENSE in
+// the main distribution directory for license terms and copyright or visit
+// https://github.com/actor-framework/actor-framework/blob/master/LICENSE.
+
+#include "caf/io/network/shm_scribe.hpp"
+
+#include "caf/logger.hpp"
+
+#include "caf/io/network/default_multiplexer.hpp"
+
+namespace caf::io::network {
+
+// -- shm_stream ---------------------------------------------------------------
+
+shm_stream::shm_stream(default_multiplexer& mpx, native_socket sockfd,
+                       shm_segment_ptr seg, bool is_creator)
+  : stream(mpx, sockfd),
+    policy_(std::move(seg), is_creator),
+    write_suspended_(false) {
+  // nop
+}
+
+void shm_stream::handle_event(operation op) {
+  CAF_LOG_TRACE(CAF_ARG(op));
+  handle_event_impl(op, policy_);
+  switch (op) {
+    case operation::read:
+      // Reading drains the doorbells, including the ones for free space.
+      if (write_suspended_ && policy_.unblock())
+        resume_writing();
+      break;
+    case operation::write:
+      if (!write_suspended_ && policy_.blocked()) {
+        CAF_LOG_DEBUG("output ring is full:" << CAF_ARG(fd()));
+        write_suspended_ = true;
+        backend().del(operation::write, fd(), this);
+      }
+      break;
+    case operation::propagate_error:
+      break;
+  }
+}
+
+void shm_stream::removed_from_loop(operation op) {
+  CAF_LOG_TRACE(CAF_ARG(op));
+  if (op == operation::write && write_suspended_)
+    return;
+  if (op == operation::read && write_suspended_) {
+    // Without reading, we never learn about free space in the output ring.
+    write_suspended_ = false;
+    stream::removed_from_loop(operation::write);
+  }
+  stream::removed_from_loop(op);
+}
+
+void shm_stream::resume_writing() {
+  CAF_LOG_TRACE(CAF_ARG(fd()));
+  write_suspended_ = false;
+  backend().add(operation::write, fd(), this);
+}
+
+// -- shm_scribe ---------------------------------------------------------------
+
+shm_scribe::shm_scribe(default_multiplexer& mpx, native_socket sockfd,
+                       shm_segment_ptr seg, bool is_creator, uint16_t port)
+  : scribe(network::conn_hdl_from_socket(sockfd)),
+    launched_(false),
+    port_(port),
+    stream_(mpx, sockfd, std::move(seg), is_creator) {
+  // nop
+}
+
+void shm_scribe::configure_read(receive_policy::config config) {
+  CAF_LOG_TRACE("");
+  stream_.configure_read(config);
+  if (!launched_)
+    launch();
+}
+
+void shm_scribe::ack_writes(bool enable) {
+  CAF_LOG_TRACE(CAF_ARG(enable));
+  stream_.ack_writes(enable);
+}
+
+byte_buffer& shm_scribe::wr_buf() {
+  return stream_.wr_buf();
+}
+
+size_t shm_scribe::pending_bytes() const {
+  return stream_.pending_bytes();
+}
+
+byte_buffer& shm_scribe::rd_buf() {
+  return stream_.rd_buf();
+}
+
+void shm_scribe::graceful_shutdown() {
+  CAF_LOG_TRACE("");
+  stream_.graceful_shutdown();
+  detach(&stream_.backend(), false);
+}
+
+void shm_scribe::flush() {
+  CAF_LOG_TRACE("");
+  stream_.flush(this);
+}
+
+std::string shm_scribe::addr() const {
+  return "localhost";
+}
+
+uint16_t shm_scribe::port() const {
+  return port_;
+}
+
+void shm_scribe::launch() {
+  CAF_LOG_TRACE("");
+  CAF_ASSERT(!launched_);
+  launched_ = true;
+  stream_.start(this);
+}
+
+void shm_scribe::add_to_loop() {
+  stream_.activate(this);
+}
+
+void shm_scribe::remove_from_loop() {
+  stream_.passivate();
+}
+
+} // namespace caf::io::network
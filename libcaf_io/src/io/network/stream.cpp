@@ -11,9 +11,25 @@
 #include "caf/defaults.hpp"
 #include "caf/io/network/default_multiplexer.hpp"
 #include "caf/logger.hpp"
+#include "caf/telemetry/counter.hpp"
+#include "caf/telemetry/gauge.hpp"
 
 namespace caf::io::network {
 
+namespace {
+
+// Bounds for the capacity of the read buffer in adaptive mode. The buffer
+// always grows beyond the upper bound for frames that require more space.
+constexpr size_t min_rd_capacity = 1024;
+constexpr size_t initial_rd_capacity = 8192;
+constexpr size_t max_rd_capacity = 1024 * 1024;
+
+// Number of consecutive reads that fill less than a quarter of the read buffer
+// before the stream halves the capacity in adaptive mode.
+constexpr size_t shrink_threshold = 16;
+
+} // namespace
+
 stream::stream(default_multiplexer& backend_ref, native_socket sockfd)
   : event_handler(backend_ref, sockfd),
     max_consecutive_reads_(get_or(backend().system().config(),
@@ -21,10 +37,23 @@ stream::stream(default_multiplexer& backend_ref, native_socket sockfd)
                                   defaults::middleman::max_consecutive_reads)),
     read_threshold_(1),
     collected_(0),
+    adaptive_reads_(get_or(backend().system().config(),
+                           "caf.middleman.adaptive-reads",
+                           defaults::middleman::adaptive_reads)),
+    rd_paused_(false),
+    draining_(false),
+    rd_pos_(0),
+    rd_capacity_(initial_rd_capacity),
+    small_reads_(0),
     written_(0) {
   configure_read(receive_policy::at_most(1024));
 }
 
+stream::~stream() {
+  if (metrics_.write_queue != nullptr)
+    metrics_.write_queue->dec(static_cast<int64_t>(reported_write_queue_));
+}
+
 void stream::start(stream_manager* mgr) {
   CAF_ASSERT(mgr != nullptr);
   activate(mgr);
@@ -36,11 +65,29 @@ void stream::activate(stream_manager* mgr) {
     event_handler::activate();
     prepare_next_read();
   }
+  if (adaptive_reads_) {
+    rd_paused_ = false;
+    resume_buffered_reads();
+  }
 }
 
 void stream::configure_read(receive_policy::config config) {
   state_.rd_flag = to_integer(config.first);
   max_ = config.second;
+  if (adaptive_reads_) {
+    // The new policy applies to the next frame when called from `consume`.
+    // Otherwise, we may already have buffered enough data for it.
+    if (!draining_) {
+      prepare_next_read();
+      if (!rd_paused_)
+        resume_buffered_reads();
+    }
+    return;
+  }
+  // Apply the new policy right away unless we have a partial read. Brokers on
+  // the scheduler reconfigure streams after the stream prepared the next read.
+  if (collected_ == 0)
+    prepare_next_read();
 }
 
 void stream::write(const void* buf, size_t num_bytes) {
@@ -59,6 +106,15 @@ void stream::flush(const manager_ptr& mgr) {
     state_.writing = true;
     prepare_next_write();
   }
+  update_write_queue();
+}
+
+void stream::metrics(const connection_metrics& x) {
+  if (metrics_.write_queue != nullptr)
+    metrics_.write_queue->dec(static_cast<int64_t>(reported_write_queue_));
+  reported_write_queue_ = 0;
+  metrics_ = x;
+  update_write_queue();
 }
 
 void stream::removed_from_loop(operation op) {
@@ -95,6 +151,29 @@ void stream::force_empty_write(const manager_ptr& mgr) {
 }
 
 void stream::prepare_next_read() {
+  if (adaptive_reads_) {
+    // Move the remainder of a partial frame to the front.
+    if (rd_pos_ > 0) {
+      auto first = rd_buf_.begin() + static_cast<ptrdiff_t>(rd_pos_);
+      auto last = rd_buf_.begin() + static_cast<ptrdiff_t>(collected_);
+      std::copy(first, last, rd_buf_.begin());
+      collected_ -= rd_pos_;
+      rd_pos_ = 0;
+    }
+    auto flag = static_cast<receive_policy_flag>(state_.rd_flag);
+    auto frame_size = flag == receive_policy_flag::at_most ? size_t{1} : max_;
+    auto size = std::max(rd_capacity_, frame_size);
+    // A paused stream may hold complete frames. Always leave room for reading.
+    if (size <= collected_)
+      size = collected_ + rd_capacity_;
+    if (rd_buf_.size() != size) {
+      rd_buf_.resize(size);
+      if (rd_buf_.capacity() > 2 * size)
+        rd_buf_.shrink_to_fit();
+    }
+    read_threshold_ = std::max(frame_size, collected_);
+    return;
+  }
   collected_ = 0;
   // This cast does nothing, but prevents a weird compiler error on GCC <= 4.9.
   // TODO: remove cast when dropping support for GCC 4.9.
@@ -134,6 +213,69 @@ void stream::prepare_next_write() {
   }
 }
 
+size_t stream::next_frame_size() const noexcept {
+  auto available = collected_ - rd_pos_;
+  switch (static_cast<receive_policy_flag>(state_.rd_flag)) {
+    case receive_policy_flag::exactly:
+      return available >= max_ ? max_ : 0;
+    case receive_policy_flag::at_most:
+      return std::min(available, max_);
+    default: // receive_policy_flag::at_least
+      return available >= max_ ? available : 0;
+  }
+}
+
+bool stream::consume_buffered() {
+  CAF_LOG_TRACE(CAF_ARG(collected_) << CAF_ARG(rd_pos_));
+  // The reader may call configure_read from consume, which changes the size
+  // of the next frame but leaves the buffer alone until we are done.
+  if (rd_paused_) {
+    prepare_next_read();
+    return false;
+  }
+  draining_ = true;
+  auto result = true;
+  for (auto n = next_frame_size(); n > 0 && reader_; n = next_frame_size()) {
+    auto data = rd_buf_.data() + rd_pos_;
+    rd_pos_ += n;
+    if (!reader_->consume(&backend(), data, n)) {
+      rd_paused_ = true;
+      passivate();
+      result = false;
+      break;
+    }
+  }
+  draining_ = false;
+  prepare_next_read();
+  return result;
+}
+
+void stream::resume_buffered_reads() {
+  if (!reader_ || draining_ || next_frame_size() == 0)
+    return;
+  // Waiting for the socket would stall, because the kernel already handed us
+  // the data. The manager owns this stream and keeps it alive.
+  backend().post([this, mgr{reader_}] {
+    if (reader_ == mgr && !rd_paused_ && !draining_)
+      consume_buffered();
+  });
+}
+
+void stream::adapt_rd_capacity(size_t rb, size_t available) {
+  if (rb == available) {
+    // Likely more data waiting in the kernel.
+    rd_capacity_ = std::min(rd_capacity_ * 2, max_rd_capacity);
+    small_reads_ = 0;
+  } else if (rb < rd_capacity_ / 4) {
+    if (++small_reads_ == shrink_threshold) {
+      rd_capacity_ = std::max(rd_capacity_ / 2, min_rd_capacity);
+      small_reads_ = 0;
+    }
+  } else {
+    small_reads_ = 0;
+  }
+}
+
 bool stream::handle_read_result(rw_state read_result, size_t rb) {
   switch (read_result) {
     case rw_state::failure:
@@ -145,6 +287,13 @@ bool stream::handle_read_result(rw_state read_result, size_t rb) {
     case rw_state::success:
       if (rb == 0)
         return false;
+      if (metrics_.bytes_in != nullptr)
+        metrics_.bytes_in->inc(static_cast<int64_t>(rb));
+      if (adaptive_reads_) {
+        adapt_rd_capacity(rb, rd_buf_.size() - collected_);
+        collected_ += rb;
+        return consume_buffered();
+      }
       collected_ += rb;
       if (collected_ >= read_threshold_) {
         auto res = reader_->consume(&backend(), rd_buf_.data(), collected_);
@@ -178,6 +327,10 @@ void stream::handle_write_result(rw_state write_result, size_t wb) {
       // prepare next send (or stop sending)
       if (remaining == 0)
         prepare_next_write();
+      if (metrics_.bytes_out != nullptr) {
+        metrics_.bytes_out->inc(static_cast<int64_t>(wb));
+        update_write_queue();
+      }
       break;
   }
 }
@@ -189,6 +342,15 @@ void stream::handle_error_propagation() {
     writer_->io_failure(&backend(), operation::write);
 }
 
+void stream::update_write_queue() {
+  if (metrics_.write_queue != nullptr) {
+    auto n = pending_bytes();
+    metrics_.write_queue->inc(static_cast<int64_t>(n)
+                              - static_cast<int64_t>(reported_write_queue_));
+    reported_write_queue_ = n;
+  }
+}
+
 void stream::send_fin() {
   CAF_LOG_TRACE(CAF_ARG2("fd", fd_));
   // Shutting down the write channel will cause TCP to send FIN for the
@@ -52,7 +52,10 @@ test_multiplexer::datagram_data::datagram_data(shared_job_queue_type input,
 }
 
 test_multiplexer::test_multiplexer(actor_system* sys)
-  : multiplexer(sys), inline_runnables_(0), servant_ids_(0) {
+  : multiplexer(sys),
+    inline_runnables_(0),
+    max_throughput_(1),
+    servant_ids_(0) {
   CAF_ASSERT(sys != nullptr);
 }
 
@@ -83,6 +86,10 @@ scribe_ptr test_multiplexer::new_scribe(connection_handle hdl) {
     byte_buffer& wr_buf() override {
       return mpx_->output_buffer(hdl());
     }
+    size_t pending_bytes() const override {
+      // Bytes remain pending until the test consumes the output buffer.
+      return mpx_->output_buffer(hdl()).size();
+    }
     byte_buffer& rd_buf() override {
       return mpx_->input_buffer(hdl());
     }
@@ -91,7 +98,7 @@ scribe_ptr test_multiplexer::new_scribe(connection_handle hdl) {
       detach(mpx_, false);
     }
     void flush() override {
-      // nop
+      mpx_->flushes(hdl()).emplace_back(mpx_->output_buffer(hdl()).size());
     }
     std::string addr() const override {
       return "test";
@@ -125,8 +132,10 @@ test_multiplexer::new_tcp_scribe(const std::string& host, uint16_t port) {
   connection_handle hdl;
   { // lifetime scope of guard
     guard_type guard{mx_};
-    auto i = scribes_.find(std::make_pair(host, port));
-    if (i != scribes_.end()) {
+    // Connect to the endpoint in the order the test provided the scribes.
+    auto key = std::make_pair(host, port);
+    auto i = scribes_.lower_bound(key);
+    if (i != scribes_.end() && i->first == key) {
       hdl = i->second;
       scribes_.erase(i);
     } else {
@@ -561,6 +570,11 @@ bool& test_multiplexer::ack_writes(connection_handle hdl) {
   return scribe_data_[hdl].ack_writes;
 }
 
+std::vector<size_t>& test_multiplexer::flushes(connection_handle hdl) {
+  CAF_ASSERT(std::this_thread::get_id() == tid_);
+  return scribe_data_[hdl].flushes;
+}
+
 bool& test_multiplexer::ack_writes(datagram_handle hdl) {
   CAF_ASSERT(std::this_thread::get_id() == tid_);
   return data_for_hdl(hdl)->ack_writes;
@@ -1005,7 +1019,7 @@ void test_multiplexer::exec(resumable_ptr& ptr) {
   CAF_ASSERT(std::this_thread::get_id() == tid_);
   CAF_ASSERT(ptr != nullptr);
   CAF_LOG_TRACE("");
-  switch (ptr->resume(this, 1)) {
+  switch (ptr->resume(this, max_throughput_)) {
     case resumable::resume_later:
       exec_later(ptr.get());
       break;
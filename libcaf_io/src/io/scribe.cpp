@@ -4,6 +4,8 @@
 
 #include "caf/io/scribe.hpp"
 
+#include <algorithm>
+
 #include "caf/logger.hpp"
 
 namespace caf::io {
@@ -16,11 +18,30 @@ scribe::~scribe() {
   CAF_LOG_TRACE("");
 }
 
+bool scribe::slices_rd_buf() const {
+  return false;
+}
+
+void scribe::metrics(const network::connection_metrics&) {
+  // nop
+}
+
+void scribe::data_views(bool enable) {
+  // Keep the message around, because the broker may disable views while
+  // handling it.
+  views_ = enable;
+  if (enable && !view_value_)
+    view_value_ = std::make_unique<mailbox_element>(
+      strong_actor_ptr{}, make_message_id(), mailbox_element::forwarding_stack{},
+      make_message(new_data_view_msg{hdl(), {}}));
+}
+
 message scribe::detach_message() {
   return make_message(connection_closed_msg{hdl()});
 }
 
-bool scribe::consume(execution_unit* ctx, const void*, size_t num_bytes) {
+bool scribe::consume(execution_unit* ctx, const void* data,
+                     size_t num_bytes) {
   CAF_ASSERT(ctx != nullptr);
   CAF_LOG_TRACE(CAF_ARG(num_bytes));
   if (detached())
@@ -29,14 +50,57 @@ bool scribe::consume(execution_unit* ctx, const void*, size_t num_bytes) {
     // the broker to call close_all() while the pollset contained
     // further activities for the broker
     return false;
+  auto& buf = rd_buf();
+  CAF_ASSERT(buf.size() >= num_bytes);
+  if (auto self = parent(); self->scheduled()) {
+    // The broker may change the receive policy while handling the data. Hence,
+    // we stop reading until the broker is done and pass a copy, because the
+    // stream reuses its buffer.
+    auto first = static_cast<const byte*>(data);
+    byte_buffer copy{first, first + num_bytes};
+    message content;
+    if (views_) {
+      // The callback below owns the bytes until the broker is done.
+      content = make_message(
+        new_data_view_msg{hdl(), make_span(copy.data(), copy.size())});
+    } else {
+      content = make_message(new_data_msg{hdl(), std::move(copy)});
+    }
+    auto resume = [self, ptr{intrusive_ptr<scribe>{this}},
+                   copy{std::move(copy)}](execution_unit*) {
+      self->post_to_backend(abstract_broker::backend_event{[ptr] {
+        auto& tokens = ptr->activity_tokens_;
+        if (!ptr->detached() && !ptr->halted_ && (!tokens || *tokens > 0))
+          ptr->add_to_loop();
+      }});
+    };
+    schedule_mailbox_element(hdl(), std::move(content),
+                             abstract_broker::io_event{std::move(resume)});
+    return false;
+  }
   // keep a strong reference to our parent until we leave scope
   // to avoid UB when becoming detached during invocation
   auto guard = parent_;
-  auto& buf = rd_buf();
-  CAF_ASSERT(buf.size() >= num_bytes);
+  if (views_) {
+    // Lend the received bytes to the broker for the duration of the handler.
+    auto& view = view_value_->payload.get_mutable_as<new_data_view_msg>(0);
+    view.buf = make_span(static_cast<const byte*>(data), num_bytes);
+    auto result = invoke_mailbox_element(ctx, *view_value_);
+    view.buf = {};
+    flush();
+    return result;
+  }
+  auto& msg_buf = msg().buf;
+  if (slices_rd_buf()) {
+    // The input buffer may contain further data, hence we copy the slice.
+    auto first = static_cast<const byte*>(data);
+    msg_buf.assign(first, first + num_bytes);
+    auto result = invoke_mailbox_element(ctx);
+    flush();
+    return result;
+  }
   // make sure size is correct, swap into message, and then call client
   buf.resize(num_bytes);
-  auto& msg_buf = msg().buf;
   msg_buf.swap(buf);
   auto result = invoke_mailbox_element(ctx);
   // swap buffer back to stream and implicitly flush wr_buf()
@@ -51,6 +115,25 @@ void scribe::data_transferred(execution_unit* ctx, size_t written,
   if (detached())
     return;
   using transferred_t = data_transferred_msg;
+  if (auto self = parent(); self->scheduled()) {
+    // Staged writes belong to the broker, hence we update them in its context.
+    self->post_io_event(abstract_broker::io_event{
+      [self, ptr{intrusive_ptr<scribe>{this}}, written,
+       remaining](execution_unit* ctx) {
+        auto hdl = ptr->hdl();
+        if (!self->has_servant(hdl, ptr.get()))
+          return;
+        if (auto i = self->staged_writes_.find(hdl);
+            i != self->staged_writes_.end())
+          i->second.in_flight -= std::min(i->second.in_flight, written);
+        mailbox_element tmp{strong_actor_ptr{}, make_message_id(),
+                            mailbox_element::forwarding_stack{},
+                            make_message(transferred_t{hdl, written,
+                                                       remaining})};
+        ptr->invoke_mailbox_element_impl(self, ctx, tmp);
+      }});
+    return;
+  }
   mailbox_element tmp{strong_actor_ptr{}, make_message_id(),
                       mailbox_element::forwarding_stack{},
                       make_message(transferred_t{hdl(), written, remaining})};
@@ -0,0 +1,119 @@
+// This file is part of CAF, the C++ Actor Framework. See the file LICENSE in
+// the main distribution directory for license terms and copyright or visit
+// https://github.com/actor-framework/actor-framework/blob/master/LICENSE.
+
+#include "caf/policy/shm.hpp"
+
+#include "caf/logger.hpp"
+
+#ifdef CAF_WINDOWS
+#  include <winsock2.h>
+#else
+#  include <sys/socket.h>
+#  include <sys/types.h>
+#endif
+
+using caf::io::network::is_error;
+using caf::io::network::native_socket;
+using caf::io::network::no_sigpipe_io_flag;
+using caf::io::network::rw_state;
+
+namespace caf::policy {
+
+shm::shm(io::network::shm_segment_ptr seg, bool is_creator)
+  : segment_(std::move(seg)), blocked_(false), peer_closed_(false) {
+  in_ = segment_->ring(is_creator ? 1 : 0);
+  out_ = segment_->ring(is_creator ? 0 : 1);
+}
+
+rw_state
+shm::read_some(size_t& result, native_socket fd, void* buf, size_t len) {
+  CAF_LOG_TRACE(CAF_ARG(fd) << CAF_ARG(len));
+  result = 0;
+  if (len == 0)
+    return rw_state::success;
+  result = in_.read(buf, len);
+  if (result == 0) {
+    if (in_.corrupted()) {
+      CAF_LOG_ERROR("peer corrupted the input ring" << CAF_ARG(fd));
+      return rw_state::failure;
+    }
+    // Only consume doorbells on an empty ring. Otherwise, we may miss the
+    // shutdown of the peer or a wakeup for our own writes.
+    drain(fd);
+    if (in_.prepare_read_wait()) {
+      // Still empty: sleep until the peer rings the doorbell.
+      if (peer_closed_) {
+        CAF_LOG_DEBUG("peer performed orderly shutdown" << CAF_ARG(fd));
+        return rw_state::failure;
+      }
+      return rw_state::success;
+    }
+    result = in_.read(buf, len);
+  }
+  if (in_.take_waiting_writer())
+    ring_doorbell(fd);
+  return rw_state::success;
+}
+
+rw_state
+shm::write_some(size_t& result, native_socket fd, const void* buf, size_t len) {
+  CAF_LOG_TRACE(CAF_ARG(fd) << CAF_ARG(len));
+  result = 0;
+  if (peer_closed_)
+    return rw_state::failure;
+  if (len == 0)
+    return rw_state::success;
+  result = out_.write(buf, len);
+  if (result == 0) {
+    if (out_.corrupted()) {
+      CAF_LOG_ERROR("peer corrupted the output ring" << CAF_ARG(fd));
+      return rw_state::failure;
+    }
+    if (out_.prepare_write_wait()) {
+      // Still full: the peer rings the doorbell after making space.
+      blocked_ = true;
+      return rw_state::success;
+    }
+    result = out_.write(buf, len);
+  }
+  if (out_.take_waiting_reader())
+    ring_doorbell(fd);
+  return rw_state::success;
+}
+
+bool shm::unblock() noexcept {
+  if (!blocked_)
+    return false;
+  // The doorbell may belong to space we have filled again in the meantime. In
+  // this case, the peer has already cleared the flag and we need to set it
+  // again before going back to sleep.
+  if (out_.free_space() == 0 && out_.prepare_write_wait())
+    return false;
+  blocked_ = false;
+  return true;
+}
+
+void shm::drain(native_socket fd) {
+  char buf[64];
+  for (;;) {
+    auto res = ::recv(fd, reinterpret_cast<io::network::socket_recv_ptr>(buf),
+                      sizeof(buf), no_sigpipe_io_flag);
+    if (res > 0)
+      continue;
+    // recv returns 0 when the peer has performed an orderly shutdown.
+    if (res == 0 || is_error(res, true))
+      peer_closed_ = true;
+    return;
+  }
+}
+
+void shm::ring_doorbell(native_socket fd) {
+  // A full socket buffer means there is already a pending doorbell and any
+  // other error surfaces as failure on the next read.
+  char dummy = 0;
+  ::send(fd, reinterpret_cast<io::network::socket_send_ptr>(&dummy), 1,
+         no_sigpipe_io_flag);
+}
+
+} // namespace caf::policy
@@ -8,6 +8,11 @@
 
 #include "caf/test/dsl.hpp"
 
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
 #include "caf/actor_cast.hpp"
 #include "caf/actor_system.hpp"
 #include "caf/behavior.hpp"
@@ -48,16 +53,16 @@ struct fixture : test_coordinator_fixture<> {
 CAF_TEST_FIXTURE_SCOPE(message_queue_tests, fixture)
 
 CAF_TEST(default construction) {
-  CAF_CHECK_EQUAL(queue.next_id, 0u);
-  CAF_CHECK_EQUAL(queue.next_undelivered, 0u);
-  CAF_CHECK_EQUAL(queue.pending.size(), 0u);
+  CAF_CHECK_EQUAL(queue.next_id.load(), 0u);
+  CAF_CHECK_EQUAL(queue.next_undelivered.load(), 0u);
+  CAF_CHECK_EQUAL(queue.capacity(), io::basp::message_queue::default_capacity);
 }
 
 CAF_TEST(ascending IDs) {
   CAF_CHECK_EQUAL(queue.new_id(), 0u);
   CAF_CHECK_EQUAL(queue.new_id(), 1u);
   CAF_CHECK_EQUAL(queue.new_id(), 2u);
-  CAF_CHECK_EQUAL(queue.next_undelivered, 0u);
+  CAF_CHECK_EQUAL(queue.next_undelivered.load(), 0u);
 }
 
 CAF_TEST(push order 0 - 1 - 2) {
@@ -138,4 +143,56 @@ CAF_TEST(dropping) {
   expect((ok_atom, int), from(self).to(testee).with(_, 2));
 }
 
+CAF_TEST(the queue reuses slots after delivering messages) {
+  auto n = static_cast<int>(queue.capacity()) * 2 + 1;
+  acquire_ids(static_cast<size_t>(n));
+  for (int i = 0; i < n; ++i) {
+    push(i);
+    expect((ok_atom, int), from(self).to(testee).with(_, i));
+  }
+  CAF_CHECK_EQUAL(queue.next_undelivered.load(), static_cast<uint64_t>(n));
+}
+
+CAF_TEST(concurrent pushes preserve the order of IDs) {
+  using namespace std::literals;
+  constexpr size_t num_threads = 4;
+  constexpr size_t num_ids = 10'000;
+  auto received = std::make_shared<std::vector<int>>();
+  auto hdl = sys.spawn<lazy_init>([received] {
+    return behavior{[received](ok_atom, int x) { received->push_back(x); }};
+  });
+  auto dst = actor_cast<strong_actor_ptr>(hdl);
+  io::basp::message_queue q{64};
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < num_threads; ++i)
+    threads.emplace_back([&] {
+      for (;;) {
+        // Threads racing for IDs emulate BASP workers that receive their jobs
+        // in order but finish them in any order.
+        auto id = q.new_id();
+        if (id >= num_ids)
+          return;
+        if (id % 7 == 0)
+          std::this_thread::sleep_for(1us);
+        if (id % 11 == 0) {
+          q.drop(nullptr, id);
+        } else {
+          auto x = static_cast<int>(id);
+          q.push(nullptr, id, dst,
+                 make_mailbox_element(nullptr, make_message_id(), {},
+                                      ok_atom_v, x));
+        }
+      }
+    });
+  for (auto& t : threads)
+    t.join();
+  CAF_CHECK_EQUAL(q.next_undelivered.load(), num_ids);
+  sched.run();
+  std::vector<int> expected;
+  for (size_t id = 0; id < num_ids; ++id)
+    if (id % 11 != 0)
+      expected.push_back(static_cast<int>(id));
+  CAF_CHECK_EQUAL(*received, expected);
+}
+
 CAF_TEST_FIXTURE_SCOPE_END()
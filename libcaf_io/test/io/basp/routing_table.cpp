@@ -0,0 +1,142 @@
+// This file is part of CAF, the C++ Actor Framework. See the file LICENSE in
+// the main distribution directory for license terms and copyright or visit
+// https://github.com/actor-framework/actor-framework/blob/master/LICENSE.
+
+#define CAF_SUITE io.basp.routing_table
+
+#include "caf/io/basp/routing_table.hpp"
+
+#include "caf/test/dsl.hpp"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace caf;
+using namespace caf::io;
+
+namespace {
+
+struct fixture {
+  basp::routing_table tbl{nullptr};
+  node_id mars;
+  node_id pluto;
+  node_id venus;
+  connection_handle mars_hdl = connection_handle::from_int(1);
+  connection_handle pluto_hdl = connection_handle::from_int(2);
+
+  fixture() {
+    mars = unbox(make_node_id(1, "00112233445566778899AABBCCDDEEFF00112233"));
+    pluto = unbox(make_node_id(2, "33221100FFEEDDCCBBAA99887766554433221100"));
+    venus = unbox(make_node_id(3, "AABBCCDDEEFF0011223344556677889900112233"));
+  }
+};
+
+} // namespace
+
+CAF_TEST_FIXTURE_SCOPE(routing_table_tests, fixture)
+
+CAF_TEST(direct routes) {
+  CAF_CHECK_EQUAL(tbl.lookup(mars), none);
+  tbl.add_direct(mars_hdl, mars);
+  CAF_CHECK_EQUAL(tbl.lookup_direct(mars_hdl), mars);
+  CAF_CHECK_EQUAL(tbl.lookup_direct(mars), mars_hdl);
+  if (auto route = tbl.lookup(mars)) {
+    CAF_CHECK_EQUAL(route->next_hop, mars);
+    CAF_CHECK_EQUAL(route->hdl, mars_hdl);
+  } else {
+    CAF_FAIL("no route to mars");
+  }
+  CAF_CHECK_EQUAL(tbl.direct_connections(),
+                  std::vector<connection_handle>{mars_hdl});
+  CAF_CHECK_EQUAL(tbl.erase_direct(mars_hdl), mars);
+  CAF_CHECK_EQUAL(tbl.lookup(mars), none);
+  CAF_CHECK_EQUAL(tbl.erase_direct(mars_hdl), node_id{});
+}
+
+CAF_TEST(stripes spread senders over additional connections) {
+  auto hdl2 = connection_handle::from_int(10);
+  auto hdl3 = connection_handle::from_int(11);
+  tbl.add_direct(mars_hdl, mars);
+  CAF_CHECK_EQUAL(tbl.stripe(mars, 42), none);
+  tbl.enable_stripes(mars, 3);
+  CAF_CHECK_EQUAL(tbl.stripe(mars, 3), mars_hdl);
+  CAF_CHECK_EQUAL(tbl.stripe(mars, 4), connection_handle{});
+  CAF_CHECK(tbl.add_stripe(hdl2, mars, 3));
+  CAF_CHECK(tbl.add_stripe(hdl3, mars, 3));
+  CAF_CHECK(!tbl.add_stripe(connection_handle::from_int(12), mars, 3));
+  CAF_CHECK_EQUAL(tbl.stripe(mars, 4), hdl2);
+  CAF_CHECK_EQUAL(tbl.stripe(mars, 5), hdl3);
+  CAF_CHECK_EQUAL(tbl.lookup_direct(hdl2), mars);
+  CAF_CHECK_EQUAL(tbl.stripes(mars),
+                  std::vector<connection_handle>({hdl2, hdl3}));
+  CAF_MESSAGE("losing an additional connection frees its stripe");
+  CAF_CHECK_EQUAL(tbl.erase_direct(hdl2), node_id{});
+  CAF_CHECK_EQUAL(tbl.stripe(mars, 4), connection_handle{});
+  CAF_CHECK_EQUAL(tbl.lookup_direct(mars), mars_hdl);
+  CAF_MESSAGE("losing the direct connection removes all stripes");
+  CAF_CHECK_EQUAL(tbl.erase_direct(mars_hdl), mars);
+  CAF_CHECK_EQUAL(tbl.stripe(mars, 5), none);
+  CAF_CHECK_EQUAL(tbl.lookup_direct(hdl3), node_id{});
+}
+
+CAF_TEST(additional connections may arrive before the direct connection) {
+  auto hdl2 = connection_handle::from_int(10);
+  CAF_CHECK(tbl.add_stripe(hdl2, mars, 2));
+  CAF_CHECK_EQUAL(tbl.lookup(mars), none);
+  CAF_CHECK_EQUAL(tbl.lookup_direct(hdl2), mars);
+  tbl.add_direct(mars_hdl, mars);
+  CAF_CHECK_EQUAL(tbl.stripe(mars, 0), mars_hdl);
+  CAF_CHECK_EQUAL(tbl.stripe(mars, 1), hdl2);
+}
+
+CAF_TEST(indirect routes) {
+  CAF_CHECK(!tbl.add_indirect(mars, venus));
+  tbl.add_direct(mars_hdl, mars);
+  tbl.add_direct(pluto_hdl, pluto);
+  CAF_CHECK(!tbl.add_indirect(mars, pluto));
+  CAF_CHECK(tbl.add_indirect(mars, venus));
+  CAF_CHECK(!tbl.add_indirect(pluto, venus));
+  if (auto route = tbl.lookup(venus)) {
+    CAF_CHECK(route->next_hop == mars || route->next_hop == pluto);
+  } else {
+    CAF_FAIL("no route to venus");
+  }
+  CAF_MESSAGE("erasing a direct route removes it as hop");
+  tbl.erase_direct(mars_hdl);
+  CAF_CHECK_EQUAL(tbl.lookup_indirect(venus), pluto);
+  if (auto route = tbl.lookup(venus))
+    CAF_CHECK_EQUAL(route->hdl, pluto_hdl);
+  else
+    CAF_FAIL("no route to venus");
+  tbl.erase_direct(pluto_hdl);
+  CAF_CHECK_EQUAL(tbl.lookup_indirect(venus), node_id{});
+  CAF_CHECK(!tbl.erase_indirect(venus));
+}
+
+CAF_TEST(readers run concurrently to writers) {
+  tbl.add_direct(mars_hdl, mars);
+  std::atomic<bool> done{false};
+  std::atomic<size_t> failures{0};
+  std::vector<std::thread> readers;
+  for (int i = 0; i < 3; ++i)
+    readers.emplace_back([&] {
+      while (!done) {
+        auto route = tbl.lookup(mars);
+        if (!route || route->hdl != mars_hdl)
+          ++failures;
+        tbl.lookup(pluto);
+        std::this_thread::yield();
+      }
+    });
+  for (int i = 0; i < 100; ++i) {
+    tbl.add_direct(pluto_hdl, pluto);
+    tbl.erase_direct(pluto_hdl);
+  }
+  done = true;
+  for (auto& t : readers)
+    t.join();
+  CAF_CHECK_EQUAL(failures.load(), 0u);
+}
+
+CAF_TEST_FIXTURE_SCOPE_END()
@@ -94,6 +94,7 @@ public:
     : sys(cfg.load<io::middleman, network::test_multiplexer>()
             .set("caf.middleman.enable-automatic-connections", autoconn)
             .set("caf.middleman.workers", size_t{0})
+            .set("caf.middleman.serialize-on-send", true)
             .set("caf.scheduler.policy", autoconn ? "testing" : "stealing")
             .set("caf.logger.inline-output", true)
             .set("caf.logger.console.verbosity", "debug")
@@ -233,15 +234,16 @@ public:
       CAF_FAIL("failed to deserialize header: " << source.get_error());
     byte_buffer payload;
     if (hdr.payload_len > 0) {
-      std::copy(buf.begin() + basp::header_size, buf.end(),
-                std::back_inserter(payload));
+      auto first = buf.begin() + basp::header_size;
+      std::copy(first, first + hdr.payload_len, std::back_inserter(payload));
     }
     return {hdr, std::move(payload)};
   }
 
   void connect_node(node& n, optional<accept_handle> ax = none,
                     actor_id published_actor_id = invalid_actor_id,
-                    const std::set<std::string>& published_actor_ifs = {}) {
+                    const std::set<std::string>& published_actor_ifs = {},
+                    uint8_t handshake_flags = no_flags) {
     auto src = ax ? *ax : ahdl_;
     CAF_MESSAGE("connect remote node "
                 << n.name << ", connection ID = " << n.connection.id()
@@ -252,10 +254,11 @@ public:
     // technically, the server handshake arrives
     // before we send the client handshake
     mock(hdl,
-         {basp::message_type::client_handshake, 0, 0, 0, invalid_actor_id,
-          invalid_actor_id},
+         {basp::message_type::client_handshake, handshake_flags, 0, 0,
+          invalid_actor_id, invalid_actor_id},
          n.id)
-      .receive(hdl, basp::message_type::server_handshake, no_flags, any_vals,
+      .receive(hdl, basp::message_type::server_handshake, handshake_flags,
+               any_vals,
                basp::version, invalid_actor_id, invalid_actor_id, this_node(),
                app_ids, published_actor_id, published_actor_ifs)
       // upon receiving our client handshake, BASP will check
@@ -527,6 +530,297 @@ CAF_TEST(client_handshake_and_dispatch) {
   jupiter().dummy_actor->receive([](int i) { CAF_CHECK_EQUAL(i, 6); });
 }
 
+CAF_TEST(fragmented_messages) {
+  constexpr size_t max_fragment_size = 128;
+  instance().max_fragment_size(max_fragment_size);
+  auto hdl = jupiter().connection;
+  connect_node(jupiter(), none, invalid_actor_id, {},
+               basp::header::fragmentation_flag);
+  auto text = std::string(500, 'x');
+  CAF_MESSAGE("receive a message in fragments");
+  byte_buffer frame;
+  basp::header hdr{basp::message_type::direct_message, 0, 0, 0,
+                   jupiter().dummy_actor->id(), self()->id()};
+  to_buf(frame, hdr, nullptr, std::vector<strong_actor_ptr>{},
+         make_message(text));
+  for (size_t pos = 0; pos < frame.size(); pos += max_fragment_size) {
+    auto n = std::min(max_fragment_size, frame.size() - pos);
+    basp::header fragment_hdr{basp::message_type::fragment,
+                              0,
+                              static_cast<uint32_t>(n),
+                              0,
+                              invalid_actor_id,
+                              invalid_actor_id};
+    byte_buffer buf;
+    to_buf(buf, fragment_hdr, nullptr);
+    buf.insert(buf.end(), frame.begin() + pos, frame.begin() + pos + n);
+    mpx()->virtual_send(hdl, buf);
+  }
+  mock().receive(hdl, basp::message_type::monitor_message, no_flags, any_vals,
+                 no_operation_data, invalid_actor_id,
+                 jupiter().dummy_actor->id(), this_node(), jupiter().id);
+  self()->receive([&](const std::string& x) { CAF_CHECK_EQUAL(x, text); });
+  CAF_MESSAGE("send a message in fragments, followed by a small message");
+  auto proxy = proxies().get(jupiter().id, jupiter().dummy_actor->id());
+  CAF_REQUIRE(proxy != nullptr);
+  self()->send(actor_cast<actor>(proxy), text);
+  self()->send(actor_cast<actor>(proxy), 42);
+  while (mpx()->try_exec_runnable()) {
+    // repeat
+  }
+  byte_buffer reassembled;
+  for (;;) {
+    auto [fragment_hdr, chunk] = read_from_out_buf(hdl);
+    if (fragment_hdr.operation != basp::message_type::fragment) {
+      CAF_MESSAGE("the small message must not overtake the large message");
+      CAF_REQUIRE(!reassembled.empty());
+      CAF_CHECK_EQUAL(fragment_hdr.operation,
+                      basp::message_type::direct_message);
+      binary_deserializer source{mpx(), chunk};
+      std::vector<strong_actor_ptr> stages;
+      message msg;
+      if (!source.apply(stages) || !source.apply(msg))
+        CAF_FAIL("deserialization failed: " << source.get_error());
+      CAF_CHECK_EQUAL(msg.get_as<int32_t>(0), 42);
+      break;
+    }
+    CAF_CHECK_LESS_OR_EQUAL(chunk.size(), max_fragment_size);
+    reassembled.insert(reassembled.end(), chunk.begin(), chunk.end());
+    // Emulate the write acknowledgement of the connection.
+    instance().write_pending(mpx(), hdl);
+  }
+  auto [msg_hdr, payload] = from_buf(reassembled);
+  CAF_CHECK_EQUAL(msg_hdr.operation, basp::message_type::direct_message);
+  CAF_CHECK_EQUAL(msg_hdr.source_actor, self()->id());
+  CAF_CHECK_EQUAL(msg_hdr.dest_actor, jupiter().dummy_actor->id());
+  CAF_CHECK_EQUAL(msg_hdr.payload_len, payload.size());
+  binary_deserializer source{mpx(), payload};
+  std::vector<strong_actor_ptr> stages;
+  message msg;
+  if (!source.apply(stages) || !source.apply(msg))
+    CAF_FAIL("deserialization failed: " << source.get_error());
+  CAF_CHECK_EQUAL(msg.get_as<std::string>(0), text);
+}
+
+CAF_TEST(down_messages_after_fragments) {
+  instance().max_fragment_size(128);
+  auto hdl = jupiter().connection;
+  connect_node(jupiter(), none, invalid_actor_id, {},
+               basp::header::fragmentation_flag);
+  auto proxy = actor_cast<actor>(
+    proxies().get_or_put(jupiter().id, jupiter().dummy_actor->id()));
+  CAF_REQUIRE(proxy != nullptr);
+  mock().receive(hdl, basp::message_type::monitor_message, no_flags, any_vals,
+                 no_operation_data, invalid_actor_id,
+                 jupiter().dummy_actor->id(), this_node(), jupiter().id);
+  self()->send(proxy, std::string(500, 'x'));
+  while (mpx()->try_exec_runnable()) {
+    // repeat
+  }
+  CAF_MESSAGE("the down message of the sender waits for the last fragment");
+  instance().write_down_message(mpx(), hdl, jupiter().id, self()->id(),
+                                make_error(exit_reason::user_shutdown));
+  size_t fragments = 0;
+  for (;;) {
+    auto [hdr, chunk] = read_from_out_buf(hdl);
+    if (hdr.operation != basp::message_type::fragment) {
+      CAF_CHECK_EQUAL(hdr.operation, basp::message_type::down_message);
+      CAF_CHECK_EQUAL(hdr.source_actor, self()->id());
+      break;
+    }
+    ++fragments;
+    // Emulate the write acknowledgement of the connection.
+    instance().write_pending(mpx(), hdl);
+  }
+  CAF_CHECK_GREATER(fragments, 1u);
+}
+
+CAF_TEST(priority_lanes) {
+  instance().priority_lanes(true);
+  auto hdl = jupiter().connection;
+  connect_node(jupiter());
+  auto proxy = actor_cast<actor>(
+    proxies().get_or_put(jupiter().id, jupiter().dummy_actor->id()));
+  CAF_REQUIRE(proxy != nullptr);
+  mock().receive(hdl, basp::message_type::monitor_message, no_flags, any_vals,
+                 no_operation_data, invalid_actor_id,
+                 jupiter().dummy_actor->id(), this_node(), jupiter().id);
+  auto next_message = [&] {
+    auto [hdr, payload] = read_from_out_buf(hdl);
+    CAF_CHECK_EQUAL(hdr.operation, basp::message_type::direct_message);
+    binary_deserializer source{mpx(), payload};
+    std::vector<strong_actor_ptr> stages;
+    message msg;
+    if (!source.apply(stages) || !source.apply(msg))
+      CAF_FAIL("deserialization failed: " << source.get_error());
+    return msg;
+  };
+  CAF_MESSAGE("fill the write buffer beyond the flush threshold");
+  auto text = std::string(defaults::middleman::flush_threshold + 1, 'x');
+  scoped_actor other{sys};
+  self()->send(proxy, text);
+  self()->send(proxy, text);
+  self()->send<message_priority::high>(proxy, 23);
+  other->send(proxy, 1);
+  other->send<message_priority::high>(proxy, 42);
+  while (mpx()->try_exec_runnable()) {
+    // repeat
+  }
+  CAF_CHECK_EQUAL(next_message().get_as<std::string>(0), text);
+  CAF_CHECK(mpx()->output_buffer(hdl).empty());
+  CAF_MESSAGE("other senders overtake the large message in the bulk lane");
+  instance().write_pending(mpx(), hdl);
+  CAF_CHECK_EQUAL(next_message().get_as<int32_t>(0), 1);
+  CAF_CHECK_EQUAL(next_message().get_as<int32_t>(0), 42);
+  CAF_CHECK_EQUAL(next_message().get_as<std::string>(0), text);
+  CAF_CHECK(mpx()->output_buffer(hdl).empty());
+  CAF_MESSAGE("urgent messages never overtake messages of the same sender");
+  instance().write_pending(mpx(), hdl);
+  CAF_CHECK_EQUAL(next_message().get_as<int32_t>(0), 23);
+}
+
+CAF_TEST(write_buffer_watermarks) {
+  aut()->high_watermark = 1024;
+  aut()->low_watermark = 512;
+  aut()->overflow_policy = detail::flow_gate::reject_messages;
+  auto hdl = jupiter().connection;
+  connect_node(jupiter());
+  auto proxy = actor_cast<actor>(
+    proxies().get_or_put(jupiter().id, jupiter().dummy_actor->id()));
+  CAF_REQUIRE(proxy != nullptr);
+  mock().receive(hdl, basp::message_type::monitor_message, no_flags, any_vals,
+                 no_operation_data, invalid_actor_id,
+                 jupiter().dummy_actor->id(), this_node(), jupiter().id);
+  CAF_MESSAGE("exceed the high watermark");
+  self()->send(proxy, std::string(2048, 'x'));
+  while (mpx()->try_exec_runnable()) {
+    // repeat
+  }
+  CAF_CHECK(!mpx()->output_buffer(hdl).empty());
+  CAF_MESSAGE("the proxy rejects messages while the connection is congested");
+  self()->request(proxy, infinite, 42).receive(
+    [](int32_t) { CAF_FAIL("proxy forwarded a message while congested"); },
+    [](const error& err) {
+      CAF_CHECK_EQUAL(err, sec::outbound_buffer_full);
+    });
+  CAF_MESSAGE("the proxy drops asynchronous messages without an error");
+  auto sender = sys.spawn([proxy](event_based_actor* snd) -> behavior {
+    return {
+      [=](put_atom) {
+        snd->send(proxy, 42);
+        return ok_atom_v;
+      },
+      [](get_atom) { return ok_atom_v; },
+    };
+  });
+  // Any error for the rejected message arrives before the second request.
+  self()->request(sender, infinite, put_atom_v).receive(
+    [](ok_atom) {},
+    [](const error& err) { CAF_FAIL("the sender terminated: " << err); });
+  self()->request(sender, infinite, get_atom_v).receive(
+    [](ok_atom) { CAF_MESSAGE("the sender is still alive"); },
+    [](const error& err) { CAF_FAIL("the sender terminated: " << err); });
+  anon_send_exit(sender, exit_reason::user_shutdown);
+  CAF_MESSAGE("draining the connection releases the proxy");
+  auto n = mpx()->output_buffer(hdl).size();
+  mpx()->output_buffer(hdl).clear();
+  anon_send(actor_cast<actor>(aut()), data_transferred_msg{hdl, n, 0});
+  while (mpx()->try_exec_runnable()) {
+    // repeat
+  }
+  self()->send(proxy, 42);
+  while (mpx()->try_exec_runnable()) {
+    // repeat
+  }
+  auto [hdr, payload] = read_from_out_buf(hdl);
+  CAF_CHECK_EQUAL(hdr.operation, basp::message_type::direct_message);
+}
+
+CAF_TEST(sender_side_serialization) {
+  CAF_REQUIRE(aut()->buffer_pool != nullptr);
+  auto hdl = jupiter().connection;
+  connect_node(jupiter());
+  auto proxy = actor_cast<actor>(
+    proxies().get_or_put(jupiter().id, jupiter().dummy_actor->id()));
+  CAF_REQUIRE(proxy != nullptr);
+  mock().receive(hdl, basp::message_type::monitor_message, no_flags, any_vals,
+                 no_operation_data, invalid_actor_id,
+                 jupiter().dummy_actor->id(), this_node(), jupiter().id);
+  CAF_MESSAGE("proxies hand serialized messages to the broker in order");
+  auto serialization_time
+    = sys.middleman().metric_singletons.serialization_time;
+  auto samples = [serialization_time] {
+    int64_t result = 0;
+    for (auto& bucket : serialization_time->buckets())
+      result += bucket.count.value();
+    return result;
+  };
+  auto samples_before = samples();
+  self()->send(proxy, 1);
+  self()->send(proxy, "two");
+  while (mpx()->try_exec_runnable()) {
+    // repeat
+  }
+  mock().receive(hdl, basp::message_type::direct_message, no_flags, any_vals,
+                 default_operation_data, self()->id(),
+                 jupiter().dummy_actor->id(), std::vector<strong_actor_ptr>{},
+                 make_message(1));
+  mock().receive(hdl, basp::message_type::direct_message, no_flags, any_vals,
+                 default_operation_data, self()->id(),
+                 jupiter().dummy_actor->id(), std::vector<strong_actor_ptr>{},
+                 make_message("two"));
+  CAF_MESSAGE("the broker returns both buffers to the pool");
+  CAF_CHECK_EQUAL(aut()->buffer_pool->size(), 2u);
+  CAF_MESSAGE("only the proxy samples the serialization time");
+  CAF_CHECK_EQUAL(samples(), samples_before + 2);
+}
+
+CAF_TEST(write_coalescing) {
+  auto hdl = jupiter().connection;
+  connect_node(jupiter());
+  auto proxy = actor_cast<actor>(
+    proxies().get_or_put(jupiter().id, jupiter().dummy_actor->id()));
+  CAF_REQUIRE(proxy != nullptr);
+  mock().receive(hdl, basp::message_type::monitor_message, no_flags, any_vals,
+                 no_operation_data, invalid_actor_id,
+                 jupiter().dummy_actor->id(), this_node(), jupiter().id);
+  auto& flushes = mpx()->flushes(hdl);
+  auto& out = mpx()->output_buffer(hdl);
+  mpx()->max_throughput(3);
+  // Sends three messages of equal size that the broker handles in a single
+  // activation and returns the sizes of the output buffer at each flush.
+  auto run = [&] {
+    flushes.clear();
+    out.clear();
+    for (int32_t i = 1; i <= 3; ++i)
+      self()->send(proxy, i);
+    while (mpx()->try_exec_runnable()) {
+      // repeat
+    }
+    return flushes;
+  };
+  aut()->max_flush_delay = timespan{0};
+  CAF_MESSAGE("the broker flushes once per activation");
+  auto coalesced = run();
+  CAF_REQUIRE_EQUAL(coalesced.size(), 1u);
+  CAF_REQUIRE_EQUAL(out.size() % 3, 0u);
+  auto n = out.size() / 3;
+  CAF_CHECK_EQUAL(coalesced.front(), 3 * n);
+  CAF_MESSAGE("the flush threshold forces an early flush");
+  aut()->flush_threshold = n;
+  CAF_CHECK_EQUAL(run(), std::vector<size_t>({n, 2 * n, 3 * n}));
+  aut()->flush_threshold = 2 * n;
+  CAF_CHECK_EQUAL(run(), std::vector<size_t>({2 * n, 3 * n}));
+  CAF_MESSAGE("the maximum flush delay bounds how long data waits");
+  aut()->flush_threshold = defaults::middleman::flush_threshold;
+  aut()->max_flush_delay = timespan{1};
+  CAF_CHECK_EQUAL(run(), std::vector<size_t>({2 * n, 3 * n}));
+  CAF_MESSAGE("a flush threshold of 0 flushes after every message");
+  aut()->flush_threshold = 0;
+  aut()->max_flush_delay = timespan{0};
+  CAF_CHECK_EQUAL(run(), std::vector<size_t>({n, 2 * n, 3 * n}));
+}
+
 CAF_TEST(message_forwarding) {
   // connect two remote nodes
   connect_node(jupiter());
@@ -552,6 +846,20 @@ CAF_TEST(publish_and_connect) {
   connect_node(jupiter(), ax, self()->id());
 }
 
+CAF_TEST(acceptor_closed) {
+  auto ax = accept_handle::from_int(4242);
+  mpx()->provide_acceptor(4242, ax);
+  CAF_REQUIRE_EQUAL(sys.middleman().publish(self(), 4242), 4242);
+  mpx()->flush_runnables();
+  connect_node(jupiter(), ax, self()->id());
+  CAF_CHECK_EQUAL(instance().published_actors().count(4242), 1u);
+  CAF_MESSAGE("the broker removes the actor after a round trip via the queues");
+  anon_send(actor_cast<actor>(aut()), acceptor_closed_msg{ax});
+  mpx()->flush_runnables();
+  CAF_CHECK_EQUAL(instance().published_actors().count(4242), 0u);
+  CAF_CHECK(aut()->closing_acceptors.empty());
+}
+
 CAF_TEST(remote_actor_and_send) {
   constexpr const char* lo = "localhost";
   CAF_MESSAGE("self: " << to_string(self()->address()));
@@ -8,6 +8,7 @@
 
 #include "caf/test/io_dsl.hpp"
 
+#include <algorithm>
 #include <cstdint>
 #include <iostream>
 #include <memory>
@@ -62,7 +63,8 @@ behavior pong(event_based_actor* self, suite_state_ptr ssp) {
   };
 }
 
-behavior peer_fun(broker* self, connection_handle hdl, const actor& buddy) {
+behavior peer_fun(broker* self, connection_handle hdl, const actor& buddy,
+                  bool views) {
   CAF_MESSAGE("peer_fun called");
   CAF_REQUIRE(self != nullptr);
   CAF_REQUIRE(self->subtype() == resumable::io_actor);
@@ -74,12 +76,26 @@ behavior peer_fun(broker* self, connection_handle hdl, const actor& buddy) {
   // Assume exactly one connection.
   CAF_REQUIRE(self->connections().size() == 1);
   self->configure_read(hdl, receive_policy::exactly(sizeof(type_id_t)));
+  self->data_views(hdl, views);
   auto write = [=](type_id_t type) {
     auto& buf = self->wr_buf(hdl);
     auto first = reinterpret_cast<byte*>(&type);
     buf.insert(buf.end(), first, first + sizeof(type_id_t));
     self->flush(hdl);
   };
+  auto dispatch = [=](span<const byte> bytes) {
+    CAF_REQUIRE_EQUAL(bytes.size(), sizeof(type_id_t));
+    type_id_t type = 0;
+    memcpy(&type, bytes.data(), sizeof(type_id_t));
+    static_assert(type_id_v<ping_atom> != type_id_v<pong_atom>);
+    if (type == type_id_v<ping_atom>) {
+      self->send(buddy, ping_atom_v);
+    } else if (type == type_id_v<pong_atom>) {
+      self->send(buddy, pong_atom_v);
+    } else {
+      CAF_FAIL("unexpected message type");
+    }
+  };
   return {
     [=](const connection_closed_msg&) {
       CAF_MESSAGE("received connection_closed_msg");
@@ -87,29 +103,28 @@ behavior peer_fun(broker* self, connection_handle hdl, const actor& buddy) {
     },
     [=](const new_data_msg& msg) {
       CAF_MESSAGE("received new_data_msg");
-      CAF_REQUIRE_EQUAL(msg.buf.size(), sizeof(type_id_t));
-      type_id_t type = 0;
-      memcpy(&type, msg.buf.data(), sizeof(type_id_t));
-      static_assert(type_id_v<ping_atom> != type_id_v<pong_atom>);
-      if (type == type_id_v<ping_atom>) {
-        self->send(buddy, ping_atom_v);
-      } else if (type == type_id_v<pong_atom>) {
-        self->send(buddy, pong_atom_v);
-      } else {
-        CAF_FAIL("unexpected message type");
-      }
+      CAF_REQUIRE(!views);
+      dispatch(msg.buf);
+    },
+    [=](const new_data_view_msg& msg) {
+      CAF_MESSAGE("received new_data_view_msg");
+      CAF_REQUIRE(views);
+      auto copy = msg.retain();
+      CAF_REQUIRE(std::equal(copy.begin(), copy.end(), msg.buf.begin(),
+                             msg.buf.end()));
+      dispatch(msg.buf);
     },
     [=](ping_atom) { write(type_id_v<ping_atom>); },
     [=](pong_atom) { write(type_id_v<pong_atom>); },
   };
 }
 
-behavior peer_acceptor_fun(broker* self, const actor& buddy) {
+behavior peer_acceptor_fun(broker* self, const actor& buddy, bool views) {
   CAF_MESSAGE("peer_acceptor_fun");
   return {
     [=](const new_connection_msg& msg) {
       CAF_MESSAGE("received `new_connection_msg`");
-      self->fork(peer_fun, msg.handle, buddy);
+      self->fork(peer_fun, msg.handle, buddy, views);
       self->quit();
     },
     [=](publish_atom) -> result<uint16_t> {
@@ -145,13 +160,31 @@ CAF_TEST(test broker to broker communication) {
   CAF_MESSAGE("spawn peer acceptor on mars");
   auto ssp = std::make_shared<suite_state>();
   auto server = mars.mm.spawn_broker(peer_acceptor_fun,
-                                     mars.sys.spawn(pong, ssp));
+                                     mars.sys.spawn(pong, ssp), false);
   mars.self->send(server, publish_atom_v);
   run();
   expect_on(mars, (uint16_t), from(server).to(mars.self).with(8080));
   CAF_MESSAGE("spawn ping and client on earth");
   auto pinger = earth.sys.spawn(ping, ssp);
-  auto client = unbox(earth.mm.spawn_client(peer_fun, "mars", 8080, pinger));
+  auto client = unbox(
+    earth.mm.spawn_client(peer_fun, "mars", 8080, pinger, false));
+  anon_send(pinger, ok_atom_v, client);
+  run();
+  CAF_CHECK_EQUAL(ssp->pings, 10);
+  CAF_CHECK_EQUAL(ssp->pongs, 10);
+}
+
+CAF_TEST(brokers receive data views on request) {
+  prepare_connection(mars, earth, "mars", 8080);
+  auto ssp = std::make_shared<suite_state>();
+  auto server = mars.mm.spawn_broker(peer_acceptor_fun,
+                                     mars.sys.spawn(pong, ssp), true);
+  mars.self->send(server, publish_atom_v);
+  run();
+  expect_on(mars, (uint16_t), from(server).to(mars.self).with(8080));
+  auto pinger = earth.sys.spawn(ping, ssp);
+  auto client = unbox(
+    earth.mm.spawn_client(peer_fun, "mars", 8080, pinger, true));
   anon_send(pinger, ok_atom_v, client);
   run();
   CAF_CHECK_EQUAL(ssp->pings, 10);
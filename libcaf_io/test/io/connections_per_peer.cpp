@@ -0,0 +1,262 @@
+// This file is part of CAF, the C++ Actor Framework. See the file LICENSE in
+// the main distribution directory for license terms and copyright or visit
+// https://github.com/actor-framework/actor-framework/blob/master/LICENSE.
+
+#define CAF_SUITE io.connections_per_peer
+
+#include "caf/test/io_dsl.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <set>
+#include <vector>
+
+#include "caf/all.hpp"
+#include "caf/io/all.hpp"
+
+using namespace caf;
+
+using io::connection_handle;
+
+namespace {
+
+constexpr size_t num_connections = 3;
+
+constexpr int num_pings = 10;
+
+struct config : actor_system_config {
+  config() {
+    load<io::middleman>();
+    set("caf.middleman.connections-per-peer", num_connections);
+    set("caf.middleman.connection-metrics", true);
+    set("caf.middleman.priority-lanes", true);
+  }
+};
+
+struct suite_state {
+  std::vector<int> received;
+};
+
+using suite_state_ptr = std::shared_ptr<suite_state>;
+
+behavior collector(event_based_actor*, suite_state_ptr ssp) {
+  return {
+    [=](int x) { ssp->received.emplace_back(x); },
+  };
+}
+
+struct fixture : point_to_point_fixture<test_coordinator_fixture<config>> {
+  fixture() : ssp(std::make_shared<suite_state>()) {
+    auto acc = next_accept_handle();
+    for (size_t i = 0; i < num_connections; ++i)
+      prepare_connection(mars, earth, "mars", 8080, acc);
+    receiver = mars.sys.spawn(collector, ssp);
+    mars.publish(receiver, 8080);
+  }
+
+  ~fixture() {
+    anon_send_exit(receiver, exit_reason::user_shutdown);
+  }
+
+  static io::basp_broker& broker(planet_type& planet) {
+    auto ptr = actor_cast<abstract_actor*>(planet.bb);
+    return dynamic_cast<io::basp_broker&>(*ptr);
+  }
+
+  static io::basp::routing_table& tbl(planet_type& planet) {
+    return broker(planet).instance.tbl();
+  }
+
+  // Delivers a header that fails to deserialize on `hdl`.
+  void inject_malformed_header(connection_handle hdl) {
+    byte_buffer buf(io::basp::header_size, byte{0xFF});
+    anon_send(earth.bb, io::new_data_msg{hdl, std::move(buf)});
+    run();
+  }
+
+  // Checks that earth dropped all connections to mars and told its observers.
+  void check_all_connections_closed(
+    const std::vector<connection_handle>& hdls) {
+    CAF_CHECK_EQUAL(tbl(earth).lookup_direct(mars.sys.node()), none);
+    CAF_CHECK(tbl(earth).stripes(mars.sys.node()).empty());
+    CAF_CHECK(tbl(earth).direct_connections().empty());
+    for (auto hdl : hdls)
+      CAF_CHECK(earth.mpx.stopped_reading(hdl));
+    auto node_down = false;
+    earth.self->receive(
+      [&](const node_down_msg& x) {
+        CAF_CHECK_EQUAL(x.node, mars.sys.node());
+        CAF_CHECK_EQUAL(x.reason, sec::malformed_basp_message);
+        node_down = true;
+      },
+      after(std::chrono::seconds(0)) >> [] {});
+    CAF_CHECK(node_down);
+  }
+
+  suite_state_ptr ssp;
+  actor receiver;
+};
+
+} // namespace
+
+CAF_TEST_FIXTURE_SCOPE(connections_per_peer_tests, fixture)
+
+CAF_TEST(nodes open additional connections after the handshake) {
+  auto dst = earth.remote_actor("mars", 8080);
+  run();
+  CAF_CHECK_EQUAL(tbl(earth).stripes(mars.sys.node()).size(),
+                  num_connections - 1);
+  CAF_CHECK_EQUAL(tbl(mars).stripes(earth.sys.node()).size(),
+                  num_connections - 1);
+  CAF_CHECK_EQUAL(tbl(earth).direct_connections().size(), num_connections);
+  CAF_MESSAGE("messages from the same sender arrive in order");
+  auto sender = earth.sys.spawn([=](event_based_actor* self) {
+    for (int i = 0; i < num_pings; ++i)
+      self->send(dst, i);
+  });
+  run();
+  anon_send_exit(sender, exit_reason::user_shutdown);
+  std::vector<int> expected;
+  for (int i = 0; i < num_pings; ++i)
+    expected.emplace_back(i);
+  CAF_CHECK_EQUAL(ssp->received, expected);
+}
+
+CAF_TEST(losing the direct connection closes all additional connections) {
+  earth.remote_actor("mars", 8080);
+  run();
+  auto hdl = tbl(earth).lookup_direct(mars.sys.node());
+  CAF_REQUIRE(hdl);
+  anon_send(earth.bb, io::connection_closed_msg{*hdl});
+  run();
+  CAF_CHECK_EQUAL(tbl(earth).lookup_direct(mars.sys.node()), none);
+  CAF_CHECK(tbl(earth).stripes(mars.sys.node()).empty());
+  CAF_CHECK(tbl(earth).direct_connections().empty());
+}
+
+CAF_TEST(losing an additional connection closes all connections) {
+  earth.remote_actor("mars", 8080);
+  run();
+  auto stripes = tbl(earth).stripes(mars.sys.node());
+  CAF_REQUIRE_EQUAL(stripes.size(), num_connections - 1);
+  anon_send(earth.bb, io::connection_closed_msg{stripes.front()});
+  run();
+  CAF_CHECK_EQUAL(tbl(earth).lookup_direct(mars.sys.node()), none);
+  CAF_CHECK(tbl(earth).stripes(mars.sys.node()).empty());
+  CAF_CHECK(tbl(earth).direct_connections().empty());
+}
+
+CAF_TEST(malformed headers on the direct connection close all connections) {
+  earth.remote_actor("mars", 8080);
+  run();
+  earth.self->monitor(mars.sys.node());
+  auto hdls = tbl(earth).direct_connections();
+  auto hdl = tbl(earth).lookup_direct(mars.sys.node());
+  CAF_REQUIRE(hdl);
+  inject_malformed_header(*hdl);
+  check_all_connections_closed(hdls);
+}
+
+CAF_TEST(malformed headers on additional connections close all connections) {
+  earth.remote_actor("mars", 8080);
+  run();
+  earth.self->monitor(mars.sys.node());
+  auto hdls = tbl(earth).direct_connections();
+  auto stripes = tbl(earth).stripes(mars.sys.node());
+  CAF_REQUIRE_EQUAL(stripes.size(), num_connections - 1);
+  inject_malformed_header(stripes.front());
+  check_all_connections_closed(hdls);
+}
+
+CAF_TEST(any congested connection throttles the node) {
+  auto& bb = broker(earth);
+  bb.high_watermark = 1024;
+  bb.low_watermark = 512;
+  earth.remote_actor("mars", 8080);
+  run();
+  auto gate = bb.gates[mars.sys.node()];
+  CAF_REQUIRE(gate != nullptr);
+  auto direct = unbox(tbl(earth).lookup_direct(mars.sys.node()));
+  auto stripe = tbl(earth).stripes(mars.sys.node()).front();
+  auto set_pending = [&](connection_handle hdl, size_t n) {
+    earth.mpx.output_buffer(hdl).resize(n);
+    bb.check_watermarks(hdl);
+  };
+  auto pending_gauge = [&] { return bb.ctx[direct].pending_bytes->value(); };
+  set_pending(direct, 0);
+  CAF_MESSAGE("a congested stripe closes the gate of the node");
+  set_pending(stripe, 2048);
+  CAF_CHECK(!gate->is_open());
+  CAF_CHECK_EQUAL(pending_gauge(), 2048);
+  CAF_MESSAGE("a drained direct connection keeps the gate closed");
+  set_pending(direct, 2048);
+  set_pending(direct, 0);
+  CAF_CHECK(!gate->is_open());
+  CAF_MESSAGE("the pending-bytes gauge sums up all connections");
+  set_pending(direct, 100);
+  CAF_CHECK_EQUAL(pending_gauge(), 2148);
+  CAF_MESSAGE("the gate opens once all connections drained");
+  set_pending(stripe, 0);
+  CAF_CHECK(gate->is_open());
+  CAF_CHECK_EQUAL(pending_gauge(), 100);
+  set_pending(direct, 0);
+}
+
+CAF_TEST(connection metrics describe each connection) {
+  auto& bb = broker(earth);
+  auto dst = earth.remote_actor("mars", 8080);
+  run();
+  auto hdls = tbl(earth).direct_connections();
+  CAF_REQUIRE_EQUAL(hdls.size(), num_connections);
+  std::set<telemetry::int_gauge*> write_queues;
+  std::set<telemetry::int_gauge*> start_times;
+  for (auto hdl : hdls) {
+    auto& metrics = bb.ctx[hdl].metrics;
+    CAF_REQUIRE(metrics.write_queue != nullptr);
+    CAF_REQUIRE(metrics.start_time != nullptr);
+    CAF_CHECK_GREATER(metrics.start_time->value(), 0);
+    write_queues.emplace(metrics.write_queue);
+    start_times.emplace(metrics.start_time);
+  }
+  CAF_CHECK_EQUAL(write_queues.size(), num_connections);
+  CAF_CHECK_EQUAL(start_times.size(), num_connections);
+  CAF_MESSAGE("bytes in the lanes count to the write queue");
+  // Full write buffers force messages into the lanes. We must not exchange
+  // data with mars while the buffers contain garbage.
+  auto lane_limit = std::max(bb.flush_threshold, io::basp::header_size);
+  for (auto hdl : hdls)
+    earth.mpx.output_buffer(hdl).resize(lane_limit);
+  for (int i = 0; i < num_pings; ++i)
+    earth.self->send(dst, i);
+  while (earth.consume_message())
+    ; // repeat
+  int64_t queued = 0;
+  int64_t reported = 0;
+  for (auto hdl : hdls) {
+    queued += static_cast<int64_t>(bb.ctx[hdl].queued_bytes);
+    reported += bb.ctx[hdl].metrics.write_queue->value();
+  }
+  CAF_CHECK_GREATER(queued, 0);
+  CAF_CHECK_EQUAL(reported, queued);
+  CAF_MESSAGE("the write queue shrinks once the lanes drain");
+  for (auto hdl : hdls) {
+    earth.mpx.output_buffer(hdl).clear();
+    anon_send(earth.bb, io::data_transferred_msg{hdl, 0, 0});
+  }
+  run();
+  for (auto hdl : hdls) {
+    CAF_CHECK_EQUAL(bb.ctx[hdl].queued_bytes, 0u);
+    CAF_CHECK_EQUAL(bb.ctx[hdl].metrics.write_queue->value(), 0);
+  }
+  CAF_CHECK_EQUAL(ssp->received.size(), static_cast<size_t>(num_pings));
+  CAF_MESSAGE("closing the connections resets their gauges");
+  auto direct = unbox(tbl(earth).lookup_direct(mars.sys.node()));
+  anon_send(earth.bb, io::connection_closed_msg{direct});
+  run();
+  for (auto ptr : start_times)
+    CAF_CHECK_EQUAL(ptr->value(), 0);
+  for (auto ptr : write_queues)
+    CAF_CHECK_EQUAL(ptr->value(), 0);
+}
+
+CAF_TEST_FIXTURE_SCOPE_END()
@@ -11,15 +11,25 @@
 
 #include "caf/test/io_dsl.hpp"
 
+#include <algorithm>
+#include <cstdio>
+#include <memory>
 #include <sys/socket.h>
 #include <sys/types.h>
+#include <unistd.h>
 
 #include "caf/actor.hpp"
 #include "caf/actor_system.hpp"
 #include "caf/behavior.hpp"
+#include "caf/io/broker.hpp"
 #include "caf/io/network/native_socket.hpp"
 #include "caf/io/network/scribe_impl.hpp"
 #include "caf/scoped_actor.hpp"
+#include "caf/telemetry/counter.hpp"
+#include "caf/telemetry/gauge.hpp"
+#include "caf/telemetry/histogram.hpp"
+#include "caf/telemetry/metric_family_impl.hpp"
+#include "caf/uri.hpp"
 
 using namespace caf;
 
@@ -29,15 +39,29 @@ namespace {
 // coordinator.
 struct node_fixture {
   struct config : actor_system_config {
-    config() {
+    config(const std::string& cache_file, const std::string& execution,
+           bool metrics) {
       load<io::middleman>();
       set("caf.scheduler.policy", "sharing");
       set("caf.scheduler.max-threads", 1);
       set("caf.middleman.workers", 0);
+      set("caf.middleman.broker-execution", execution);
+      set("caf.middleman.connection-metrics", metrics);
+      if (!cache_file.empty()) {
+        set("caf.middleman.pipelined-handshake", true);
+        set("caf.middleman.handshake-cache-file", cache_file);
+      }
     }
   };
 
-  node_fixture() : sys(cfg), mm(sys.middleman()), mpx(mm.backend()), self(sys) {
+  explicit node_fixture(const std::string& cache_file = std::string{},
+                        const std::string& execution = "multiplexer",
+                        bool metrics = false)
+    : cfg(cache_file, execution, metrics),
+      sys(cfg),
+      mm(sys.middleman()),
+      mpx(mm.backend()),
+      self(sys) {
     basp_broker = mm.get_named_broker("BASP");
   }
 
@@ -78,6 +102,43 @@ struct fixture {
   }
 };
 
+struct local_fixture {
+  node_fixture earth;
+  node_fixture mars;
+  std::string path;
+  uri locator;
+
+  local_fixture() {
+    path = "/tmp/caf-io-middleman-" + std::to_string(getpid()) + ".sock";
+    locator = unbox(make_uri("unix://" + path));
+  }
+
+  void check_adder(node_fixture& client, const actor& proxy) {
+    client.self->request(proxy, std::chrono::minutes(1), int32_t{7}, int32_t{8})
+      .receive([](int32_t result) { CAF_CHECK_EQUAL(result, 15); },
+               [](caf::error& err) { CAF_FAIL("request failed: " << err); });
+  }
+};
+
+behavior adder() {
+  return {
+    [](int32_t x, int32_t y) { return x + y; },
+  };
+}
+
+// Responds to `ok_atom` once a message sent via `delayed_io_send` arrives.
+behavior ticker(io::broker* self) {
+  auto rp = std::make_shared<response_promise>();
+  return {
+    [=](ok_atom) {
+      *rp = self->make_response_promise();
+      self->delayed_io_send(std::chrono::milliseconds(1), tick_atom_v);
+      return *rp;
+    },
+    [=](tick_atom) { rp->deliver(ok_atom_v); },
+  };
+}
+
 } // namespace
 
 CAF_TEST_FIXTURE_SCOPE(middleman_tests, fixture)
@@ -102,3 +163,209 @@ CAF_TEST(remote_lookup allows registry lookups on other nodes) {
 }
 
 CAF_TEST_FIXTURE_SCOPE_END()
+
+CAF_TEST_FIXTURE_SCOPE(local_middleman_tests, local_fixture)
+
+CAF_TEST(actors are reachable via Unix domain sockets) {
+  auto testee = earth.sys.spawn(adder);
+  if (auto res = earth.mm.publish(testee, locator); !res)
+    CAF_FAIL("publish failed: " << res.error());
+  auto proxy = unbox(mars.mm.remote_actor(locator));
+  CAF_CHECK_EQUAL(testee->node(), proxy.node());
+  CAF_CHECK_EQUAL(testee->id(), proxy.id());
+  mars.self->request(proxy, std::chrono::minutes(1), int32_t{7}, int32_t{8})
+    .receive([](int32_t result) { CAF_CHECK_EQUAL(result, 15); },
+             [](caf::error& err) { CAF_FAIL("request failed: " << err); });
+  CAF_MESSAGE("unpublishing closes the Unix domain socket");
+  CAF_CHECK(earth.mm.unpublish(testee));
+  CAF_CHECK(!earth.mm.unpublish(testee));
+  anon_send_exit(testee, exit_reason::user_shutdown);
+}
+
+CAF_TEST(pipelined handshakes reuse cached server handshakes) {
+  auto cache_file = path + ".cache";
+  auto testee = earth.sys.spawn(adder);
+  if (auto res = earth.mm.publish(testee, locator); !res)
+    CAF_FAIL("publish failed: " << res.error());
+  CAF_MESSAGE("the first connection performs a regular handshake");
+  {
+    node_fixture venus{cache_file};
+    auto proxy = unbox(venus.mm.remote_actor(locator));
+    check_adder(venus, proxy);
+  }
+  CAF_MESSAGE("later connections skip waiting for the server handshake");
+  {
+    node_fixture venus{cache_file};
+    auto proxy = unbox(venus.mm.remote_actor(locator));
+    CAF_CHECK_EQUAL(testee->node(), proxy.node());
+    CAF_CHECK_EQUAL(testee->id(), proxy.id());
+    check_adder(venus, proxy);
+  }
+  CAF_MESSAGE("publishing another actor refuses pipelined messages");
+  CAF_CHECK(earth.mm.unpublish(testee));
+  auto successor = earth.sys.spawn(adder);
+  if (auto res = earth.mm.publish(successor, locator); !res)
+    CAF_FAIL("publish failed: " << res.error());
+  {
+    node_fixture venus{cache_file};
+    auto proxy = unbox(venus.mm.remote_actor(locator));
+    CAF_CHECK_EQUAL(proxy.id(), testee->id());
+    venus.self->request(proxy, std::chrono::minutes(1), int32_t{7}, int32_t{8})
+      .receive([](int32_t) { CAF_FAIL("stale proxy received a result"); },
+               [](caf::error&) {
+                 // nop
+               });
+  }
+  {
+    node_fixture venus{cache_file};
+    auto proxy = unbox(venus.mm.remote_actor(locator));
+    CAF_CHECK_EQUAL(proxy.id(), successor->id());
+    check_adder(venus, proxy);
+  }
+  CAF_MESSAGE("connecting to a restarted server updates the cache");
+  CAF_CHECK(earth.mm.unpublish(successor));
+  auto other = mars.sys.spawn(adder);
+  if (auto res = mars.mm.publish(other, locator); !res)
+    CAF_FAIL("publish failed: " << res.error());
+  {
+    node_fixture venus{cache_file};
+    auto proxy = unbox(venus.mm.remote_actor(locator));
+    CAF_CHECK_EQUAL(proxy.node(), earth.sys.node());
+    venus.self->request(proxy, std::chrono::minutes(1), int32_t{7}, int32_t{8})
+      .receive([](int32_t) { CAF_FAIL("stale proxy received a result"); },
+               [](caf::error&) {
+                 // nop
+               });
+  }
+  {
+    node_fixture venus{cache_file};
+    auto proxy = unbox(venus.mm.remote_actor(locator));
+    CAF_CHECK_EQUAL(proxy.node(), mars.sys.node());
+    check_adder(venus, proxy);
+  }
+  CAF_CHECK(mars.mm.unpublish(other));
+  anon_send_exit(testee, exit_reason::user_shutdown);
+  anon_send_exit(successor, exit_reason::user_shutdown);
+  anon_send_exit(other, exit_reason::user_shutdown);
+  remove(cache_file.c_str());
+}
+
+CAF_TEST(remote_actor resolves host names asynchronously) {
+  auto testee = earth.sys.spawn(adder);
+  auto port = unbox(earth.mm.publish(testee, 0));
+  auto proxy = unbox(mars.mm.remote_actor("localhost", port));
+  CAF_CHECK_EQUAL(testee->node(), proxy.node());
+  check_adder(mars, proxy);
+  CAF_CHECK(earth.mm.unpublish(testee, port));
+  anon_send_exit(testee, exit_reason::user_shutdown);
+}
+
+CAF_TEST(killed proxies reject requests) {
+  auto testee = earth.sys.spawn(adder);
+  auto port = unbox(earth.mm.publish(testee, 0));
+  auto proxy = unbox(mars.mm.remote_actor("localhost", port));
+  check_adder(mars, proxy);
+  mars.self->monitor(proxy);
+  anon_send_exit(testee, exit_reason::user_shutdown);
+  mars.self->receive([](const down_msg&) {});
+  CAF_MESSAGE("requests fail right away instead of running into a timeout");
+  mars.self->request(proxy, std::chrono::minutes(1), int32_t{1}, int32_t{2})
+    .receive([](int32_t) { CAF_FAIL("killed proxy delivered a request"); },
+             [](caf::error& err) {
+               CAF_CHECK_EQUAL(err, sec::request_receiver_down);
+             });
+}
+
+CAF_TEST(brokers on the scheduler serve remote actors) {
+  node_fixture venus{std::string{}, "scheduler"};
+  node_fixture jupiter{std::string{}, "scheduler"};
+  auto testee = venus.sys.spawn(adder);
+  auto port = unbox(venus.mm.publish(testee, 0));
+  auto proxy = unbox(jupiter.mm.remote_actor("localhost", port));
+  CAF_CHECK_EQUAL(testee->node(), proxy.node());
+  for (int i = 0; i < 10; ++i)
+    check_adder(jupiter, proxy);
+  CAF_MESSAGE("the broker samples the latency on the scheduler only");
+  auto& metrics = venus.mm.metric_singletons;
+  CAF_CHECK_GREATER(metrics.scheduler_broker_latency->sum(), 0.0);
+  CAF_CHECK_EQUAL(metrics.multiplexer_broker_latency->sum(), 0.0);
+  CAF_MESSAGE("plain TCP servers also work with multiplexer-driven clients");
+  auto other = unbox(mars.mm.remote_actor("localhost", port));
+  check_adder(mars, other);
+  CAF_CHECK(venus.mm.unpublish(testee, port));
+  anon_send_exit(testee, exit_reason::user_shutdown);
+}
+
+CAF_TEST(brokers receive delayed messages from the event loop) {
+  node_fixture venus{std::string{}, "scheduler"};
+  for (auto node : {&earth, &venus}) {
+    auto testee = node->mm.spawn_broker(ticker);
+    auto fired = false;
+    node->self->request(testee, std::chrono::minutes(1), ok_atom_v)
+      .receive([&](ok_atom) { fired = true; },
+               [](caf::error& err) { CAF_FAIL("request failed: " << err); });
+    CAF_CHECK(fired);
+    anon_send_exit(testee, exit_reason::user_shutdown);
+  }
+}
+
+CAF_TEST(the middleman collects metrics per connection on request) {
+  node_fixture venus{std::string{}, "multiplexer", true};
+  node_fixture jupiter{std::string{}, "scheduler", true};
+  auto testee = venus.sys.spawn(adder);
+  auto port = unbox(venus.mm.publish(testee, 0));
+  auto proxy = unbox(jupiter.mm.remote_actor("localhost", port));
+  for (int i = 0; i < 10; ++i)
+    check_adder(jupiter, proxy);
+  auto check = [](node_fixture& self, node_fixture& peer) {
+    auto& fs = self.mm.metric_singletons;
+    auto node = to_string(peer.sys.node());
+    auto labels = {telemetry::label_view{"node", node}};
+    CAF_CHECK_GREATER(fs.received_bytes->get_or_add(labels)->value(), 0);
+    CAF_CHECK_GREATER(fs.sent_bytes->get_or_add(labels)->value(), 0);
+    CAF_CHECK_GREATER_OR_EQUAL(fs.received_frames->get_or_add(labels)->value(),
+                               10);
+    CAF_CHECK_GREATER_OR_EQUAL(fs.sent_frames->get_or_add(labels)->value(), 10);
+    CAF_CHECK_GREATER(fs.read_time->get_or_add(labels)->sum(), 0.0);
+    CAF_CHECK_GREATER(fs.write_time->get_or_add(labels)->sum(), 0.0);
+    // Gauges carry the connection as additional label.
+    auto started = 0;
+    auto collector = [&](auto*, const telemetry::metric* instance,
+                         const telemetry::int_gauge* gauge) {
+      auto& xs = instance->labels();
+      auto is_peer = [&](const telemetry::label& x) {
+        return x.name() == "node" && x.value() == node;
+      };
+      if (std::any_of(xs.begin(), xs.end(), is_peer) && gauge->value() > 0)
+        ++started;
+    };
+    fs.connection_start_time->collect(collector);
+    CAF_CHECK_EQUAL(started, 1);
+  };
+  check(venus, jupiter);
+  check(jupiter, venus);
+  CAF_MESSAGE("the middleman samples (de)serialization time per message type");
+  auto types = to_string(make_type_id_list<int32_t, int32_t>());
+  auto labels = {telemetry::label_view{"type", types}};
+  auto& vfs = venus.mm.metric_singletons;
+  CAF_CHECK_GREATER(vfs.deserialization_time_by_type->get_or_add(labels)->sum(),
+                    0.0);
+  auto& jfs = jupiter.mm.metric_singletons;
+  CAF_CHECK_GREATER(jfs.serialization_time_by_type->get_or_add(labels)->sum(),
+                    0.0);
+  CAF_MESSAGE("connection metrics are disabled by default");
+  CAF_CHECK_EQUAL(earth.mm.metric_singletons.received_bytes, nullptr);
+  CAF_CHECK(venus.mm.unpublish(testee, port));
+  anon_send_exit(testee, exit_reason::user_shutdown);
+}
+
+CAF_TEST(Unix domain sockets require URIs with matching scheme) {
+  auto testee = earth.sys.spawn(adder);
+  auto res = earth.mm.publish(testee, unbox(make_uri("tcp://localhost:8080")));
+  CAF_CHECK_EQUAL(res, sec::invalid_argument);
+  CAF_CHECK_EQUAL(mars.mm.remote_actor(unbox(make_uri("unix://foo/bar"))),
+                  sec::invalid_argument);
+  anon_send_exit(testee, exit_reason::user_shutdown);
+}
+
+CAF_TEST_FIXTURE_SCOPE_END()
@@ -20,13 +20,15 @@ struct fixture : point_to_point_fixture<> {
   }
 
   // Connects earth and mars, storing the connection handles in earth_conn and
-  // mars_conn.
-  void connect() {
+  // mars_conn. Returns the proxy for `earth.self` on mars.
+  actor connect() {
     auto acc = next_accept_handle();
     std::tie(earth_conn, mars_conn)
       = prepare_connection(earth, mars, "localhost", 8080, acc);
     CAF_CHECK_EQUAL(earth.publish(actor{earth.self}, 8080), 8080);
-    CAF_CHECK(mars.remote_actor("localhost", 8080));
+    auto proxy = mars.remote_actor("localhost", 8080);
+    CAF_CHECK(proxy);
+    return proxy;
   }
 
   void disconnect() {
@@ -34,6 +36,8 @@ struct fixture : point_to_point_fixture<> {
     earth.handle_io_event();
     anon_send(mars.bb, io::connection_closed_msg{mars_conn});
     mars.handle_io_event();
+    // Observers receive node_down_msg after tearing down all proxies.
+    run();
   }
 
   node_id mars_id;
@@ -55,6 +59,22 @@ CAF_TEST(disconnects cause node_down_msg) {
   CAF_CHECK(earth.self->mailbox().empty());
 }
 
+CAF_TEST(node_down_msg arrives after the down_msg of each proxy) {
+  auto proxy = connect();
+  auto earth_id = earth.sys.node();
+  mars.self->monitor(proxy);
+  mars.self->monitor(earth_id);
+  run();
+  disconnect();
+  expect_on(mars, (down_msg),
+            to(mars.self).with(down_msg{
+              proxy.address(),
+              make_error(exit_reason::remote_link_unreachable)}));
+  expect_on(mars, (node_down_msg),
+            to(mars.self).with(node_down_msg{earth_id, error{}}));
+  CAF_CHECK(mars.self->mailbox().empty());
+}
+
 CAF_TEST(node_down_msg calls the special node_down_handler) {
   connect();
   bool node_down_handler_called = false;
@@ -62,14 +82,13 @@ CAF_TEST(node_down_msg calls the special node_down_handler) {
     self->monitor(mars_id);
     self->set_node_down_handler([&](node_down_msg& dm) {
       CAF_CHECK_EQUAL(dm.node, mars_id);
+      CAF_CHECK_EQUAL(dm.reason, error{});
       node_down_handler_called = true;
     });
     return [] {};
   });
   run();
   disconnect();
-  expect_on(earth, (node_down_msg),
-            to(observer).with(node_down_msg{mars_id, error{}}));
   CAF_CHECK(node_down_handler_called);
 }
 
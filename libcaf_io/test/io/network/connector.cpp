@@ -0,0 +1,147 @@
+// This file is part of CAF, the C++ Actor Framework. See the file LICENSE in
+// the main distribution directory for license terms and copyright or visit
+// https://github.com/actor-framework/actor-framework/blob/master/LICENSE.
+
+#define CAF_SUITE io.network.connector
+
+#include "caf/io/network/connector.hpp"
+
+#include "caf/test/dsl.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <optional>
+
+#include "caf/io/network/default_multiplexer.hpp"
+
+#ifdef CAF_LINUX
+#  include <arpa/inet.h>
+#  include <netinet/in.h>
+#  include <sys/socket.h>
+#endif
+
+using namespace caf;
+using namespace caf::io::network;
+
+namespace {
+
+struct fixture : test_coordinator_fixture<> {
+  default_multiplexer mpx;
+
+  std::optional<expected<native_socket>> result;
+
+  fixture() : mpx(&sys) {
+    // nop
+  }
+
+  ~fixture() {
+    if (result && *result)
+      close_socket(**result);
+  }
+
+  void connect(uint16_t port, const resolver::address_list& addrs,
+               timespan attempt_delay = timespan{250'000'000}) {
+    auto f = [this](expected<native_socket> res) { result = std::move(res); };
+    make_counted<connector>(mpx, "localhost", port, addrs, attempt_delay, f)
+      ->start();
+    // Apply the changes to the event loop as if we were running in it.
+    mpx.handle_internal_events();
+    // The connector uses timers, so a blocking poll eventually returns.
+    for (size_t i = 0; i < 1000 && !result; ++i)
+      mpx.poll_once(true);
+    if (!result)
+      CAF_FAIL("connector did not report a result");
+    // Let canceled attempts clean up.
+    while (mpx.poll_once(false))
+      ; // nop
+  }
+
+  native_socket listen_on(const char* addr) {
+    return unbox(new_tcp_acceptor_impl(0, addr, false));
+  }
+};
+
+} // namespace
+
+CAF_TEST_FIXTURE_SCOPE(connector_tests, fixture)
+
+CAF_TEST(connectors alternate between address families) {
+  resolver::address_list addrs{
+    {"::1", protocol::ipv6},        {"::2", protocol::ipv6},
+    {"::3", protocol::ipv6},        {"10.0.0.1", protocol::ipv4},
+    {"10.0.0.2", protocol::ipv4},
+  };
+  resolver::address_list expected{
+    {"::1", protocol::ipv6}, {"10.0.0.1", protocol::ipv4},
+    {"::2", protocol::ipv6}, {"10.0.0.2", protocol::ipv4},
+    {"::3", protocol::ipv6},
+  };
+  CAF_CHECK_EQUAL(connector::interleave(addrs), expected);
+  CAF_MESSAGE("the first address determines the preferred family");
+  std::rotate(addrs.begin(), addrs.begin() + 3, addrs.end());
+  expected = {
+    {"10.0.0.1", protocol::ipv4}, {"::1", protocol::ipv6},
+    {"10.0.0.2", protocol::ipv4}, {"::2", protocol::ipv6},
+    {"::3", protocol::ipv6},
+  };
+  CAF_CHECK_EQUAL(connector::interleave(addrs), expected);
+}
+
+CAF_TEST(connectors fall back to the next address after a failure) {
+  auto fd = listen_on("127.0.0.1");
+  auto port = unbox(local_port_of_fd(fd));
+  // Nothing listens on ::1 for this port or IPv6 is unavailable. Either way,
+  // the connector must move on to 127.0.0.1 without waiting for the delay.
+  connect(port, {{"::1", protocol::ipv6}, {"127.0.0.1", protocol::ipv4}},
+          timespan{60'000'000'000});
+  if (CAF_CHECK(*result))
+    CAF_CHECK_EQUAL(unbox(remote_addr_of_fd(**result)), "127.0.0.1");
+  close_socket(fd);
+}
+
+CAF_TEST(connectors report an error if all addresses fail) {
+  auto fd = listen_on("127.0.0.1");
+  auto port = unbox(local_port_of_fd(fd));
+  close_socket(fd);
+  connect(port, {{"127.0.0.1", protocol::ipv4}});
+  CAF_CHECK_EQUAL(result->error(), sec::cannot_connect_to_node);
+  CAF_MESSAGE("an empty address list means that the lookup failed");
+  result = std::nullopt;
+  connect(port, {});
+  CAF_CHECK_EQUAL(result->error(), sec::cannot_connect_to_node);
+}
+
+#ifdef CAF_LINUX
+
+CAF_TEST(connectors race the next address after the attempt delay) {
+  // Linux drops SYNs for a listening socket with a full backlog, i.e., any
+  // connect to 127.0.0.1 hangs after filling the backlog with one connection.
+  auto slow = ::socket(AF_INET, SOCK_STREAM, 0);
+  sockaddr_in sa;
+  memset(&sa, 0, sizeof(sa));
+  sa.sin_family = AF_INET;
+  sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  if (bind(slow, reinterpret_cast<sockaddr*>(&sa), sizeof(sa)) != 0
+      || listen(slow, 0) != 0)
+    CAF_FAIL("cannot create listening socket");
+  auto port = unbox(local_port_of_fd(slow));
+  auto filler = unbox(new_tcp_connection("127.0.0.1", port));
+  // Listen on the same port at 127.0.0.2 for the second attempt.
+  auto fast = ::socket(AF_INET, SOCK_STREAM, 0);
+  sa.sin_port = htons(port);
+  sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK + 1);
+  if (bind(fast, reinterpret_cast<sockaddr*>(&sa), sizeof(sa)) != 0
+      || listen(fast, SOMAXCONN) != 0)
+    CAF_FAIL("cannot create listening socket");
+  connect(port, {{"127.0.0.1", protocol::ipv4}, {"127.0.0.2", protocol::ipv4}},
+          timespan{10'000'000});
+  if (CAF_CHECK(*result))
+    CAF_CHECK_EQUAL(unbox(remote_addr_of_fd(**result)), "127.0.0.2");
+  close_socket(fast);
+  close_socket(filler);
+  close_socket(slow);
+}
+
+#endif // CAF_LINUX
+
+CAF_TEST_FIXTURE_SCOPE_END()
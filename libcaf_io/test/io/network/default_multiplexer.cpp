@@ -9,12 +9,21 @@
 #include "caf/test/io_dsl.hpp"
 
 #include <algorithm>
+#include <array>
+#include <fstream>
+#include <string>
+#include <thread>
 #include <vector>
 
 #include "caf/all.hpp"
 #include "caf/io/all.hpp"
 #include "caf/io/network/operation.hpp"
 
+#ifndef CAF_WINDOWS
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif
+
 using namespace caf;
 
 namespace {
@@ -35,6 +44,21 @@ struct sub_fixture : test_coordinator_fixture<> {
   }
 };
 
+struct busy_poll_config : actor_system_config {
+  busy_poll_config() {
+    put(content, "caf.middleman.busy-poll-duration",
+        timespan{60'000'000'000});
+  }
+};
+
+struct busy_poll_fixture : test_coordinator_fixture<busy_poll_config> {
+  io::network::default_multiplexer mpx;
+
+  busy_poll_fixture() : mpx(&sys) {
+    // nop
+  }
+};
+
 struct fixture {
   sub_fixture client;
 
@@ -65,4 +89,158 @@ CAF_TEST(doorman io_failure) {
   CAF_CHECK_EQUAL(server.mpx.num_socket_handlers(), 1u);
 }
 
+CAF_TEST(the multiplexer drains all dispatch requests per wakeup) {
+  auto& mpx = server.mpx;
+  std::array<int64_t, 1> buckets{{1}};
+  auto hist = server.sys.metrics().histogram_singleton(
+    "caf.middleman", "dispatches-per-wakeup", buckets, "");
+  std::vector<int> order;
+  // Only requests from other threads go through the dispatch queue.
+  auto post_from_other_thread = [&](int first, int last) {
+    std::thread t{[&] {
+      for (int i = first; i < last; ++i)
+        mpx.post([&order, i] { order.emplace_back(i); });
+    }};
+    t.join();
+  };
+  post_from_other_thread(0, 10);
+  CAF_MESSAGE("a single wakeup runs all requests in order");
+  CAF_CHECK(mpx.poll_once(false));
+  CAF_CHECK_EQUAL(order, std::vector<int>({0, 1, 2, 3, 4, 5, 6, 7, 8, 9}));
+  CAF_CHECK_EQUAL(hist->sum(), 10);
+  CAF_MESSAGE("the multiplexer blocks the queue after draining it");
+  CAF_CHECK(!mpx.poll_once(false));
+  post_from_other_thread(10, 11);
+  CAF_CHECK(mpx.poll_once(false));
+  CAF_CHECK_EQUAL(order.size(), 11u);
+  CAF_CHECK_EQUAL(hist->sum(), 11);
+}
+
+CAF_TEST(requests from other threads during a wakeup wait for the next poll) {
+  auto& mpx = server.mpx;
+  std::vector<int> order;
+  // Only requests from other threads go through the dispatch queue.
+  auto post_from_other_thread = [&](auto f) {
+    std::thread t{[&] { mpx.post(f); }};
+    t.join();
+  };
+  post_from_other_thread([&] {
+    order.emplace_back(1);
+    post_from_other_thread([&] { order.emplace_back(2); });
+  });
+  CAF_CHECK(mpx.poll_once(false));
+  CAF_CHECK_EQUAL(order, std::vector<int>({1}));
+  CAF_MESSAGE("the multiplexer wakes itself up for the remaining requests");
+  CAF_CHECK(mpx.poll_once(false));
+  CAF_CHECK_EQUAL(order, std::vector<int>({1, 2}));
+  CAF_CHECK(!mpx.poll_once(false));
+}
+
+CAF_TEST(scheduled functions run in the order of their due time) {
+  using std::chrono::steady_clock;
+  auto& mpx = server.mpx;
+  std::vector<int> order;
+  auto t0 = steady_clock::now();
+  mpx.schedule(timespan{200'000}, [&order] { order.emplace_back(1); });
+  mpx.schedule(timespan{1'500'000}, [&order] { order.emplace_back(3); });
+  mpx.schedule(timespan{600'000}, [&order] { order.emplace_back(2); });
+  while (order.size() < 3)
+    mpx.poll_once(true);
+  CAF_CHECK_EQUAL(order, std::vector<int>({1, 2, 3}));
+  CAF_CHECK_GREATER_OR_EQUAL(steady_clock::now() - t0,
+                             std::chrono::microseconds(1500));
+  CAF_MESSAGE("timers do not count as socket handlers");
+  CAF_CHECK_EQUAL(mpx.num_socket_handlers(), 1u);
+}
+
+CAF_TEST_FIXTURE_SCOPE_END()
+
+CAF_TEST_FIXTURE_SCOPE(busy_poll_tests, busy_poll_fixture)
+
+CAF_TEST(busy polling returns as soon as an event arrives) {
+  using std::chrono::steady_clock;
+  auto t0 = steady_clock::now();
+  CAF_MESSAGE("the multiplexer picks up requests from other threads");
+  auto posted = false;
+  std::thread t{[&] {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    mpx.post([&posted] { posted = true; });
+  }};
+  CAF_CHECK(mpx.poll_once(true));
+  t.join();
+  CAF_CHECK(posted);
+  CAF_MESSAGE("the multiplexer runs timeouts while spinning");
+  auto fired = false;
+  mpx.schedule(timespan{10'000'000}, [&fired] { fired = true; });
+  while (!fired)
+    CAF_CHECK(mpx.poll_once(true));
+  CAF_MESSAGE("neither event had to wait for the spin duration to elapse");
+  CAF_CHECK(steady_clock::now() - t0 < std::chrono::seconds(30));
+}
+
+CAF_TEST_FIXTURE_SCOPE_END()
+
+#ifndef CAF_WINDOWS
+
+namespace {
+
+struct local_socket_fixture : sub_fixture {
+  std::string dir;
+
+  std::string path;
+
+  local_socket_fixture() {
+    char tmpl[] = "/tmp/caf-test-XXXXXX";
+    if (mkdtemp(tmpl) == nullptr)
+      CAF_FAIL("mkdtemp failed");
+    dir = tmpl;
+    path = dir + "/socket";
+  }
+
+  ~local_socket_fixture() {
+    unlink(path.c_str());
+    rmdir(dir.c_str());
+  }
+};
+
+} // namespace
+
+CAF_TEST_FIXTURE_SCOPE(local_socket_tests, local_socket_fixture)
+
+CAF_TEST(local acceptors replace stale socket files) {
+  auto fd = unbox(io::network::new_local_acceptor_impl(path));
+  io::network::close_socket(fd);
+  fd = unbox(io::network::new_local_acceptor_impl(path));
+  io::network::close_socket(fd);
+}
+
+CAF_TEST(local acceptors refuse paths in use) {
+  auto fd = unbox(io::network::new_local_acceptor_impl(path));
+  auto res = io::network::new_local_acceptor_impl(path);
+  if (CAF_CHECK(!res))
+    CAF_CHECK_EQUAL(res.error(), sec::cannot_open_port);
+  io::network::close_socket(fd);
+}
+
+CAF_TEST(local acceptors refuse files other than sockets) {
+  std::ofstream{path} << "data";
+  auto res = io::network::new_local_acceptor_impl(path);
+  if (CAF_CHECK(!res))
+    CAF_CHECK_EQUAL(res.error(), sec::cannot_open_port);
+  struct stat st;
+  CAF_CHECK_EQUAL(lstat(path.c_str(), &st), 0);
+}
+
+CAF_TEST(local doormen leave replaced socket files alone) {
+  auto dm = unbox(mpx.new_local_doorman(path));
+  unlink(path.c_str());
+  auto fd = unbox(io::network::new_local_acceptor_impl(path));
+  dm.reset();
+  struct stat st;
+  CAF_CHECK_EQUAL(lstat(path.c_str(), &st), 0);
+  io::network::close_socket(fd);
+}
+
 CAF_TEST_FIXTURE_SCOPE_END()
+
+#endif // CAF_WINDOWS
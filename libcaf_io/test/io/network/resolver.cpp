@@ -0,0 +1,63 @@
+// This file is part of CAF, the C++ Actor Framework. See the file LICENSE in
+// the main distribution directory for license terms and copyright or visit
+// https://github.com/actor-framework/actor-framework/blob/master/LICENSE.
+
+#define CAF_SUITE io.network.resolver
+
+#include "caf/io/network/resolver.hpp"
+
+#include "caf/test/dsl.hpp"
+
+#include <optional>
+
+#include "caf/io/network/default_multiplexer.hpp"
+
+using namespace caf;
+using namespace caf::io::network;
+
+namespace {
+
+struct fixture : test_coordinator_fixture<> {
+  default_multiplexer mpx;
+
+  fixture() : mpx(&sys) {
+    // nop
+  }
+
+  // Resolves `host` and runs the event loop until the callback fires.
+  std::optional<resolver::address_list> resolve(resolver& uut,
+                                                const std::string& host) {
+    std::optional<resolver::address_list> result;
+    uut.resolve(host, [&](const resolver::address_list& xs) { result = xs; });
+    for (size_t i = 0; i < 1000 && !result; ++i)
+      mpx.poll_once(true);
+    return result;
+  }
+};
+
+} // namespace
+
+CAF_TEST_FIXTURE_SCOPE(resolver_tests, fixture)
+
+CAF_TEST(resolvers report failed lookups after stopping) {
+  resolver uut{mpx, 1, timespan{60'000'000'000}};
+  uut.stop();
+  auto result = resolve(uut, "localhost");
+  if (CAF_CHECK(result))
+    CAF_CHECK(result->empty());
+}
+
+CAF_TEST(resolvers drop expired cache entries) {
+  resolver uut{mpx, 1, timespan{0}};
+  if (auto result = resolve(uut, "localhost"); CAF_CHECK(result))
+    CAF_CHECK(!result->empty());
+  CAF_CHECK_EQUAL(uut.cache_size(), 1u);
+  CAF_MESSAGE("the next lookup of another host prunes the cache");
+  // Unlike the parser for IPv4 addresses, getaddrinfo accepts the short form.
+  if (auto result = resolve(uut, "127.1"); CAF_CHECK(result))
+    CAF_CHECK(!result->empty());
+  CAF_CHECK_EQUAL(uut.cache_size(), 1u);
+  uut.stop();
+}
+
+CAF_TEST_FIXTURE_SCOPE_END()
@@ -0,0 +1,235 @@
+// This file is part of CAF, the C++ Actor Framework. See the file LICENSE in
+// the main distribution directory for license terms and copyright or visit
+// https://github.com/actor-framework/actor-framework/blob/master/LICENSE.
+
+#define CAF_SUITE io.network.shared_memory
+
+#include "caf/io/network/shared_memory.hpp"
+
+#include "caf/test/dsl.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <numeric>
+#include <string>
+#include <vector>
+
+#include "caf/policy/shm.hpp"
+
+#ifdef CAF_LINUX
+#  include <sys/socket.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif
+
+using namespace caf;
+using namespace caf::io::network;
+
+#ifdef CAF_LINUX
+
+namespace {
+
+struct fixture {
+  fixture() {
+    seg = unbox(shm_segment::create(4096));
+    // Emulate the peer by mapping the same segment a second time.
+    peer = unbox(shm_segment::attach(dup(seg->fd())));
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0)
+      CAF_FAIL("socketpair failed");
+    nonblocking(fds[0], true);
+    nonblocking(fds[1], true);
+  }
+
+  ~fixture() {
+    close(fds[0]);
+    close(fds[1]);
+  }
+
+  std::vector<uint8_t> bytes(size_t n, uint8_t first = 0) {
+    std::vector<uint8_t> result(n);
+    std::iota(result.begin(), result.end(), first);
+    return result;
+  }
+
+  shm_segment_ptr seg;
+  shm_segment_ptr peer;
+  int fds[2];
+};
+
+} // namespace
+
+CAF_TEST_FIXTURE_SCOPE(shared_memory_tests, fixture)
+
+CAF_TEST(rings transfer bytes between mappings) {
+  auto out = seg->ring(0);
+  auto in = peer->ring(0);
+  CAF_CHECK_EQUAL(out.capacity(), 4096u);
+  auto xs = bytes(100);
+  CAF_CHECK_EQUAL(out.write(xs.data(), xs.size()), 100u);
+  CAF_CHECK_EQUAL(in.size(), 100u);
+  std::vector<uint8_t> ys(100);
+  CAF_CHECK_EQUAL(in.read(ys.data(), ys.size()), 100u);
+  CAF_CHECK_EQUAL(xs, ys);
+  CAF_CHECK_EQUAL(in.size(), 0u);
+  CAF_MESSAGE("the other ring remains empty");
+  CAF_CHECK_EQUAL(seg->ring(1).size(), 0u);
+}
+
+CAF_TEST(rings wrap around and refuse writes when full) {
+  auto out = seg->ring(0);
+  auto in = peer->ring(0);
+  auto xs = bytes(3000);
+  std::vector<uint8_t> ys(3000);
+  CAF_CHECK_EQUAL(out.write(xs.data(), xs.size()), 3000u);
+  CAF_CHECK_EQUAL(in.read(ys.data(), ys.size()), 3000u);
+  xs = bytes(3000, 42);
+  CAF_CHECK_EQUAL(out.write(xs.data(), xs.size()), 3000u);
+  CAF_CHECK_EQUAL(out.free_space(), 1096u);
+  CAF_CHECK_EQUAL(out.write(xs.data(), xs.size()), 1096u);
+  CAF_CHECK_EQUAL(out.write(xs.data(), xs.size()), 0u);
+  CAF_CHECK_EQUAL(in.read(ys.data(), ys.size()), 3000u);
+  CAF_CHECK_EQUAL(xs, ys);
+}
+
+CAF_TEST(waiting readers and writers need a wakeup exactly once) {
+  auto out = seg->ring(0);
+  auto in = peer->ring(0);
+  CAF_MESSAGE("readers start out waiting");
+  CAF_CHECK(out.take_waiting_reader());
+  CAF_CHECK(!out.take_waiting_reader());
+  CAF_CHECK(in.prepare_read_wait());
+  auto xs = bytes(10);
+  out.write(xs.data(), xs.size());
+  CAF_CHECK(out.take_waiting_reader());
+  CAF_CHECK(!out.take_waiting_reader());
+  CAF_MESSAGE("readers do not wait on non-empty rings");
+  CAF_CHECK(!in.prepare_read_wait());
+}
+
+CAF_TEST(rings refuse positions beyond their capacity) {
+  // Emulate a peer that writes arbitrary positions into the header.
+  constexpr size_t capacity = 4096;
+  shm_ring_header hdr{{0}, {0}, {false}, {false}};
+  std::vector<std::byte> data(capacity);
+  shm_ring ring{&hdr, data.data(), capacity};
+  std::vector<uint8_t> buf(3 * capacity, 0xFF);
+  CAF_MESSAGE("readers refuse a tail too far ahead of the head");
+  hdr.tail = 3 * capacity;
+  CAF_CHECK(ring.corrupted());
+  CAF_CHECK_EQUAL(ring.read(buf.data(), buf.size()), 0u);
+  CAF_CHECK_EQUAL(hdr.head.load(), 0u);
+  CAF_CHECK(std::all_of(buf.begin(), buf.end(),
+                        [](uint8_t x) { return x == 0xFF; }));
+  CAF_MESSAGE("writers refuse a head ahead of the tail");
+  hdr.tail = 0;
+  hdr.head = 100;
+  CAF_CHECK(ring.corrupted());
+  CAF_CHECK_EQUAL(ring.free_space(), 0u);
+  CAF_CHECK_EQUAL(ring.write(buf.data(), buf.size()), 0u);
+  CAF_CHECK_EQUAL(hdr.tail.load(), 0u);
+  CAF_MESSAGE("a full ring is not corrupted");
+  hdr.head = 0;
+  hdr.tail = capacity;
+  CAF_CHECK(!ring.corrupted());
+  CAF_CHECK_EQUAL(ring.read(buf.data(), buf.size()), capacity);
+}
+
+CAF_TEST(attaching rejects foreign memory) {
+  auto fd = dup(fds[0]);
+  CAF_CHECK(!shm_segment::attach(fd));
+}
+
+CAF_TEST(segments travel over Unix domain sockets) {
+  CAF_CHECK(send_fd(fds[0], seg->fd()));
+  auto fd = unbox(receive_fd(fds[1], std::chrono::seconds(1)));
+  auto other = unbox(shm_segment::attach(fd));
+  auto xs = bytes(10);
+  seg->ring(0).write(xs.data(), xs.size());
+  CAF_CHECK_EQUAL(other->ring(0).size(), 10u);
+}
+
+CAF_TEST(receiving segments times out) {
+  CAF_CHECK(!receive_fd(fds[1], std::chrono::milliseconds(1)));
+}
+
+CAF_TEST(peers of the same user pass the credentials check) {
+  CAF_CHECK(check_peer_credentials(fds[0]));
+  CAF_CHECK(check_peer_credentials(fds[1]));
+}
+
+CAF_TEST(socket directories must not be accessible by other users) {
+  char tmpl[] = "/tmp/caf-shm-test-XXXXXX";
+  auto dir = std::string{mkdtemp(tmpl)};
+  CAF_CHECK_EQUAL(unbox(shm_socket_dir(dir)), dir);
+  chmod(dir.c_str(), 0755);
+  CAF_CHECK(!shm_socket_dir(dir));
+  rmdir(dir.c_str());
+  CAF_MESSAGE("missing directories are created with mode 0700");
+  CAF_CHECK_EQUAL(unbox(shm_socket_dir(dir)), dir);
+  struct stat st;
+  CAF_REQUIRE_EQUAL(stat(dir.c_str(), &st), 0);
+  CAF_CHECK_EQUAL(st.st_mode & 0777, 0700u);
+  rmdir(dir.c_str());
+}
+
+CAF_TEST(the shm policy rings the doorbell for sleeping readers) {
+  policy::shm creator{seg, true};
+  policy::shm client{peer, false};
+  size_t n = 0;
+  std::vector<uint8_t> buf(100);
+  CAF_MESSAGE("reading from an empty ring puts the client to sleep");
+  CAF_CHECK_EQUAL(client.read_some(n, fds[1], buf.data(), buf.size()),
+                  rw_state::success);
+  CAF_CHECK_EQUAL(n, 0u);
+  CAF_MESSAGE("writing wakes up the client");
+  auto xs = bytes(10);
+  CAF_CHECK_EQUAL(creator.write_some(n, fds[0], xs.data(), xs.size()),
+                  rw_state::success);
+  CAF_CHECK_EQUAL(n, 10u);
+  char doorbell;
+  CAF_CHECK_EQUAL(recv(fds[1], &doorbell, 1, MSG_PEEK), 1);
+  CAF_CHECK_EQUAL(client.read_some(n, fds[1], buf.data(), buf.size()),
+                  rw_state::success);
+  CAF_CHECK_EQUAL(n, 10u);
+  CAF_MESSAGE("the client reports failure after the creator shuts down");
+  shutdown(fds[0], SHUT_WR);
+  CAF_CHECK_EQUAL(client.read_some(n, fds[1], buf.data(), buf.size()),
+                  rw_state::failure);
+  CAF_CHECK(client.peer_closed());
+}
+
+CAF_TEST(the shm policy blocks on full rings) {
+  policy::shm creator{seg, true};
+  policy::shm client{peer, false};
+  size_t n = 0;
+  auto xs = bytes(5000);
+  CAF_CHECK_EQUAL(creator.write_some(n, fds[0], xs.data(), xs.size()),
+                  rw_state::success);
+  CAF_CHECK_EQUAL(n, 4096u);
+  CAF_CHECK_EQUAL(creator.write_some(n, fds[0], xs.data(), xs.size()),
+                  rw_state::success);
+  CAF_CHECK_EQUAL(n, 0u);
+  CAF_CHECK(creator.blocked());
+  CAF_CHECK(!creator.unblock());
+  std::vector<uint8_t> buf(100);
+  CAF_CHECK_EQUAL(client.read_some(n, fds[1], buf.data(), buf.size()),
+                  rw_state::success);
+  CAF_CHECK_EQUAL(n, 100u);
+  CAF_MESSAGE("reading wakes up the creator");
+  char doorbell;
+  CAF_CHECK_EQUAL(recv(fds[0], &doorbell, 1, MSG_PEEK), 1);
+  CAF_CHECK(creator.unblock());
+  CAF_CHECK(!creator.blocked());
+}
+
+CAF_TEST_FIXTURE_SCOPE_END()
+
+#else // CAF_LINUX
+
+CAF_TEST(shared memory requires Linux) {
+  CAF_CHECK(!shm_segment::create(4096));
+}
+
+#endif // CAF_LINUX
@@ -0,0 +1,214 @@
+// This file is part of CAF, the C++ Actor Framework. See the file LICENSE in
+// the main distribution directory for license terms and copyright or visit
+// https://github.com/actor-framework/actor-framework/blob/master/LICENSE.
+
+#define CAF_SUITE io.network.stream
+
+#include "caf/io/network/stream.hpp"
+
+#include "caf/test/dsl.hpp"
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "caf/io/network/default_multiplexer.hpp"
+#include "caf/io/network/stream_impl.hpp"
+#include "caf/io/network/stream_manager.hpp"
+#include "caf/policy/tcp.hpp"
+
+#ifndef CAF_WINDOWS
+#  include <sys/socket.h>
+#endif
+
+using namespace caf;
+using namespace caf::io::network;
+
+namespace {
+
+using string_list = std::vector<std::string>;
+
+// Records all frames and pauses reading after `pause_after` frames.
+class recorder : public io::network::stream_manager {
+public:
+  bool consume(execution_unit*, const void* buf, size_t bsize) override {
+    auto first = static_cast<const char*>(buf);
+    frames.emplace_back(first, first + bsize);
+    if (on_frame)
+      on_frame(frames.back());
+    return frames.size() != pause_after;
+  }
+
+  void data_transferred(execution_unit*, size_t, size_t) override {
+    // nop
+  }
+
+  uint16_t port() const override {
+    return 0;
+  }
+
+  std::string addr() const override {
+    return {};
+  }
+
+  void graceful_shutdown() override {
+    // nop
+  }
+
+  void remove_from_loop() override {
+    // nop
+  }
+
+  void add_to_loop() override {
+    // nop
+  }
+
+  string_list frames;
+
+  size_t pause_after = 0;
+
+  std::function<void(const std::string&)> on_frame;
+
+protected:
+  message detach_message() override {
+    return {};
+  }
+
+  void detach_from(io::abstract_broker*) override {
+    // nop
+  }
+
+  bool attached_to(io::abstract_broker*) override {
+    return false;
+  }
+};
+
+template <bool AdaptiveReads>
+struct config : actor_system_config {
+  config() {
+    put(content, "caf.middleman.adaptive-reads", AdaptiveReads);
+  }
+};
+
+template <bool AdaptiveReads>
+struct fixture : test_coordinator_fixture<config<AdaptiveReads>> {
+  default_multiplexer mpx;
+  native_socket acceptor;
+  native_socket writer;
+  std::unique_ptr<stream_impl<policy::tcp>> reader;
+  intrusive_ptr<recorder> mgr;
+
+  fixture() : mpx(&this->sys) {
+    acceptor = unbox(new_tcp_acceptor_impl(0, "127.0.0.1", false));
+    auto port = unbox(local_port_of_fd(acceptor));
+    writer = unbox(new_tcp_connection("127.0.0.1", port));
+    auto fd = ::accept(acceptor, nullptr, nullptr);
+    if (fd == invalid_native_socket)
+      CAF_FAIL("accept failed");
+    tcp_nodelay(writer, true);
+    reader = std::make_unique<stream_impl<policy::tcp>>(mpx, fd);
+    mgr = make_counted<recorder>();
+  }
+
+  ~fixture() {
+    reader->passivate();
+    mpx.handle_internal_events();
+    close_socket(writer);
+    close_socket(acceptor);
+  }
+
+  void start(io::receive_policy::config cfg) {
+    reader->configure_read(cfg);
+    reader->start(mgr.get());
+    mpx.handle_internal_events();
+  }
+
+  // Sends `str` and runs the event loop until the reader received `n` frames.
+  void send(const std::string& str, size_t n) {
+    size_t offset = 0;
+    for (size_t i = 0; i < 1000 && mgr->frames.size() < n; ++i) {
+      if (offset < str.size()) {
+        size_t written = 0;
+        if (policy::tcp::write_some(written, writer, str.data() + offset,
+                                    str.size() - offset)
+            == rw_state::failure)
+          CAF_FAIL("failed to write to the socket");
+        offset += written;
+      }
+      mpx.poll_once(offset == str.size());
+    }
+    if (mgr->frames.size() < n)
+      CAF_FAIL("reader received " << mgr->frames.size() << " frames, expected "
+                                  << n);
+  }
+};
+
+using adaptive_fixture = fixture<true>;
+
+using plain_fixture = fixture<false>;
+
+} // namespace
+
+CAF_TEST_FIXTURE_SCOPE(plain_stream_tests, plain_fixture)
+
+CAF_TEST(streams apply receive policies changed outside of consume) {
+  // Brokers on the scheduler change the policy after the stream already
+  // prepared the next read.
+  start(io::receive_policy::exactly(4));
+  send("aaaa", 1);
+  reader->configure_read(io::receive_policy::exactly(2));
+  send("bbcc", 3);
+  CAF_CHECK_EQUAL(mgr->frames, string_list({"aaaa", "bb", "cc"}));
+}
+
+CAF_TEST_FIXTURE_SCOPE_END()
+
+CAF_TEST_FIXTURE_SCOPE(adaptive_stream_tests, adaptive_fixture)
+
+CAF_TEST(adaptive streams slice frames out of a single read) {
+  start(io::receive_policy::exactly(4));
+  send("aaaabbbbccccdd", 3);
+  CAF_CHECK_EQUAL(mgr->frames, string_list({"aaaa", "bbbb", "cccc"}));
+  CAF_MESSAGE("partial frames remain in the buffer until complete");
+  send("dd", 4);
+  CAF_CHECK_EQUAL(mgr->frames.back(), "dddd");
+}
+
+CAF_TEST(adaptive streams honor receive policies changed by the reader) {
+  // Each frame starts with six digits for the size of its payload.
+  auto header = true;
+  mgr->on_frame = [&](const std::string& frame) {
+    if (header)
+      reader->configure_read(io::receive_policy::exactly(std::stoul(frame)));
+    else
+      reader->configure_read(io::receive_policy::exactly(6));
+    header = !header;
+  };
+  start(io::receive_policy::exactly(6));
+  send("000003abc000002de000005fghij", 6);
+  CAF_CHECK_EQUAL(mgr->frames, string_list({"000003", "abc", "000002", "de",
+                                            "000005", "fghij"}));
+  CAF_MESSAGE("frames may exceed the current capacity of the buffer");
+  auto large = std::string(100'000, 'x');
+  send("100000" + large + "000001y", 10);
+  CAF_CHECK_EQUAL(mgr->frames[6], "100000");
+  CAF_CHECK(mgr->frames[7] == large);
+  CAF_CHECK_EQUAL(mgr->frames[9], "y");
+}
+
+CAF_TEST(adaptive streams deliver buffered frames after resuming) {
+  mgr->pause_after = 1;
+  start(io::receive_policy::at_most(2));
+  send("aabbcc", 1);
+  CAF_CHECK_EQUAL(mgr->frames, string_list({"aa"}));
+  CAF_MESSAGE("activating the stream again consumes buffered frames");
+  mpx.handle_internal_events();
+  reader->activate(mgr.get());
+  while (mpx.poll_once(false))
+    ; // nop
+  CAF_CHECK_EQUAL(mgr->frames, string_list({"aa", "bb", "cc"}));
+}
+
+CAF_TEST_FIXTURE_SCOPE_END()
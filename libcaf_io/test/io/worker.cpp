@@ -16,6 +16,7 @@
 #include "caf/io/network/test_multiplexer.hpp"
 #include "caf/make_actor.hpp"
 #include "caf/proxy_registry.hpp"
+#include "caf/shared_bytes.hpp"
 
 using namespace caf;
 
@@ -29,6 +30,12 @@ behavior testee_impl() {
   };
 }
 
+behavior collector_impl(event_based_actor*, shared_bytes* out) {
+  return {
+    [out](const shared_bytes& x) { *out = x; },
+  };
+}
+
 struct config : actor_system_config {
   config() {
     test_coordinator_fixture<>::init_config(*this);
@@ -72,13 +79,14 @@ private:
 
 struct fixture : test_coordinator_fixture<config> {
   detail::worker_hub<io::basp::worker> hub;
-  io::basp::message_queue queue;
+  io::basp::message_queue_ptr queue;
   mock_proxy_registry_backend proxies_backend;
   proxy_registry proxies;
   node_id last_hop;
   actor testee;
 
   fixture() : proxies_backend(sys), proxies(sys, proxies_backend) {
+    queue = make_counted<io::basp::message_queue>();
     auto tmp = make_node_id(123, "0011223344556677889900112233445566778899");
     last_hop = unbox(std::move(tmp));
     testee = sys.spawn<lazy_init>(testee_impl);
@@ -98,7 +106,7 @@ CAF_TEST_FIXTURE_SCOPE(worker_tests, fixture)
 CAF_TEST(deliver serialized message) {
   CAF_MESSAGE("create the BASP worker");
   CAF_REQUIRE_EQUAL(hub.peek(), nullptr);
-  hub.add_new_worker(queue, proxies);
+  hub.add_new_worker(proxies);
   CAF_REQUIRE_NOT_EQUAL(hub.peek(), nullptr);
   auto w = hub.pop();
   CAF_MESSAGE("create a fake message + BASP header");
@@ -115,9 +123,37 @@ CAF_TEST(deliver serialized message) {
                        42,
                        testee.id()};
   CAF_MESSAGE("launch worker");
-  w->launch(last_hop, hdr, payload);
+  w->launch(queue, last_hop, hdr, payload);
   sched.run_once();
   expect((ok_atom), from(_).to(testee));
 }
 
+CAF_TEST(shared_bytes in messages alias the payload) {
+  hub.add_new_worker(proxies);
+  auto w = hub.pop();
+  shared_bytes received;
+  auto collector = sys.spawn<lazy_init>(collector_impl, &received);
+  sys.registry().put(collector.id(), collector);
+  byte_buffer payload;
+  std::vector<strong_actor_ptr> stages;
+  binary_serializer sink{sys, payload};
+  auto msg = make_message(shared_bytes{byte_buffer(4096, byte{0x2A})});
+  if (!sink.apply(stages) || !sink.apply(msg))
+    CAF_FAIL("unable to serialize message: " << sink.get_error());
+  auto first = payload.data();
+  auto last = first + payload.size();
+  io::basp::header hdr{io::basp::message_type::direct_message,
+                       0,
+                       static_cast<uint32_t>(payload.size()),
+                       make_message_id().integer_value(),
+                       42,
+                       collector.id()};
+  w->launch(queue, last_hop, hdr, payload);
+  sched.run_once();
+  expect((shared_bytes), from(_).to(collector));
+  CAF_CHECK_EQUAL(received.size(), 4096u);
+  CAF_CHECK(received.data() >= first && received.end() == last);
+  sys.registry().erase(collector.id());
+}
+
 CAF_TEST_FIXTURE_SCOPE_END()
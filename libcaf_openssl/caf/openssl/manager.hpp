@@ -4,12 +4,21 @@
 
 #pragma once
 
+#include <map>
+#include <mutex>
 #include <set>
 #include <string>
 
+#include "caf/config.hpp"
+
+CAF_PUSH_WARNINGS
+#include <openssl/ssl.h>
+CAF_POP_WARNINGS
+
 #include "caf/actor_system.hpp"
 #include "caf/detail/openssl_export.hpp"
 #include "caf/io/middleman_actor.hpp"
+#include "caf/telemetry/counter.hpp"
 
 namespace caf::openssl {
 
@@ -17,6 +26,15 @@ namespace caf::openssl {
 /// credentials for establishing connections.
 class CAF_OPENSSL_EXPORT manager : public actor_system::module {
 public:
+  /// Metrics that the OpenSSL module collects by default.
+  struct metric_singletons_t {
+    /// Counts TLS handshakes that required public-key operations.
+    telemetry::int_counter* full_handshakes = nullptr;
+
+    /// Counts TLS handshakes that resumed a previous session.
+    telemetry::int_counter* resumed_handshakes = nullptr;
+  };
+
   ~manager() override;
 
   void start() override;
@@ -48,6 +66,21 @@ public:
   /// of peers.
   bool authentication_enabled();
 
+  /// Returns the OpenSSL context that all sessions of this manager share.
+  /// Creates the context on first use.
+  /// @throws `runtime_error` if loading certificates or keys fails.
+  SSL_CTX* context();
+
+  /// Prepares `ssl` for resuming the last session with `peer`. Returns whether
+  /// the cache contained a session for `peer`.
+  /// @thread-safe
+  bool resume_session(const std::string& peer, SSL* ssl);
+
+  /// Stores `ptr` for resuming later connections to `peer`, taking ownership
+  /// of `ptr`.
+  /// @thread-safe
+  void cache_session(const std::string& peer, SSL_SESSION* ptr);
+
   /// Adds module-specific options to the config before loading the module.
   static void add_module_options(actor_system_config& cfg);
 
@@ -61,15 +94,29 @@ public:
   /// Adds message types of the OpenSSL module to the global meta object table.
   static void init_global_meta_objects();
 
+  /// Stores metric handles for the OpenSSL module.
+  metric_singletons_t metric_singletons;
+
 private:
   /// Private since instantiation is only allowed via `make`.
   manager(actor_system& sys);
 
+  SSL_CTX* make_context();
+
   /// Reference to the parent.
   actor_system& system_;
 
   /// OpenSSL-aware connection manager.
   io::middleman_actor manager_;
+
+  /// Guards `ctx_` and `sessions_`.
+  std::mutex mtx_;
+
+  /// Shared context for all sessions.
+  SSL_CTX* ctx_;
+
+  /// Stores the last session for each peer, keyed by address and port.
+  std::map<std::string, SSL_SESSION*> sessions_;
 };
 
 } // namespace caf::openssl
@@ -4,7 +4,9 @@
 
 #pragma once
 
+#include <functional>
 #include <memory>
+#include <string>
 
 #include "caf/config.hpp"
 
@@ -14,6 +16,7 @@ CAF_POP_WARNINGS
 
 #include "caf/actor_system.hpp"
 #include "caf/detail/openssl_export.hpp"
+#include "caf/expected.hpp"
 #include "caf/io/network/default_multiplexer.hpp"
 #include "caf/io/network/native_socket.hpp"
 
@@ -26,6 +29,11 @@ CAF_POP_WARNINGS
 #  define CAF_SSL_HAS_ECDH_AUTO
 #endif
 
+#if defined(CAF_LINUX) && defined(SSL_OP_ENABLE_KTLS)                          \
+  && !defined(OPENSSL_NO_KTLS)
+#  define CAF_SSL_HAS_KTLS
+#endif
+
 namespace caf::openssl {
 
 using native_socket = io::network::native_socket;
@@ -34,6 +42,18 @@ using rw_state = io::network::rw_state;
 
 class CAF_OPENSSL_EXPORT session {
 public:
+  /// Outcome of `continue_handshake`.
+  enum class handshake_result {
+    /// The handshake completed successfully.
+    done,
+    /// The handshake waits for the socket to become readable.
+    want_read,
+    /// The handshake waits for the socket to become writable.
+    want_write,
+    /// The handshake failed.
+    failure,
+  };
+
   session(actor_system& sys);
   ~session();
 
@@ -44,23 +64,49 @@ public:
   bool try_connect(native_socket fd);
   bool try_accept(native_socket fd);
 
+  /// Binds this session to `fd` without running the handshake yet.
+  void prepare_handshake(native_socket fd, bool from_accepted_socket);
+
+  /// Runs the handshake until it either completes or needs to wait for the
+  /// socket. Safe to call from any thread as long as no other thread accesses
+  /// this session at the same time.
+  handshake_result continue_handshake();
+
   bool must_read_more(native_socket, size_t threshold);
 
   const char* openssl_passphrase();
 
+  /// Returns whether the kernel encrypts outgoing records of this session.
+  bool ktls_send() const noexcept {
+    return ktls_send_;
+  }
+
+  /// Returns the address and port of the server for client sessions or an
+  /// empty string for server sessions.
+  const std::string& peer() const noexcept {
+    return peer_;
+  }
+
+  /// Returns whether the kernel decrypts incoming records of this session.
+  bool ktls_recv() const noexcept {
+    return ktls_recv_;
+  }
+
 private:
   rw_state do_some(int (*f)(SSL*, void*, int), size_t& result, void* buf,
                    size_t len, const char* debug_name);
-  SSL_CTX* create_ssl_context();
   std::string get_ssl_error();
   bool handle_ssl_result(int ret);
+  void handshake_done();
 
   actor_system& sys_;
   SSL_CTX* ctx_;
   SSL* ssl_;
-  std::string openssl_passphrase_;
+  std::string peer_;
   bool connecting_;
   bool accepting_;
+  bool ktls_send_;
+  bool ktls_recv_;
 };
 
 /// @relates session
@@ -70,4 +116,20 @@ using session_ptr = std::unique_ptr<session>;
 CAF_OPENSSL_EXPORT session_ptr make_session(actor_system& sys, native_socket fd,
                                             bool from_accepted_socket);
 
+/// Receives the result of `async_handshake`.
+/// @relates session
+using handshake_callback = std::function<void(expected<session_ptr>)>;
+
+/// Creates a session for `fd` and runs its handshake without blocking the
+/// event loop of `mpx`. Waits for socket events in the event loop but runs the
+/// handshake itself on scheduler workers unless `caf.openssl.offload-handshakes`
+/// is `false`. Passes the session to `f` from the event loop once the
+/// handshake completed. Closes `fd` if the handshake fails.
+/// @warning Do not call from outside the multiplexer's event loop.
+/// @relates session
+CAF_OPENSSL_EXPORT void async_handshake(io::network::default_multiplexer& mpx,
+                                        native_socket fd,
+                                        bool from_accepted_socket,
+                                        handshake_callback f);
+
 } // namespace caf::openssl
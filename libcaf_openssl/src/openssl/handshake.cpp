@@ -0,0 +1,152 @@
+// This file is part of CAF, the C++ Actor Framework. See the file LICENSE in
+// the main distribution directory for license terms and copyright or visit
+// https://github.com/actor-framework/actor-framework/blob/master/LICENSE.
+
+#include "caf/openssl/session.hpp"
+
+#include "caf/actor_system_config.hpp"
+#include "caf/defaults.hpp"
+#include "caf/logger.hpp"
+#include "caf/scheduler/abstract_coordinator.hpp"
+#include "caf/sec.hpp"
+#include "caf/settings.hpp"
+
+#include "caf/io/network/default_multiplexer.hpp"
+#include "caf/io/network/event_handler.hpp"
+
+namespace caf::openssl {
+
+namespace {
+
+using io::network::operation;
+
+/// Drives the handshake of a single session. Only waits for socket events in
+/// the event loop and runs each handshake step either on a scheduler worker
+/// or in the event loop itself. At most one of the following holds at any
+/// time: the socket is registered for an event, a handshake step runs, or the
+/// multiplexer has a pending call to `resume`. Hence, the session never sees
+/// two threads at once. Destroys itself after reporting the result.
+class handshake : public io::network::event_handler {
+public:
+  using result = session::handshake_result;
+
+  handshake(io::network::default_multiplexer& mpx, native_socket fd,
+            session_ptr ptr, bool offload, handshake_callback f)
+    : event_handler(mpx, fd),
+      session_(std::move(ptr)),
+      offload_(offload),
+      f_(std::move(f)),
+      op_(operation::read),
+      waiting_(false),
+      canceled_(false) {
+    // nop
+  }
+
+  /// Runs the next handshake step and passes its result to `resume` in the
+  /// event loop.
+  void run() {
+    if (!offload_) {
+      resume(session_->continue_handshake());
+      return;
+    }
+    struct job : io::network::multiplexer::runnable {
+      handshake* ptr;
+      explicit job(handshake* ptr) : ptr(ptr) {
+        // nop
+      }
+      resume_result resume(execution_unit*, size_t) override {
+        auto res = ptr->session_->continue_handshake();
+        ptr->backend().post([ptr{ptr}, res] { ptr->resume(res); });
+        return done;
+      }
+    };
+    backend().system().scheduler().enqueue(new job(this));
+  }
+
+  void handle_event(operation) override {
+    CAF_LOG_TRACE(CAF_ARG(fd()));
+    // Stop listening for events while the next step runs.
+    if (!waiting_)
+      return;
+    waiting_ = false;
+    backend().del(op_, fd(), this);
+  }
+
+  void removed_from_loop(operation op) override {
+    if (op != op_)
+      return;
+    // The multiplexer calls this function while it iterates its pending
+    // events, hence we continue from a separate event.
+    backend().post([this] {
+      if (canceled_)
+        finish(make_error(sec::cannot_connect_to_node, "handshake aborted"));
+      else
+        run();
+    });
+  }
+
+  void graceful_shutdown() override {
+    canceled_ = true;
+    if (waiting_) {
+      waiting_ = false;
+      backend().del(op_, fd(), this);
+    }
+  }
+
+private:
+  void resume(result res) {
+    CAF_LOG_TRACE(CAF_ARG(fd()));
+    if (canceled_) {
+      finish(make_error(sec::cannot_connect_to_node, "handshake aborted"));
+      return;
+    }
+    switch (res) {
+      case result::done:
+        fd_ = io::network::invalid_native_socket;
+        finish(std::move(session_));
+        break;
+      case result::want_read:
+      case result::want_write:
+        op_ = res == result::want_read ? operation::read : operation::write;
+        waiting_ = true;
+        backend().add(op_, fd(), this);
+        break;
+      default:
+        finish(make_error(sec::cannot_connect_to_node, "TLS handshake failed"));
+    }
+  }
+
+  void finish(expected<session_ptr> res) {
+    auto f = std::move(f_);
+    // Closes the socket unless the handshake succeeded.
+    delete this;
+    f(std::move(res));
+  }
+
+  session_ptr session_;
+  bool offload_;
+  handshake_callback f_;
+  operation op_;
+  bool waiting_;
+  bool canceled_;
+};
+
+} // namespace
+
+void async_handshake(io::network::default_multiplexer& mpx, native_socket fd,
+                     bool from_accepted_socket, handshake_callback f) {
+  CAF_LOG_TRACE(CAF_ARG(fd) << CAF_ARG(from_accepted_socket));
+  auto& sys = mpx.system();
+  session_ptr ptr{new session(sys)};
+  if (!ptr->init()) {
+    io::network::close_socket(fd);
+    f(make_error(sec::cannot_connect_to_node, "cannot create SSL session"));
+    return;
+  }
+  ptr->prepare_handshake(fd, from_accepted_socket);
+  auto offload = get_or(sys.config(), "caf.openssl.offload-handshakes",
+                        defaults::openssl::offload_handshakes);
+  (new handshake(mpx, fd, std::move(ptr), offload, std::move(f)))->run();
+}
+
+} // namespace caf::openssl
@@ -9,21 +9,26 @@ CAF_PUSH_WARNINGS
 #include <openssl/ssl.h>
 CAF_POP_WARNINGS
 
+#include <cstring>
 #include <mutex>
 #include <vector>
 
 #include "caf/actor_control_block.hpp"
 #include "caf/actor_system.hpp"
 #include "caf/actor_system_config.hpp"
+#include "caf/defaults.hpp"
 #include "caf/expected.hpp"
 #include "caf/raise_error.hpp"
 #include "caf/scoped_actor.hpp"
+#include "caf/settings.hpp"
+#include "caf/telemetry/metric_registry.hpp"
 
 #include "caf/io/basp_broker.hpp"
 #include "caf/io/middleman.hpp"
 #include "caf/io/network/default_multiplexer.hpp"
 
 #include "caf/openssl/middleman_actor.hpp"
+#include "caf/openssl/session.hpp"
 
 #if OPENSSL_VERSION_NUMBER < 0x10100000L
 struct CRYPTO_dynlock_value {
@@ -66,7 +71,46 @@ void dynlock_destroy(CRYPTO_dynlock_value* dynlock, const char*, int) {
 
 namespace caf::openssl {
 
+namespace {
+
+int pem_passwd_cb(char* buf, int size, int, void* ptr) {
+  auto mgr = reinterpret_cast<manager*>(ptr);
+  auto& passphrase = mgr->config().openssl_passphrase;
+  strncpy(buf, passphrase.c_str(), static_cast<size_t>(size));
+  buf[size - 1] = '\0';
+  return static_cast<int>(strlen(buf));
+}
+
+// Stores sessions that the server sent to a client for resuming later
+// connections to the same peer. Servers may send sessions after the handshake,
+// e.g., session tickets in TLS 1.3.
+int new_session_cb(SSL* ssl, SSL_SESSION* ptr) {
+  auto sssn = reinterpret_cast<session*>(SSL_get_app_data(ssl));
+  if (sssn == nullptr || sssn->peer().empty())
+    return 0;
+  auto mgr = reinterpret_cast<manager*>(
+    SSL_CTX_get_app_data(SSL_get_SSL_CTX(ssl)));
+  mgr->cache_session(sssn->peer(), ptr);
+  return 1; // We took ownership of ptr.
+}
+
+manager::metric_singletons_t make_metrics(telemetry::metric_registry& reg) {
+  auto handshakes = reg.counter_family(
+    "caf.openssl", "handshakes", {"type"},
+    "Number of completed TLS handshakes.", "1", true);
+  return manager::metric_singletons_t{
+    handshakes->get_or_add({{"type", "full"}}),
+    handshakes->get_or_add({{"type", "resumed"}}),
+  };
+}
+
+} // namespace
+
 manager::~manager() {
+  for (auto& kvp : sessions_)
+    SSL_SESSION_free(kvp.second);
+  if (ctx_ != nullptr)
+    SSL_CTX_free(ctx_);
 #if OPENSSL_VERSION_NUMBER < 0x10100000L
   std::lock_guard<std::mutex> lock{init_mutex};
   --init_count;
@@ -135,6 +179,37 @@ bool manager::authentication_enabled() {
          || !cfg.openssl_cafile.empty();
 }
 
+SSL_CTX* manager::context() {
+  std::unique_lock<std::mutex> guard{mtx_};
+  if (ctx_ == nullptr)
+    ctx_ = make_context();
+  return ctx_;
+}
+
+bool manager::resume_session(const std::string& peer, SSL* ssl) {
+  std::unique_lock<std::mutex> guard{mtx_};
+  auto i = sessions_.find(peer);
+  if (i == sessions_.end())
+    return false;
+#if OPENSSL_VERSION_NUMBER >= 0x10101000L
+  if (SSL_SESSION_is_resumable(i->second) != 1) {
+    SSL_SESSION_free(i->second);
+    sessions_.erase(i);
+    return false;
+  }
+#endif
+  return SSL_set_session(ssl, i->second) == 1;
+}
+
+void manager::cache_session(const std::string& peer, SSL_SESSION* ptr) {
+  CAF_LOG_TRACE(CAF_ARG(peer));
+  std::unique_lock<std::mutex> guard{mtx_};
+  auto& entry = sessions_[peer];
+  if (entry != nullptr)
+    SSL_SESSION_free(entry);
+  entry = ptr;
+}
+
 void manager::add_module_options(actor_system_config& cfg) {
   config_option_adder(cfg.custom_options(), "caf.openssl")
     .add<std::string>(cfg.openssl_certificate, "certificate",
@@ -148,7 +223,11 @@ void manager::add_module_options(actor_system_config& cfg) {
       "path to an OpenSSL-style directory of trusted certificates")
     .add<std::string>(
       cfg.openssl_cafile, "cafile",
-      "path to a file of concatenated PEM-formatted certificates");
+      "path to a file of concatenated PEM-formatted certificates")
+    .add<bool>("ktls", "offload record encryption to the kernel if available")
+    .add<bool>("offload-handshakes",
+               "run TLS handshakes on scheduler workers instead of the "
+               "multiplexer thread");
 }
 
 actor_system::module* manager::make(actor_system& sys, detail::type_list<>) {
@@ -164,8 +243,96 @@ void manager::init_global_meta_objects() {
   // nop
 }
 
-manager::manager(actor_system& sys) : system_(sys) {
+manager::manager(actor_system& sys)
+  : metric_singletons(make_metrics(sys.metrics())),
+    system_(sys),
+    ctx_(nullptr) {
   // nop
 }
 
+SSL_CTX* manager::make_context() {
+#ifdef CAF_SSL_HAS_NON_VERSIONED_TLS_FUN
+  auto ctx = SSL_CTX_new(TLS_method());
+#else
+  auto ctx = SSL_CTX_new(TLSv1_2_method());
+#endif
+  if (!ctx)
+    CAF_RAISE_ERROR("cannot create OpenSSL context");
+  // Servers resume sessions via stateless session tickets. Clients store the
+  // last session of each peer in `sessions_` via `new_session_cb`.
+  SSL_CTX_set_app_data(ctx, this);
+  SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_BOTH
+                                        | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+  SSL_CTX_sess_set_new_cb(ctx, new_session_cb);
+  const unsigned char sid_ctx[] = "caf";
+  SSL_CTX_set_session_id_context(ctx, sid_ctx, sizeof(sid_ctx) - 1);
+#ifdef CAF_SSL_HAS_KTLS
+  auto ktls = get_or(config(), "caf.openssl.ktls", defaults::openssl::ktls);
+  // OpenSSL silently falls back to user space encryption if the kernel lacks
+  // support for kTLS or for the negotiated cipher.
+  if (ktls)
+    SSL_CTX_set_options(ctx, SSL_OP_ENABLE_KTLS);
+#endif
+  if (authentication_enabled()) {
+    // Require valid certificates on both sides.
+    auto& cfg = config();
+    if (!cfg.openssl_certificate.empty()
+        && SSL_CTX_use_certificate_chain_file(ctx,
+                                              cfg.openssl_certificate.c_str())
+             != 1)
+      CAF_RAISE_ERROR("cannot load certificate");
+    if (!cfg.openssl_passphrase.empty()) {
+      SSL_CTX_set_default_passwd_cb(ctx, pem_passwd_cb);
+      SSL_CTX_set_default_passwd_cb_userdata(ctx, this);
+    }
+    if (!cfg.openssl_key.empty()
+        && SSL_CTX_use_PrivateKey_file(ctx, cfg.openssl_key.c_str(),
+                                       SSL_FILETYPE_PEM)
+             != 1)
+      CAF_RAISE_ERROR("cannot load private key");
+    auto cafile = (!cfg.openssl_cafile.empty() ? cfg.openssl_cafile.c_str()
+                                               : nullptr);
+    auto capath = (!cfg.openssl_capath.empty() ? cfg.openssl_capath.c_str()
+                                               : nullptr);
+    if (cafile || capath) {
+      if (SSL_CTX_load_verify_locations(ctx, cafile, capath) != 1)
+        CAF_RAISE_ERROR("cannot load trusted CA certificates");
+    }
+    SSL_CTX_set_verify(ctx, SSL_VERIFY_PEER | SSL_VERIFY_FAIL_IF_NO_PEER_CERT,
+                       nullptr);
+    if (SSL_CTX_set_cipher_list(ctx, "HIGH:!aNULL:!MD5") != 1)
+      CAF_RAISE_ERROR("cannot set cipher list");
+  } else {
+    // No authentication.
+    SSL_CTX_set_verify(ctx, SSL_VERIFY_NONE, nullptr);
+#if defined(CAF_SSL_HAS_ECDH_AUTO) && (OPENSSL_VERSION_NUMBER < 0x10100000L)
+    SSL_CTX_set_ecdh_auto(ctx, 1);
+#else
+    auto ecdh = EC_KEY_new_by_curve_name(NID_secp384r1);
+    if (!ecdh)
+      CAF_RAISE_ERROR("cannot get ECDH curve");
+    CAF_PUSH_WARNINGS
+    SSL_CTX_set_tmp_ecdh(ctx, ecdh);
+    EC_KEY_free(ecdh);
+    CAF_POP_WARNINGS
+#endif
+#ifdef CAF_SSL_HAS_SECURITY_LEVEL
+    const char* cipher = "AECDH-AES256-SHA@SECLEVEL=0";
+#else
+    const char* cipher = "AECDH-AES256-SHA";
+#endif
+#ifdef CAF_SSL_HAS_KTLS
+    // The kernel only implements AEAD ciphers. Prefer anonymous AES-GCM but
+    // still accept the default cipher from peers without kTLS.
+    if (ktls) {
+      SSL_CTX_set_dh_auto(ctx, 1);
+      cipher = "ADH-AES256-GCM-SHA384:AECDH-AES256-SHA@SECLEVEL=0";
+    }
+#endif
+    if (SSL_CTX_set_cipher_list(ctx, cipher) != 1)
+      CAF_RAISE_ERROR("cannot set anonymous cipher");
+  }
+  return ctx;
+}
+
 } // namespace caf::openssl
@@ -19,7 +19,6 @@
 #include "caf/actor.hpp"
 #include "caf/actor_proxy.hpp"
 #include "caf/actor_system_config.hpp"
-#include "caf/detail/socket_guard.hpp"
 #include "caf/logger.hpp"
 #include "caf/node_id.hpp"
 #include "caf/sec.hpp"
@@ -33,6 +32,7 @@
 #include "caf/io/network/default_multiplexer.hpp"
 #include "caf/io/network/doorman_impl.hpp"
 #include "caf/io/network/interfaces.hpp"
+#include "caf/io/network/local_doorman.hpp"
 #include "caf/io/network/stream_impl.hpp"
 
 #ifdef CAF_WINDOWS
@@ -139,10 +139,22 @@ public:
     return stream_.wr_buf();
   }
 
+  size_t pending_bytes() const override {
+    return stream_.pending_bytes();
+  }
+
   byte_buffer& rd_buf() override {
     return stream_.rd_buf();
   }
 
+  bool slices_rd_buf() const override {
+    return stream_.adaptive_reads();
+  }
+
+  void metrics(const io::network::connection_metrics& x) override {
+    stream_.metrics(x);
+  }
+
   void graceful_shutdown() override {
     CAF_LOG_TRACE("");
     stream_.graceful_shutdown();
@@ -211,21 +223,49 @@ public:
       return false;
     auto& dm = acceptor_.backend();
     auto fd = acceptor_.accepted_socket();
-    detail::socket_guard sguard{fd};
     io::network::nonblocking(fd, true);
-    auto sssn = make_session(parent()->system(), fd, true);
-    if (sssn == nullptr) {
-      CAF_LOG_ERROR("Unable to create SSL session for accepted socket");
-      return false;
-    }
-    auto scrb = make_counted<scribe_impl>(dm, fd, std::move(sssn));
-    sguard.release(); // The scribe claims ownership of the socket.
-    auto hdl = scrb->hdl();
-    parent()->add_scribe(std::move(scrb));
-    return doorman::new_connection(&dm, hdl);
+    // Announce the connection to the broker only after the handshake, which
+    // may run on a scheduler worker.
+    auto f = [ptr{intrusive_ptr<doorman_impl>{this}}, &dm,
+              fd](expected<session_ptr> sssn) {
+      if (!sssn) {
+        CAF_LOG_INFO("TLS handshake with accepted socket failed:"
+                     << sssn.error());
+        return;
+      }
+      if (ptr->detached()) {
+        io::network::close_socket(fd);
+        return;
+      }
+      auto scrb = make_counted<scribe_impl>(dm, fd, std::move(*sssn));
+      auto hdl = scrb->hdl();
+      ptr->parent()->add_scribe(std::move(scrb));
+      ptr->doorman::new_connection(&dm, hdl);
+    };
+    async_handshake(dm, fd, true, std::move(f));
+    return true;
   }
 };
 
+class local_doorman_impl : public doorman_impl {
+public:
+  local_doorman_impl(default_mpx& mx, native_socket sockfd, std::string path)
+    : doorman_impl(mx, sockfd), file_(std::move(path)) {
+    // nop
+  }
+
+  std::string addr() const override {
+    return file_.path();
+  }
+
+  uint16_t port() const override {
+    return 0;
+  }
+
+private:
+  io::network::local_socket_file file_;
+};
+
 class middleman_actor_impl : public io::middleman_actor_impl {
 public:
   middleman_actor_impl(actor_config& cfg, actor default_broker)
@@ -238,10 +278,37 @@ public:
   }
 
 protected:
-  expected<io::scribe_ptr>
-  connect(const std::string& host, uint16_t port) override {
-    CAF_LOG_TRACE(CAF_ARG(host) << CAF_ARG(port));
-    auto fd = io::network::new_tcp_connection(host, port);
+  io::network::multiplexer::scribe_factory tcp_scribe_factory() override {
+    auto mpx = &this->mpx();
+    return [mpx](native_socket fd,
+                 io::network::multiplexer::scribe_callback f) {
+      CAF_LOG_TRACE(CAF_ARG(fd));
+      auto g = [mpx, fd, f{std::move(f)}](expected<session_ptr> sssn) {
+        if (!sssn) {
+          CAF_LOG_ERROR("Unable to create SSL session for connection");
+          f(std::move(sssn.error()));
+          return;
+        }
+        CAF_LOG_DEBUG("successfully created an SSL session for:"
+                      << CAF_ARG(fd));
+        f(make_counted<scribe_impl>(*mpx, fd, std::move(*sssn)));
+      };
+      async_handshake(*mpx, fd, false, std::move(g));
+    };
+  }
+
+  expected<io::doorman_ptr>
+  open(uint16_t port, const char* addr, bool reuse) override {
+    CAF_LOG_TRACE(CAF_ARG(port) << CAF_ARG(reuse));
+    auto fd = io::network::new_tcp_acceptor_impl(port, addr, reuse);
+    if (!fd)
+      return std::move(fd.error());
+    return make_counted<doorman_impl>(mpx(), *fd);
+  }
+
+  expected<io::scribe_ptr> connect_local(const std::string& path) override {
+    CAF_LOG_TRACE(CAF_ARG(path));
+    auto fd = io::network::new_local_connection(path);
     if (!fd)
       return std::move(fd.error());
     io::network::nonblocking(*fd, true);
@@ -250,18 +317,21 @@ protected:
       CAF_LOG_ERROR("Unable to create SSL session for connection");
       return sec::cannot_connect_to_node;
     }
-    CAF_LOG_DEBUG("successfully created an SSL session for:" << CAF_ARG(host)
-                                                             << CAF_ARG(port));
     return make_counted<scribe_impl>(mpx(), *fd, std::move(sssn));
   }
 
-  expected<io::doorman_ptr>
-  open(uint16_t port, const char* addr, bool reuse) override {
-    CAF_LOG_TRACE(CAF_ARG(port) << CAF_ARG(reuse));
-    auto fd = io::network::new_tcp_acceptor_impl(port, addr, reuse);
+  expected<io::doorman_ptr> open_local(const std::string& path) override {
+    CAF_LOG_TRACE(CAF_ARG(path));
+    auto fd = io::network::new_local_acceptor_impl(path);
     if (!fd)
       return std::move(fd.error());
-    return make_counted<doorman_impl>(mpx(), *fd);
+    return make_counted<local_doorman_impl>(mpx(), *fd, path);
+  }
+
+  expected<io::doorman_ptr> open_shm(uint16_t) override {
+    // Shared memory connections would bypass TLS.
+    return make_error(sec::unsupported_operation,
+                      "shared memory transport bypasses TLS");
   }
 
 private:
@@ -9,6 +9,7 @@ CAF_PUSH_WARNINGS
 CAF_POP_WARNINGS
 
 #include "caf/actor_system_config.hpp"
+#include "caf/policy/tcp.hpp"
 
 #include "caf/io/network/default_multiplexer.hpp"
 
@@ -47,40 +48,47 @@ CAF_POP_WARNINGS
 
 namespace caf::openssl {
 
-namespace {
-
-int pem_passwd_cb(char* buf, int size, int, void* ptr) {
-  auto passphrase = reinterpret_cast<session*>(ptr)->openssl_passphrase();
-  strncpy(buf, passphrase, static_cast<size_t>(size));
-  buf[size - 1] = '\0';
-  return static_cast<int>(strlen(buf));
-}
-
-} // namespace
-
 session::session(actor_system& sys)
   : sys_(sys),
     ctx_(nullptr),
     ssl_(nullptr),
     connecting_(false),
-    accepting_(false) {
+    accepting_(false),
+    ktls_send_(false),
+    ktls_recv_(false) {
   // nop
 }
 
 bool session::init() {
   CAF_LOG_TRACE("");
-  ctx_ = create_ssl_context();
+  // All sessions share the context of the manager, which allows clients to
+  // resume earlier sessions instead of running a full handshake.
+  ctx_ = sys_.openssl_manager().context();
+#if OPENSSL_VERSION_NUMBER >= 0x10100000L
+  SSL_CTX_up_ref(ctx_);
+#else
+  CRYPTO_add(&ctx_->references, 1, CRYPTO_LOCK_SSL_CTX);
+#endif
   ssl_ = SSL_new(ctx_);
   if (ssl_ == nullptr) {
     CAF_LOG_ERROR("cannot create SSL session");
     return false;
   }
+  SSL_set_app_data(ssl_, this);
   return true;
 }
 
 session::~session() {
-  SSL_free(ssl_);
-  SSL_CTX_free(ctx_);
+  if (ssl_ != nullptr) {
+    // OpenSSL refuses to resume sessions of connections that did not shut
+    // down cleanly. Since TLS 1.1, an unexpected close no longer requires
+    // this, so we keep the session of established connections.
+    if (SSL_is_init_finished(ssl_))
+      SSL_set_shutdown(ssl_, SSL_SENT_SHUTDOWN | SSL_RECEIVED_SHUTDOWN);
+    SSL_free(ssl_);
+  }
+  if (ctx_ != nullptr)
+    SSL_CTX_free(ctx_);
 }
 
 rw_state session::do_some(int (*f)(SSL*, void*, int), size_t& result, void* buf,
@@ -112,6 +120,7 @@ rw_state session::do_some(int (*f)(SSL*, void*, int), size_t& result, void* buf,
     if (res == 1) {
       CAF_LOG_DEBUG("SSL connection established");
       connecting_ = false;
+      handshake_done();
     } else {
       result = 0;
       return check_ssl_res(res);
@@ -123,6 +132,7 @@ rw_state session::do_some(int (*f)(SSL*, void*, int), size_t& result, void* buf,
     if (res == 1) {
       CAF_LOG_DEBUG("SSL connection accepted");
       accepting_ = false;
+      handshake_done();
     } else {
       result = 0;
       return check_ssl_res(res);
@@ -148,9 +158,12 @@ session::read_some(size_t& result, native_socket, void* buf, size_t len) {
   return do_some(SSL_read, result, buf, len, "read_some");
 }
 
-rw_state session::write_some(size_t& result, native_socket, const void* buf,
-                             size_t len) {
+rw_state session::write_some(size_t& result, native_socket fd,
+                             const void* buf, size_t len) {
   CAF_LOG_TRACE(CAF_ARG(len));
+  // The kernel encrypts plain writes to the socket once OpenSSL enabled kTLS.
+  if (ktls_send_ && len > 0)
+    return policy::tcp::write_some(result, fd, buf, len);
   auto wr_fun = [](SSL* sptr, void* vptr, int ptr_size) {
     return SSL_write(sptr, vptr, ptr_size);
   };
@@ -160,97 +173,76 @@ rw_state session::write_some(size_t& result, native_socket, const void* buf,
 bool session::try_connect(native_socket fd) {
   CAF_LOG_TRACE(CAF_ARG(fd));
   CAF_BLOCK_SIGPIPE();
-  SSL_set_fd(ssl_, fd);
-  SSL_set_connect_state(ssl_);
+  prepare_handshake(fd, false);
   auto ret = SSL_connect(ssl_);
-  if (ret == 1)
+  if (ret == 1) {
+    connecting_ = false;
+    handshake_done();
     return true;
-  connecting_ = true;
+  }
   return handle_ssl_result(ret);
 }
 
 bool session::try_accept(native_socket fd) {
   CAF_LOG_TRACE(CAF_ARG(fd));
   CAF_BLOCK_SIGPIPE();
-  SSL_set_fd(ssl_, fd);
-  SSL_set_accept_state(ssl_);
+  prepare_handshake(fd, true);
   auto ret = SSL_accept(ssl_);
-  if (ret == 1)
+  if (ret == 1) {
+    accepting_ = false;
+    handshake_done();
     return true;
-  accepting_ = true;
+  }
   return handle_ssl_result(ret);
 }
 
+void session::prepare_handshake(native_socket fd, bool from_accepted_socket) {
+  CAF_LOG_TRACE(CAF_ARG(fd) << CAF_ARG(from_accepted_socket));
+  SSL_set_fd(ssl_, fd);
+  if (from_accepted_socket) {
+    SSL_set_accept_state(ssl_);
+    accepting_ = true;
+    return;
+  }
+  SSL_set_connect_state(ssl_);
+  connecting_ = true;
+  auto addr = io::network::remote_addr_of_fd(fd);
+  auto port = io::network::remote_port_of_fd(fd);
+  if (addr && port) {
+    peer_ = *addr + ":" + std::to_string(*port);
+    if (sys_.openssl_manager().resume_session(peer_, ssl_))
+      CAF_LOG_DEBUG("try to resume session with" << peer_);
+  }
+}
+
+session::handshake_result session::continue_handshake() {
+  CAF_LOG_TRACE("");
+  CAF_BLOCK_SIGPIPE();
+  auto ret = SSL_do_handshake(ssl_);
+  if (ret == 1) {
+    CAF_LOG_DEBUG("SSL handshake completed");
+    connecting_ = false;
+    accepting_ = false;
+    handshake_done();
+    return handshake_result::done;
+  }
+  switch (SSL_get_error(ssl_, ret)) {
+    case SSL_ERROR_WANT_READ:
+      return handshake_result::want_read;
+    case SSL_ERROR_WANT_WRITE:
+      return handshake_result::want_write;
+    default:
+      CAF_LOG_INFO("SSL handshake failed:" << get_ssl_error());
+      return handshake_result::failure;
+  }
+}
+
 bool session::must_read_more(native_socket, size_t threshold) {
   return static_cast<size_t>(SSL_pending(ssl_)) >= threshold;
 }
 
 const char* session::openssl_passphrase() {
-  return openssl_passphrase_.c_str();
-}
-
-SSL_CTX* session::create_ssl_context() {
-  CAF_BLOCK_SIGPIPE();
-#ifdef CAF_SSL_HAS_NON_VERSIONED_TLS_FUN
-  auto ctx = SSL_CTX_new(TLS_method());
-#else
-  auto ctx = SSL_CTX_new(TLSv1_2_method());
-#endif
-  if (!ctx)
-    CAF_RAISE_ERROR("cannot create OpenSSL context");
-  if (sys_.openssl_manager().authentication_enabled()) {
-    // Require valid certificates on both sides.
-    auto& cfg = sys_.config();
-    if (!cfg.openssl_certificate.empty()
-        && SSL_CTX_use_certificate_chain_file(ctx,
-                                              cfg.openssl_certificate.c_str())
-             != 1)
-      CAF_RAISE_ERROR("cannot load certificate");
-    if (!cfg.openssl_passphrase.empty()) {
-      openssl_passphrase_ = cfg.openssl_passphrase;
-      SSL_CTX_set_default_passwd_cb(ctx, pem_passwd_cb);
-      SSL_CTX_set_default_passwd_cb_userdata(ctx, this);
-    }
-    if (!cfg.openssl_key.empty()
-        && SSL_CTX_use_PrivateKey_file(ctx, cfg.openssl_key.c_str(),
-                                       SSL_FILETYPE_PEM)
-             != 1)
-      CAF_RAISE_ERROR("cannot load private key");
-    auto cafile = (!cfg.openssl_cafile.empty() ? cfg.openssl_cafile.c_str()
-                                               : nullptr);
-    auto capath = (!cfg.openssl_capath.empty() ? cfg.openssl_capath.c_str()
-                                               : nullptr);
-    if (cafile || capath) {
-      if (SSL_CTX_load_verify_locations(ctx, cafile, capath) != 1)
-        CAF_RAISE_ERROR("cannot load trusted CA certificates");
-    }
-    SSL_CTX_set_verify(ctx, SSL_VERIFY_PEER | SSL_VERIFY_FAIL_IF_NO_PEER_CERT,
-                       nullptr);
-    if (SSL_CTX_set_cipher_list(ctx, "HIGH:!aNULL:!MD5") != 1)
-      CAF_RAISE_ERROR("cannot set cipher list");
-  } else {
-    // No authentication.
-    SSL_CTX_set_verify(ctx, SSL_VERIFY_NONE, nullptr);
-#if defined(CAF_SSL_HAS_ECDH_AUTO) && (OPENSSL_VERSION_NUMBER < 0x10100000L)
-    SSL_CTX_set_ecdh_auto(ctx, 1);
-#else
-    auto ecdh = EC_KEY_new_by_curve_name(NID_secp384r1);
-    if (!ecdh)
-      CAF_RAISE_ERROR("cannot get ECDH curve");
-    CAF_PUSH_WARNINGS
-    SSL_CTX_set_tmp_ecdh(ctx, ecdh);
-    EC_KEY_free(ecdh);
-    CAF_POP_WARNINGS
-#endif
-#ifdef CAF_SSL_HAS_SECURITY_LEVEL
-    const char* cipher = "AECDH-AES256-SHA@SECLEVEL=0";
-#else
-    const char* cipher = "AECDH-AES256-SHA";
-#endif
-    if (SSL_CTX_set_cipher_list(ctx, cipher) != 1)
-      CAF_RAISE_ERROR("cannot set anonymous cipher");
-  }
-  return ctx;
+  return sys_.config().openssl_passphrase.c_str();
 }
 
 std::string session::get_ssl_error() {
@@ -283,6 +275,20 @@ bool session::handle_ssl_result(int ret) {
   }
 }
 
+void session::handshake_done() {
+  auto& mgr = sys_.openssl_manager();
+  if (SSL_session_reused(ssl_) == 1)
+    mgr.metric_singletons.resumed_handshakes->inc();
+  else
+    mgr.metric_singletons.full_handshakes->inc();
+#ifdef CAF_SSL_HAS_KTLS
+  ktls_send_ = BIO_get_ktls_send(SSL_get_wbio(ssl_)) > 0;
+  ktls_recv_ = BIO_get_ktls_recv(SSL_get_rbio(ssl_)) > 0;
+  CAF_LOG_DEBUG(CAF_ARG2("ktls-send", ktls_send_)
+                << CAF_ARG2("ktls-recv", ktls_recv_));
+#endif
+}
+
 session_ptr
 make_session(actor_system& sys, native_socket fd, bool from_accepted_socket) {
   session_ptr ptr{new session(sys)};
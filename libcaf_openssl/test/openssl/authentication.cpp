@@ -110,7 +110,7 @@ struct fixture {
     }
   }
 
-  bool init(bool skip_client_side_ca) {
+  bool init(bool skip_client_side_ca, bool ktls = false) {
     auto cd = config::data_dir();
     cd += '/';
     server_side_config.openssl_passphrase = "12345";
@@ -133,6 +133,8 @@ struct fixture {
       }
       *x.second = std::move(path);
     }
+    server_side_config.set("caf.openssl.ktls", ktls);
+    client_side_config.set("caf.openssl.ktls", ktls);
     CAF_MESSAGE("initialize server side");
     new (&server_side) actor_system(server_side_config);
     CAF_MESSAGE("initialize client side");
@@ -205,6 +207,25 @@ CAF_TEST(authentication_success) {
   exec_loop();
 }
 
+CAF_TEST(authentication_success_with_ktls) {
+  // Passes regardless of kernel support, since OpenSSL falls back to
+  // encrypting in user space.
+  if (!init(false, true))
+    return;
+  auto spong = server_side.spawn(make_pong_behavior);
+  exec_loop();
+  loop_after_next_enqueue(server_side);
+  auto port = unbox(publish(spong, 0, local_host));
+  exec_loop();
+  loop_after_next_enqueue(client_side);
+  auto pong = unbox(remote_actor(client_side, local_host, port));
+  auto sping = client_side.spawn(make_ping_behavior, pong);
+  while (!terminated(sping))
+    exec_loop();
+  anon_send_exit(spong, exit_reason::user_shutdown);
+  exec_loop();
+}
+
 CAF_TEST(authentication_failure) {
   if (!init(true))
     return;
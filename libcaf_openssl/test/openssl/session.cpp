@@ -0,0 +1,190 @@
+// This file is part of CAF, the C++ Actor Framework. See the file LICENSE in
+// the main distribution directory for license terms and copyright or visit
+// https://github.com/actor-framework/actor-framework/blob/master/LICENSE.
+
+#define CAF_SUITE openssl.session
+
+#include "caf/openssl/session.hpp"
+
+#include "openssl-test.hpp"
+
+#include <optional>
+#include <utility>
+
+#include "caf/all.hpp"
+#include "caf/io/all.hpp"
+#include "caf/openssl/all.hpp"
+#include "caf/policy/tcp.hpp"
+#include "caf/scheduler/test_coordinator.hpp"
+
+#ifndef CAF_WINDOWS
+#  include <sys/socket.h>
+#endif
+
+using namespace caf;
+using namespace caf::io::network;
+
+namespace {
+
+class config : public actor_system_config {
+public:
+  config() {
+    load<io::middleman>();
+    load<openssl::manager>();
+    set("caf.middleman.manual-multiplexing", true);
+    set("caf.scheduler.policy", "testing");
+  }
+};
+
+struct fixture {
+  config cfg;
+  actor_system sys{cfg};
+  scheduler::test_coordinator& sched;
+  default_multiplexer& mpx;
+  native_socket acceptor;
+  uint16_t port;
+
+  fixture()
+    : sched(dynamic_cast<scheduler::test_coordinator&>(sys.scheduler())),
+      mpx(static_cast<default_multiplexer&>(sys.middleman().backend())) {
+    acceptor = unbox(new_tcp_acceptor_impl(0, "127.0.0.1", false));
+    port = unbox(local_port_of_fd(acceptor));
+  }
+
+  ~fixture() {
+    close_socket(acceptor);
+  }
+
+  // Returns a connected pair of nonblocking sockets.
+  std::pair<native_socket, native_socket> connect() {
+    auto client_fd = unbox(new_tcp_connection("127.0.0.1", port));
+    auto server_fd = ::accept(acceptor, nullptr, nullptr);
+    if (server_fd == invalid_native_socket)
+      CAF_FAIL("accept failed");
+    for (auto fd : {client_fd, server_fd}) {
+      nonblocking(fd, true);
+      // Don't let Nagle's algorithm hold back the last message of a flight.
+      tcp_nodelay(fd, true);
+    }
+    return {client_fd, server_fd};
+  }
+
+  // Runs the event loop and the scheduler until `pred` becomes true.
+  template <class Predicate>
+  void run_until(Predicate pred) {
+    for (size_t i = 0; i < 10'000 && !pred(); ++i) {
+      sched.try_run_once();
+      mpx.try_run_once();
+    }
+    if (!pred())
+      CAF_FAIL("predicate remained false");
+  }
+
+  // Connects a client and a server session over loopback and sends a single
+  // byte once the handshake completed.
+  void handshake() {
+    auto [client_fd, server_fd] = connect();
+    auto client = openssl::make_session(sys, client_fd, false);
+    auto server = openssl::make_session(sys, server_fd, true);
+    if (client == nullptr || server == nullptr)
+      CAF_FAIL("make_session failed");
+    char out = 'x';
+    char in = 0;
+    size_t written = 0;
+    size_t received = 0;
+    for (size_t i = 0; i < 100 && received == 0; ++i) {
+      if (written == 0
+          && client->write_some(written, client_fd, &out, 1)
+               == rw_state::failure)
+        CAF_FAIL("client failed to write");
+      if (server->read_some(received, server_fd, &in, 1) == rw_state::failure)
+        CAF_FAIL("server failed to read");
+    }
+    CAF_CHECK_EQUAL(received, 1u);
+    CAF_CHECK_EQUAL(in, 'x');
+    // Process session tickets that arrive after the handshake.
+    client->read_some(received, client_fd, &in, 1);
+    close_socket(client_fd);
+    close_socket(server_fd);
+  }
+
+  int64_t full_handshakes() {
+    return sys.openssl_manager().metric_singletons.full_handshakes->value();
+  }
+
+  int64_t resumed_handshakes() {
+    return sys.openssl_manager().metric_singletons.resumed_handshakes->value();
+  }
+};
+
+} // namespace
+
+CAF_TEST_FIXTURE_SCOPE(session_tests, fixture)
+
+CAF_TEST(clients resume sessions when reconnecting to a known server) {
+  CAF_MESSAGE("the first connection runs a full handshake on both sides");
+  handshake();
+  CAF_CHECK_EQUAL(full_handshakes(), 2);
+  CAF_CHECK_EQUAL(resumed_handshakes(), 0);
+  CAF_MESSAGE("reconnecting resumes the session on both sides");
+  handshake();
+  CAF_CHECK_EQUAL(full_handshakes(), 2);
+  CAF_CHECK_EQUAL(resumed_handshakes(), 2);
+  handshake();
+  CAF_CHECK_EQUAL(full_handshakes(), 2);
+  CAF_CHECK_EQUAL(resumed_handshakes(), 4);
+}
+
+CAF_TEST(handshakes run on scheduler workers) {
+  auto [client_fd, server_fd] = connect();
+  std::optional<expected<openssl::session_ptr>> client;
+  std::optional<expected<openssl::session_ptr>> server;
+  openssl::async_handshake(mpx, client_fd, false,
+                           [&](expected<openssl::session_ptr> res) {
+                             client = std::move(res);
+                           });
+  openssl::async_handshake(mpx, server_fd, true,
+                           [&](expected<openssl::session_ptr> res) {
+                             server = std::move(res);
+                           });
+  CAF_MESSAGE("the multiplexer thread does not run any handshake step");
+  CAF_CHECK_EQUAL(sched.jobs.size(), 2u);
+  CAF_CHECK_EQUAL(full_handshakes(), 0);
+  run_until([&] { return client && server; });
+  if (!CAF_CHECK(*client) || !CAF_CHECK(*server))
+    return;
+  CAF_CHECK_EQUAL(full_handshakes(), 2);
+  CAF_MESSAGE("the sessions exchange data after the handshake");
+  char out = 'x';
+  char in = 0;
+  size_t written = 0;
+  size_t received = 0;
+  CAF_CHECK_EQUAL((**client)->write_some(written, client_fd, &out, 1),
+                  rw_state::success);
+  CAF_CHECK_EQUAL(written, 1u);
+  for (size_t i = 0; i < 100 && received == 0; ++i)
+    (**server)->read_some(received, server_fd, &in, 1);
+  CAF_CHECK_EQUAL(in, 'x');
+  close_socket(client_fd);
+  close_socket(server_fd);
+}
+
+CAF_TEST(failed handshakes report an error) {
+  auto [client_fd, server_fd] = connect();
+  std::optional<expected<openssl::session_ptr>> client;
+  openssl::async_handshake(mpx, client_fd, false,
+                           [&](expected<openssl::session_ptr> res) {
+                             client = std::move(res);
+                           });
+  CAF_MESSAGE("a peer that does not speak TLS makes the handshake fail");
+  const char garbage[] = "HTTP/1.1 400 Bad Request\r\n\r\n";
+  size_t written = 0;
+  policy::tcp::write_some(written, server_fd, garbage, sizeof(garbage) - 1);
+  run_until([&] { return client.has_value(); });
+  if (CAF_CHECK(!*client))
+    CAF_CHECK_EQUAL(client->error(), sec::cannot_connect_to_node);
+  CAF_CHECK_EQUAL(full_handshakes(), 0);
+  close_socket(server_fd);
+}
+
+CAF_TEST_FIXTURE_SCOPE_END()